@@ -0,0 +1,67 @@
+/**
+ *
+ * @file bl_break_entry.c
+ *
+ * @ingroup bl_break_entry
+ *
+ * @brief This file contains the break watcher. The receiver's break detection does the timing: at
+ *        @ref BL_BREAK_ENTRY_BRG a break is only recognised after @ref BL_BREAK_ENTRY_MIN_US of low input, and
+ *        RXBKIF is set when the input rises again, so the line is idle by the time the bootloader starts.
+ *
+ * @version BL_BREAK_ENTRY Version 1.0.0
+ */
+
+/*
+ [2022] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip
+    software and any derivatives exclusively with Microchip products.
+    You are responsible for complying with 3rd party license terms
+    applicable to your use of 3rd party software (including open source
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.?
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR
+    THIS SOFTWARE.
+ */
+
+#include "bl_break_entry.h"
+#include "bl_entry_request.h"
+
+void BL_BreakEntryInitialize(void)
+{
+    // RX1 on RF1, as in the bootloader
+    ANSELFbits.ANSELF1 = 0;
+    TRISFbits.TRISF1 = 1;
+    U1RXPPS = 0x29;
+
+    U1BRGL = (uint8_t) BL_BREAK_ENTRY_BRG;
+    U1BRGH = (uint8_t) (BL_BREAK_ENTRY_BRG >> 8);
+    //MODE Asynchronous 8-bit mode; RXEN enabled; TXEN disabled; BRGS high speed;
+    U1CON0 = 0x90;
+    //RUNOVF RX input shifter keeps synchronizing after an overflow, so breaks are still seen;
+    U1CON2 = 0x80;
+    U1ERRIR = 0x0;
+    //SENDB disabled; BRKOVR disabled; RXBIMD Set RXBKIF on rising RX input; WUE disabled; ON enabled;
+    U1CON1 = 0x80;
+}
+
+void BL_BreakEntryTasks(void)
+{
+    while (U1FIFObits.RXBE == 0U)
+    {
+        (void) U1RXB;
+    }
+
+    if (U1ERRIRbits.RXBKIF == 1U)
+    {
+        BL_EntryRequestBreak();
+    }
+}
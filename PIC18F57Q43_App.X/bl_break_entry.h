@@ -0,0 +1,74 @@
+/**
+ *
+ * @file bl_break_entry.h
+ *
+ * @defgroup bl_break_entry BL_BREAK_ENTRY
+ *
+ * @brief This file contains the API of the break watcher, which hands over to the bootloader when the host
+ *        holds the UART1 receive line low for at least @ref BL_BREAK_ENTRY_MIN_US.
+ *
+ * @version BL_BREAK_ENTRY Version 1.0.0
+ */
+
+/*
+ [2022] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip
+    software and any derivatives exclusively with Microchip products.
+    You are responsible for complying with 3rd party license terms
+    applicable to your use of 3rd party software (including open source
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.?
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR
+    THIS SOFTWARE.
+ */
+
+#ifndef BL_BREAK_ENTRY_H
+#define BL_BREAK_ENTRY_H
+
+#include <xc.h>
+#include <stdint.h>
+#include "mcc_generated_files/system/clock.h"
+
+/**
+ * @ingroup bl_break_entry
+ * @def BL_BREAK_ENTRY_MIN_US
+ * This is a macro for the shortest break, in microseconds, that requests the bootloader.
+ * Shorter low pulses, such as a 0x00 byte at any baud rate above 5500, are ignored.
+ */
+#define BL_BREAK_ENTRY_MIN_US   (2000UL)
+/**
+ * @ingroup bl_break_entry
+ * @def BL_BREAK_ENTRY_BRG
+ * This is a macro for the UART1 baud rate generator value at which 11 bit periods, the break detection time
+ * of the receiver, last @ref BL_BREAK_ENTRY_MIN_US (high speed mode, 4 clocks per bit).
+ */
+#define BL_BREAK_ENTRY_BRG      ((uint16_t) (((_XTAL_FREQ / 4000000UL) * BL_BREAK_ENTRY_MIN_US) / 11UL) - 1U)
+
+/**
+ * @ingroup bl_break_entry
+ * @brief Sets up the UART1 receiver on the bootloader RX pin (RF1) to detect breaks. The application must not
+ *        use UART1 at another baud rate while the watcher runs.
+ * @param none
+ * @return none
+ */
+void BL_BreakEntryInitialize(void);
+
+/**
+ * @ingroup bl_break_entry
+ * @brief Discards received bytes and hands over to the bootloader once a break has ended. Call it from the main
+ *        loop; the break flag is latched by the hardware, so the call interval only adds to the entry latency.
+ * @param none
+ * @return none; does not return after a break
+ */
+void BL_BreakEntryTasks(void);
+
+#endif // BL_BREAK_ENTRY_H
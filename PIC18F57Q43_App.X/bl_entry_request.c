@@ -0,0 +1,89 @@
+/**
+ *
+ * @file bl_entry_request.c
+ *
+ * @ingroup bl_entry_request
+ *
+ * @brief This file contains the application side of the bootloader entry handshake.
+ *
+ * @version BL_ENTRY_REQUEST Version 1.0.0
+ */
+
+/*
+ [2022] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip
+    software and any derivatives exclusively with Microchip products.
+    You are responsible for complying with 3rd party license terms
+    applicable to your use of 3rd party software (including open source
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.?
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR
+    THIS SOFTWARE.
+ */
+
+#include "bl_entry_request.h"
+
+// Absolute objects are not cleared by the runtime startup code, so the bootloader sees the value after RESET()
+static volatile uint32_t entryRequestWord __at(BL_ENTRY_REQUEST_RAM_ADDRESS);
+
+void BL_EntryRequestRam(void)
+{
+    INTCON0bits.GIE = 0;
+    entryRequestWord = BL_ENTRY_REQUEST_RAM_MAGIC;
+    RESET();
+}
+
+void BL_EntryRequestBreak(void)
+{
+    INTCON0bits.GIE = 0;
+    entryRequestWord = BL_ENTRY_REQUEST_BREAK_MAGIC;
+    RESET();
+}
+
+void BL_EntryRequestInstall(uint16_t unlockKey)
+{
+    INTCON0bits.GIE = 0;
+    entryRequestWord = ((uint32_t) BL_ENTRY_REQUEST_INSTALL_MAGIC << 16) | unlockKey;
+    RESET();
+}
+
+void BL_EntryRequestEeprom(void)
+{
+    INTCON0bits.GIE = 0;
+
+    NVMADRU = (uint8_t) (BL_ENTRY_REQUEST_EEPROM >> 16);
+    NVMADRH = (uint8_t) (BL_ENTRY_REQUEST_EEPROM >> 8);
+    NVMADRL = (uint8_t) BL_ENTRY_REQUEST_EEPROM;
+    NVMDATL = BL_ENTRY_REQUEST_EEPROM_MAGIC;
+
+    //Set the byte write command
+    NVMCON1bits.NVMCMD = 0x03;
+
+    //Perform the unlock sequence and start the byte write
+    asm("asmopt push");
+    asm("asmopt off");
+    asm("banksel(_NVMLOCK)");
+    asm("movlw 0x55");
+    asm("movwf (_NVMLOCK&0xFF),b");
+    asm("movlw 0xAA");
+    asm("movwf (_NVMLOCK&0xFF),b");
+    asm("bsf (_NVMCON0bits&0xFF)," ___mkstr(_NVMCON0_GO_POSN) ",b");
+    asm("asmopt pop");
+
+    while (NVMCON0bits.GO == 1U)
+    {
+    }
+    NVMCON1bits.NVMCMD = 0x00;
+
+    // A RAM request would take precedence and leave the EEPROM byte set after the update
+    RESET();
+}
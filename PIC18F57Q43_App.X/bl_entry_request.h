@@ -0,0 +1,114 @@
+/**
+ *
+ * @file bl_entry_request.h
+ *
+ * @defgroup bl_entry_request BL_ENTRY_REQUEST
+ *
+ * @brief This file contains the application side of the bootloader entry handshake.
+ *        The values below must match bl_boot_config.h and bl_entry_request.h of the bootloader project.
+ *
+ * @version BL_ENTRY_REQUEST Version 1.0.0
+ */
+
+/*
+ [2022] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip
+    software and any derivatives exclusively with Microchip products.
+    You are responsible for complying with 3rd party license terms
+    applicable to your use of 3rd party software (including open source
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.?
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR
+    THIS SOFTWARE.
+ */
+
+#ifndef BL_ENTRY_REQUEST_H
+#define BL_ENTRY_REQUEST_H
+
+#include <xc.h>
+#include <stdint.h>
+
+/**
+ * @ingroup bl_entry_request
+ * @def BL_ENTRY_REQUEST_RAM_ADDRESS
+ * This is a macro for the RAM address of the 32-bit entry request word. The application must not use this RAM.
+ */
+#define BL_ENTRY_REQUEST_RAM_ADDRESS    (0x24FCU)
+/**
+ * @ingroup bl_entry_request
+ * @def BL_ENTRY_REQUEST_RAM_MAGIC
+ * This is a macro for the value that requests bootloader entry through RAM.
+ */
+#define BL_ENTRY_REQUEST_RAM_MAGIC      (0x5AA5C33CUL)
+/**
+ * @ingroup bl_entry_request
+ * @def BL_ENTRY_REQUEST_BREAK_MAGIC
+ * This is a macro for the value that requests bootloader entry through RAM after a break on UART1.
+ */
+#define BL_ENTRY_REQUEST_BREAK_MAGIC    (0xA55A3CC3UL)
+/**
+ * @ingroup bl_entry_request
+ * @def BL_ENTRY_REQUEST_EEPROM
+ * This is a macro for the EEPROM location of the entry request byte.
+ */
+#define BL_ENTRY_REQUEST_EEPROM         (0x3803FEUL)
+/**
+ * @ingroup bl_entry_request
+ * @def BL_ENTRY_REQUEST_EEPROM_MAGIC
+ * This is a macro for the value that requests bootloader entry through EEPROM.
+ */
+#define BL_ENTRY_REQUEST_EEPROM_MAGIC   (0xB1U)
+/**
+ * @ingroup bl_entry_request
+ * @def BL_ENTRY_REQUEST_INSTALL_MAGIC
+ * This is a macro for the upper 16 bits of the RAM request word that asks for the download slot to be installed.
+ */
+#define BL_ENTRY_REQUEST_INSTALL_MAGIC  (0x1A57U)
+
+/**
+ * @ingroup bl_entry_request
+ * @brief Stores the RAM request and resets the device. The bootloader starts without the pin settle delay
+ *        and the image verification. A power loss before the bootloader runs cancels the request.
+ * @param none
+ * @return This function does not return
+ */
+void BL_EntryRequestRam(void);
+
+/**
+ * @ingroup bl_entry_request
+ * @brief Stores the EEPROM request and resets the device. The request survives a power loss and is cleared
+ *        by the bootloader once the host starts writing the application. Takes up to one EEPROM byte write time longer
+ *        than @ref BL_EntryRequestRam.
+ * @param none
+ * @return This function does not return
+ */
+void BL_EntryRequestEeprom(void);
+
+/**
+ * @ingroup bl_entry_request
+ * @brief Same as @ref BL_EntryRequestRam, but the bootloader logs the entry as a break handoff.
+ *        Called by the break watcher in bl_break_entry.c.
+ * @param none
+ * @return This function does not return
+ */
+void BL_EntryRequestBreak(void);
+
+/**
+ * @ingroup bl_entry_request
+ * @brief Asks the bootloader to install the download slot, and resets the device. The bootloader starts the
+ *        application again afterwards. Called by @ref BL_SlotInstall in bl_slot.c.
+ * @param [in] unlockKey - NVM unlock key the bootloader uses for the install
+ * @return This function does not return
+ */
+void BL_EntryRequestInstall(uint16_t unlockKey);
+
+#endif // BL_ENTRY_REQUEST_H
@@ -0,0 +1,137 @@
+/**
+ *
+ * @file bl_service.c
+ *
+ * @ingroup bl_service
+ *
+ * @brief This file contains the calls into the bootloader service table. Each call fills the parameter block
+ *        and jumps to the single entry point; the bootloader writes the status back into the block.
+ *
+ * @version BL_SERVICE Version 1.0.0
+ */
+
+/*
+ [2022] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip
+    software and any derivatives exclusively with Microchip products.
+    You are responsible for complying with 3rd party license terms
+    applicable to your use of 3rd party software (including open source
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.?
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR
+    THIS SOFTWARE.
+ */
+
+#include "bl_service.h"
+
+#define BL_SERVICE_FLASH_READ       (0x00U)
+#define BL_SERVICE_FLASH_ERASE      (0x01U)
+#define BL_SERVICE_FLASH_WRITE      (0x02U)
+#define BL_SERVICE_CHECKSUM         (0x03U)
+#define BL_SERVICE_RECORD_READ      (0x04U)
+#define BL_SERVICE_RECORD_WRITE     (0x05U)
+
+typedef struct
+{
+    uint8_t service;
+    uint8_t status;
+    uint16_t unlockKey;
+    uint32_t address;
+    uint16_t buffer;
+    uint16_t length;
+    uint32_t value;
+} bl_service_args_t;
+
+// The same absolute address as in the bootloader; the rest of its RAM is kept free by the -mram option
+static volatile bl_service_args_t serviceArgs __at(BL_SERVICE_ARGS_ADDRESS);
+
+static uint8_t BL_ServiceRun(uint8_t service);
+
+static uint8_t BL_ServiceRun(uint8_t service)
+{
+    serviceArgs.service = service;
+    serviceArgs.status = BL_SERVICE_UNSUPPORTED;
+    ((void (*)(void)) BL_SERVICE_ENTRY_ADDRESS)();
+    return serviceArgs.status;
+}
+
+bool BL_ServiceIsCompatible(void)
+{
+    uint8_t header[5];
+
+    TBLPTRU = (uint8_t) (BL_SERVICE_TABLE_ADDRESS >> 16);
+    TBLPTRH = (uint8_t) (BL_SERVICE_TABLE_ADDRESS >> 8);
+    TBLPTRL = (uint8_t) BL_SERVICE_TABLE_ADDRESS;
+    for (uint8_t i = 0U; i < sizeof(header); i++)
+    {
+        asm("TBLRD*+");
+        header[i] = TABLAT;
+    }
+
+    // An erased page or an older bootloader without the table fails the magic check
+    return (header[0] == (uint8_t) BL_SERVICE_MAGIC) && (header[1] == (uint8_t) (BL_SERVICE_MAGIC >> 8))
+           && (header[2] == BL_SERVICE_VERSION_MAJOR) && (header[3] >= BL_SERVICE_VERSION_MINOR)
+           && (header[4] >= BL_SERVICE_COUNT);
+}
+
+uint8_t BL_ServiceFlashRead(uint32_t address, uint8_t *buffer, uint16_t length)
+{
+    serviceArgs.address = address;
+    serviceArgs.buffer = (uint16_t) buffer;
+    serviceArgs.length = length;
+    return BL_ServiceRun(BL_SERVICE_FLASH_READ);
+}
+
+uint8_t BL_ServiceFlashErase(uint32_t address)
+{
+    serviceArgs.address = address;
+    serviceArgs.unlockKey = BL_SERVICE_UNLOCK_KEY;
+    return BL_ServiceRun(BL_SERVICE_FLASH_ERASE);
+}
+
+uint8_t BL_ServiceFlashWrite(uint32_t address, const uint8_t *page)
+{
+    serviceArgs.address = address;
+    serviceArgs.buffer = (uint16_t) page;
+    serviceArgs.length = BL_SERVICE_PAGE_SIZE;
+    serviceArgs.unlockKey = BL_SERVICE_UNLOCK_KEY;
+    return BL_ServiceRun(BL_SERVICE_FLASH_WRITE);
+}
+
+uint8_t BL_ServiceChecksum(uint32_t address, uint16_t length, uint16_t *checksum)
+{
+    uint8_t status;
+
+    serviceArgs.address = address;
+    serviceArgs.length = length;
+    status = BL_ServiceRun(BL_SERVICE_CHECKSUM);
+    *checksum = (uint16_t) serviceArgs.value;
+    return status;
+}
+
+uint8_t BL_ServiceRecordRead(uint8_t key, uint32_t *value)
+{
+    uint8_t status;
+
+    serviceArgs.address = key;
+    status = BL_ServiceRun(BL_SERVICE_RECORD_READ);
+    *value = serviceArgs.value;
+    return status;
+}
+
+uint8_t BL_ServiceRecordWrite(uint8_t key, uint32_t value)
+{
+    serviceArgs.address = key;
+    serviceArgs.value = value;
+    serviceArgs.unlockKey = BL_SERVICE_UNLOCK_KEY;
+    return BL_ServiceRun(BL_SERVICE_RECORD_WRITE);
+}
@@ -0,0 +1,187 @@
+/**
+ *
+ * @file bl_service.h
+ *
+ * @defgroup bl_service BL_SERVICE
+ *
+ * @brief This file contains the application side of the bootloader service table.
+ *        The values below must match bl_boot_config.h and bl_service.h of the bootloader project, and the
+ *        application must leave the bootloader RAM alone (see the readme).
+ *
+ * @version BL_SERVICE Version 1.0.0
+ */
+
+/*
+ [2022] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip
+    software and any derivatives exclusively with Microchip products.
+    You are responsible for complying with 3rd party license terms
+    applicable to your use of 3rd party software (including open source
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.?
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR
+    THIS SOFTWARE.
+ */
+
+#ifndef BL_SERVICE_H
+#define BL_SERVICE_H
+
+#include <xc.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @ingroup bl_service
+ * @def BL_SERVICE_TABLE_ADDRESS
+ * This is a macro for the flash address of the service table header.
+ */
+#define BL_SERVICE_TABLE_ADDRESS    (0x2F00UL)
+/**
+ * @ingroup bl_service
+ * @def BL_SERVICE_ENTRY_ADDRESS
+ * This is a macro for the flash address of the service entry point.
+ */
+#define BL_SERVICE_ENTRY_ADDRESS    (BL_SERVICE_TABLE_ADDRESS + 8UL)
+/**
+ * @ingroup bl_service
+ * @def BL_SERVICE_ARGS_ADDRESS
+ * This is a macro for the RAM address of the service parameter block.
+ */
+#define BL_SERVICE_ARGS_ADDRESS     (0x1C00U)
+/**
+ * @ingroup bl_service
+ * @def BL_SERVICE_MAGIC
+ * This is a macro for the first two bytes of the service table header.
+ */
+#define BL_SERVICE_MAGIC            (0xB15EU)
+/**
+ * @ingroup bl_service
+ * @def BL_SERVICE_VERSION_MAJOR
+ * This is a macro for the table major version this application was built for; it must match exactly.
+ */
+#define BL_SERVICE_VERSION_MAJOR    (1U)
+/**
+ * @ingroup bl_service
+ * @def BL_SERVICE_VERSION_MINOR
+ * This is a macro for the lowest table minor version this application needs.
+ */
+#define BL_SERVICE_VERSION_MINOR    (0U)
+/**
+ * @ingroup bl_service
+ * @def BL_SERVICE_COUNT
+ * This is a macro for the number of services this application calls.
+ */
+#define BL_SERVICE_COUNT            (0x06U)
+/**
+ * @ingroup bl_service
+ * @def BL_SERVICE_UNLOCK_KEY
+ * This is a macro for the NVM unlock key the bootloader expects, the same one the host sends in its frames.
+ */
+#define BL_SERVICE_UNLOCK_KEY       (0xAA55U)
+/**
+ * @ingroup bl_service
+ * @def BL_SERVICE_PAGE_SIZE
+ * This is a macro for the flash page size used by @ref BL_ServiceFlashWrite.
+ */
+#define BL_SERVICE_PAGE_SIZE        (256U)
+
+/**
+ * @ingroup bl_service
+ * @def BL_SERVICE_OK
+ * This is a macro for the status of a service that succeeded.
+ */
+#define BL_SERVICE_OK               (0x01U)
+/**
+ * @ingroup bl_service
+ * @def BL_SERVICE_FAILED
+ * This is a macro for the status of a service whose NVM operation failed, or a record that was not found.
+ */
+#define BL_SERVICE_FAILED           (0xFDU)
+/**
+ * @ingroup bl_service
+ * @def BL_SERVICE_OUT_OF_RANGE
+ * This is a macro for the status of a service called with an address or log key it does not accept.
+ */
+#define BL_SERVICE_OUT_OF_RANGE     (0xFEU)
+/**
+ * @ingroup bl_service
+ * @def BL_SERVICE_UNSUPPORTED
+ * This is a macro for the status of a service the bootloader was built without.
+ */
+#define BL_SERVICE_UNSUPPORTED      (0xFFU)
+
+/**
+ * @ingroup bl_service
+ * @brief Checks the service table header: the magic, the major version, and that the minor version and
+ *        the number of services are at least the ones this application was built for.
+ * @param none
+ * @retval true - The services below may be called
+ * @retval false - The bootloader has no compatible service table
+ */
+bool BL_ServiceIsCompatible(void);
+
+/**
+ * @ingroup bl_service
+ * @brief Copies flash, configuration or device ID bytes into RAM.
+ * @param [in] address - First flash address
+ * @param [out] *buffer - Destination
+ * @param [in] length - Number of bytes
+ * @return BL_SERVICE_OK or an error status
+ */
+uint8_t BL_ServiceFlashRead(uint32_t address, uint8_t *buffer, uint16_t length);
+
+/**
+ * @ingroup bl_service
+ * @brief Erases one application page. Pages below the application start are rejected.
+ * @param [in] address - Page aligned flash address
+ * @return BL_SERVICE_OK or an error status
+ */
+uint8_t BL_ServiceFlashErase(uint32_t address);
+
+/**
+ * @ingroup bl_service
+ * @brief Erases one application page and writes @ref BL_SERVICE_PAGE_SIZE bytes into it.
+ * @param [in] address - Page aligned flash address
+ * @param [in] *page - Page contents
+ * @return BL_SERVICE_OK or an error status
+ */
+uint8_t BL_ServiceFlashWrite(uint32_t address, const uint8_t *page);
+
+/**
+ * @ingroup bl_service
+ * @brief Sums the little-endian 16-bit words of a flash range, like the CALC_CHECKSUM command.
+ * @param [in] address - First flash address
+ * @param [in] length - Number of bytes, even
+ * @param [out] *checksum - Sum of the words
+ * @return BL_SERVICE_OK or an error status
+ */
+uint8_t BL_ServiceChecksum(uint32_t address, uint16_t length, uint16_t *checksum);
+
+/**
+ * @ingroup bl_service
+ * @brief Reads the newest value of a key from the bootloader's EEPROM record log.
+ * @param [in] key - Log key, 0x01 to 0xFE
+ * @param [out] *value - Value of the key
+ * @return BL_SERVICE_OK, BL_SERVICE_FAILED if the key has no record, or an error status
+ */
+uint8_t BL_ServiceRecordRead(uint8_t key, uint32_t *value);
+
+/**
+ * @ingroup bl_service
+ * @brief Appends a record to the bootloader's EEPROM record log; blocks until the EEPROM is written.
+ * @param [in] key - Log key, 0x80 to 0xFE
+ * @param [in] value - New value of the key
+ * @return BL_SERVICE_OK or an error status
+ */
+uint8_t BL_ServiceRecordWrite(uint8_t key, uint32_t value);
+
+#endif // BL_SERVICE_H
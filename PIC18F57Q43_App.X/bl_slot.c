@@ -0,0 +1,66 @@
+/**
+ *
+ * @file bl_slot.c
+ *
+ * @ingroup bl_slot
+ *
+ * @brief This file contains the application side of the dual-slot update.
+ *
+ * @version BL_SLOT Version 1.0.0
+ */
+
+/*
+ [2022] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip
+    software and any derivatives exclusively with Microchip products.
+    You are responsible for complying with 3rd party license terms
+    applicable to your use of 3rd party software (including open source
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.?
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR
+    THIS SOFTWARE.
+ */
+
+#include "bl_slot.h"
+#include "bl_entry_request.h"
+
+uint8_t BL_SlotWrite(uint32_t offset, const uint8_t *page)
+{
+    if ((offset + BL_SERVICE_PAGE_SIZE) > BL_SLOT_SIZE)
+    {
+        return BL_SERVICE_OUT_OF_RANGE;
+    }
+    return BL_ServiceFlashWrite(BL_SLOT_B_ADDRESS + offset, page);
+}
+
+bool BL_SlotIsValid(void)
+{
+    uint16_t checksum;
+    uint8_t stored[2];
+
+    if ((BL_ServiceChecksum(BL_SLOT_B_ADDRESS, (uint16_t) (BL_SLOT_SIZE - 2U), &checksum) != BL_SERVICE_OK)
+            || (BL_ServiceFlashRead(BL_SLOT_B_ADDRESS + BL_SLOT_SIZE - 2U, stored, sizeof(stored)) != BL_SERVICE_OK))
+    {
+        return false;
+    }
+    return checksum == (uint16_t) (stored[0] | ((uint16_t) stored[1] << 8));
+}
+
+bool BL_SlotInstall(void)
+{
+    if (BL_SlotIsValid() == false)
+    {
+        return false;
+    }
+    BL_EntryRequestInstall(BL_SERVICE_UNLOCK_KEY);
+    return true;
+}
@@ -0,0 +1,84 @@
+/**
+ *
+ * @file bl_slot.h
+ *
+ * @defgroup bl_slot BL_SLOT
+ *
+ * @brief This file contains the application side of the dual-slot update. The application writes the new image
+ *        into the download slot through the bootloader services while it keeps running, then asks the bootloader
+ *        to install it. The values below must match bl_boot_config.h of the bootloader project.
+ *
+ * @version BL_SLOT Version 1.0.0
+ */
+
+/*
+ [2022] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip
+    software and any derivatives exclusively with Microchip products.
+    You are responsible for complying with 3rd party license terms
+    applicable to your use of 3rd party software (including open source
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.?
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR
+    THIS SOFTWARE.
+ */
+
+#ifndef BL_SLOT_H
+#define BL_SLOT_H
+
+#include <xc.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "bl_service.h"
+
+/**
+ * @ingroup bl_slot
+ * @def BL_SLOT_SIZE
+ * This is a macro for the size of each slot. The application is linked into the first one, from 0x3000.
+ */
+#define BL_SLOT_SIZE        (0xE800UL)
+/**
+ * @ingroup bl_slot
+ * @def BL_SLOT_B_ADDRESS
+ * This is a macro for the start address of the download slot.
+ */
+#define BL_SLOT_B_ADDRESS   (0x3000UL + BL_SLOT_SIZE)
+
+/**
+ * @ingroup bl_slot
+ * @brief Writes one page of the new image into the download slot.
+ * @param [in] offset - Offset of the page in the image, a multiple of @ref BL_SERVICE_PAGE_SIZE
+ * @param [in] *page - Page contents, as linked for 0x3000 + offset
+ * @return BL_SERVICE_OK or an error status
+ */
+uint8_t BL_SlotWrite(uint32_t offset, const uint8_t *page);
+
+/**
+ * @ingroup bl_slot
+ * @brief Checks the image in the download slot against the checksum in its last two bytes,
+ *        the same check the bootloader makes before it installs the slot.
+ * @param none
+ * @retval true - The download slot holds a complete image
+ * @retval false - The image is incomplete or damaged
+ */
+bool BL_SlotIsValid(void);
+
+/**
+ * @ingroup bl_slot
+ * @brief Checks the download slot and, if it is valid, resets into the bootloader to install it.
+ *        The application is down from the reset until the bootloader started the new image.
+ * @param none
+ * @retval false - The download slot is not valid; the function only returns in this case
+ */
+bool BL_SlotInstall(void);
+
+#endif // BL_SLOT_H
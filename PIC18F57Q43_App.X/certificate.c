@@ -3,9 +3,20 @@
 #include <xc.h>
 #endif
 
+#ifdef DIGEST_FOOTER
+// SHA256 configuration: hexmate puts the 32 byte digest of 3000-1FFDF here (BL_DIGEST_VERIFY_ENABLE)
+volatile const uint8_t
+#ifdef __XC8__
+__at(0x1FFE0)
+#endif
+digestFooter[32] __attribute__((used, section("digest_foot_address"))) = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+};
+#else
 volatile const uint32_t
 #ifdef __XC8__
 __at(0x1FFFC)
 #endif
 crcStart __attribute__((used, section("crc_foot_start_address"))) = 0xFFFFFFFF;
-
+#endif
@@ -32,6 +32,7 @@
  */
 #include "mcc_generated_files/system/system.h"
 #include "mcc_generated_files/timer/delay.h"
+#include "bl_break_entry.h"
 
 /*
     Main application
@@ -39,7 +40,10 @@
 
 int main(void)
 {
+    uint16_t ticks = 0U;
+
     SYSTEM_Initialize();
+    BL_BreakEntryInitialize();
 
     // If using interrupts in PIC18 High/Low Priority Mode you need to enable the Global High and Low Interrupts
     // If using interrupts in PIC Mid-Range Compatibility Mode you need to enable the Global Interrupts
@@ -54,7 +58,14 @@ int main(void)
 
     while (1)
     {
-        DELAY_milliseconds(500);
-        LED0_Toggle();
+        // A 1 ms loop keeps the break handoff latency low
+        BL_BreakEntryTasks();
+        DELAY_milliseconds(1);
+        ticks++;
+        if (ticks == 500U)
+        {
+            ticks = 0U;
+            LED0_Toggle();
+        }
     }
 }
\ No newline at end of file
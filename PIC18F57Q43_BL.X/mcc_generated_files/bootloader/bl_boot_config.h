@@ -39,9 +39,138 @@
 /**
  * @ingroup generic_bootloader_8bit
  * @def START_OF_APP
- * This is a macro for application start address.
+ * This is a macro for application start address; a multiple of the page size. The code-model-rom range of the
+ * bootloader project and the code offset of the application follow it.
  */
+#ifndef START_OF_APP
 #define START_OF_APP                (0x3000U)
+#endif
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_CMD_READ_FLASH_ENABLE
+ * This is a macro to include the READ_FLASH command (1) or leave it out (0). A left-out command is answered with
+ * ERROR_INVALID_COMMAND. READ_VERSION, ERASE_FLASH and RESET_DEVICE are always included, and WRITE_FLASH unless
+ * @ref BL_PLAINTEXT_FLASH_ENABLE is 0.
+ */
+#ifndef BL_CMD_READ_FLASH_ENABLE
+#define BL_CMD_READ_FLASH_ENABLE        (1U)
+#endif
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_CMD_READ_EE_DATA_ENABLE
+ * This is a macro to include the READ_EE_DATA command (1) or leave it out (0).
+ */
+#ifndef BL_CMD_READ_EE_DATA_ENABLE
+#define BL_CMD_READ_EE_DATA_ENABLE      (1U)
+#endif
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_CMD_WRITE_EE_DATA_ENABLE
+ * This is a macro to include the WRITE_EE_DATA command (1) or leave it out (0).
+ */
+#ifndef BL_CMD_WRITE_EE_DATA_ENABLE
+#define BL_CMD_WRITE_EE_DATA_ENABLE     (1U)
+#endif
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_CMD_READ_CONFIG_ENABLE
+ * This is a macro to include the READ_CONFIG command (1) or leave it out (0).
+ */
+#ifndef BL_CMD_READ_CONFIG_ENABLE
+#define BL_CMD_READ_CONFIG_ENABLE       (1U)
+#endif
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_CMD_WRITE_CONFIG_ENABLE
+ * This is a macro to include the WRITE_CONFIG command (1) or leave it out (0).
+ */
+#ifndef BL_CMD_WRITE_CONFIG_ENABLE
+#define BL_CMD_WRITE_CONFIG_ENABLE      (1U)
+#endif
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_CMD_CALC_CHECKSUM_ENABLE
+ * This is a macro to include the CALC_CHECKSUM command (1) or leave it out (0). The host verifies an update with it.
+ */
+#ifndef BL_CMD_CALC_CHECKSUM_ENABLE
+#define BL_CMD_CALC_CHECKSUM_ENABLE     (1U)
+#endif
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_CMD_BATCH_ENABLE
+ * This is a macro to include the BATCH command (1) or leave it out (0). It runs the write, erase, checksum and
+ * reset commands of one frame in a single round trip, and needs a frame-sized copy buffer in RAM.
+ */
+#ifndef BL_CMD_BATCH_ENABLE
+#define BL_CMD_BATCH_ENABLE             (0U)
+#endif
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_CMD_BLANK_CHECK_ENABLE
+ * This is a macro to include the BLANK_CHECK command (1) or leave it out (0).
+ */
+#ifndef BL_CMD_BLANK_CHECK_ENABLE
+#define BL_CMD_BLANK_CHECK_ENABLE       (0U)
+#endif
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_CMD_PATCH_ENABLE
+ * This is a macro to include the PATCH command (1) or leave it out (0).
+ */
+#ifndef BL_CMD_PATCH_ENABLE
+#define BL_CMD_PATCH_ENABLE             (0U)
+#endif
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_CMD_SECURE_WRITE_ENABLE
+ * This is a macro to include the SECURE_WRITE command (1) or leave it out (0). It programs whole pages sent
+ * encrypted and authenticated with AES-128-CCM under @ref BL_SECURE_KEY, and grows the frame buffer by the
+ * nonce and the tag.
+ */
+#ifndef BL_CMD_SECURE_WRITE_ENABLE
+#define BL_CMD_SECURE_WRITE_ENABLE      (0U)
+#endif
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_SECURE_KEY
+ * This is a macro for the 16 bytes of the SECURE_WRITE key, as an initializer list. There is no default: a build
+ * with @ref BL_CMD_SECURE_WRITE_ENABLE must define it, or define BL_SECURE_DEVELOPMENT_KEY to use the development
+ * key of the host tools (the FIPS-197 example key) for testing. The key is part of the bootloader image, so the
+ * boot block has to be code protected.
+ */
+#if defined(BL_SECURE_DEVELOPMENT_KEY) && !defined(BL_SECURE_KEY)
+#define BL_SECURE_KEY   {0x2BU, 0x7EU, 0x15U, 0x16U, 0x28U, 0xAEU, 0xD2U, 0xA6U, \
+                         0xABU, 0xF7U, 0x15U, 0x88U, 0x09U, 0xCFU, 0x4FU, 0x3CU}
+#endif
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_PLAINTEXT_FLASH_ENABLE
+ * This is a macro to keep the plaintext flash commands (1), or to leave out READ_FLASH, WRITE_FLASH and PATCH and
+ * limit CALC_CHECKSUM to the whole application area (0), so that the application can only be programmed with
+ * SECURE_WRITE and not be read back.
+ */
+#ifndef BL_PLAINTEXT_FLASH_ENABLE
+#define BL_PLAINTEXT_FLASH_ENABLE       (1U)
+#endif
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_CMD_DIGEST_ENABLE
+ * This is a macro to include the DIGEST command (1) or leave it out (0). It returns the SHA-256 digest of a
+ * flash range; with @ref BL_PLAINTEXT_FLASH_ENABLE 0, only of the whole application area.
+ */
+#ifndef BL_CMD_DIGEST_ENABLE
+#define BL_CMD_DIGEST_ENABLE            (0U)
+#endif
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_DIGEST_VERIFY_ENABLE
+ * This is a macro to verify the application at boot with the SHA-256 digest of the application area, compared
+ * with the 32 byte digest after @ref END_OF_APP (1), or with the 16-bit checksum (0). Hashing the whole area
+ * makes every reset slower; see the readme for the time.
+ */
+#ifndef BL_DIGEST_VERIFY_ENABLE
+#define BL_DIGEST_VERIFY_ENABLE         (0U)
+#endif
 /**
  * @ingroup generic_bootloader_8bit
  * @def PROGMEM_PAGE_SIZE_LOW_BYTE
@@ -58,15 +187,65 @@
 /**
  * @ingroup generic_bootloader_8bit
  * @def CHECKSUM_SIZE
- * This is a macro for checksum size.
+ * This is a macro for checksum size: the 16-bit checksum, or the SHA-256 digest with @ref BL_DIGEST_VERIFY_ENABLE.
  */
+#if (BL_DIGEST_VERIFY_ENABLE == 1U)
+#define CHECKSUM_SIZE      32U
+#else
 #define CHECKSUM_SIZE      2U
+#endif
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_SLOT_ENABLE
+ * This is a macro to split the application area into an execution slot at @ref START_OF_APP and a download slot
+ * at @ref BL_SLOT_B_ADDRESS, which the bootloader installs on request of the application (1),
+ * or to use the whole area for one image (0).
+ */
+#ifndef BL_SLOT_ENABLE
+#define BL_SLOT_ENABLE      (0U)
+#endif
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_SLOT_SIZE
+ * This is a macro for the size of each slot; a multiple of the page size, half of the application area at most.
+ */
+#define BL_SLOT_SIZE        (0xE800UL)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_SLOT_B_ADDRESS
+ * This is a macro for the start address of the download slot.
+ */
+#define BL_SLOT_B_ADDRESS   ((flash_address_t)(START_OF_APP + BL_SLOT_SIZE))
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_GOLDEN_ENABLE
+ * This is a macro to restore the application from the compressed golden image at @ref BL_GOLDEN_ADDRESS
+ * when it fails verification (1), or to wait for the host as before (0).
+ */
+#ifndef BL_GOLDEN_ENABLE
+#define BL_GOLDEN_ENABLE    (0U)
+#endif
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_GOLDEN_ADDRESS
+ * This is a macro for the start of the golden image region, which runs to the end of flash. Page aligned.
+ */
+#define BL_GOLDEN_ADDRESS   (0x18000UL)
 /**
  * @ingroup generic_bootloader_8bit
  * @def END_OF_APP
- * This is a macro for application end address.
+ * This is a macro for application end address. With @ref BL_SLOT_ENABLE, the application ends with the execution slot,
+ * and with @ref BL_GOLDEN_ENABLE below the golden image region. The two regions would overlap, so only one can be enabled.
  */
+#if (BL_SLOT_ENABLE == 1U) && (BL_GOLDEN_ENABLE == 1U)
+#error "BL_GOLDEN_ENABLE and BL_SLOT_ENABLE cannot be used together"
+#elif (BL_SLOT_ENABLE == 1U)
+#define END_OF_APP          ((flash_address_t)((START_OF_APP + BL_SLOT_SIZE - 1U) - CHECKSUM_SIZE))
+#elif (BL_GOLDEN_ENABLE == 1U)
+#define END_OF_APP          ((flash_address_t)((BL_GOLDEN_ADDRESS - 1U) - CHECKSUM_SIZE))
+#else
 #define END_OF_APP          ((flash_address_t)((PROGMEM_SIZE - 1U) - CHECKSUM_SIZE))
+#endif
 /**
  * @ingroup generic_bootloader_8bit
  * @def CHECKSUM_ADDRESS
@@ -79,5 +258,215 @@
  * This is a macro for checksum length.
  */
 #define CHECKSUM_LENGTH     (CHECKSUM_ADDRESS - START_OF_APP)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_TRACE_ENABLE
+ * This is a macro to include the protocol trace ring and the READ_TRACE command (1) or leave them out (0).
+ */
+#ifndef BL_TRACE_ENABLE
+#define BL_TRACE_ENABLE     (0U)
+#endif
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_TRACE_DEPTH
+ * This is a macro for the number of records held in the trace ring. Must be a power of two.
+ */
+#define BL_TRACE_DEPTH      (16U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_MULTIDROP_ENABLE
+ * This is a macro to accept node addressed and broadcast frames on a shared RS-485 bus (1)
+ * or to run the point-to-point protocol only (0).
+ */
+#ifndef BL_MULTIDROP_ENABLE
+#define BL_MULTIDROP_ENABLE (0U)
+#endif
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_COMPACT_REPLY_ENABLE
+ * This is a macro to include compact replies in the REPLY_MODE command (1) or leave them out (0). REPLY_MODE itself
+ * stays while @ref BL_SKIP_UNCHANGED_ENABLE or @ref BL_SKIP_BLANK_ENABLE needs it to select the reply counts. In compact mode a successful status
+ * reply is 2 bytes after the sync byte instead of 10. Left out with @ref BL_MULTIDROP_ENABLE, since the other nodes
+ * of the bus skip replies by their header.
+ */
+#ifndef BL_COMPACT_REPLY_ENABLE
+#define BL_COMPACT_REPLY_ENABLE     (0U)
+#endif
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_NODE_ADDRESS
+ * This is a macro for the node address used when the EEPROM cell at @ref BL_NODE_ADDRESS_EEPROM
+ * holds 0x00 or 0xFF. Valid addresses are 0x01 to 0xFE.
+ */
+#define BL_NODE_ADDRESS     (0x00U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_NODE_ADDRESS_EEPROM
+ * This is a macro for the EEPROM location holding the node address, so that all nodes can share one bootloader image.
+ */
+#define BL_NODE_ADDRESS_EEPROM  (0x3803FFU)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_TRANSPORT_SELECT
+ * This is a macro to select the transport backend: BL_TRANSPORT_UART (0) for UART1 with autobaud,
+ * or BL_TRANSPORT_SPI (1) for SPI1 in target mode with DMA.
+ */
+#ifndef BL_TRANSPORT_SELECT
+#define BL_TRANSPORT_SELECT (0U)
+#endif
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_EE_QUEUE_ENABLE
+ * This is a macro to queue the bytes of WRITE_EE_DATA frames and program them while the next frame is received.
+ * A WRITE_EE_DATA frame with DATALEN 0 waits for the queue to drain; all other commands drain it first.
+ */
+#ifndef BL_EE_QUEUE_ENABLE
+#define BL_EE_QUEUE_ENABLE  (0U)
+#endif
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_EE_QUEUE_SIZE
+ * This is a macro for the number of EEPROM bytes the queue holds; a power of two. A full frame fits, so the
+ * reply to a WRITE_EE_DATA frame is only held back while the bytes of the frame before it are still queued.
+ */
+#define BL_EE_QUEUE_SIZE    (256U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_EE_QUEUE_RUNS
+ * This is a macro for the number of runs the queue holds. A run is a range of consecutive bytes with one unlock key;
+ * the bytes of a frame form one run, so a new frame only waits for a free run while this many are queued.
+ */
+#define BL_EE_QUEUE_RUNS    (8U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_SKIP_UNCHANGED_ENABLE
+ * This is a macro to program only the EEPROM and configuration bytes that differ from the current content.
+ * WRITE_EE_DATA and WRITE_CONFIG replies then carry the number of bytes programmed and skipped after the status byte.
+ */
+#ifndef BL_SKIP_UNCHANGED_ENABLE
+#define BL_SKIP_UNCHANGED_ENABLE    (0U)
+#endif
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_SKIP_BLANK_ENABLE
+ * This is a macro to leave out the erase of flash pages that already read all 0xFF, in ERASE_FLASH and WRITE_FLASH.
+ * ERASE_FLASH replies then carry the number of pages erased and skipped after the status byte.
+ */
+#ifndef BL_SKIP_BLANK_ENABLE
+#define BL_SKIP_BLANK_ENABLE        (0U)
+#endif
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_ERASED_MAP_ENABLE
+ * This is a macro to keep a RAM bitmap of the application pages erased since the bootloader started, one bit per page.
+ * WRITE_FLASH then neither reads nor erases a page whose bit is set.
+ */
+#ifndef BL_ERASED_MAP_ENABLE
+#define BL_ERASED_MAP_ENABLE        (0U)
+#endif
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_LOG_ENABLE
+ * This is a macro to keep the bootloader metadata in a wear-leveled record log in EEPROM (1) or to leave the log out (0).
+ */
+#ifndef BL_LOG_ENABLE
+#define BL_LOG_ENABLE       (0U)
+#endif
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_LOG_START_ADDRESS
+ * This is a macro for the EEPROM address of the record log. The application must not use the two banks that start here.
+ */
+#define BL_LOG_START_ADDRESS    (0x380300U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_LOG_BANK_SIZE
+ * This is a macro for the size of each of the two log banks; a multiple of the 8 byte record size, 0xF8 at most.
+ * The default banks end below the node address cell.
+ */
+#ifndef BL_LOG_BANK_SIZE
+#define BL_LOG_BANK_SIZE    (0x78U)
+#endif
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_JOURNAL_ENABLE
+ * This is a macro to record the committed application pages in EEPROM and include the JOURNAL command (1),
+ * so that an interrupted update can be resumed, or to leave the journal out (0).
+ */
+#ifndef BL_JOURNAL_ENABLE
+#define BL_JOURNAL_ENABLE   (0U)
+#endif
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_JOURNAL_ADDRESS
+ * This is a macro for the EEPROM address of the page journal: a 4 byte image ID followed by one bit per application page.
+ */
+#define BL_JOURNAL_ADDRESS  (0x380280U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_ENTRY_REQUEST_ENABLE
+ * This is a macro to enter the bootloader when the application asks for it through the RAM or EEPROM handshake (1),
+ * or to rely on the entry pin and the image verification only (0).
+ */
+#ifndef BL_ENTRY_REQUEST_ENABLE
+#define BL_ENTRY_REQUEST_ENABLE (0U)
+#endif
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_ENTRY_REQUEST_RAM_ADDRESS
+ * This is a macro for the RAM address of the 32-bit entry request word. Neither the bootloader nor the application
+ * clears it at startup, so it survives a RESET instruction. Both projects place it at the same absolute address.
+ */
+#define BL_ENTRY_REQUEST_RAM_ADDRESS    (0x24FCU)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_ENTRY_REQUEST_EEPROM
+ * This is a macro for the EEPROM location of the entry request byte, which also survives a power loss.
+ */
+#define BL_ENTRY_REQUEST_EEPROM (0x3803FEU)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_SERVICE_ENABLE
+ * This is a macro to place the service table at @ref BL_SERVICE_TABLE_ADDRESS, so that the application can call
+ * the flash, checksum and EEPROM record routines of the bootloader (1), or to leave it out (0).
+ * Both projects must then split the RAM as described in the readme.
+ */
+#ifndef BL_SERVICE_ENABLE
+#define BL_SERVICE_ENABLE   (0U)
+#endif
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_SERVICE_TABLE_ADDRESS
+ * This is a macro for the flash address of the service table header; the entry point follows 8 bytes later.
+ * The last page of the boot block, so that the table does not move when the bootloader grows.
+ */
+#define BL_SERVICE_TABLE_ADDRESS    (START_OF_APP - 0x100U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_SERVICE_ARGS_ADDRESS
+ * This is a macro for the RAM address of the service parameter block, inside the RAM reserved for the bootloader.
+ */
+#define BL_SERVICE_ARGS_ADDRESS     (0x1C00U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_SLOT_STATE_EEPROM
+ * This is a macro for the EEPROM address of the 3 byte install state: the unlock key of the install request,
+ * then the state byte, which is only set while the download slot is copied into the execution slot.
+ */
+#define BL_SLOT_STATE_EEPROM        (0x3803FBU)
+
+#if (BL_SLOT_ENABLE == 1U) && (BL_ENTRY_REQUEST_ENABLE == 0U)
+#error "BL_SLOT_ENABLE needs BL_ENTRY_REQUEST_ENABLE, which reads the install request and calls BL_SlotInstall"
+#endif
+#if (BL_EE_QUEUE_ENABLE == 1U) && (BL_CMD_WRITE_EE_DATA_ENABLE == 0U)
+#error "BL_EE_QUEUE_ENABLE needs the WRITE_EE_DATA command (BL_CMD_WRITE_EE_DATA_ENABLE)"
+#endif
+#if (BL_CMD_SECURE_WRITE_ENABLE == 1U) && !defined(BL_SECURE_KEY)
+#error "BL_CMD_SECURE_WRITE_ENABLE needs the device key in BL_SECURE_KEY (or BL_SECURE_DEVELOPMENT_KEY for testing)"
+#endif
+#if (BL_PLAINTEXT_FLASH_ENABLE == 0U) && (BL_CMD_SECURE_WRITE_ENABLE == 0U)
+#error "BL_PLAINTEXT_FLASH_ENABLE 0 needs the SECURE_WRITE command (BL_CMD_SECURE_WRITE_ENABLE) to program the application"
+#endif
+
 #endif //BL_BOOT_CONFIG_H
 
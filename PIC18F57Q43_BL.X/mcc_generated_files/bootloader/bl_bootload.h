@@ -53,21 +53,24 @@
 /**
  * @ingroup generic_bootloader_8bit
  * @def NEW_RESET_VECTOR
- * This is a macro for new reset vercor.
+ * This is a macro for new reset vercor. It is jumped to from inline assembly, so it is set without the U suffix,
+ * together with @ref START_OF_APP.
  */
+#ifndef NEW_RESET_VECTOR
 #define  NEW_RESET_VECTOR            (0x3000)
+#endif
 /**
  * @ingroup generic_bootloader_8bit
  * @def NEW_INTERRUPT_VECTOR_HIGH
  * This is a macro for new high interrupt vector.
  */
-#define  NEW_INTERRUPT_VECTOR_HIGH   (0x3008)
+#define  NEW_INTERRUPT_VECTOR_HIGH   (NEW_RESET_VECTOR + 0x08)
 /**
  * @ingroup generic_bootloader_8bit
  * @def NEW_INTERRUPT_VECTOR_LOW
  * This is a macro for new low interrupt vector.
  */
-#define  NEW_INTERRUPT_VECTOR_LOW    (0x3018)
+#define  NEW_INTERRUPT_VECTOR_LOW    (NEW_RESET_VECTOR + 0x18)
 /**
  * @ingroup generic_bootloader_8bit
  * @def CONFIGURATION_BYTES_START
@@ -89,6 +92,16 @@
  * This is a macro for bootloader frame data size.
  */
 #define  BL_FRAME_DATA_SIZE           (PROGMEM_PAGE_SIZE)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_FRAME_BUFFER_SIZE
+ * This is a macro for the data size of the frame buffer: @ref BL_FRAME_DATA_SIZE, or a SECURE_WRITE frame.
+ */
+#if (BL_CMD_SECURE_WRITE_ENABLE == 1U)
+#define  BL_FRAME_BUFFER_SIZE         (BL_SECURE_FRAME_SIZE)
+#else
+#define  BL_FRAME_BUFFER_SIZE         (BL_FRAME_DATA_SIZE)
+#endif
 
 /**
  * @ingroup generic_bootloader_8bit
@@ -121,6 +134,26 @@
  * This is a macro to hold offset of bootloader header.
  */
 #define BL_HEADER                    (9U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_WRITE_COUNTS_SIZE
+ * This is a macro for the number of bytes after the status byte of a WRITE_EE_DATA or WRITE_CONFIG reply
+ * when BL_SKIP_UNCHANGED_ENABLE is set and BL_REPLY_COUNTS selected: bytes programmed and bytes skipped, 16 bits each.
+ */
+#define BL_WRITE_COUNTS_SIZE         (4U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_ERASE_COUNTS_SIZE
+ * This is a macro for the number of bytes after the status byte of an ERASE_FLASH reply
+ * when BL_SKIP_BLANK_ENABLE is set and BL_REPLY_COUNTS selected: pages erased and blank pages skipped, 16 bits each.
+ */
+#define BL_ERASE_COUNTS_SIZE         (4U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_ERASED_MAP_SIZE
+ * This is a macro for the size of the erased page bitmap of BL_ERASED_MAP_ENABLE: one bit per application page.
+ */
+#define BL_ERASED_MAP_SIZE           ((((PROGMEM_SIZE - START_OF_APP) / PROGMEM_PAGE_SIZE) + 7U) / 8U)
 /**
  * @ingroup generic_bootloader_8bit
  * @def DEVICE_ID_START_ADDRESS
@@ -176,7 +209,7 @@
  * @ingroup generic_bootloader_8bit
  * @def READ_VERSION
  * This macro holds the command to read the version.
- * RD_VER      0x00    Read Version Information.
+ * RD_VER      0x00    Read Version Information. With ADDR @ref BL_VERSION_CAPABILITIES the capability block follows.
  */
 #define READ_VERSION   (0x00U)
 /**
@@ -242,6 +275,228 @@
  * RESET       0x09    Reset Device and run application.
  */
 #define RESET_DEVICE   (0x09U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def READ_TRACE
+ * This macro holds the command to read the protocol trace ring.
+ * RD_TRACE    0x0A    Read Trace Records (cleared afterwards when DATALEN is non-zero).
+ */
+#define READ_TRACE     (0x0AU)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def POLL_STATUS
+ * This macro holds the command to read the result of the broadcast frames on a multi-drop bus.
+ * POLL        0x0B    Poll Broadcast Status (cleared afterwards when DATALEN is non-zero).
+ */
+#define POLL_STATUS    (0x0BU)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def JOURNAL
+ * This macro holds the command to read the page journal, or to start it for a new image.
+ * JOURNAL     0x0C    Read Page Journal (DATALEN 0), or start it for the image ID in DATA (DATALEN 4).
+ */
+#define JOURNAL        (0x0CU)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BATCH
+ * This macro holds the command to run several commands from one frame.
+ * BATCH       0x0D    Run the frames in DATA in order, up to the first one that fails.
+ * Each frame in DATA is a 9 byte header followed by its data, as on the wire without the sync byte.
+ */
+#define BATCH          (0x0DU)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_BATCH_REPLY_SIZE
+ * This macro holds the data size of the BATCH reply: status of the first frame that failed (COMMAND_SUCCESS if none),
+ * index of that frame (the number of frames if none failed) and the 16-bit result of the last CALC_CHECKSUM frame.
+ */
+#define BL_BATCH_REPLY_SIZE     (4U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def REPLY_MODE
+ * This macro holds the command to select the reply format of the commands that follow.
+ * REPLY_MODE  0x0E    Set Reply Mode to ADDR_L: BL_REPLY_FULL, or BL_REPLY_COMPACT and BL_REPLY_COUNTS or'ed.
+ * The reply carries the mode and the sequence number, which restarts at 0. A mode bit the build does not have
+ * is refused with ERROR_ADDRESS_OUT_OF_RANGE.
+ */
+#define REPLY_MODE     (0x0EU)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_REPLY_FULL
+ * This macro holds the reply mode in which every reply echoes the 9 byte header. It is the mode after reset.
+ */
+#define BL_REPLY_FULL           (0x00U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_REPLY_COMPACT
+ * This macro holds the reply mode in which a reply made of the header and COMMAND_SUCCESS is sent as
+ * [0x55 | BL_COMPACT_REPLY_FLAG + CMD | SEQUENCE]. Replies with an error or with data stay full.
+ * SEQUENCE counts the compact replies modulo 256, so that the host can tell when one was lost.
+ */
+#define BL_REPLY_COMPACT        (0x01U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_REPLY_COUNTS
+ * This macro holds the reply mode bit that appends the write counts (BL_SKIP_UNCHANGED_ENABLE) and the erase
+ * counts (BL_SKIP_BLANK_ENABLE) after the status byte. It is off after reset, so that hosts which expect a 10 byte status reply keep getting one.
+ */
+#define BL_REPLY_COUNTS         (0x02U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_COMPACT_REPLY_FLAG
+ * This macro holds the bit set in the command byte of a compact reply. Command codes stay below it.
+ */
+#define BL_COMPACT_REPLY_FLAG   (0x40U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_COMPACT_REPLY_SIZE
+ * This macro holds the size of a compact reply without the sync byte.
+ */
+#define BL_COMPACT_REPLY_SIZE   (2U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BLANK_CHECK
+ * This macro holds the command to find the erased pages of a flash range.
+ * BLANK_CHECK 0x0F    Blank Check DATALEN pages from ADDR. The reply holds the number of blank pages and a bitmap,
+ * one bit per page from ADDR, set when the page reads all 0xFF.
+ */
+#define BLANK_CHECK    (0x0FU)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def PATCH
+ * This macro holds the command to rebuild a flash page from the current flash content and a delta stream.
+ * PATCH 0x10    Patch the page at ADDR. DATA is a sequence of @ref BL_PATCH_COPY, @ref BL_PATCH_ADD and
+ * @ref BL_PATCH_RUN instructions that produce exactly one page; the page is then erased and programmed.
+ */
+#define PATCH          (0x10U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_PATCH_COPY
+ * This macro holds the PATCH instruction [0x00][LEN][ADDR_L][ADDR_H][ADDR_U]: LEN bytes of the flash from ADDR,
+ * which must lie in the application area. The page being patched still holds its old content.
+ * LEN 0 stands for 256 in every instruction.
+ */
+#define BL_PATCH_COPY           (0x00U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_PATCH_ADD
+ * This macro holds the PATCH instruction [0x01][LEN][LEN bytes]: the bytes that follow.
+ */
+#define BL_PATCH_ADD            (0x01U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_PATCH_RUN
+ * This macro holds the PATCH instruction [0x02][LEN][BYTE]: LEN times the byte that follows.
+ */
+#define BL_PATCH_RUN            (0x02U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def SECURE_WRITE
+ * This macro holds the command to program a page sent encrypted and authenticated.
+ * SECURE_WRITE 0x11   Decrypt and program the page at ADDR. DATA is [NONCE][CIPHERTEXT][TAG], DATALEN is
+ * @ref BL_SECURE_FRAME_SIZE. The page is AES-128-CCM encrypted with the 8 byte NONCE and the 3 byte ADDR
+ * (little-endian) as the CCM nonce, and an 8 byte TAG; it is only programmed if the tag matches.
+ */
+#define SECURE_WRITE   (0x11U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_SECURE_NONCE_SIZE
+ * This macro holds the size of the nonce the host chooses for an image; it must not be used with the same key twice.
+ */
+#define BL_SECURE_NONCE_SIZE    (8U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_SECURE_TAG_SIZE
+ * This macro holds the size of the CCM authentication tag.
+ */
+#define BL_SECURE_TAG_SIZE      (8U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_SECURE_FRAME_SIZE
+ * This macro holds the data size of a SECURE_WRITE frame.
+ */
+#define BL_SECURE_FRAME_SIZE    (BL_SECURE_NONCE_SIZE + PROGMEM_PAGE_SIZE + BL_SECURE_TAG_SIZE)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def DIGEST
+ * This macro holds the command to calculate the SHA-256 digest of a flash range.
+ * DIGEST 0x12   Digest of the DATALEN bytes from ADDR; bits 16 to 23 of the length are in KEY_L, as for
+ * CALC_CHECKSUM. The reply holds the status and the @ref BL_DIGEST_SIZE bytes of the digest.
+ */
+#define DIGEST         (0x12U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_DIGEST_SIZE
+ * This macro holds the size of a SHA-256 digest.
+ */
+#define BL_DIGEST_SIZE          (32U)
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_VERSION_CAPABILITIES
+ * This macro holds the READ_VERSION address that appends the capability block to the 16 version bytes.
+ * Bytes 4 and 5 of the version data give the version and size of that block. Bootloaders without the block
+ * return 0 there and ignore ADDR, so they answer this request with the 16 version bytes only.
+ */
+#define BL_VERSION_CAPABILITIES     (0x01U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_CAPABILITY_VERSION
+ * This macro holds the version of the capability block layout. Fields are only ever appended; a host reads the
+ * fields it knows and skips the rest of @ref BL_CAPABILITY_SIZE.
+ * Version 1, little endian:
+ * Offset  Size  Field
+ * 0       1     BL_CAPABILITY_VERSION
+ * 1       1     BL_CAPABILITY_SIZE
+ * 2       4     Commands: bit n set if command code n is built in
+ * 6       4     Features: BL_FEATURE_xxx bits
+ * 10      2     Largest DATALEN of a frame
+ * 12      1     Boot verification scheme: BL_VERIFY_xxx
+ * 13      1     Frames the host may send before it waits for the reply of the first one
+ * 14      2     Bytes the transport receives while the bootloader is busy programming
+ * 16      2     EEPROM write queue size, 0 without BL_EE_QUEUE_ENABLE
+ * 18      1     BL_TRANSPORT_SELECT
+ * 19      1     Reserved, 0
+ * 20      4     Lowest bit rate the transport locks on to, 0 if the host sets the clock
+ * 24      4     Highest bit rate the transport locks on to, 0 if the host sets the clock
+ * 28      4     START_OF_APP
+ */
+#define BL_CAPABILITY_VERSION       (0x01U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_CAPABILITY_SIZE
+ * This macro holds the size of the capability block in bytes.
+ */
+#define BL_CAPABILITY_SIZE          (32U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_FEATURE_EE_QUEUE
+ * This macro holds the feature bit of @ref BL_EE_QUEUE_ENABLE. The other bits follow the build options below.
+ */
+#define BL_FEATURE_EE_QUEUE         (0x00000001UL)
+#define BL_FEATURE_SKIP_UNCHANGED   (0x00000002UL)
+#define BL_FEATURE_LOG              (0x00000004UL)
+#define BL_FEATURE_ENTRY_REQUEST    (0x00000008UL)
+#define BL_FEATURE_SERVICE          (0x00000010UL)
+#define BL_FEATURE_SLOT             (0x00000020UL)
+#define BL_FEATURE_GOLDEN           (0x00000040UL)
+#define BL_FEATURE_MULTIDROP        (0x00000080UL)
+#define BL_FEATURE_COMPACT_REPLY    (0x00000100UL)
+#define BL_FEATURE_SKIP_BLANK       (0x00000200UL)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_VERIFY_CHECKSUM16
+ * This macro holds the boot verification scheme of the capability block: the 16-bit sum of little-endian words
+ * over the application area, compared with the word after @ref END_OF_APP, the same sum as CALC_CHECKSUM.
+ */
+#define BL_VERIFY_CHECKSUM16        (0x01U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_VERIFY_SHA256
+ * This macro holds the boot verification scheme of @ref BL_DIGEST_VERIFY_ENABLE: the SHA-256 digest of the
+ * application area, compared with the 32 bytes after @ref END_OF_APP, the same digest as DIGEST.
+ */
+#define BL_VERIFY_SHA256            (0x02U)
 
 /**
  * @ingroup generic_bootloader_8bit
@@ -263,9 +518,9 @@ typedef union
         uint8_t address_H; /**< Contains the high byte of target memory address */
         uint8_t address_U; /**< Contains the upper byte of target memory address */
         uint8_t address_E; /**< Contains the extended byte of target memory address */
-        uint8_t data[BL_FRAME_DATA_SIZE + 1U]; /**< Contains the actual data payload upto 255 bytes*/
+        uint8_t data[BL_FRAME_BUFFER_SIZE + 1U]; /**< Contains the actual data payload upto 255 bytes*/
     };
-    uint8_t buffer[BL_FRAME_DATA_SIZE + 1U + BL_HEADER]; /**< Buffer to store the protocol frame contents including the bootloader header */
+    uint8_t buffer[BL_FRAME_BUFFER_SIZE + 1U + BL_HEADER]; /**< Buffer to store the protocol frame contents including the bootloader header */
 } frame_t;
 
 
@@ -287,5 +542,14 @@ void BL_Initialize(void);
  * @retval false if a valid application is not present at @ref NEW_RESET_VECTOR
  */
 bool BL_bootVerify(void);
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @brief This API checks an image laid out like the application area, but starting at another address.
+ * @param [in] imageAddress - First address of the image, @ref START_OF_APP for the application itself
+ * @retval true if the checksum or digest of the image matches the one stored at its end
+ * @retval false if the image is damaged or missing
+ */
+bool BL_bootVerifyImage(flash_address_t imageAddress);
 #endif //BL_BOOTLOADER_H
 
@@ -37,6 +37,14 @@
 #include <stdbool.h>
 #include "../system/system.h"
 
+/**
+ * @ingroup generic_bootloader_8bit
+ * @brief This API claims the transport backend selected by @ref BL_TRANSPORT_SELECT. It is called once before the first frame.
+ * @param none
+ * @retval none
+ */
+void BL_CommunicationModuleOpen(void);
+
 /**
  * @ingroup generic_bootloader_8bit
  * @brief This API innitializes the communication for bootloader library.
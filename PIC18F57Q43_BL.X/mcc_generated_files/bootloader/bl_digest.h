@@ -0,0 +1,68 @@
+/**
+ *
+ * @file bl_digest.h
+ *
+ * @ingroup generic_bootloader_8bit
+ *
+ * @brief This file contains the API prototypes for the SHA-256 digest of a flash range, used by the DIGEST command
+ *        and by the boot verification of @ref BL_DIGEST_VERIFY_ENABLE.
+ *
+ *        The flash is read with TBLRD and a post-incremented table pointer straight into the message schedule,
+ *        64 bytes per block, instead of a FLASH_Read call per byte. The schedule is kept as a ring of 16 words,
+ *        and the rotations are split into byte moves and at most four single-bit shifts, since the 8-bit core
+ *        shifts a 32-bit value one bit at a time.
+ *
+ * @version BOOTLOADER Driver Version 3.0.0
+*/
+
+/*
+ [2023] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef BL_DIGEST_H
+#define BL_DIGEST_H
+
+#include <stdint.h>
+#include "bl_bootload.h"
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_DIGEST_INCLUDED
+ * This is a macro that is 1 when the DIGEST command or the digest boot verification is built in.
+ */
+#if (BL_CMD_DIGEST_ENABLE == 1U) || (BL_DIGEST_VERIFY_ENABLE == 1U)
+#define BL_DIGEST_INCLUDED      (1U)
+#else
+#define BL_DIGEST_INCLUDED      (0U)
+#endif
+
+#if (BL_DIGEST_INCLUDED == 1U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @brief This API calculates the SHA-256 digest of a flash range.
+ * @param [in] address - First address of the range
+ * @param [in] length - Number of bytes, up to the end of the flash
+ * @param [out] *digest - @ref BL_DIGEST_SIZE bytes, in the byte order of FIPS 180-4
+ * @retval none
+ */
+void BL_DigestFlash(flash_address_t address, uint32_t length, uint8_t *digest);
+#endif
+
+#endif //BL_DIGEST_H
@@ -0,0 +1,109 @@
+/**
+ *
+ * @file bl_ee_queue.h
+ *
+ * @ingroup generic_bootloader_8bit
+ *
+ * @brief This file contains the API prototypes for the EEPROM write queue, which programs EEPROM bytes
+ *        in the background while the next frame is received.
+ *
+ * @version BOOTLOADER Driver Version 3.0.0
+*/
+
+/*
+ [2023] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef BL_EE_QUEUE_H
+#define BL_EE_QUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "bl_bootload.h"
+
+#if (BL_EE_QUEUE_ENABLE == 1U)
+
+#if ((BL_EE_QUEUE_SIZE & (BL_EE_QUEUE_SIZE - 1U)) != 0U)
+#error "BL_EE_QUEUE_SIZE must be a power of two"
+#endif
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @brief This API empties the queue and clears its error record.
+ * @param none
+ * @retval none
+ */
+void BL_EEQueueInitialize(void);
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @brief This API queues one EEPROM byte write. It only blocks, servicing the queue, while the queue is full.
+ *        A byte that follows the newest run, with the same key, joins it; any other byte starts a run of its own.
+ * @param [in] address - EEPROM address of the byte
+ * @param [in] data - Byte to program
+ * @param [in] unlockKey - NVM unlock key of the frame the byte came with
+ * @param [in] counted - false for bytes the bootloader writes for itself, which are left out of @ref BL_EEQueueCountsGet
+ * @retval none
+ */
+void BL_EEQueueWrite(eeprom_address_t address, eeprom_data_t data, uint16_t unlockKey, bool counted);
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @brief This API checks the result of the write in progress once the NVM is idle, then starts the next queued write.
+ *        It returns at once and is called from every wait loop of the bootloader.
+ * @param none
+ * @retval none
+ */
+void BL_EEQueueService(void);
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @brief This API waits until every queued byte is programmed, so that the NVM is free for other operations.
+ * @param none
+ * @retval none
+ */
+void BL_EEQueueFlush(void);
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @brief This API returns whether a queued write failed since the last call, and clears that record.
+ *        The byte may have been queued by an earlier frame than the one being answered, so its address is returned too.
+ * @param [out] *address - EEPROM address of the first byte that failed; left alone if none failed
+ * @retval NVM_OK - All queued writes checked so far succeeded
+ * @retval NVM_ERROR - At least one queued write failed
+ */
+nvm_status_t BL_EEQueueStatusGet(eeprom_address_t *address);
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @brief This API returns how many queued bytes were programmed and how many were skipped as unchanged
+ *        since the last call, and restarts both counts.
+ * @param [out] *programmed - Number of bytes programmed
+ * @param [out] *skipped - Number of bytes that already held the queued value
+ * @retval none
+ */
+void BL_EEQueueCountsGet(uint16_t *programmed, uint16_t *skipped);
+
+#define BL_EE_QUEUE_SERVICE()       BL_EEQueueService()
+#else
+#define BL_EE_QUEUE_SERVICE()
+#endif
+
+#endif //BL_EE_QUEUE_H
@@ -0,0 +1,151 @@
+/**
+ *
+ * @file bl_entry_request.h
+ *
+ * @ingroup generic_bootloader_8bit
+ *
+ * @brief This file contains the API of the application-requested bootloader entry of the 8-bit Bootloader library.
+ *
+ * @version BOOTLOADER Driver Version 3.0.0
+*/
+
+/*
+ [2023] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef BL_ENTRY_REQUEST_H
+#define BL_ENTRY_REQUEST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "bl_bootload.h"
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_ENTRY_REQUEST_RAM_MAGIC
+ * This is a macro for the value the application stores at @ref BL_ENTRY_REQUEST_RAM_ADDRESS before it executes RESET().
+ */
+#define BL_ENTRY_REQUEST_RAM_MAGIC      (0x5AA5C33CUL)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_ENTRY_REQUEST_BREAK_MAGIC
+ * This is a macro for the RAM request value stored by the application when the host sent a break on UART1.
+ */
+#define BL_ENTRY_REQUEST_BREAK_MAGIC    (0xA55A3CC3UL)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_ENTRY_REQUEST_EEPROM_MAGIC
+ * This is a macro for the value the application stores at @ref BL_ENTRY_REQUEST_EEPROM for a request that
+ * must also survive a power loss.
+ */
+#define BL_ENTRY_REQUEST_EEPROM_MAGIC   (0xB1U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_ENTRY_REQUEST_INSTALL_MAGIC
+ * This is a macro for the upper 16 bits of the RAM request word that asks for the download slot to be installed.
+ * The lower 16 bits carry the NVM unlock key for the install.
+ */
+#define BL_ENTRY_REQUEST_INSTALL_MAGIC  (0x1A57U)
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_ENTRY_NONE
+ * This is a macro for the entry reason when the application is started.
+ */
+#define BL_ENTRY_NONE                   (0x00U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_ENTRY_PIN
+ * This is a macro for the entry reason when the entry pin was held.
+ */
+#define BL_ENTRY_PIN                    (0x01U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_ENTRY_INVALID_IMAGE
+ * This is a macro for the entry reason when the application image failed verification.
+ */
+#define BL_ENTRY_INVALID_IMAGE          (0x02U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_ENTRY_RAM_REQUEST
+ * This is a macro for the entry reason when the application requested entry through RAM.
+ */
+#define BL_ENTRY_RAM_REQUEST            (0x03U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_ENTRY_EEPROM_REQUEST
+ * This is a macro for the entry reason when the application requested entry through EEPROM.
+ */
+#define BL_ENTRY_EEPROM_REQUEST         (0x04U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_ENTRY_BREAK_REQUEST
+ * This is a macro for the entry reason when the application handed over after a break on UART1.
+ */
+#define BL_ENTRY_BREAK_REQUEST          (0x05U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_ENTRY_INSTALL_REQUEST
+ * This is a macro for the request reason when the application asked for the download slot to be installed.
+ * It does not keep the bootloader running by itself.
+ */
+#define BL_ENTRY_INSTALL_REQUEST        (0x06U)
+
+#if (BL_ENTRY_REQUEST_ENABLE == 1U)
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @brief This API checks for an entry request of the application. The RAM request is only honored after a
+ *        RESET instruction, since RAM is undefined after a power-on or brown-out reset, and it is consumed at once.
+ *        The EEPROM request stays set until @ref BL_EntryRequestRelease is called.
+ * @param none
+ * @retval BL_ENTRY_RAM_REQUEST - The application requested entry through RAM
+ * @retval BL_ENTRY_BREAK_REQUEST - The application requested entry through RAM after a UART break
+ * @retval BL_ENTRY_INSTALL_REQUEST - The application requested the install of the download slot through RAM
+ * @retval BL_ENTRY_EEPROM_REQUEST - The application requested entry through EEPROM
+ * @retval BL_ENTRY_NONE - No request is pending
+ */
+uint8_t BL_EntryRequestCheck(void);
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @brief This API returns the unlock key the application passed with its install request.
+ * @param none
+ * @retval The unlock key, valid after @ref BL_EntryRequestCheck returned @ref BL_ENTRY_INSTALL_REQUEST
+ */
+uint16_t BL_EntryRequestKeyGet(void);
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @brief This API clears a pending EEPROM request. It is called by the first command that changes the application,
+ *        so that a device which loses power before the host connects still comes back into the bootloader.
+ *        Only the first call after an EEPROM request writes anything.
+ * @pre The EEPROM write queue is drained.
+ * @param [in] unlockKey - NVM unlock key of the frame
+ * @retval none
+ */
+void BL_EntryRequestRelease(uint16_t unlockKey);
+
+#define BL_ENTRY_REQUEST_RELEASE(unlockKey)     BL_EntryRequestRelease(unlockKey)
+#else
+#define BL_ENTRY_REQUEST_RELEASE(unlockKey)
+#endif
+
+#endif //BL_ENTRY_REQUEST_H
@@ -0,0 +1,118 @@
+/**
+ *
+ * @file bl_golden.h
+ *
+ * @ingroup generic_bootloader_8bit
+ *
+ * @brief This file contains the API of the golden image restore of the 8-bit Bootloader library.
+ *        The golden image is a compressed copy of a known good application, built by bl_golden on the host
+ *        and stored at @ref BL_GOLDEN_ADDRESS. It is a 16 byte header followed by an LZSS stream:
+ *        a flag byte for each group of 8 items, bit set for a literal byte, clear for a 2 byte back-reference
+ *        with a 12-bit distance minus one in the upper bits and a 4-bit length minus three in the lower bits.
+ *        Length 18 is followed by one more byte that is added to it.
+ *
+ * @version BOOTLOADER Driver Version 3.0.0
+*/
+
+/*
+ [2023] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef BL_GOLDEN_H
+#define BL_GOLDEN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "bl_bootload.h"
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_GOLDEN_MAGIC
+ * This is a macro for the first two bytes of the golden image header.
+ */
+#define BL_GOLDEN_MAGIC             (0x601DU)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_GOLDEN_FORMAT
+ * This is a macro for the stream format byte of the header.
+ */
+#define BL_GOLDEN_FORMAT            (0x01U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_GOLDEN_HEADER_SIZE
+ * This is a macro for the size of the golden image header.
+ */
+#define BL_GOLDEN_HEADER_SIZE       (16U)
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_GOLDEN_RESTORED
+ * This is a macro for the restore result when the application area was rebuilt from the golden image.
+ */
+#define BL_GOLDEN_RESTORED          (0x01U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_GOLDEN_MISSING
+ * This is a macro for the restore result when there is no intact golden image; nothing was written.
+ */
+#define BL_GOLDEN_MISSING           (0x02U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_GOLDEN_FAILED
+ * This is a macro for the restore result when an NVM operation failed or the stream ended early.
+ */
+#define BL_GOLDEN_FAILED            (0x03U)
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @struct bl_golden_header_t
+ * @brief Structure of the golden image header, little-endian.
+ */
+typedef struct
+{
+    uint16_t magic; /**< @ref BL_GOLDEN_MAGIC */
+    uint8_t format; /**< @ref BL_GOLDEN_FORMAT */
+    uint8_t reserved; /**< 0xFF */
+    uint16_t unlockKey; /**< NVM unlock key used for the restore */
+    uint16_t streamSum; /**< 16-bit sum of the stream bytes */
+    uint32_t streamLength; /**< Number of stream bytes after the header */
+    uint32_t imageLength; /**< Number of bytes the stream expands to, from @ref START_OF_APP */
+} bl_golden_header_t;
+
+#if (BL_GOLDEN_ENABLE == 1U)
+
+#if (((BL_GOLDEN_ADDRESS % PROGMEM_PAGE_SIZE) != 0U) || (BL_GOLDEN_ADDRESS <= START_OF_APP) \
+    || ((BL_GOLDEN_ADDRESS + BL_GOLDEN_HEADER_SIZE) > PROGMEM_SIZE))
+#error "BL_GOLDEN_ADDRESS must be page aligned and inside the application area"
+#endif
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @brief This API rebuilds the application area below @ref BL_GOLDEN_ADDRESS from the golden image.
+ *        The header and the stream sum are checked first. Pages that already hold the restored contents
+ *        are not written. The golden image region itself is only read.
+ * @param none
+ * @retval BL_GOLDEN_xxx - Result of the restore
+ */
+uint8_t BL_GoldenRestore(void);
+
+#endif
+
+#endif
@@ -0,0 +1,126 @@
+/**
+ *
+ * @file bl_journal.h
+ *
+ * @ingroup generic_bootloader_8bit
+ *
+ * @brief This file contains the API prototypes for the page journal, which records in EEPROM which application
+ *        pages hold the data of the image being programmed, so that a host can resume an interrupted update.
+ *
+ *        The journal is a 4 byte image ID, given by the host, and one bit per application page. A bit is cleared
+ *        once a WRITE_FLASH frame has written the page up to its last byte, and set again when ERASE_FLASH
+ *        erases the page. Erasing also clears the image ID, so the bits only count for an image once the host
+ *        has started the journal for it after the erase.
+ *
+ * @version BOOTLOADER Driver Version 3.0.0
+*/
+
+/*
+ [2023] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef BL_JOURNAL_H
+#define BL_JOURNAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "bl_bootload.h"
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_JOURNAL_PAGES
+ * This is a macro for the number of application pages the journal covers, from @ref START_OF_APP.
+ */
+#define BL_JOURNAL_PAGES            ((uint16_t) ((PROGMEM_SIZE - START_OF_APP) / PROGMEM_PAGE_SIZE))
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_JOURNAL_ID_SIZE
+ * This is a macro for the size of the image ID.
+ */
+#define BL_JOURNAL_ID_SIZE          (4U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_JOURNAL_BITMAP_SIZE
+ * This is a macro for the size of the page bitmap. Bit n of byte m stands for page 8m + n.
+ */
+#define BL_JOURNAL_BITMAP_SIZE      ((BL_JOURNAL_PAGES + 7U) / 8U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_JOURNAL_NO_IMAGE
+ * This is a macro for the image ID of a journal that belongs to no image.
+ */
+#define BL_JOURNAL_NO_IMAGE         (0xFFFFFFFFU)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_JOURNAL_STATUS_SIZE
+ * This is a macro for the number of bytes after the status byte in a JOURNAL reply:
+ * ID_0 to ID_3, PAGES_L, PAGES_H and the bitmap.
+ */
+#define BL_JOURNAL_STATUS_SIZE      (BL_JOURNAL_ID_SIZE + 2U + BL_JOURNAL_BITMAP_SIZE)
+
+#if (BL_JOURNAL_ENABLE == 1U)
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @brief This API marks a page as committed. With the EEPROM write queue, the bitmap byte is programmed while
+ *        the next frame is received; otherwise the call blocks for the byte write. Only the first call for a page
+ *        since its erase writes anything.
+ * @pre The EEPROM write queue is drained.
+ * @param [in] pageAddress - Start address of the page
+ * @param [in] unlockKey - NVM unlock key of the WRITE_FLASH frame
+ * @retval none
+ */
+void BL_JournalPageCommitted(flash_address_t pageAddress, uint16_t unlockKey);
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @brief This API clears the image ID and marks the given pages as not committed. It is called before the pages
+ *        are erased, so that a reset during the erase cannot leave an erased page marked as committed.
+ * @pre The EEPROM write queue is drained.
+ * @param [in] pageAddress - Start address of the first page
+ * @param [in] pages - Number of pages
+ * @param [in] unlockKey - NVM unlock key of the ERASE_FLASH frame
+ * @retval NVM_OK - The journal was updated
+ * @retval NVM_ERROR - An EEPROM write failed
+ */
+nvm_status_t BL_JournalPagesErased(flash_address_t pageAddress, uint16_t pages, uint16_t unlockKey);
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @brief This API starts the journal for a new image: it marks every page as not committed, then writes the image ID.
+ * @pre The EEPROM write queue is drained.
+ * @param [in] imageId - Image ID chosen by the host; not @ref BL_JOURNAL_NO_IMAGE
+ * @param [in] unlockKey - NVM unlock key of the JOURNAL frame
+ * @retval NVM_OK - The journal was started
+ * @retval NVM_ERROR - An EEPROM write failed
+ */
+nvm_status_t BL_JournalBegin(uint32_t imageId, uint16_t unlockKey);
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @brief This API copies the image ID, the page count and the bitmap into a reply buffer.
+ * @pre The EEPROM write queue is drained.
+ * @param [out] *data - Buffer of at least @ref BL_JOURNAL_STATUS_SIZE bytes
+ * @return Number of bytes written to data
+ */
+uint16_t BL_JournalRead(uint8_t *data);
+#endif
+
+#endif //BL_JOURNAL_H
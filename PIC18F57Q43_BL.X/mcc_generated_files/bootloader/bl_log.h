@@ -0,0 +1,111 @@
+/**
+ *
+ * @file bl_log.h
+ *
+ * @ingroup generic_bootloader_8bit
+ *
+ * @brief This file contains the API prototypes for the record log, a wear-leveled key/value store
+ *        for bootloader metadata in a reserved EEPROM region.
+ *
+ *        The region holds two banks of 8 byte records. Slot 0 of a bank is its header and carries the bank epoch;
+ *        the bank with the newer valid header is active. Records are appended to the active bank, so a
+ *        rewritten value uses a fresh slot instead of wearing one cell. When the bank is full, the newest record
+ *        of each key is copied into the other bank, and the header written last switches over to it.
+ *
+ * @version BOOTLOADER Driver Version 3.0.0
+*/
+
+/*
+ [2023] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef BL_LOG_H
+#define BL_LOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "bl_bootload.h"
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_LOG_RECORD_SIZE
+ * This is a macro for the size of a record: key, 32-bit value, 16-bit sequence number and check byte.
+ */
+#define BL_LOG_RECORD_SIZE          (8U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_LOG_KEY_HEADER
+ * This is a macro for the key of the bank header record, whose value is the bank epoch.
+ */
+#define BL_LOG_KEY_HEADER           (0x00U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_LOG_KEY_FREE
+ * This is a macro for the key byte of an erased slot.
+ */
+#define BL_LOG_KEY_FREE             (0xFFU)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_LOG_KEY_UPDATE_GENERATION
+ * This is a macro for the key counting the application erases, that is, the updates started.
+ */
+#define BL_LOG_KEY_UPDATE_GENERATION    (0x01U)
+
+#if (BL_LOG_ENABLE == 1U)
+
+#if (((BL_LOG_BANK_SIZE % BL_LOG_RECORD_SIZE) != 0U) || (BL_LOG_BANK_SIZE < (2U * BL_LOG_RECORD_SIZE)) || (BL_LOG_BANK_SIZE > 0xF8U))
+#error "BL_LOG_BANK_SIZE must be a multiple of 8 between 0x10 and 0xF8"
+#endif
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @brief This API finds the active bank and, with a binary search over its slots, the first free slot.
+ *        It only reads the EEPROM; an empty or damaged log is formatted by the first write.
+ * @param none
+ * @retval none
+ */
+void BL_LogInitialize(void);
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @brief This API looks up the newest valid record of a key, scanning back from the end of the active bank.
+ * @param [in] key - Key to look up, 0x01 to 0xFE
+ * @param [out] *value - Value of the newest record of the key
+ * @retval true - The key was found
+ * @retval false - The log holds no valid record of the key
+ */
+bool BL_LogRead(uint8_t key, uint32_t *value);
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @brief This API appends a record, compacting the log into the other bank first if the active bank is full.
+ *        Nothing is written if the key already holds the value. The write blocks until the EEPROM is idle again.
+ * @pre The EEPROM write queue is drained.
+ * @param [in] key - Key to write, 0x01 to 0xFE
+ * @param [in] value - New value of the key
+ * @param [in] unlockKey - NVM unlock key of the frame that caused the write
+ * @retval NVM_OK - The record was written
+ * @retval NVM_ERROR - An EEPROM write failed, or the bank cannot hold one record of each key
+ */
+nvm_status_t BL_LogWrite(uint8_t key, uint32_t value, uint16_t unlockKey);
+
+#endif
+
+#endif //BL_LOG_H
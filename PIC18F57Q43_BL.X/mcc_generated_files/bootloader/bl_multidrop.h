@@ -0,0 +1,123 @@
+/**
+ *
+ * @file bl_multidrop.h
+ *
+ * @ingroup generic_bootloader_8bit
+ *
+ * @brief This file contains the API prototypes for node addressing on a multi-drop (RS-485) bus.
+ *
+ * @version BOOTLOADER Driver Version 3.0.0
+*/
+
+/*
+ [2023] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef BL_MULTIDROP_H
+#define BL_MULTIDROP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "bl_bootload.h"
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_NODE_LOCAL
+ * This is a macro for the ADDR_E value of an unaddressed frame. Every node executes it and
+ * replies in the point-to-point format, so it may only be used with a single node attached.
+ */
+#define BL_NODE_LOCAL               (0x00U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_NODE_BROADCAST
+ * This is a macro for the ADDR_E value of a broadcast frame. Every node executes it and none replies.
+ */
+#define BL_NODE_BROADCAST           (0xFFU)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_REPLY_FLAG
+ * This is a macro for the bit set in the command byte of a reply to an addressed frame.
+ * Such a reply carries its payload length in DATALEN so that the other nodes can skip it.
+ */
+#define BL_REPLY_FLAG               (0x80U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_MULTIDROP_STATUS_SIZE
+ * This is a macro for the number of bytes after the status byte in a POLL_STATUS reply.
+ */
+#define BL_MULTIDROP_STATUS_SIZE    (8U)
+
+#if (BL_MULTIDROP_ENABLE == 1U)
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @enum bl_route_t
+ * @brief This enumeration tells the frame loop how to handle a received frame.
+ */
+typedef enum
+{
+    BL_ROUTE_LOCAL, /**< Unaddressed frame: execute and reply as on a point-to-point link */
+    BL_ROUTE_NODE, /**< Frame addressed to this node: execute and send a tagged reply */
+    BL_ROUTE_BROADCAST, /**< Broadcast frame: execute, record the result and stay silent */
+    BL_ROUTE_NONE /**< Frame or reply of another node: drop it */
+} bl_route_t;
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @brief This API loads the node address and clears the broadcast status record.
+ * @param none
+ * @retval none
+ */
+void BL_MultidropInitialize(void);
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @brief This API decides from the ADDR_E byte and the command whether this node handles a frame.
+ * @param [in] *frame - Pointer to the received frame
+ * @retval Route of the frame
+ */
+bl_route_t BL_MultidropRoute(const frame_t *frame);
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @brief This API finishes a processed frame according to its route. Broadcast results are
+ *        folded into the status record and node replies are tagged with @ref BL_REPLY_FLAG.
+ * @param [in,out] *frame - Pointer to the processed frame
+ * @param [in] route - Route returned by @ref BL_MultidropRoute
+ * @param [in] length - Reply length returned by the command handler
+ * @retval Number of bytes to send back, 0 for a broadcast frame
+ */
+uint16_t BL_MultidropComplete(frame_t *frame, bl_route_t route, uint16_t length);
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @brief This API copies the broadcast status record into a POLL_STATUS reply payload.
+ * @param [out] *data - Pointer to the reply payload after the status byte
+ * @param [in] clear - Start a new record afterwards
+ * @retval Number of bytes written to data
+ */
+uint16_t BL_MultidropStatus(uint8_t *data, bool clear);
+
+#define BL_MULTIDROP_IS_REPLY(command)      (((command) & BL_REPLY_FLAG) != 0U)
+#else
+#define BL_MULTIDROP_IS_REPLY(command)      (false)
+#endif
+
+#endif //BL_MULTIDROP_H
@@ -0,0 +1,90 @@
+/**
+ *
+ * @file bl_secure.h
+ *
+ * @ingroup generic_bootloader_8bit
+ *
+ * @brief This file contains the API prototypes for the SECURE_WRITE decryption: AES-128 in CCM mode, one page per
+ *        frame, with an 8 byte tag.
+ *
+ *        The CCM nonce of a page is the 8 byte image nonce of the frame followed by the 3 byte page address, so the
+ *        host can reuse one image nonce for all pages of an image but a page cannot be moved to another address.
+ *        The plaintext is not bound to an image version: a page of an older image encrypted under the same key
+ *        is accepted at its own address.
+ *
+ *        The cipher is written for the 8-bit core, which has no AES hardware: byte-wide operations only, the
+ *        S-box as a RAM table (one indexed read per byte), the round keys expanded once, and the encryption
+ *        direction only, since CCM decrypts with the counter mode keystream.
+ *
+ * @version BOOTLOADER Driver Version 3.0.0
+*/
+
+/*
+ [2023] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef BL_SECURE_H
+#define BL_SECURE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "bl_bootload.h"
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_SECURE_BLOCK_SIZE
+ * This is a macro for the AES block size.
+ */
+#define BL_SECURE_BLOCK_SIZE        (16U)
+
+#if (BL_CMD_SECURE_WRITE_ENABLE == 1U)
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @brief This API copies the S-box into RAM and expands @ref BL_SECURE_KEY into the round keys.
+ * @param none
+ * @retval none
+ */
+void BL_SecureInitialize(void);
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @brief This API encrypts one block in place with the expanded key.
+ * @pre @ref BL_SecureInitialize was called.
+ * @param [in,out] *block - @ref BL_SECURE_BLOCK_SIZE bytes
+ * @retval none
+ */
+void BL_SecureBlockEncrypt(uint8_t *block);
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @brief This API decrypts the page of a SECURE_WRITE frame in place and checks its tag. The whole page is
+ *        decrypted and the tag compared in constant time, whatever the result.
+ * @pre @ref BL_SecureInitialize was called.
+ * @param [in,out] *data - Frame data of @ref BL_SECURE_FRAME_SIZE bytes; the ciphertext after the nonce is
+ *                 replaced by the plaintext
+ * @param [in] pageAddress - Address of the page, part of the CCM nonce
+ * @retval true - The tag matches and data holds the plaintext page after the nonce
+ * @retval false - The frame was not encrypted for this page and key; the page must not be programmed
+ */
+bool BL_SecurePageOpen(uint8_t *data, flash_address_t pageAddress);
+#endif
+
+#endif //BL_SECURE_H
@@ -0,0 +1,158 @@
+/**
+ *
+ * @file bl_service.h
+ *
+ * @ingroup generic_bootloader_8bit
+ *
+ * @brief This file contains the service table the 8-bit Bootloader library exports to the application.
+ *        The application fills the parameter block at @ref BL_SERVICE_ARGS_ADDRESS and calls the entry point
+ *        @ref BL_SERVICE_ENTRY_ADDRESS; the layout below is mirrored by bl_service.h of the application project.
+ *
+ * @version BOOTLOADER Driver Version 3.0.0
+*/
+
+/*
+ [2023] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef BL_SERVICE_H
+#define BL_SERVICE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "bl_bootload.h"
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_SERVICE_MAGIC
+ * This is a macro for the first two bytes of the service table header.
+ */
+#define BL_SERVICE_MAGIC            (0xB15EU)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_SERVICE_VERSION_MAJOR
+ * This is a macro for the major version of the service table; changed when a service or the parameter block
+ * changes incompatibly.
+ */
+#define BL_SERVICE_VERSION_MAJOR    (1U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_SERVICE_VERSION_MINOR
+ * This is a macro for the minor version of the service table; changed when services are appended.
+ */
+#define BL_SERVICE_VERSION_MINOR    (0U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_SERVICE_ENTRY_ADDRESS
+ * This is a macro for the flash address of the service entry point.
+ */
+#define BL_SERVICE_ENTRY_ADDRESS    (BL_SERVICE_TABLE_ADDRESS + 8U)
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_SERVICE_FLASH_READ
+ * This is a macro for the service that copies length bytes from the flash at address to buffer.
+ */
+#define BL_SERVICE_FLASH_READ       (0x00U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_SERVICE_FLASH_ERASE
+ * This is a macro for the service that erases the application page at address.
+ */
+#define BL_SERVICE_FLASH_ERASE      (0x01U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_SERVICE_FLASH_WRITE
+ * This is a macro for the service that erases the application page at address and writes the page from buffer.
+ */
+#define BL_SERVICE_FLASH_WRITE      (0x02U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_SERVICE_CHECKSUM
+ * This is a macro for the service that returns in value the 16-bit checksum of length bytes at address,
+ * calculated like the CALC_CHECKSUM command.
+ */
+#define BL_SERVICE_CHECKSUM         (0x03U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_SERVICE_RECORD_READ
+ * This is a macro for the service that returns in value the newest EEPROM log record of the key in address.
+ */
+#define BL_SERVICE_RECORD_READ      (0x04U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_SERVICE_RECORD_WRITE
+ * This is a macro for the service that appends value as an EEPROM log record of the key in address.
+ */
+#define BL_SERVICE_RECORD_WRITE     (0x05U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_SERVICE_COUNT
+ * This is a macro for the number of services in this version of the table.
+ */
+#define BL_SERVICE_COUNT            (0x06U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_SERVICE_RECORD_KEY_FIRST
+ * This is a macro for the first log key the application may write; the keys below belong to the bootloader.
+ */
+#define BL_SERVICE_RECORD_KEY_FIRST (0x80U)
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @struct bl_service_header_t
+ * @brief Structure of the service table header at @ref BL_SERVICE_TABLE_ADDRESS.
+ */
+typedef struct
+{
+    uint16_t magic; /**< @ref BL_SERVICE_MAGIC */
+    uint8_t versionMajor; /**< @ref BL_SERVICE_VERSION_MAJOR */
+    uint8_t versionMinor; /**< @ref BL_SERVICE_VERSION_MINOR */
+    uint8_t count; /**< @ref BL_SERVICE_COUNT */
+    uint8_t reserved[3]; /**< 0xFF */
+} bl_service_header_t;
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @struct bl_service_args_t
+ * @brief Structure of the parameter block at @ref BL_SERVICE_ARGS_ADDRESS.
+ *        XC8 passes parameters through a compiled stack that only the bootloader project knows, hence the fixed block.
+ */
+typedef struct
+{
+    uint8_t service; /**< BL_SERVICE_xxx to run */
+    uint8_t status; /**< COMMAND_SUCCESS, or the error code of the frame commands */
+    uint16_t unlockKey; /**< NVM unlock key of the services that write */
+    uint32_t address; /**< Flash address, or the log key */
+    uint16_t buffer; /**< RAM address of the data */
+    uint16_t length; /**< Number of bytes */
+    uint32_t value; /**< Checksum, or log record value */
+} bl_service_args_t;
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @brief This API runs the service selected in the parameter block. It is placed at @ref BL_SERVICE_ENTRY_ADDRESS
+ *        and only called by the application; the bootloader itself never calls it.
+ * @param none
+ * @retval none
+ */
+void BL_ServiceCall(void);
+
+#endif
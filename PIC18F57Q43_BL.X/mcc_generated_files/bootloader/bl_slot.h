@@ -0,0 +1,106 @@
+/**
+ *
+ * @file bl_slot.h
+ *
+ * @ingroup generic_bootloader_8bit
+ *
+ * @brief This file contains the API of the dual-slot install of the 8-bit Bootloader library.
+ *        The application downloads a new image into the slot at @ref BL_SLOT_B_ADDRESS while it runs,
+ *        and the bootloader copies it over the execution slot at the next reset.
+ *
+ * @version BOOTLOADER Driver Version 3.0.0
+*/
+
+/*
+ [2023] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef BL_SLOT_H
+#define BL_SLOT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "bl_bootload.h"
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_SLOT_STATE_INSTALLING
+ * This is a macro for the state byte while the download slot is copied; any other value means idle.
+ */
+#define BL_SLOT_STATE_INSTALLING    (0x5AU)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_SLOT_PAGES
+ * This is a macro for the number of pages in a slot.
+ */
+#define BL_SLOT_PAGES               ((uint16_t) (BL_SLOT_SIZE / PROGMEM_PAGE_SIZE))
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_SLOT_NONE
+ * This is a macro for the install result when no install was requested or pending.
+ */
+#define BL_SLOT_NONE                (0x00U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_SLOT_INSTALLED
+ * This is a macro for the install result when the download slot was copied and the execution slot verified.
+ */
+#define BL_SLOT_INSTALLED           (0x01U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_SLOT_REJECTED
+ * This is a macro for the install result when the download slot failed verification; nothing was copied.
+ */
+#define BL_SLOT_REJECTED            (0x02U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_SLOT_FAILED
+ * This is a macro for the install result when an NVM operation failed, or the copy did not verify.
+ */
+#define BL_SLOT_FAILED              (0x03U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_SLOT_RESUMED
+ * This is a macro for the install result when an install interrupted by a reset was completed.
+ */
+#define BL_SLOT_RESUMED             (0x04U)
+
+#if (BL_SLOT_ENABLE == 1U)
+
+#if (((BL_SLOT_SIZE % PROGMEM_PAGE_SIZE) != 0U) || ((START_OF_APP + (2U * BL_SLOT_SIZE)) > PROGMEM_SIZE))
+#error "BL_SLOT_SIZE must be a multiple of the page size and fit twice into the application area"
+#endif
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @brief This API installs the download slot when the application requested it, or finishes an install that
+ *        a reset interrupted. The download slot is verified first. Pages that already match are not written,
+ *        so an interrupted install resumes where it stopped. The state in EEPROM is cleared once the
+ *        install ends, also when it failed, so that the host can repair the execution slot in the bootloader.
+ * @param [in] requested - true if the application requested the install
+ * @param [in] unlockKey - NVM unlock key of the request
+ * @retval BL_SLOT_xxx - Result of the install
+ */
+uint8_t BL_SlotInstall(bool requested, uint16_t unlockKey);
+
+#endif
+
+#endif
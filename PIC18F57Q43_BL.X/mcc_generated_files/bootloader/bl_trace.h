@@ -0,0 +1,161 @@
+/**
+ *
+ * @file bl_trace.h
+ *
+ * @ingroup generic_bootloader_8bit
+ *
+ * @brief This file contains the API prototypes for the protocol trace ring of the 8-bit Bootloader library.
+ *
+ * @version BOOTLOADER Driver Version 3.0.0
+*/
+
+/*
+ [2023] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef BL_TRACE_H
+#define BL_TRACE_H
+
+#include <stdint.h>
+#include "bl_bootload.h"
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_TRACE_RECORD_SIZE
+ * This is a macro for the size in bytes of one trace record as sent to the host.
+ */
+#define BL_TRACE_RECORD_SIZE        (10U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_TRACE_REPLY_HEADER_SIZE
+ * This is a macro for the number of bytes in front of the records in a READ_TRACE reply.
+ */
+#define BL_TRACE_REPLY_HEADER_SIZE  (6U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_TRACE_EVENT_NVM_ERROR
+ * This is a macro for the command code of a record logged when an NVM operation fails.
+ */
+#define BL_TRACE_EVENT_NVM_ERROR    (0xE0U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_TRACE_EVENT_ENTRY
+ * This is a macro for the command code of the record logged once the bootloader is ready for frames.
+ * Its status is the entry reason and its timestamp the time taken since TMR0 was started.
+ */
+#define BL_TRACE_EVENT_ENTRY        (0xE1U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_TRACE_EVENT_INSTALL
+ * This is a macro for the command code of the record logged after the download slot was installed, or refused.
+ * Its status is the BL_SLOT_xxx result and its address the number of pages copied.
+ */
+#define BL_TRACE_EVENT_INSTALL      (0xE2U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_TRACE_EVENT_RESTORE
+ * This is a macro for the command code of the record logged after a restore from the golden image.
+ * Its status is the BL_GOLDEN_xxx result and its address the number of pages written.
+ */
+#define BL_TRACE_EVENT_RESTORE      (0xE3U)
+
+#if (BL_TRACE_ENABLE == 1U)
+
+#if ((BL_TRACE_DEPTH & (BL_TRACE_DEPTH - 1U)) != 0U)
+#error "BL_TRACE_DEPTH must be a power of two"
+#endif
+#if ((BL_TRACE_REPLY_HEADER_SIZE + (BL_TRACE_DEPTH * BL_TRACE_RECORD_SIZE)) > (BL_FRAME_DATA_SIZE + 1U))
+#error "BL_TRACE_DEPTH records do not fit in a single reply frame"
+#endif
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @struct bl_trace_record_t
+ * @brief This structure holds one entry of the trace ring.
+ * Record Format: [<TIME_L><TIME_H><COMMAND><STATUS><LEN_L><LEN_H><ADDR_L><ADDR_H><ADDR_U><TIME_U>]
+ * TIME_U extends the 16-bit TMR0 count, which wraps after about 1 s, by the wraps BL_TraceTick counted. It comes
+ * last, so that decoders of the 9 byte records read the other fields where they were.
+ */
+typedef struct
+{
+    uint16_t timestamp; /**< TMR0 count when the record was logged */
+    uint8_t command; /**< Command code of the frame, or a BL_TRACE_EVENT_xxx code */
+    uint8_t status; /**< First byte of the reply payload, or the nvm_status_t of an event */
+    uint16_t length; /**< Data length field of the frame */
+    uint8_t address_L; /**< Low byte of the target address */
+    uint8_t address_H; /**< High byte of the target address */
+    uint8_t address_U; /**< Upper byte of the target address */
+    uint8_t timestamp_U; /**< TMR0 wraps when the record was logged, modulo 256 */
+} bl_trace_record_t;
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @brief This API empties the trace ring.
+ * @param none
+ * @retval none
+ */
+void BL_TraceClear(void);
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @brief This API logs a processed frame. It must be called after the command handler
+ *        so that data[0] holds the result code.
+ * @param [in] *frame - Pointer to the processed frame
+ * @retval none
+ */
+void BL_TraceFrame(const frame_t *frame);
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @brief This API logs an event that is not tied to a received frame.
+ * @param [in] event - BL_TRACE_EVENT_xxx code
+ * @param [in] status - Event specific status byte
+ * @param [in] address - Memory address the event refers to
+ * @retval none
+ */
+void BL_TraceEvent(uint8_t event, uint8_t status, flash_address_t address);
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @brief This API counts a TMR0 wrap into the upper byte of the timestamps. It must run at least once a second,
+ *        so it is called while the transport waits and in the loops that erase or write many pages.
+ * @param none
+ * @retval none
+ */
+void BL_TraceTick(void);
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @brief This API copies the trace ring, oldest record first, into a reply payload.
+ * @param [out] *data - Pointer to the reply payload after the status byte
+ * @retval Number of bytes written to data
+ */
+uint16_t BL_TraceRead(uint8_t *data);
+
+#define BL_TRACE_FRAME(frame)                       BL_TraceFrame(frame)
+#define BL_TRACE_EVENT(event, status, address)      BL_TraceEvent((event), (status), (address))
+#define BL_TRACE_TICK()                             BL_TraceTick()
+#else
+#define BL_TRACE_FRAME(frame)
+#define BL_TRACE_EVENT(event, status, address)
+#define BL_TRACE_TICK()
+#endif
+
+#endif //BL_TRACE_H
@@ -0,0 +1,129 @@
+/**
+ *
+ * @file bl_transport.h
+ *
+ * @ingroup generic_bootloader_8bit
+ *
+ * @brief This file contains the transport backend interface used behind the communication interface of the 8-bit Bootloader library.
+ *
+ * @version BOOTLOADER Driver Version 3.0.0
+*/
+
+/*
+ [2023] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef BL_TRANSPORT_H
+#define BL_TRANSPORT_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "bl_boot_config.h"
+#include "bl_ee_queue.h"
+#include "bl_trace.h"
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_TRANSPORT_UART
+ * This is a macro to select the UART1 backend (autobaud on the 0x55 sync byte) in @ref BL_TRANSPORT_SELECT.
+ */
+#define BL_TRANSPORT_UART       (0U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_TRANSPORT_SPI
+ * This is a macro to select the SPI1 target mode backend with DMA in @ref BL_TRANSPORT_SELECT.
+ */
+#define BL_TRANSPORT_SPI        (1U)
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_TRANSPORT_IDLE
+ * This is a macro for the background work a backend runs while it waits for the host or the peripheral.
+ */
+#define BL_TRANSPORT_IDLE()     do { BL_EE_QUEUE_SERVICE(); BL_TRACE_TICK(); } while (0)
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @struct bl_transport_t
+ * @brief Structure containing the function pointers of a bootloader transport backend.
+ */
+typedef struct
+{
+    void (*Initialize)(void); /**< Claims the peripheral before the first frame; the bootloader only leaves through a device reset */
+    void (*FrameSync)(void); /**< Waits until the host starts the next frame */
+    void (*Read)(uint8_t *data, size_t dataLength); /**< Blocks until dataLength bytes were received */
+    void (*Write)(uint8_t *data, size_t dataLength); /**< Queues the STX byte and dataLength bytes of reply */
+    bool (*IsTxDone)(void); /**< Returns true once the whole reply has left the device */
+} bl_transport_t;
+
+#if (BL_TRANSPORT_SELECT == BL_TRANSPORT_UART)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @brief External object for the UART1 transport backend.
+ */
+extern const bl_transport_t BL_UART_TRANSPORT;
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_TRANSPORT_RX_DEPTH
+ * This is a macro for the bytes the backend holds while the bootloader is busy: the two-byte UART1 receive FIFO.
+ */
+#define BL_TRANSPORT_RX_DEPTH   (2U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_TRANSPORT_BAUD_MIN
+ * This is a macro for the lowest bit rate autobaud locks on to: FOSC / (4 * (BRG + 1)) at the largest 16-bit BRG.
+ */
+#define BL_TRANSPORT_BAUD_MIN   ((uint32_t) (_XTAL_FREQ / 262144UL) + 1UL)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_TRANSPORT_BAUD_MAX
+ * This is a macro for the highest bit rate autobaud measures to within 3 %: a BRG of 31 or more.
+ */
+#define BL_TRANSPORT_BAUD_MAX   ((uint32_t) (_XTAL_FREQ / 128UL))
+#endif
+
+#if (BL_TRANSPORT_SELECT == BL_TRANSPORT_SPI)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @brief External object for the SPI1 target mode transport backend.
+ */
+extern const bl_transport_t BL_SPI_TRANSPORT;
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_TRANSPORT_RX_DEPTH
+ * This is a macro for the bytes the backend holds while the bootloader is busy: the DMA receive ring.
+ */
+#define BL_TRANSPORT_RX_DEPTH   (256U)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_TRANSPORT_BAUD_MIN
+ * This is a macro for the lowest bit rate of the backend; 0 because the host drives SCK.
+ */
+#define BL_TRANSPORT_BAUD_MIN   (0UL)
+/**
+ * @ingroup generic_bootloader_8bit
+ * @def BL_TRANSPORT_BAUD_MAX
+ * This is a macro for the highest bit rate of the backend; 0 because the host drives SCK.
+ */
+#define BL_TRANSPORT_BAUD_MAX   (0UL)
+#endif
+
+#endif //BL_TRANSPORT_H
@@ -57,25 +57,120 @@
 #include <stdbool.h>
 #include "../bl_bootload.h"
 #include "../bl_communication_interface.h"
+#include "../bl_trace.h"
+#include "../bl_multidrop.h"
+#include "../bl_ee_queue.h"
+#include "../bl_log.h"
+#include "../bl_journal.h"
+#include "../bl_entry_request.h"
+#include "../bl_slot.h"
+#include "../bl_golden.h"
+#include "../bl_transport.h"
+#include "../bl_secure.h"
+#include "../bl_digest.h"
+
+#if (NEW_RESET_VECTOR != START_OF_APP)
+#error "NEW_RESET_VECTOR must be equal to START_OF_APP"
+#endif
+
+// Compact replies carry no header, so the other nodes of a multi-drop bus could not skip them
+#if (BL_COMPACT_REPLY_ENABLE == 1U) && (BL_MULTIDROP_ENABLE == 0U)
+#define BL_COMPACT_REPLY    (1U)
+#else
+#define BL_COMPACT_REPLY    (0U)
+#endif
+
+// REPLY_MODE selects compact replies and the counts appended to write and erase replies, where the build has them
+#define BL_REPLY_MODES      ( \
+    ((BL_COMPACT_REPLY == 1U) ? BL_REPLY_COMPACT : 0U) | \
+    (((BL_SKIP_UNCHANGED_ENABLE == 1U) || (BL_SKIP_BLANK_ENABLE == 1U)) ? BL_REPLY_COUNTS : 0U))
+
+// Without plaintext flash access the application is only programmed with SECURE_WRITE, and never read back
+#if (BL_PLAINTEXT_FLASH_ENABLE == 1U)
+#define BL_READ_FLASH_INCLUDED  (BL_CMD_READ_FLASH_ENABLE)
+#define BL_PATCH_INCLUDED       (BL_CMD_PATCH_ENABLE)
+#else
+#define BL_READ_FLASH_INCLUDED  (0U)
+#define BL_PATCH_INCLUDED       (0U)
+#endif
 
 //****************************************
 // Default Functions (Always Used)
-static uint8_t BL_GetVersionData(void);
+static uint16_t BL_GetVersionData(void);
+static uint8_t BL_PutCapability(uint8_t dataIndex, uint32_t value, uint8_t size);
 static void BL_RunBootloader(void);
 static bool BL_BootloadRequired(void);
 static void BL_CheckDeviceReset(void);
-static uint8_t BL_WriteFlash(void);
-static uint8_t BL_EraseFlash(void);
+#if (BL_PLAINTEXT_FLASH_ENABLE == 1U)
+static uint16_t BL_WriteFlash(void);
+#endif
+static uint16_t BL_EraseFlash(void);
+static uint16_t BL_ResetDevice(void);
 static uint16_t BL_ProcessBootBuffer(void);
+static uint16_t BL_CommandRun(uint8_t required);
+static uint8_t BL_FrameDecode(uint8_t checks);
 
 //****************************************
 // Conditional Functions
-static uint8_t BL_CalcChecksum(void);
+#if (BL_CMD_CALC_CHECKSUM_ENABLE == 1U)
+static uint16_t BL_CalcChecksum(void);
+#endif
+#if (BL_READ_FLASH_INCLUDED == 1U)
 static uint16_t BL_ReadFlash(void);
+#endif
+#if (BL_CMD_READ_CONFIG_ENABLE == 1U)
 static uint16_t BL_ReadConfig(void);
-static uint8_t BL_WriteConfig(void);
+#endif
+#if (BL_CMD_WRITE_CONFIG_ENABLE == 1U)
+static uint16_t BL_WriteConfig(void);
+#endif
+#if (BL_CMD_READ_EE_DATA_ENABLE == 1U)
 static uint16_t BL_ReadEEData(void);
-static uint8_t BL_WriteEEData(void);
+#endif
+#if (BL_CMD_WRITE_EE_DATA_ENABLE == 1U)
+static uint16_t BL_WriteEEData(void);
+static uint8_t BL_WriteEEError(eeprom_address_t address, uint16_t programmed, uint16_t skipped);
+#endif
+#if (BL_CMD_WRITE_EE_DATA_ENABLE == 1U) || (BL_CMD_WRITE_CONFIG_ENABLE == 1U)
+static uint8_t BL_WriteReply(uint8_t status, uint16_t programmed, uint16_t skipped);
+#endif
+#if (BL_TRACE_ENABLE == 1U)
+static uint16_t BL_ReadTrace(void);
+#endif
+#if (BL_MULTIDROP_ENABLE == 1U)
+static uint16_t BL_PollStatus(void);
+#endif
+#if (BL_JOURNAL_ENABLE == 1U)
+static uint16_t BL_Journal(void);
+#endif
+#if (BL_CMD_BATCH_ENABLE == 1U)
+static uint16_t BL_Batch(void);
+#endif
+#if (BL_REPLY_MODES != 0U)
+static uint16_t BL_ReplyMode(void);
+#endif
+#if (BL_COMPACT_REPLY == 1U)
+static uint16_t BL_CompactReply(uint16_t length);
+#endif
+#if (BL_SKIP_BLANK_ENABLE == 1U) || (BL_CMD_BLANK_CHECK_ENABLE == 1U)
+static bool BL_PageBlank(const flash_data_t *page);
+#endif
+#if (BL_CMD_BLANK_CHECK_ENABLE == 1U)
+static uint16_t BL_BlankCheck(void);
+#endif
+#if (BL_PATCH_INCLUDED == 1U)
+static uint16_t BL_Patch(void);
+#endif
+#if (BL_CMD_SECURE_WRITE_ENABLE == 1U)
+static uint16_t BL_SecureWrite(void);
+#endif
+#if (BL_CMD_DIGEST_ENABLE == 1U)
+static uint16_t BL_Digest(void);
+#endif
+#if (BL_ERASED_MAP_ENABLE == 1U)
+static bool BL_PageErased(flash_address_t pageAddress);
+static void BL_PageErasedSet(flash_address_t pageAddress, bool erased);
+#endif
 
 
 
@@ -87,12 +182,144 @@ static uint8_t BL_WriteEEData(void);
 // *****************************************************************************
 // *****************************************************************************
 static bool resetPending = false;
+static uint8_t entryReason = BL_ENTRY_NONE;
 
 // The data frame used for
 // holding the current data frame throughout
 // boot operation
 static frame_t frame;
 
+// Address and unlock key of the current frame, decoded once by BL_FrameDecode
+static flash_address_t frameAddress;
+static uint16_t frameKey;
+
+#if (BL_CMD_BATCH_ENABLE == 1U)
+// Data of the BATCH frame; each of its frames is copied back into the frame buffer to run
+static uint8_t batchBuffer[BL_FRAME_DATA_SIZE];
+#endif
+
+#if (BL_ERASED_MAP_ENABLE == 1U)
+// One bit per application page that holds only 0xFF: erased or found blank since the bootloader started, not written since
+static uint8_t erasedMap[BL_ERASED_MAP_SIZE];
+#endif
+
+#if (BL_REPLY_MODES != 0U)
+// Reply mode set by REPLY_MODE and the number of compact replies sent in it
+static uint8_t replyMode = BL_REPLY_FULL;
+static uint8_t replySequence = 0U;
+#endif
+
+// Checks BL_FrameDecode applies before a handler runs; the first one that fails is the reply status
+#define BL_CHECK_KEY        (0x01U) // Unlock key is UNLOCK_KEY, else COMMAND_PROCESSING_ERROR
+#define BL_CHECK_LENGTH     (0x02U) // DATALEN fits the data buffer, else COMMAND_OVERLOAD_ERROR
+#define BL_CHECK_APP        (0x04U) // Address is START_OF_APP or above, else ERROR_ADDRESS_OUT_OF_RANGE
+#define BL_CHECK_FLASH_END  (0x08U) // Address is below PROGMEM_SIZE, else ERROR_ADDRESS_OUT_OF_RANGE
+#define BL_CHECK_PAGE       (0x10U) // Address is on a page boundary, else ERROR_ADDRESS_OUT_OF_RANGE
+#define BL_CHECK_EEPROM     (0x20U) // Address is inside the EEPROM, else ERROR_ADDRESS_OUT_OF_RANGE
+// The command may be one of the frames of a BATCH; its reply data starts with its status, or it is CALC_CHECKSUM
+#define BL_BATCH_ALLOWED    (0x40U)
+// DATALEN bytes of data follow the header; kept for left-out commands so that the next header is still found
+#define BL_FRAME_HAS_DATA   (0x80U)
+
+typedef struct
+{
+    uint16_t (*handler)(void); // NULL for a left-out command
+    uint8_t flags;
+} bl_command_t;
+
+// Indexed by the command code; a missing entry leaves the command out
+static const bl_command_t commandTable[] = {
+    [READ_VERSION] = {&BL_GetVersionData, 0U},
+#if (BL_READ_FLASH_INCLUDED == 1U)
+    [READ_FLASH] = {&BL_ReadFlash, BL_CHECK_APP | BL_CHECK_FLASH_END | BL_CHECK_LENGTH},
+#endif
+#if (BL_PLAINTEXT_FLASH_ENABLE == 1U)
+    [WRITE_FLASH] = {&BL_WriteFlash, BL_CHECK_KEY | BL_CHECK_LENGTH | BL_CHECK_APP | BL_FRAME_HAS_DATA | BL_BATCH_ALLOWED},
+#else
+    [WRITE_FLASH] = {NULL, BL_FRAME_HAS_DATA},
+#endif
+    [ERASE_FLASH] = {&BL_EraseFlash, BL_CHECK_KEY | BL_CHECK_PAGE | BL_CHECK_APP | BL_BATCH_ALLOWED},
+#if (BL_CMD_READ_EE_DATA_ENABLE == 1U)
+    [READ_EE_DATA] = {&BL_ReadEEData, BL_CHECK_EEPROM | BL_CHECK_LENGTH},
+#endif
+#if (BL_CMD_WRITE_EE_DATA_ENABLE == 1U)
+    [WRITE_EE_DATA] = {&BL_WriteEEData, BL_CHECK_LENGTH | BL_CHECK_EEPROM | BL_FRAME_HAS_DATA | BL_BATCH_ALLOWED},
+#else
+    [WRITE_EE_DATA] = {NULL, BL_FRAME_HAS_DATA},
+#endif
+#if (BL_CMD_READ_CONFIG_ENABLE == 1U)
+    [READ_CONFIG] = {&BL_ReadConfig, BL_CHECK_APP | BL_CHECK_LENGTH},
+#endif
+#if (BL_CMD_WRITE_CONFIG_ENABLE == 1U)
+    [WRITE_CONFIG] = {&BL_WriteConfig, BL_CHECK_APP | BL_CHECK_LENGTH | BL_FRAME_HAS_DATA | BL_BATCH_ALLOWED},
+#else
+    [WRITE_CONFIG] = {NULL, BL_FRAME_HAS_DATA},
+#endif
+#if (BL_CMD_CALC_CHECKSUM_ENABLE == 1U)
+    [CALC_CHECKSUM] = {&BL_CalcChecksum, BL_CHECK_APP | BL_BATCH_ALLOWED},
+#endif
+    [RESET_DEVICE] = {&BL_ResetDevice, BL_BATCH_ALLOWED},
+#if (BL_TRACE_ENABLE == 1U)
+    [READ_TRACE] = {&BL_ReadTrace, 0U},
+#endif
+#if (BL_MULTIDROP_ENABLE == 1U)
+    [POLL_STATUS] = {&BL_PollStatus, 0U},
+#endif
+#if (BL_JOURNAL_ENABLE == 1U)
+    [JOURNAL] = {&BL_Journal, BL_FRAME_HAS_DATA},
+#else
+    [JOURNAL] = {NULL, BL_FRAME_HAS_DATA},
+#endif
+#if (BL_CMD_BATCH_ENABLE == 1U)
+    [BATCH] = {&BL_Batch, BL_CHECK_LENGTH | BL_FRAME_HAS_DATA},
+#else
+    [BATCH] = {NULL, BL_FRAME_HAS_DATA},
+#endif
+#if (BL_REPLY_MODES != 0U)
+    [REPLY_MODE] = {&BL_ReplyMode, 0U},
+#endif
+#if (BL_CMD_BLANK_CHECK_ENABLE == 1U)
+    [BLANK_CHECK] = {&BL_BlankCheck, BL_CHECK_APP | BL_CHECK_FLASH_END | BL_CHECK_PAGE},
+#endif
+#if (BL_PATCH_INCLUDED == 1U)
+    [PATCH] = {&BL_Patch, BL_CHECK_KEY | BL_CHECK_LENGTH | BL_CHECK_APP | BL_CHECK_FLASH_END | BL_CHECK_PAGE
+                | BL_FRAME_HAS_DATA | BL_BATCH_ALLOWED},
+#else
+    [PATCH] = {NULL, BL_FRAME_HAS_DATA},
+#endif
+#if (BL_CMD_SECURE_WRITE_ENABLE == 1U)
+    // A whole page and longer than BL_FRAME_DATA_SIZE, so the handler checks DATALEN itself; too long for BATCH
+    [SECURE_WRITE] = {&BL_SecureWrite, BL_CHECK_KEY | BL_CHECK_APP | BL_CHECK_FLASH_END | BL_CHECK_PAGE | BL_FRAME_HAS_DATA},
+#else
+    [SECURE_WRITE] = {NULL, BL_FRAME_HAS_DATA},
+#endif
+#if (BL_CMD_DIGEST_ENABLE == 1U)
+    // Any range of the application area; single-byte digests of the boot block would give it away
+    [DIGEST] = {&BL_Digest, BL_CHECK_APP | BL_CHECK_FLASH_END},
+#endif
+};
+
+#define BL_COMMAND_COUNT    (sizeof(commandTable) / sizeof(commandTable[0]))
+
+// Features bitmap of the capability block, fixed by the build options
+#define BL_FEATURES     ( \
+    ((BL_EE_QUEUE_ENABLE == 1U) ? BL_FEATURE_EE_QUEUE : 0UL) | \
+    ((BL_SKIP_UNCHANGED_ENABLE == 1U) ? BL_FEATURE_SKIP_UNCHANGED : 0UL) | \
+    ((BL_LOG_ENABLE == 1U) ? BL_FEATURE_LOG : 0UL) | \
+    ((BL_ENTRY_REQUEST_ENABLE == 1U) ? BL_FEATURE_ENTRY_REQUEST : 0UL) | \
+    ((BL_SERVICE_ENABLE == 1U) ? BL_FEATURE_SERVICE : 0UL) | \
+    ((BL_SLOT_ENABLE == 1U) ? BL_FEATURE_SLOT : 0UL) | \
+    ((BL_GOLDEN_ENABLE == 1U) ? BL_FEATURE_GOLDEN : 0UL) | \
+    ((BL_MULTIDROP_ENABLE == 1U) ? BL_FEATURE_MULTIDROP : 0UL) | \
+    ((BL_COMPACT_REPLY == 1U) ? BL_FEATURE_COMPACT_REPLY : 0UL) | \
+    ((BL_SKIP_BLANK_ENABLE == 1U) ? BL_FEATURE_SKIP_BLANK : 0UL))
+
+#if (BL_EE_QUEUE_ENABLE == 1U)
+#define BL_CAPABILITY_EE_QUEUE_SIZE     (BL_EE_QUEUE_SIZE)
+#else
+#define BL_CAPABILITY_EE_QUEUE_SIZE     (0U)
+#endif
+
 /*
  * @todo Documentation Needed
  */
@@ -108,6 +335,7 @@ void BL_Initialize(void)
         BL_INDICATOR_ON();
         BL_RunBootloader(); // generic comms layer
     }
+    TMR0_Deinitialize();
     STKPTR = 0x00U;
     BSR = 0x00U;
     BL_INDICATOR_OFF();
@@ -124,6 +352,23 @@ static bool BL_BootloadRequired(void)
      * Currently the bootloader checks an IO pin at programming time to force entry into bootloader.
     */  
 
+#if (BL_ENTRY_REQUEST_ENABLE == 1U)
+    // An application request skips the pin settle delay and the image verification
+    entryReason = BL_EntryRequestCheck();
+#if (BL_SLOT_ENABLE == 1U)
+    // Installs the download slot on request, and finishes an install that a reset interrupted
+    (void) BL_SlotInstall(entryReason == BL_ENTRY_INSTALL_REQUEST, BL_EntryRequestKeyGet());
+    if (entryReason == BL_ENTRY_INSTALL_REQUEST)
+    {
+        entryReason = BL_ENTRY_NONE;
+    }
+#endif
+    if (entryReason != BL_ENTRY_NONE)
+    {
+        return (true);
+    }
+#endif
+
     // #info  "You may need to add additional delay here between enabling weak pullups and testing the pin."
     for (uint8_t i = 0U; i != 0xFFU; i++)
     {
@@ -131,11 +376,21 @@ static bool BL_BootloadRequired(void)
     }
     if (IO_PIN_ENTRY_GetInputValue() == IO_PIN_ENTRY_RUN_BL)
     {
+            entryReason = BL_ENTRY_PIN;
             return (true);                
     }
     if (BL_bootVerify() == false)
     {
+        entryReason = BL_ENTRY_INVALID_IMAGE;
         status = true;
+#if (BL_GOLDEN_ENABLE == 1U)
+        // Rebuild the application from the golden image rather than wait for the host
+        if ((BL_GoldenRestore() == BL_GOLDEN_RESTORED) && (BL_bootVerify() == true))
+        {
+            entryReason = BL_ENTRY_NONE;
+            status = false;
+        }
+#endif
     }
     else
     {
@@ -153,54 +408,107 @@ static bool BL_BootloadRequired(void)
  */
 static uint16_t BL_ProcessBootBuffer(void)
 {
-    uint16_t len;
-    switch (frame.command)
-    {
-    case READ_VERSION:
-        len = BL_GetVersionData();
-        break;
-    case READ_FLASH:
-        len = BL_ReadFlash();
-        break;
-    case WRITE_FLASH:
-        len = BL_WriteFlash();
-        break;
-    case ERASE_FLASH:
-        len = BL_EraseFlash();
-        break;
-    case READ_EE_DATA:
-        len = BL_ReadEEData();
-        break;
-    case WRITE_EE_DATA:
-        len = BL_WriteEEData();
-        break;
-    case READ_CONFIG:
-        len = BL_ReadConfig();
-        break;
-    case WRITE_CONFIG:
-        len = BL_WriteConfig();
-        break;
-    case CALC_CHECKSUM:
-        len = BL_CalcChecksum();
-        break;
-    case RESET_DEVICE:
-            frame.data[0] = COMMAND_SUCCESS;
-        resetPending = true;
-        len = 10U;
-        break;
-    default:
-        frame.data[0] = ERROR_INVALID_COMMAND;
-        len = 10U;
-        break;
+    uint16_t len = BL_CommandRun(0U);
+
+    BL_TRACE_FRAME(&frame);
+    return (len);
+}
+
+/**
+ * @ingroup generic_bootloader_8bit
+ * @brief Runs the command of the frame buffer and leaves its reply there.
+ * @param [in] required - Flags the command table entry must have, else the reply is ERROR_INVALID_COMMAND
+ * @return Length of the reply including the 9 byte header
+ */
+static uint16_t BL_CommandRun(uint8_t required)
+{
+    uint16_t len = 10U;
+    uint8_t status = ERROR_INVALID_COMMAND;
+
+#if (BL_EE_QUEUE_ENABLE == 1U)
+    // Every other command may use the NVM, so queued EEPROM bytes are programmed first
+    if (frame.command != WRITE_EE_DATA)
+    {
+        BL_EEQueueFlush();
+    }
+#endif
+    if ((frame.command < BL_COMMAND_COUNT) && (commandTable[frame.command].handler != NULL)
+            && ((commandTable[frame.command].flags & required) == required))
+    {
+        status = BL_FrameDecode(commandTable[frame.command].flags);
+        if (status == COMMAND_SUCCESS)
+        {
+            len = commandTable[frame.command].handler();
+        }
+    }
+    if (status != COMMAND_SUCCESS)
+    {
+        frame.data[0] = status;
     }
     return (len);
 }
 
+/**
+ * @ingroup generic_bootloader_8bit
+ * @brief Decodes the address and unlock key of the frame into frameAddress and frameKey, and applies the given checks.
+ * @param [in] checks - BL_CHECK_xxx flags of the command
+ * @retval COMMAND_SUCCESS if the frame passed all checks, else the status for the reply
+ */
+static uint8_t BL_FrameDecode(uint8_t checks)
+{
+    uint8_t status = COMMAND_SUCCESS;
+
+    frameKey = (((uint16_t) frame.EE_key_2) << 8U) | (uint16_t) frame.EE_key_1;
+    frameAddress = (((flash_address_t) frame.address_U) << 16U)
+            | (((flash_address_t) frame.address_H) << 8U)
+            | (flash_address_t) frame.address_L;
+
+    if (((checks & BL_CHECK_KEY) != 0U) && (frameKey != UNLOCK_KEY))
+    {
+        status = COMMAND_PROCESSING_ERROR;
+    }
+    else if (((checks & BL_CHECK_LENGTH) != 0U) && (frame.data_length > BL_FRAME_DATA_SIZE))
+    {
+        status = COMMAND_OVERLOAD_ERROR;
+    }
+    else if ((((checks & BL_CHECK_APP) != 0U) && (frameAddress < (flash_address_t) START_OF_APP))
+            || (((checks & BL_CHECK_FLASH_END) != 0U) && (frameAddress >= (flash_address_t) PROGMEM_SIZE))
+            || (((checks & BL_CHECK_PAGE) != 0U) && (FLASH_PageOffsetGet(frameAddress) != 0U))
+            || (((checks & BL_CHECK_EEPROM) != 0U) && ((frameAddress < EEPROM_START_ADDRESS_U)
+                    || (frameAddress >= (EEPROM_START_ADDRESS_U + EEPROM_SIZE_U)))))
+    {
+        status = ERROR_ADDRESS_OUT_OF_RANGE;
+    }
+    else
+    {
+        // All checks passed
+    }
+
+    return status;
+}
+
 static void BL_RunBootloader(void)
 {
     uint16_t messageLength = 0U;
     uint16_t index = 0U;
     uint8_t ch;
+#if (BL_MULTIDROP_ENABLE == 1U)
+    bl_route_t route;
+
+    BL_MultidropInitialize();
+#endif
+
+#if (BL_EE_QUEUE_ENABLE == 1U)
+    BL_EEQueueInitialize();
+#endif
+#if (BL_LOG_ENABLE == 1U)
+    BL_LogInitialize();
+#endif
+#if (BL_CMD_SECURE_WRITE_ENABLE == 1U)
+    BL_SecureInitialize();
+#endif
+    BL_CommunicationModuleOpen();
+    BL_TRACE_EVENT(BL_TRACE_EVENT_ENTRY, entryReason, 0U);
 
     while (1)
     {
@@ -213,14 +521,17 @@ static void BL_RunBootloader(void)
         while (index < messageLength)
         {
             BL_CommunicationModuleRead(&ch, 1);
-            frame.buffer[index] = ch;
+            // Oversized frames are still consumed so that the next header is found
+            if (index < sizeof(frame.buffer))
+            {
+                frame.buffer[index] = ch;
+            }
 
             index++;
             if (index == 5U)
             {
-                if ((frame.command == WRITE_FLASH)
-                        || (frame.command == WRITE_EE_DATA)
-                        || (frame.command == WRITE_CONFIG))
+                if (((frame.command < BL_COMMAND_COUNT) && ((commandTable[frame.command].flags & BL_FRAME_HAS_DATA) != 0U))
+                        || (BL_MULTIDROP_IS_REPLY(frame.command)))
                 {
                     messageLength += frame.data_length;
                 }
@@ -231,7 +542,18 @@ static void BL_RunBootloader(void)
             }
         }
 
+#if (BL_MULTIDROP_ENABLE == 1U)
+        route = BL_MultidropRoute(&frame);
+        if (route == BL_ROUTE_NONE)
+        {
+            continue;
+        }
+        messageLength = BL_MultidropComplete(&frame, route, BL_ProcessBootBuffer());
+#elif (BL_COMPACT_REPLY == 1U)
+        messageLength = BL_CompactReply(BL_ProcessBootBuffer());
+#else
         messageLength = BL_ProcessBootBuffer();
+#endif
 
         if (messageLength > 0U)
         {
@@ -239,12 +561,19 @@ static void BL_RunBootloader(void)
 
             while (BL_CommunicationModuleIsReady() != true)
             {
-
+                BL_EE_QUEUE_SERVICE();
             }
         }
     }
 }
 
+static uint16_t BL_ResetDevice(void)
+{
+    frame.data[0] = COMMAND_SUCCESS;
+    resetPending = true;
+    return (10U);
+}
+
 static void BL_CheckDeviceReset(void)
 {
     if (resetPending == true)
@@ -260,9 +589,10 @@ static void BL_CheckDeviceReset(void)
 //        Cmd     Length----------------   Address---------------
 // In:   [|0x00 | 0x00 | 0x00 | 0x00 | 0x00 | 0x00 | 0x00 | 0x00 | 0x00|]
 // OUT:  [|0x00 | 0x00 | 0x00 | 0x00 | 0x00 | 0x00 | 0x00 | 0x00 | 0x00 | VERL | VERH|]
+// With ADDR BL_VERSION_CAPABILITIES the capability block follows the 16 version bytes
 // ******************************************************************************
 
-static uint8_t BL_GetVersionData(void)
+static uint16_t BL_GetVersionData(void)
 {
     uint8_t dataIndex = 0U;
     uint32_t maxPacketSize = 0U;
@@ -282,10 +612,10 @@ static uint8_t BL_GetVersionData(void)
     frame.data[dataIndex] = (uint8_t) ((maxPacketSize >> 8U) & 0xFFU);
     dataIndex++;
 
-    // Unused Bytes
-    frame.data[dataIndex] = 0U;
+    // Capability block version and size
+    frame.data[dataIndex] = BL_CAPABILITY_VERSION;
     dataIndex++;
-    frame.data[dataIndex] = 0U;
+    frame.data[dataIndex] = BL_CAPABILITY_SIZE;
     dataIndex++;
 
     // device id
@@ -312,44 +642,70 @@ static uint8_t BL_GetVersionData(void)
         dataIndex++;
     }
 
+    if (frameAddress == BL_VERSION_CAPABILITIES)
+    {
+        uint32_t commands = 0UL;
+
+        // Only commands with a handler in this build
+        for (uint8_t command = 0U; command < BL_COMMAND_COUNT; command++)
+        {
+            if (commandTable[command].handler != NULL)
+            {
+                commands |= (1UL << command);
+            }
+        }
+        dataIndex = BL_PutCapability(dataIndex, BL_CAPABILITY_VERSION, 1U);
+        dataIndex = BL_PutCapability(dataIndex, BL_CAPABILITY_SIZE, 1U);
+        dataIndex = BL_PutCapability(dataIndex, commands, 4U);
+        dataIndex = BL_PutCapability(dataIndex, BL_FEATURES, 4U);
+        dataIndex = BL_PutCapability(dataIndex, BL_FRAME_DATA_SIZE, 2U);
+        dataIndex = BL_PutCapability(dataIndex, (BL_DIGEST_VERIFY_ENABLE == 1U) ? BL_VERIFY_SHA256 : BL_VERIFY_CHECKSUM16, 1U);
+        // One frame at a time: the host waits for each reply
+        dataIndex = BL_PutCapability(dataIndex, 1U, 1U);
+        dataIndex = BL_PutCapability(dataIndex, BL_TRANSPORT_RX_DEPTH, 2U);
+        dataIndex = BL_PutCapability(dataIndex, BL_CAPABILITY_EE_QUEUE_SIZE, 2U);
+        dataIndex = BL_PutCapability(dataIndex, BL_TRANSPORT_SELECT, 1U);
+        dataIndex = BL_PutCapability(dataIndex, 0U, 1U);
+        dataIndex = BL_PutCapability(dataIndex, BL_TRANSPORT_BAUD_MIN, 4U);
+        dataIndex = BL_PutCapability(dataIndex, BL_TRANSPORT_BAUD_MAX, 4U);
+        dataIndex = BL_PutCapability(dataIndex, START_OF_APP, 4U);
+    }
+
     return (BL_HEADER + dataIndex); // total length to send back 9 byte header + payload
 }
 
+// Stores size bytes of value little endian at frame.data[dataIndex] and returns the index after them
+static uint8_t BL_PutCapability(uint8_t dataIndex, uint32_t value, uint8_t size)
+{
+    for (uint8_t i = 0U; i < size; i++)
+    {
+        frame.data[dataIndex] = (uint8_t) (value & 0xFFU);
+        value >>= 8U;
+        dataIndex++;
+    }
+    return dataIndex;
+}
+
 // *****************************************************************************
 // Read Flash
 //        Cmd     Length----------------   Address---------------  Data ---------
 // In:   [|0x01 | 0x00 | 0x00 | 0x00 | 0x00 | 0x00 | 0x00 | 0x00 | 0x00|]
 // OUT:  [|0x01 | 0x00 | 0x00 | 0x00 | 0x00 | 0x00 | 0x00 | 0x00 | 0x00 | Data |.. | data |]
 // *****************************************************************************
+#if (BL_READ_FLASH_INCLUDED == 1U)
 static uint16_t BL_ReadFlash(void)
 {
-    flash_address_t address;
+    flash_address_t address = frameAddress;
     uint16_t dataIndex;
 
-    address = (((flash_address_t) frame.address_U) << 16U)
-            | (((flash_address_t) frame.address_H) << 8U)
-            | (flash_address_t) frame.address_L;
-
     /*
      * Note: 
-     *      This block is used to prevent read access within the boot block and outside of the normal flash range. 
+     *      BL_CHECK_APP and BL_CHECK_FLASH_END in the command table prevent read access within the boot block and outside of the normal flash range. 
      *      This was done because it is considered a security risk to allow the host to read the code out of the bootloader. 
      *   
-     *      If you want to allow this type of read access in your system, you will need to delete this if block. And be warned that 
+     *      If you want to allow this type of read access in your system, you will need to remove these checks. And be warned that 
      *      a malicious host could read portions of the chips memory that should be considered private.
      */
-    if(!((address >= START_OF_APP) && (address < PROGMEM_SIZE)))
-    {
-        frame.data[0] = ERROR_ADDRESS_OUT_OF_RANGE;
-        return (10U);
-    }
-
-    // Prevent any read operation that exceeds the data buffer size
-    if( frame.data_length > BL_FRAME_DATA_SIZE )
-    {
-        frame.data[0] = COMMAND_OVERLOAD_ERROR;
-        return (10U);
-    }
 
     for (dataIndex = 0U; dataIndex < frame.data_length; dataIndex++)
     {
@@ -360,55 +716,52 @@ static uint16_t BL_ReadFlash(void)
 
     return (frame.data_length + 10U);
 }
+#endif
 
+#if (BL_PLAINTEXT_FLASH_ENABLE == 1U)
 // *****************************************************************************
 // Write Flash
 //        Cmd     Length----- Keys------   Address---------------  Data ---------
 // In:   [|0x02 | 0x00 | 0x00 | 0x55 | 0xAA | 0x00 | 0x00 | 0x00 | 0x00 | Data |.. | data |]
 // OUT:  [|0x02 | 0x00 | 0x00 | 0x00 | 0x00 | 0x00 | 0x00 | 0x00 | 0x00 | 0x01|]
 // *****************************************************************************
-static uint8_t BL_WriteFlash(void)
+static uint16_t BL_WriteFlash(void)
 {
     nvm_status_t errorStatus = NVM_OK;
-    flash_address_t userAddress;
+    flash_address_t userAddress = frameAddress;
     flash_address_t flashStartPageAddress;
     flash_address_t userDataStartOffset;
     flash_data_t writeBuffer[PROGMEM_PAGE_SIZE];
+    uint16_t unlockKey = frameKey;
+    bool pageBlank = false;
 
-    uint16_t unlockKey = (((uint16_t) frame.EE_key_2) << 8U) 
-                        | (uint16_t) frame.EE_key_1;
-
-    if(unlockKey != UNLOCK_KEY)
-    {
-        frame.data[0] = COMMAND_PROCESSING_ERROR;
-        return (10U);
-    }
-
-    userAddress = (((flash_address_t) frame.address_U) << 16U)
-            | (((flash_address_t) frame.address_H) << 8U)
-            | (flash_address_t) frame.address_L;
-
-    // Prevent any write operation that exceeds the data buffer size
-    if( frame.data_length > BL_FRAME_DATA_SIZE )
-    {
-        frame.data[0] = COMMAND_OVERLOAD_ERROR;
-        return (10U);
-    }
-
-    if (userAddress < NEW_RESET_VECTOR)
-    {
-        frame.data[0] = ERROR_ADDRESS_OUT_OF_RANGE;
-        return (10U);
-    }
+    BL_ENTRY_REQUEST_RELEASE(unlockKey);
 
     // get that start of the page and the user data start address
     flashStartPageAddress = FLASH_PageAddressGet(userAddress);
     userDataStartOffset = FLASH_PageOffsetGet(userAddress);
 
-    // read the whole page that contains the address
-    for (uint16_t offset = 0U; offset < BL_FRAME_DATA_SIZE; offset++)
+#if (BL_ERASED_MAP_ENABLE == 1U)
+    // A page erased in this session needs neither the page read nor a second erase
+    pageBlank = BL_PageErased(flashStartPageAddress);
+    // Cleared before the write, so that a failed write leaves the page unknown
+    BL_PageErasedSet(flashStartPageAddress, false);
+#endif
+    if (pageBlank == false)
+    {
+        // read the whole page that contains the address with one NVM page read
+        (void) FLASH_RowRead(flashStartPageAddress, writeBuffer);
+#if (BL_SKIP_BLANK_ENABLE == 1U)
+        // A page erased before, usually by ERASE_FLASH, is written without a second erase
+        pageBlank = BL_PageBlank(writeBuffer);
+#endif
+    }
+    else
     {
-        writeBuffer[offset] = FLASH_Read(flashStartPageAddress + offset);
+        for (uint16_t offset = 0U; offset < PROGMEM_PAGE_SIZE; offset++)
+        {
+            writeBuffer[offset] = 0xFFU;
+        }
     }
 
     for (uint16_t userByte = 0U; userByte < frame.data_length; userByte++)
@@ -416,21 +769,40 @@ static uint8_t BL_WriteFlash(void)
         writeBuffer[userDataStartOffset + userByte] = frame.data[userByte];
     }
     // ***** perform write action *****
-    NVM_UnlockKeySet(unlockKey);
-    errorStatus = FLASH_PageErase(flashStartPageAddress);
-    NVM_UnlockKeyClear();
+    if (pageBlank == false)
+    {
+        NVM_UnlockKeySet(unlockKey);
+        errorStatus = FLASH_PageErase(flashStartPageAddress);
+        NVM_UnlockKeyClear();
+    }
     if (errorStatus == NVM_OK)
     {
         NVM_UnlockKeySet(unlockKey);
         errorStatus = FLASH_RowWrite(flashStartPageAddress, writeBuffer);
         NVM_UnlockKeyClear();
     }
+    if (errorStatus != NVM_OK)
+    {
+        BL_TRACE_EVENT(BL_TRACE_EVENT_NVM_ERROR, (uint8_t) errorStatus, flashStartPageAddress);
+    }
+#if (BL_JOURNAL_ENABLE == 1U)
+    // Frames are written in address order, so a page is complete once a frame reaches its end
+    else if ((userDataStartOffset + frame.data_length) == PROGMEM_PAGE_SIZE)
+    {
+        BL_JournalPageCommitted(flashStartPageAddress, unlockKey);
+    }
+    else
+    {
+        // The rest of the page is still to come
+    }
+#endif
 
     frame.data[0] = (errorStatus == NVM_OK) ? COMMAND_SUCCESS : COMMAND_PROCESSING_ERROR;
 
     NVM_StatusClear();
     return (10U);
 }
+#endif
 
 
 /************************************************************************************************
@@ -438,63 +810,110 @@ static uint8_t BL_WriteFlash(void)
  *        Cmd--- Length----- Keys------- Address------------------------- Data ------------------
  * In:   [|0x03 | DATALEN_L | DATALEN_L | 0x55 | 0xAA | ADDR_L | ADDR_H | ADDR_U | ADDR_E|]
  * OUT:  [|0x03 | DATALEN_L | DATALEN_L | KEY_L | KEY_H | ADDR_L | ADDR_H | ADDR_U | ADDR_E | CMD_STATUS|]
+ * With BL_SKIP_BLANK_ENABLE, blank pages are not erased, and once the host selected BL_REPLY_COUNTS
+ * the reply ends with [| ERASED_L | ERASED_H | SKIPPED_L | SKIPPED_H |]
  ************************************************************************************************
  */
-static uint8_t BL_EraseFlash(void)
+static uint16_t BL_EraseFlash(void)
 {
     nvm_status_t errorStatus = NVM_OK;
-    flash_address_t address;
-
-    uint16_t unlockKey;
-    unlockKey = (((uint16_t) frame.EE_key_2) << 8U)
-            | (uint16_t) frame.EE_key_1;
-    address = ((((flash_address_t) frame.address_U) << 16U)
-            | (((flash_address_t) frame.address_H) << 8U)
-            | (flash_address_t) frame.address_L);
+    flash_address_t address = frameAddress;
+    uint16_t unlockKey = frameKey;
+#if (BL_SKIP_BLANK_ENABLE == 1U)
+    flash_data_t pageBuffer[PROGMEM_PAGE_SIZE];
+    uint16_t erased = 0U;
+    uint16_t skipped = 0U;
+#endif
 
-    // Fail if the given unlock key is incorrect
-    if (unlockKey != UNLOCK_KEY)
-    {
-        frame.data[0] = COMMAND_PROCESSING_ERROR;
-        NVM_StatusClear();
-        return (10U);
-    }
+    BL_ENTRY_REQUEST_RELEASE(unlockKey);
 
-    // Fail if the given address is not on a page boundry
-    if (FLASH_PageOffsetGet(address) > (flash_address_t) 0U)
-    {
-        frame.data[0] = ERROR_ADDRESS_OUT_OF_RANGE;
-        NVM_StatusClear();
-        return (10U);
-    }
+#if (BL_LOG_ENABLE == 1U)
+    flash_address_t eraseStart = address;
+#endif
 
-    // Fail if the given address is inside the boot space
-    if (address < (flash_address_t) NEW_RESET_VECTOR)
+#if (BL_JOURNAL_ENABLE == 1U)
+    errorStatus = BL_JournalPagesErased(address, frame.data_length, unlockKey);
+    if (errorStatus != NVM_OK)
     {
-        frame.data[0] = ERROR_ADDRESS_OUT_OF_RANGE;
-        NVM_StatusClear();
+        frame.data[0] = COMMAND_PROCESSING_ERROR;
         return (10U);
     }
+#endif
 
     for (uint16_t i = 0U; i < frame.data_length; i++)
     {
-        NVM_UnlockKeySet(unlockKey);
-        errorStatus = FLASH_PageErase(address);
-        NVM_UnlockKeyClear();
+        bool pageBlank = false;
 
-        address += PROGMEM_PAGE_SIZE;
+#if (BL_ERASED_MAP_ENABLE == 1U)
+        pageBlank = BL_PageErased(address);
+#endif
+#if (BL_SKIP_BLANK_ENABLE == 1U)
+        if (pageBlank == false)
+        {
+            // A page read and scan takes a fraction of the page erase time
+            (void) FLASH_RowRead(address, pageBuffer);
+            pageBlank = BL_PageBlank(pageBuffer);
+        }
+#endif
+        if (pageBlank == false)
+        {
+            NVM_UnlockKeySet(unlockKey);
+            errorStatus = FLASH_PageErase(address);
+            NVM_UnlockKeyClear();
 
-        if (errorStatus == NVM_ERROR)
+            if (errorStatus == NVM_ERROR)
+            {
+                BL_TRACE_EVENT(BL_TRACE_EVENT_NVM_ERROR, (uint8_t) errorStatus, address);
+                break;
+            }
+        }
+#if (BL_ERASED_MAP_ENABLE == 1U)
+        BL_PageErasedSet(address, true);
+#endif
+#if (BL_SKIP_BLANK_ENABLE == 1U)
+        if (pageBlank == true)
         {
-            break;
+            skipped++;
+        }
+        else
+        {
+            erased++;
         }
+#endif
+
+        address += PROGMEM_PAGE_SIZE;
+        BL_TRACE_TICK();
+    }
+
+#if (BL_LOG_ENABLE == 1U)
+    // An erase from the start of the application begins an update
+    if ((errorStatus == NVM_OK) && (frame.data_length > 0U) && (eraseStart == (flash_address_t) START_OF_APP))
+    {
+        uint32_t generation = 0U;
+
+        (void) BL_LogRead(BL_LOG_KEY_UPDATE_GENERATION, &generation);
+        errorStatus = BL_LogWrite(BL_LOG_KEY_UPDATE_GENERATION, generation + 1U, unlockKey);
     }
+#endif
 
     frame.data[0] = (errorStatus == NVM_OK) ? COMMAND_SUCCESS : COMMAND_PROCESSING_ERROR;
     NVM_StatusClear();
+#if (BL_SKIP_BLANK_ENABLE == 1U)
+    if ((replyMode & BL_REPLY_COUNTS) == 0U)
+    {
+        return (10U);
+    }
+    frame.data[1] = (uint8_t) erased;
+    frame.data[2] = (uint8_t) (erased >> 8U);
+    frame.data[3] = (uint8_t) skipped;
+    frame.data[4] = (uint8_t) (skipped >> 8U);
+    return (BL_HEADER + 1U + BL_ERASE_COUNTS_SIZE);
+#else
     return (10U);
+#endif
 }
 
+#if (BL_CMD_READ_EE_DATA_ENABLE == 1U)
 /** 
  * @todo Finish the API comments here
  * @example
@@ -507,22 +926,7 @@ static uint8_t BL_EraseFlash(void)
  */
 static uint16_t BL_ReadEEData(void)
 {
-    eeprom_address_t address;
-    address = (((eeprom_address_t) frame.address_U) << 16U)
-            | (((eeprom_address_t) frame.address_H) << 8U)
-            | (eeprom_address_t) frame.address_L;
-
-    if(!((address >= EEPROM_START_ADDRESS_U) && (address < (EEPROM_START_ADDRESS_U + EEPROM_SIZE_U))))
-    {
-        frame.data[0] = ERROR_ADDRESS_OUT_OF_RANGE;
-        return 10U;
-    }
-
-    // Prevent any read operation that exceeds the data buffer size
-    if( frame.data_length > BL_FRAME_DATA_SIZE ) {
-        frame.data[0] = COMMAND_OVERLOAD_ERROR;
-        return (10U);
-    }
+    eeprom_address_t address = (eeprom_address_t) frameAddress;
 
     for (uint16_t i = 0U; i < frame.data_length; i++)
     {
@@ -532,7 +936,9 @@ static uint16_t BL_ReadEEData(void)
     frame.data[0] = (NVM_StatusGet() == NVM_OK) ? COMMAND_SUCCESS : COMMAND_PROCESSING_ERROR;
     return (frame.data_length + 10U);
 }
+#endif
 
+#if (BL_CMD_WRITE_EE_DATA_ENABLE == 1U)
 /** 
  * @todo Finish the API comments here
  * @example
@@ -542,50 +948,106 @@ static uint16_t BL_ReadEEData(void)
  * In:   [|0x05 | DATALEN_L | DATALEN_H | 0x55 | 0xAA | ADDR_L | ADDR_H | ADDR_U | ADDR_E | Data |.. | data |]
  * OUT:  [|0x05 | DATALEN_L | DATALEN_H | KEY_L | KEY_H | ADDR_L | ADDR_H | ADDR_U | ADDR_E | CMD_STATUS|]
  * ************************************************************************************************
+ * With BL_EE_QUEUE_ENABLE the bytes are only queued, and CMD_STATUS reports the writes that completed
+ * since the last WRITE_EE_DATA reply. DATALEN 0 waits until all queued bytes are programmed.
+ * A failed byte may therefore belong to an earlier frame than the one answered. On a failure, ADDR in the reply
+ * is the address of the first byte that failed instead of the address of the frame, with or without the queue.
  */
-static uint8_t BL_WriteEEData(void)
+static uint16_t BL_WriteEEData(void)
 {
-    eeprom_address_t address;
+    eeprom_address_t address = (eeprom_address_t) frameAddress;
+    uint16_t unlockKey = frameKey;
+    uint16_t programmed = 0U;
+    uint16_t skipped = 0U;
+#if (BL_EE_QUEUE_ENABLE == 1U)
+    eeprom_address_t failed = 0U;
+#endif
 
-    // Prevent any write operation that exceeds the data buffer size
-    if( frame.data_length > BL_FRAME_DATA_SIZE ) {
-        frame.data[0] = COMMAND_OVERLOAD_ERROR;
-        return (10U);
+#if (BL_EE_QUEUE_ENABLE == 1U)
+    for (uint16_t i = 0U; i < frame.data_length; i++)
+    {
+        BL_EEQueueWrite(address++, frame.data[i], unlockKey, true);
     }
-
-
-    uint16_t unlockKey = (((uint16_t) frame.EE_key_2) << 8U) | (uint16_t) frame.EE_key_1;
-    
-    address = (((eeprom_address_t) frame.address_U) << 16U)
-            | (((eeprom_address_t) frame.address_H) << 8U)
-            | (eeprom_address_t) frame.address_L;
-
-    if(!((address >= EEPROM_START_ADDRESS_U) && (address < (EEPROM_START_ADDRESS_U + EEPROM_SIZE_U))))
+    if (frame.data_length == 0U)
     {
-        frame.data[0] = ERROR_ADDRESS_OUT_OF_RANGE;
-        return 10U;
+        BL_EEQueueFlush();
     }
-    
+    BL_EEQueueCountsGet(&programmed, &skipped);
+    if (BL_EEQueueStatusGet(&failed) != NVM_OK)
+    {
+        return BL_WriteEEError(failed, programmed, skipped);
+    }
+#else
     for (uint16_t i = 0U; i < frame.data_length; i++)
     {
+#if (BL_SKIP_UNCHANGED_ENABLE == 1U)
+        if (EEPROM_Read(address) == frame.data[i])
+        {
+            address++;
+            skipped++;
+            continue;
+        }
+#endif
         NVM_UnlockKeySet(unlockKey);
         EEPROM_Write(address++, frame.data[i]);
         while (NVM_IsBusy())
         {
         }
         NVM_UnlockKeyClear();
+        programmed++;
 
         if (NVM_StatusGet() != NVM_OK)
         {
+            BL_TRACE_EVENT(BL_TRACE_EVENT_NVM_ERROR, (uint8_t) NVM_ERROR, address - 1U);
             NVM_StatusClear();
-            frame.data[0] = ERROR_ADDRESS_OUT_OF_RANGE;
-            return (BL_HEADER + 1U);
+            return BL_WriteEEError(address - 1U, programmed, skipped);
         }
     }
-    frame.data[0] = COMMAND_SUCCESS;
+#endif
+    return BL_WriteReply(COMMAND_SUCCESS, programmed, skipped);
+}
+
+/**
+ * Failure reply of WRITE_EE_DATA: ERROR_ADDRESS_OUT_OF_RANGE, with ADDR replaced by the address of the byte that failed.
+ * ADDR_E is left alone, since it carries the node address on a multi-drop bus.
+ */
+static uint8_t BL_WriteEEError(eeprom_address_t address, uint16_t programmed, uint16_t skipped)
+{
+    frame.address_L = (uint8_t) address;
+    frame.address_H = (uint8_t) (address >> 8U);
+    frame.address_U = (uint8_t) (address >> 16U);
+    return BL_WriteReply(ERROR_ADDRESS_OUT_OF_RANGE, programmed, skipped);
+}
+#endif
+
+#if (BL_CMD_WRITE_EE_DATA_ENABLE == 1U) || (BL_CMD_WRITE_CONFIG_ENABLE == 1U)
+/**
+ * Status reply of WRITE_EE_DATA and WRITE_CONFIG
+ * OUT:  [| header | CMD_STATUS | PROGRAMMED_L | PROGRAMMED_H | SKIPPED_L | SKIPPED_H |]
+ * The counts are only sent with BL_SKIP_UNCHANGED_ENABLE, once the host selected BL_REPLY_COUNTS.
+ */
+static uint8_t BL_WriteReply(uint8_t status, uint16_t programmed, uint16_t skipped)
+{
+    frame.data[0] = status;
+#if (BL_SKIP_UNCHANGED_ENABLE == 1U)
+    if ((replyMode & BL_REPLY_COUNTS) == 0U)
+    {
+        return (BL_HEADER + 1U);
+    }
+    frame.data[1] = (uint8_t) programmed;
+    frame.data[2] = (uint8_t) (programmed >> 8U);
+    frame.data[3] = (uint8_t) skipped;
+    frame.data[4] = (uint8_t) (skipped >> 8U);
+    return (BL_HEADER + 1U + BL_WRITE_COUNTS_SIZE);
+#else
+    (void) programmed;
+    (void) skipped;
     return (BL_HEADER + 1U);
+#endif
 }
+#endif
 
+#if (BL_CMD_READ_CONFIG_ENABLE == 1U)
 // *****************************************************************************
 // Read Config Words
 //        Cmd     Length-----              Address---------------  Data ---------
@@ -594,18 +1056,9 @@ static uint8_t BL_WriteEEData(void)
 // *****************************************************************************
 static uint16_t BL_ReadConfig(void)
 {
-    configuration_address_t configurationAddress;
-    uint8_t dataIndex = 1;
+    configuration_address_t configurationAddress = (configuration_address_t) frameAddress;
+    uint16_t dataIndex = 1U;
 
-    configurationAddress = (((uint32_t) frame.address_U) << 16U)
-            | (((uint32_t) frame.address_H) << 8U)
-            | (uint32_t) frame.address_L;
-
-    if (configurationAddress < (configuration_address_t) NEW_RESET_VECTOR)
-    {
-        frame.data[0] = ERROR_ADDRESS_OUT_OF_RANGE;
-        return (10U);
-    }
     for (uint8_t i = 0; i < frame.data_length; i++)
     {
         frame.data[dataIndex] = EEPROM_Read(configurationAddress);
@@ -619,61 +1072,66 @@ static uint16_t BL_ReadConfig(void)
     return (BL_HEADER + dataIndex);
 
 }
+#endif
 
+#if (BL_CMD_WRITE_CONFIG_ENABLE == 1U)
 // **************************************************************************************
 // Write Config Words
 //        Cmd     Length-----              Address---------------  Data ---------
 // In:   [|0x07 | 0x00 | 0x00 | 0x55 | 0xAA | 0x00 | 0x00 | 0x00 | 0x00 | Data |.. | data |]
 // OUT:  [|0x07 | 0x00 | 0x00 | 0x00 | 0x00 | 0x00 | 0x00 | 0x00 | 0x00|]
 // **************************************************************************************
-static uint8_t BL_WriteConfig(void)
+static uint16_t BL_WriteConfig(void)
 {
-    configuration_address_t configurationAddress;
-    uint16_t unlockKey;
-    uint8_t configurationByte = 0U;
-
-    configurationAddress = (((configuration_address_t) frame.address_U) << 16U)
-            | (((configuration_address_t) frame.address_H) << 8U)
-            | (configuration_address_t) frame.address_L;
+    configuration_address_t configurationAddress = (configuration_address_t) frameAddress;
+    uint16_t programmed = 0U;
+    uint16_t skipped = 0U;
+    uint8_t status;
 
-    unlockKey = (((uint16_t) frame.EE_key_2) << 8U)
-            | (uint16_t) frame.EE_key_1;
-
-    if (configurationAddress < (configuration_address_t) NEW_RESET_VECTOR)
-    {
-        frame.data[0] = ERROR_ADDRESS_OUT_OF_RANGE;
-        return (10U);
-    }
-
-    NVM_UnlockKeySet(unlockKey);
+    NVM_UnlockKeySet(frameKey);
 
     for (uint8_t i = 0U; i < frame.data_length; i++)
     {
-
-        configurationByte = EEPROM_Read(configurationAddress);
-        configurationByte = frame.data[i];
-        EEPROM_Write(configurationAddress, configurationByte);
+#if (BL_SKIP_UNCHANGED_ENABLE == 1U)
+        if (EEPROM_Read(configurationAddress) == frame.data[i])
+        {
+            ++configurationAddress;
+            skipped++;
+            continue;
+        }
+#endif
+        EEPROM_Write(configurationAddress, frame.data[i]);
+        while (NVM_IsBusy())
+        {
+        }
+        programmed++;
 
         ++configurationAddress;
     }
 
     NVM_UnlockKeyClear();
 
-    frame.data[0] = (NVM_StatusGet() == NVM_OK)? COMMAND_SUCCESS: COMMAND_PROCESSING_ERROR;
+    if (NVM_StatusGet() != NVM_OK)
+    {
+        BL_TRACE_EVENT(BL_TRACE_EVENT_NVM_ERROR, (uint8_t) NVM_ERROR, configurationAddress);
+    }
+    status = (NVM_StatusGet() == NVM_OK)? COMMAND_SUCCESS: COMMAND_PROCESSING_ERROR;
     
     NVM_StatusClear();
-    return (10U);
+    return BL_WriteReply(status, programmed, skipped);
 }
+#endif
 
+#if (BL_CMD_CALC_CHECKSUM_ENABLE == 1U)
 // **************************************************************************************
 // Calculate Checksum
 // In:	[|0x08 | DataLengthL | DataLengthH | unused | unused | ADDRL | ADDRH | ADDRU | unused |...]
 // OUT:	[9 byte header + ChecksumL + ChecksumH]
 // **************************************************************************************
 
-static uint8_t BL_CalcChecksum(void)
+static uint16_t BL_CalcChecksum(void)
 {
-    flash_address_t address;
+    flash_address_t address = frameAddress;
 #if PROGMEM_SIZE > 0x10000
     uint32_t i;
     uint32_t length = frame.data_length;
@@ -682,18 +1140,16 @@ static uint8_t BL_CalcChecksum(void)
     uint16_t i;
     uint16_t length = frame.data_length;
 #endif
-    address = (((flash_address_t) frame.address_U) << 16U)
-            | (((flash_address_t) frame.address_H) << 8U)
-            | (flash_address_t) frame.address_L;
+    uint16_t checkSum = 0U;
 
-    if(address < START_OF_APP)
+#if (BL_PLAINTEXT_FLASH_ENABLE == 0U)
+    // Sums over short ranges would read the application back a word at a time
+    if ((address != (flash_address_t) START_OF_APP) || (length != (PROGMEM_SIZE - START_OF_APP)))
     {
         frame.data[0] = ERROR_ADDRESS_OUT_OF_RANGE;
         return (10U);
     }
-    
-    uint16_t checkSum = 0U;
-
+#endif
     for (i = 0U; i < length; i += 2U)
     {
         checkSum += (uint16_t) FLASH_Read(address++);
@@ -704,5 +1160,534 @@ static uint8_t BL_CalcChecksum(void)
     frame.data[1] = (uint8_t) ((checkSum & 0xFF00U) >> 8U);
     return (11U);
 }
+#endif
+
+#if (BL_TRACE_ENABLE == 1U)
+// **************************************************************************************
+// Read Trace
+//        Cmd     Length-----              Address---------------
+// In:   [|0x0A | CLR_L | CLR_H | 0x00 | 0x00 | 0x00 | 0x00 | 0x00 | 0x00|]
+// OUT:  [9 byte header + CMD_STATUS + RECSIZE + DEPTH + COUNT_L + COUNT_H + TICK_US + 0x00 + Records]
+// **************************************************************************************
+static uint16_t BL_ReadTrace(void)
+{
+    uint16_t length;
+
+    length = BL_TraceRead(&frame.data[1]);
+    if (frame.data_length != 0U)
+    {
+        BL_TraceClear();
+    }
+    frame.data[0] = COMMAND_SUCCESS;
+
+    return (BL_HEADER + 1U + length);
+}
+#endif
+#if (BL_MULTIDROP_ENABLE == 1U)
+// **************************************************************************************
+// Poll Broadcast Status
+//        Cmd     Length-----              Address---------------------------
+// In:   [|0x0B | CLR_L | CLR_H | 0x00 | 0x00 | 0x00 | 0x00 | 0x00 | NODE|]
+// OUT:  [9 byte header + CMD_STATUS + NODE + BC_STATUS + BC_FRAMES_L + BC_FRAMES_H + FAIL_CMD + FAIL_ADDR_L/H/U]
+// **************************************************************************************
+static uint16_t BL_PollStatus(void)
+{
+    uint16_t length;
+
+    length = BL_MultidropStatus(&frame.data[1], (frame.data_length != 0U));
+    frame.data[0] = COMMAND_SUCCESS;
+
+    return (BL_HEADER + 1U + length);
+}
+#endif
+#if (BL_JOURNAL_ENABLE == 1U)
+// **************************************************************************************
+// Page Journal
+//        Cmd     Length------   Keys-------   Address---------------   Data-----------------------
+// In:   [|0x0C | 0x00 | 0x00 | 0x00 | 0x00 | 0x00 | 0x00 | 0x00 | 0x00|]                             read
+// In:   [|0x0C | 0x04 | 0x00 | 0x55 | 0xAA | 0x00 | 0x00 | 0x00 | 0x00 | ID_0 | ID_1 | ID_2 | ID_3|]  start
+// OUT:  [9 byte header + CMD_STATUS + ID_0..ID_3 + PAGES_L + PAGES_H + BITMAP (bit clear: page committed)]
+// **************************************************************************************
+static uint16_t BL_Journal(void)
+{
+    uint16_t length;
+    uint32_t imageId;
+    uint16_t unlockKey = frameKey;
+
+    if (frame.data_length == BL_JOURNAL_ID_SIZE)
+    {
+        if (unlockKey != UNLOCK_KEY)
+        {
+            frame.data[0] = COMMAND_PROCESSING_ERROR;
+            return (10U);
+        }
+        imageId = ((uint32_t) frame.data[3] << 24U) | ((uint32_t) frame.data[2] << 16U)
+                | ((uint32_t) frame.data[1] << 8U) | (uint32_t) frame.data[0];
+        if (BL_JournalBegin(imageId, unlockKey) != NVM_OK)
+        {
+            frame.data[0] = COMMAND_PROCESSING_ERROR;
+            return (10U);
+        }
+    }
+    else if (frame.data_length != 0U)
+    {
+        frame.data[0] = COMMAND_PROCESSING_ERROR;
+        return (10U);
+    }
+    else
+    {
+        // Read only
+    }
+
+    length = BL_JournalRead(&frame.data[1]);
+    frame.data[0] = COMMAND_SUCCESS;
+
+    return (BL_HEADER + 1U + length);
+}
+#endif
 
+#if (BL_CMD_BATCH_ENABLE == 1U)
+// **************************************************************************************
+// Batch
+//        Cmd     Length-----              Address---------------
+// In:   [|0x0D | LEN_L | LEN_H | 0x00 | 0x00 | 0x00 | 0x00 | 0x00 | 0x00| Frames... ]
+// OUT:  [9 byte header + CMD_STATUS + INDEX + CHECKSUM_L + CHECKSUM_H]
+// Each frame is a 9 byte header and the data of commands that carry it. The frames run in order until one fails.
+// ADDR_L to ADDR_U of the reply are then those of that frame's reply, which for WRITE_EE_DATA is the byte that failed.
+// **************************************************************************************
+static uint16_t BL_Batch(void)
+{
+    uint8_t header[BL_HEADER];
+    uint16_t batchLength = frame.data_length;
+    uint16_t offset = 0U;
+    uint16_t dataLength;
+    uint16_t length;
+    uint16_t checkSum = 0U;
+    uint8_t status = COMMAND_SUCCESS;
+    uint8_t index = 0U;
+
+    // The reply carries the header of the BATCH frame
+    for (uint8_t i = 0U; i < BL_HEADER; i++)
+    {
+        header[i] = frame.buffer[i];
+    }
+    for (uint16_t i = 0U; i < batchLength; i++)
+    {
+        batchBuffer[i] = frame.data[i];
+    }
+
+    while (offset < batchLength)
+    {
+        if ((uint16_t) (batchLength - offset) < BL_HEADER)
+        {
+            status = COMMAND_OVERLOAD_ERROR;
+            break;
+        }
+        for (uint8_t i = 0U; i < BL_HEADER; i++)
+        {
+            frame.buffer[i] = batchBuffer[offset];
+            offset++;
+        }
+        dataLength = 0U;
+        if ((frame.command < BL_COMMAND_COUNT) && ((commandTable[frame.command].flags & BL_FRAME_HAS_DATA) != 0U))
+        {
+            dataLength = frame.data_length;
+        }
+        if (dataLength > (uint16_t) (batchLength - offset))
+        {
+            status = COMMAND_OVERLOAD_ERROR;
+            break;
+        }
+        for (uint16_t i = 0U; i < dataLength; i++)
+        {
+            frame.data[i] = batchBuffer[offset];
+            offset++;
+        }
+
+        length = BL_CommandRun(BL_BATCH_ALLOWED);
+        BL_TRACE_FRAME(&frame);
+        // CALC_CHECKSUM replies with the sum only; a failed check leaves the header-only status reply
+        if ((frame.command == CALC_CHECKSUM) && (length > 10U))
+        {
+            checkSum = (uint16_t) frame.data[0] | ((uint16_t) frame.data[1] << 8U);
+            status = COMMAND_SUCCESS;
+        }
+        else
+        {
+            status = frame.data[0];
+        }
+        if (status != COMMAND_SUCCESS)
+        {
+            header[5] = frame.address_L;
+            header[6] = frame.address_H;
+            header[7] = frame.address_U;
+            break;
+        }
+        index++;
+    }
+
+    for (uint8_t i = 0U; i < BL_HEADER; i++)
+    {
+        frame.buffer[i] = header[i];
+    }
+    frame.data[0] = status;
+    frame.data[1] = index;
+    frame.data[2] = (uint8_t) (checkSum & 0x00FFU);
+    frame.data[3] = (uint8_t) ((checkSum & 0xFF00U) >> 8U);
+    return (BL_HEADER + BL_BATCH_REPLY_SIZE);
+}
+#endif
+
+#if (BL_REPLY_MODES != 0U)
+// **************************************************************************************
+// Reply Mode
+//        Cmd     Length-----              Address---------------
+// In:   [|0x0E | 0x00 | 0x00 | 0x00 | 0x00 | MODE | 0x00 | 0x00 | 0x00|]
+// OUT:  [9 byte header + CMD_STATUS + MODE + SEQUENCE]
+// The reply is always full, so that a host that does not know the current mode can read it.
+// MODE bits this build does not have are refused.
+// **************************************************************************************
+static uint16_t BL_ReplyMode(void)
+{
+    if ((frameAddress & ~(flash_address_t) BL_REPLY_MODES) != 0U)
+    {
+        frame.data[0] = ERROR_ADDRESS_OUT_OF_RANGE;
+        return (10U);
+    }
+    replyMode = (uint8_t) frameAddress;
+    replySequence = 0U;
+    frame.data[0] = COMMAND_SUCCESS;
+    frame.data[1] = replyMode;
+    frame.data[2] = replySequence;
+
+    return (BL_HEADER + 3U);
+}
+#endif
 
+#if (BL_COMPACT_REPLY == 1U)
+// Turns a reply made of the header and COMMAND_SUCCESS into a compact reply in compact mode
+static uint16_t BL_CompactReply(uint16_t length)
+{
+    if (((replyMode & BL_REPLY_COMPACT) != 0U) && (length == (BL_HEADER + 1U)) && (frame.data[0] == COMMAND_SUCCESS))
+    {
+        replySequence++;
+        frame.buffer[0] = BL_COMPACT_REPLY_FLAG | frame.command;
+        frame.buffer[1] = replySequence;
+        length = BL_COMPACT_REPLY_SIZE;
+    }
+    return length;
+}
+#endif
+
+#if (BL_SKIP_BLANK_ENABLE == 1U) || (BL_CMD_BLANK_CHECK_ENABLE == 1U)
+// Returns true when every byte of a page read into page is erased
+static bool BL_PageBlank(const flash_data_t *page)
+{
+    for (uint16_t offset = 0U; offset < PROGMEM_PAGE_SIZE; offset++)
+    {
+        if (page[offset] != 0xFFU)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+#endif
+
+#if (BL_ERASED_MAP_ENABLE == 1U)
+// Returns true when the page at pageAddress is marked in the erased page bitmap
+static bool BL_PageErased(flash_address_t pageAddress)
+{
+    uint16_t page;
+
+    if ((pageAddress < (flash_address_t) START_OF_APP) || (pageAddress >= (flash_address_t) PROGMEM_SIZE))
+    {
+        return false;
+    }
+    page = (uint16_t) ((pageAddress - START_OF_APP) / PROGMEM_PAGE_SIZE);
+    return ((erasedMap[page / 8U] & (uint8_t) (1U << (page % 8U))) != 0U);
+}
+
+// Marks the page at pageAddress as erased or written; addresses outside the application area are ignored
+static void BL_PageErasedSet(flash_address_t pageAddress, bool erased)
+{
+    uint16_t page;
+    uint8_t mask;
+
+    if ((pageAddress < (flash_address_t) START_OF_APP) || (pageAddress >= (flash_address_t) PROGMEM_SIZE))
+    {
+        return;
+    }
+    page = (uint16_t) ((pageAddress - START_OF_APP) / PROGMEM_PAGE_SIZE);
+    mask = (uint8_t) (1U << (page % 8U));
+    if (erased == true)
+    {
+        erasedMap[page / 8U] |= mask;
+    }
+    else
+    {
+        erasedMap[page / 8U] &= (uint8_t) ~mask;
+    }
+}
+#endif
+
+#if (BL_CMD_BLANK_CHECK_ENABLE == 1U)
+// **************************************************************************************
+// Blank Check
+//        Cmd     Length-----              Address---------------
+// In:   [|0x0F | PAGES_L | PAGES_H | 0x00 | 0x00 | ADDR_L | ADDR_H | ADDR_U | 0x00|]
+// OUT:  [9 byte header + CMD_STATUS + BLANK_L + BLANK_H + BITMAP (bit set: page blank)]
+// The bitmap holds one bit per page from ADDR, least significant bit first.
+// **************************************************************************************
+static uint16_t BL_BlankCheck(void)
+{
+    flash_data_t pageBuffer[PROGMEM_PAGE_SIZE];
+    flash_address_t address = frameAddress;
+    uint16_t pages = frame.data_length;
+    uint16_t bitmapSize = (pages + 7U) / 8U;
+    uint16_t blank = 0U;
+
+    // The range ends inside the flash, so the bitmap of at most PROGMEM_SIZE / PROGMEM_PAGE_SIZE pages fits the frame
+    if (((uint32_t) pages * PROGMEM_PAGE_SIZE) > ((uint32_t) PROGMEM_SIZE - address))
+    {
+        frame.data[0] = ERROR_ADDRESS_OUT_OF_RANGE;
+        return (10U);
+    }
+
+    for (uint16_t i = 0U; i < bitmapSize; i++)
+    {
+        frame.data[3U + i] = 0x00U;
+    }
+    for (uint16_t page = 0U; page < pages; page++)
+    {
+        (void) FLASH_RowRead(address, pageBuffer);
+        if (BL_PageBlank(pageBuffer) == true)
+        {
+            frame.data[3U + (page / 8U)] |= (uint8_t) (1U << (page % 8U));
+            blank++;
+        }
+        address += PROGMEM_PAGE_SIZE;
+    }
+    frame.data[0] = COMMAND_SUCCESS;
+    frame.data[1] = (uint8_t) blank;
+    frame.data[2] = (uint8_t) (blank >> 8U);
+
+    return (BL_HEADER + 3U + bitmapSize);
+}
+#endif
+
+#if (BL_PATCH_INCLUDED == 1U)
+// **************************************************************************************
+// Patch
+//        Cmd     Length----- Keys------   Address---------------  Data ---------
+// In:   [|0x10 | DATALEN_L | DATALEN_H | 0x55 | 0xAA | ADDR_L | ADDR_H | ADDR_U | 0x00 | Instructions |]
+// OUT:  [9 byte header + CMD_STATUS]
+// The page at ADDR is built in RAM from the instructions, then erased and programmed. COPY reads the flash
+// as it is, so a source inside the page being patched gets its old content, and a source in a page patched
+// before gets the new one. The host builds the delta in page order against that view of the flash.
+// A stream that does not produce exactly one page leaves the flash untouched.
+// **************************************************************************************
+static uint16_t BL_Patch(void)
+{
+    nvm_status_t errorStatus = NVM_OK;
+    flash_data_t pageBuffer[PROGMEM_PAGE_SIZE];
+    flash_address_t pageAddress = frameAddress;
+    flash_address_t source;
+    uint16_t unlockKey = frameKey;
+    uint16_t in = 0U;
+    uint16_t out = 0U;
+    uint16_t length;
+    uint8_t instruction;
+    uint8_t status = COMMAND_SUCCESS;
+    bool pageBlank = false;
+
+    BL_ENTRY_REQUEST_RELEASE(unlockKey);
+
+    while ((status == COMMAND_SUCCESS) && ((in + 2U) <= frame.data_length))
+    {
+        instruction = frame.data[in];
+        length = (frame.data[in + 1U] == 0U) ? 256U : frame.data[in + 1U];
+        in += 2U;
+        if (length > (PROGMEM_PAGE_SIZE - out))
+        {
+            status = COMMAND_PROCESSING_ERROR;
+        }
+        else if ((instruction == BL_PATCH_COPY) && ((in + 3U) <= frame.data_length))
+        {
+            source = (flash_address_t) frame.data[in] | ((flash_address_t) frame.data[in + 1U] << 8U)
+                     | ((flash_address_t) frame.data[in + 2U] << 16U);
+            in += 3U;
+            // The boot block is not copied into the application, where READ_FLASH could read it back
+            if ((source < (flash_address_t) START_OF_APP) || (source > ((flash_address_t) PROGMEM_SIZE - length)))
+            {
+                status = ERROR_ADDRESS_OUT_OF_RANGE;
+            }
+            else
+            {
+                while (length > 0U)
+                {
+                    pageBuffer[out++] = FLASH_Read(source++);
+                    length--;
+                }
+            }
+        }
+        else if ((instruction == BL_PATCH_ADD) && ((in + length) <= frame.data_length))
+        {
+            while (length > 0U)
+            {
+                pageBuffer[out++] = frame.data[in++];
+                length--;
+            }
+        }
+        else if ((instruction == BL_PATCH_RUN) && ((in + 1U) <= frame.data_length))
+        {
+            while (length > 0U)
+            {
+                pageBuffer[out++] = frame.data[in];
+                length--;
+            }
+            in++;
+        }
+        else
+        {
+            status = COMMAND_PROCESSING_ERROR;
+        }
+    }
+    if ((status == COMMAND_SUCCESS) && ((in != frame.data_length) || (out != PROGMEM_PAGE_SIZE)))
+    {
+        status = COMMAND_PROCESSING_ERROR;
+    }
+
+    if (status == COMMAND_SUCCESS)
+    {
+#if (BL_ERASED_MAP_ENABLE == 1U)
+        pageBlank = BL_PageErased(pageAddress);
+        BL_PageErasedSet(pageAddress, false);
+#endif
+        if (pageBlank == false)
+        {
+            NVM_UnlockKeySet(unlockKey);
+            errorStatus = FLASH_PageErase(pageAddress);
+            NVM_UnlockKeyClear();
+        }
+        if (errorStatus == NVM_OK)
+        {
+            NVM_UnlockKeySet(unlockKey);
+            errorStatus = FLASH_RowWrite(pageAddress, pageBuffer);
+            NVM_UnlockKeyClear();
+        }
+        if (errorStatus != NVM_OK)
+        {
+            BL_TRACE_EVENT(BL_TRACE_EVENT_NVM_ERROR, (uint8_t) errorStatus, pageAddress);
+            status = COMMAND_PROCESSING_ERROR;
+        }
+#if (BL_JOURNAL_ENABLE == 1U)
+        else
+        {
+            BL_JournalPageCommitted(pageAddress, unlockKey);
+        }
+#endif
+        NVM_StatusClear();
+    }
+
+    frame.data[0] = status;
+    return (10U);
+}
+#endif
+
+#if (BL_CMD_SECURE_WRITE_ENABLE == 1U)
+// **************************************************************************************
+// Secure Write
+//        Cmd     Length----- Keys------   Address---------------  Data ---------
+// In:   [|0x11 | 0x10 | 0x01 | 0x55 | 0xAA | ADDR_L | ADDR_H | ADDR_U | 0x00 | NONCE | CIPHERTEXT | TAG |]
+// OUT:  [9 byte header + CMD_STATUS]
+// The page is decrypted in the frame buffer and only erased and programmed once its tag matches, so a frame
+// that was corrupted or not encrypted for this page and key leaves the flash untouched.
+// **************************************************************************************
+static uint16_t BL_SecureWrite(void)
+{
+    nvm_status_t errorStatus = NVM_OK;
+    flash_address_t pageAddress = frameAddress;
+    uint16_t unlockKey = frameKey;
+    uint8_t status = COMMAND_SUCCESS;
+    bool pageBlank = false;
+
+    BL_ENTRY_REQUEST_RELEASE(unlockKey);
+
+    if (frame.data_length != BL_SECURE_FRAME_SIZE)
+    {
+        status = COMMAND_OVERLOAD_ERROR;
+    }
+    else if (BL_SecurePageOpen(frame.data, pageAddress) == false)
+    {
+        status = COMMAND_PROCESSING_ERROR;
+    }
+    else
+    {
+#if (BL_ERASED_MAP_ENABLE == 1U)
+        pageBlank = BL_PageErased(pageAddress);
+        BL_PageErasedSet(pageAddress, false);
+#endif
+        if (pageBlank == false)
+        {
+            NVM_UnlockKeySet(unlockKey);
+            errorStatus = FLASH_PageErase(pageAddress);
+            NVM_UnlockKeyClear();
+        }
+        if (errorStatus == NVM_OK)
+        {
+            NVM_UnlockKeySet(unlockKey);
+            errorStatus = FLASH_RowWrite(pageAddress, &frame.data[BL_SECURE_NONCE_SIZE]);
+            NVM_UnlockKeyClear();
+        }
+        if (errorStatus != NVM_OK)
+        {
+            BL_TRACE_EVENT(BL_TRACE_EVENT_NVM_ERROR, (uint8_t) errorStatus, pageAddress);
+            status = COMMAND_PROCESSING_ERROR;
+        }
+#if (BL_JOURNAL_ENABLE == 1U)
+        else
+        {
+            BL_JournalPageCommitted(pageAddress, unlockKey);
+        }
+#endif
+        NVM_StatusClear();
+    }
+
+    frame.data[0] = status;
+    return (10U);
+}
+#endif
+
+#if (BL_CMD_DIGEST_ENABLE == 1U)
+// **************************************************************************************
+// Digest
+//        Cmd     Length-----   Length       Address---------------
+// In:   [|0x12 | LEN_L | LEN_H | LEN_U | 0x00 | ADDR_L | ADDR_H | ADDR_U | 0x00 |]
+// OUT:  [9 byte header + CMD_STATUS + 32 byte SHA-256 digest]
+// **************************************************************************************
+static uint16_t BL_Digest(void)
+{
+    flash_address_t address = frameAddress;
+    uint32_t length = frame.data_length;
+
+    length += ((uint32_t) frame.EE_key_1) << 16U;
+#if (BL_PLAINTEXT_FLASH_ENABLE == 0U)
+    // The digests of short ranges would give the application away a few bytes at a time
+    if ((address != (flash_address_t) START_OF_APP) || (length != (PROGMEM_SIZE - START_OF_APP)))
+    {
+        frame.data[0] = ERROR_ADDRESS_OUT_OF_RANGE;
+        return (10U);
+    }
+#endif
+    if (length > (PROGMEM_SIZE - address))
+    {
+        frame.data[0] = ERROR_ADDRESS_OUT_OF_RANGE;
+        return (10U);
+    }
+
+    BL_DigestFlash(address, length, &frame.data[1]);
+    frame.data[0] = COMMAND_SUCCESS;
+    return (10U + BL_DIGEST_SIZE);
+}
+#endif
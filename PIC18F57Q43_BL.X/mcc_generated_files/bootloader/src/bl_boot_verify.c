@@ -33,6 +33,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "../bl_bootload.h"
+#include "../bl_digest.h"
 
 
 
@@ -43,11 +44,58 @@ typedef enum
     ERROR
 } validation_status_t;
 
+#if (BL_DIGEST_VERIFY_ENABLE == 1U)
+static validation_status_t BL_ValidateDigest(flash_address_t startAddress, uint32_t length, flash_address_t checkAddress);
+#else
 static void BL_CalculateChecksum(flash_address_t startAddress, uint32_t length, uint16_t *checkSum);
 static validation_status_t BL_ValidateChecksum(flash_address_t startAddress, uint32_t length, flash_address_t checkAddress);
+#endif
 
 
+#if (BL_DIGEST_VERIFY_ENABLE == 1U)
+/**
+ * @brief This function validates the SHA-256 digest of the APP section against the
+ *      BL_DIGEST_SIZE byte digest that the end application project stores after it
+ * @param [in] startAddress - starting address of FLASH memory region to be hashed
+ * @param [in] length - number of bytes from startAddress to be hashed
+ * @param [in] checkAddress - address of the stored digest
+ * @retval validation_status_t - OK if passes;
+ *                          FAIL if validation did not pass;
+ *                          ERROR if memory reference issue occured;
+ */
+static validation_status_t BL_ValidateDigest(flash_address_t startAddress, uint32_t length, flash_address_t checkAddress)
+{
+    validation_status_t status = ERROR;
+    uint8_t digest[BL_DIGEST_SIZE];
+
+    bool refAddrInsideEvaluatedArea = (((checkAddress + BL_DIGEST_SIZE) > startAddress) && (checkAddress < (startAddress + length)));
+    bool refAddrOutsideFlash = ((checkAddress + BL_DIGEST_SIZE) > PROGMEM_SIZE);
+
+    if ((length == 0U) || ((startAddress + length) > PROGMEM_SIZE))
+    {
+        status = ERROR;
+    }
+    else if (refAddrInsideEvaluatedArea || refAddrOutsideFlash)
+    {
+        status = ERROR;
+    }
+    else
+    {
+        BL_DigestFlash(startAddress, length, digest);
+        // An erased footer reads all 0xFF, which no image can be expected to hash to
+        status = OK;
+        for (uint8_t i = 0U; i < BL_DIGEST_SIZE; i++)
+        {
+            if (FLASH_Read(checkAddress + i) != digest[i])
+            {
+                status = FAIL;
+            }
+        }
+    }
 
+    return status;
+}
+#else
 // Checksum validation/calculation functions
 static void BL_CalculateChecksum(flash_address_t startAddress, uint32_t length, uint16_t *checkSum)
 {
@@ -105,14 +153,24 @@ static validation_status_t BL_ValidateChecksum(flash_address_t startAddress, uin
 
     return status;
 }
+#endif
 
 bool BL_bootVerify(void)
+{
+    return BL_bootVerifyImage(START_OF_APP);
+}
+
+bool BL_bootVerifyImage(flash_address_t imageAddress)
 {
     bool retVal;
 // **************************************************************************************
-//  Calculate a checksum over the application area and compare to pre-calculated checksum from application image
+//  Calculate a checksum or digest over the application area and compare to the pre-calculated one from application image
 // **************************************************************************************
-    validation_status_t checksumPassed = BL_ValidateChecksum(START_OF_APP, CHECKSUM_LENGTH, CHECKSUM_ADDRESS);
+#if (BL_DIGEST_VERIFY_ENABLE == 1U)
+    validation_status_t checksumPassed = BL_ValidateDigest(imageAddress, CHECKSUM_LENGTH, imageAddress + CHECKSUM_LENGTH);
+#else
+    validation_status_t checksumPassed = BL_ValidateChecksum(imageAddress, CHECKSUM_LENGTH, imageAddress + CHECKSUM_LENGTH);
+#endif
 
     if (checksumPassed == OK)
     {
@@ -33,81 +33,35 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "../bl_communication_interface.h"
+#include "../bl_transport.h"
 
-#define  STX   0x55
-
-#define USART_IsRxReady()                       UART1_IsRxReady()
-#define USART_Read()                            UART1_Read()
-#define USART_Write(data)                       UART1_Write(data)
-#define USART_IsTxReady()                       UART1_IsTxReady()
-#define USART_IsTxDone()                        UART1_IsTxDone()
-#define UART_AutoBaudSet(enable)                UART1_AutoBaudSet(enable)
-#define UART_AutoBaudQuery()                    UART1_AutoBaudQuery()
-#define USART_AutoBaudDetectErrorReset()        UART1_AutoBaudDetectOverflowReset()
-#define USART_IsAutoBaudDetectError()           UART1_IsAutoBaudDetectOverflow()
+#if (BL_TRANSPORT_SELECT == BL_TRANSPORT_SPI)
+static const bl_transport_t *const transport = &BL_SPI_TRANSPORT;
+#else
+static const bl_transport_t *const transport = &BL_UART_TRANSPORT;
+#endif
 
+void BL_CommunicationModuleOpen(void)
+{
+    transport->Initialize();
+}
 
 void BL_CommunicationModuleInit(void)
 {
-
-    UART_AutoBaudSet(true);
-
-    while(UART_AutoBaudQuery() != 1)
-    {
-        if( USART_IsAutoBaudDetectError() == true)
-        {
-            UART_AutoBaudSet(false);
-            USART_AutoBaudDetectErrorReset();
-            UART_AutoBaudSet(true); 
-        }
-    }
+    transport->FrameSync();
 }
 
 bool BL_CommunicationModuleIsReady(void)
 {
-    bool status;
-
-    if (USART_IsTxDone())
-    {
-        status = true;
-    }
-    else
-    {
-        status = false;
-    }
-
-    return status;
+    return transport->IsTxDone();
 }
 
 void BL_CommunicationModuleRead(uint8_t *data, size_t dataLength)
 {
-    size_t commReadDataCount;
-    commReadDataCount = 0;
-
-    while (commReadDataCount < dataLength)
-    {
-        if (USART_IsRxReady())
-        {
-            *data++ = USART_Read();
-            commReadDataCount++;
-        }
-    }
+    transport->Read(data, dataLength);
 }
 
 void BL_CommunicationModuleWrite(uint8_t *data, size_t dataLength)
 {
-    size_t commWriteDataCount;
-    commWriteDataCount = 0;
-
-    USART_Write(STX);
-    while (commWriteDataCount < dataLength)
-    {
-        if (USART_IsTxReady())
-        {
-            USART_Write(*data);
-            commWriteDataCount++;
-            data++;
-        }
-
-    }
+    transport->Write(data, dataLength);
 }
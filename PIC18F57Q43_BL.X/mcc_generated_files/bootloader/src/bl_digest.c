@@ -0,0 +1,226 @@
+/**
+ *
+ * @file bl_digest.c
+ *
+ * @ingroup generic_bootloader_8bit
+ *
+ * @brief This source file provides the SHA-256 digest of a flash range.
+ *
+ * @version BOOTLOADER Driver Version 3.0.0
+ */
+
+/*
+ [2023] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#include <stdbool.h>
+#include "../bl_digest.h"
+#include "../bl_trace.h"
+
+#if (BL_DIGEST_INCLUDED == 1U)
+
+#define BL_DIGEST_BLOCK_SIZE    (64U)
+// The last 8 bytes of the final block hold the message length in bits
+#define BL_DIGEST_LENGTH_OFFSET (56U)
+#define BL_DIGEST_ROUNDS        (64U)
+
+// A 32-bit word and its bytes, least significant first as XC8 stores it
+typedef union
+{
+    uint32_t word;
+    uint8_t bytes[4];
+} bl_digest_word_t;
+
+static void BL_DigestPut(uint8_t index, uint8_t value);
+static void BL_DigestBlock(void);
+static uint32_t BL_DigestRotate(uint32_t x, uint8_t bytes, int8_t bits);
+
+static const uint32_t roundConstants[BL_DIGEST_ROUNDS] = {
+    0x428A2F98UL, 0x71374491UL, 0xB5C0FBCFUL, 0xE9B5DBA5UL, 0x3956C25BUL, 0x59F111F1UL, 0x923F82A4UL, 0xAB1C5ED5UL,
+    0xD807AA98UL, 0x12835B01UL, 0x243185BEUL, 0x550C7DC3UL, 0x72BE5D74UL, 0x80DEB1FEUL, 0x9BDC06A7UL, 0xC19BF174UL,
+    0xE49B69C1UL, 0xEFBE4786UL, 0x0FC19DC6UL, 0x240CA1CCUL, 0x2DE92C6FUL, 0x4A7484AAUL, 0x5CB0A9DCUL, 0x76F988DAUL,
+    0x983E5152UL, 0xA831C66DUL, 0xB00327C8UL, 0xBF597FC7UL, 0xC6E00BF3UL, 0xD5A79147UL, 0x06CA6351UL, 0x14292967UL,
+    0x27B70A85UL, 0x2E1B2138UL, 0x4D2C6DFCUL, 0x53380D13UL, 0x650A7354UL, 0x766A0ABBUL, 0x81C2C92EUL, 0x92722C85UL,
+    0xA2BFE8A1UL, 0xA81A664BUL, 0xC24B8B70UL, 0xC76C51A3UL, 0xD192E819UL, 0xD6990624UL, 0xF40E3585UL, 0x106AA070UL,
+    0x19A4C116UL, 0x1E376C08UL, 0x2748774CUL, 0x34B0BCB5UL, 0x391C0CB3UL, 0x4ED8AA4AUL, 0x5B9CCA4FUL, 0x682E6FF3UL,
+    0x748F82EEUL, 0x78A5636FUL, 0x84C87814UL, 0x8CC70208UL, 0x90BEFFFAUL, 0xA4506CEBUL, 0xBEF9A3F7UL, 0xC67178F2UL
+};
+
+static const uint32_t initialState[8] = {
+    0x6A09E667UL, 0xBB67AE85UL, 0x3C6EF372UL, 0xA54FF53AUL, 0x510E527FUL, 0x9B05688CUL, 0x1F83D9ABUL, 0x5BE0CD19UL
+};
+
+// Message schedule W[t mod 16]; a block is loaded into it big-endian, and extended in place from round 16 on
+static bl_digest_word_t schedule[16];
+static bl_digest_word_t state[8];
+
+static void BL_DigestPut(uint8_t index, uint8_t value)
+{
+    schedule[index >> 2U].bytes[3U - (index & 3U)] = value;
+}
+
+// Rotates right by 8 * bytes + bits; bits from -4 to 4, negative to rotate left
+static uint32_t BL_DigestRotate(uint32_t x, uint8_t bytes, int8_t bits)
+{
+    bl_digest_word_t in;
+    bl_digest_word_t out;
+
+    in.word = x;
+    out.bytes[0] = in.bytes[bytes & 3U];
+    out.bytes[1] = in.bytes[(bytes + 1U) & 3U];
+    out.bytes[2] = in.bytes[(bytes + 2U) & 3U];
+    out.bytes[3] = in.bytes[(bytes + 3U) & 3U];
+    while (bits > 0)
+    {
+        bool low = ((out.bytes[0] & 0x01U) != 0U);
+        out.word >>= 1U;
+        if (low)
+        {
+            out.bytes[3] |= 0x80U;
+        }
+        bits--;
+    }
+    while (bits < 0)
+    {
+        bool high = ((out.bytes[3] & 0x80U) != 0U);
+        out.word <<= 1U;
+        if (high)
+        {
+            out.bytes[0] |= 0x01U;
+        }
+        bits++;
+    }
+    return out.word;
+}
+
+static void BL_DigestBlock(void)
+{
+    uint32_t a = state[0].word;
+    uint32_t b = state[1].word;
+    uint32_t c = state[2].word;
+    uint32_t d = state[3].word;
+    uint32_t e = state[4].word;
+    uint32_t f = state[5].word;
+    uint32_t g = state[6].word;
+    uint32_t h = state[7].word;
+    uint32_t t1;
+    uint32_t t2;
+
+    for (uint8_t t = 0U; t < BL_DIGEST_ROUNDS; t++)
+    {
+        uint8_t i = t & 15U;
+
+        if (t >= 16U)
+        {
+            uint32_t w2 = schedule[(t - 2U) & 15U].word;
+            uint32_t w15 = schedule[(t - 15U) & 15U].word;
+
+            // sigma1 = ROTR 17 ^ ROTR 19 ^ SHR 10, sigma0 = ROTR 7 ^ ROTR 18 ^ SHR 3
+            schedule[i].word += (BL_DigestRotate(w2, 2U, 1) ^ BL_DigestRotate(w2, 2U, 3) ^ (w2 >> 10U))
+                                + schedule[(t - 7U) & 15U].word
+                                + (BL_DigestRotate(w15, 1U, -1) ^ BL_DigestRotate(w15, 2U, 2) ^ (w15 >> 3U));
+        }
+        // SIGMA1 = ROTR 6 ^ ROTR 11 ^ ROTR 25, Ch = (e & f) ^ (~e & g)
+        t1 = h + (BL_DigestRotate(e, 1U, -2) ^ BL_DigestRotate(e, 1U, 3) ^ BL_DigestRotate(e, 3U, 1))
+             + (g ^ (e & (f ^ g))) + roundConstants[t] + schedule[i].word;
+        // SIGMA0 = ROTR 2 ^ ROTR 13 ^ ROTR 22, Maj = (a & b) ^ (a & c) ^ (b & c)
+        t2 = (BL_DigestRotate(a, 0U, 2) ^ BL_DigestRotate(a, 2U, -3) ^ BL_DigestRotate(a, 3U, -2))
+             + ((a & b) | (c & (a | b)));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    state[0].word += a;
+    state[1].word += b;
+    state[2].word += c;
+    state[3].word += d;
+    state[4].word += e;
+    state[5].word += f;
+    state[6].word += g;
+    state[7].word += h;
+}
+
+void BL_DigestFlash(flash_address_t address, uint32_t length, uint8_t *digest)
+{
+    // The length in bits; a range of the flash is far below 2^29 bytes
+    uint32_t bits = length << 3U;
+    uint8_t index;
+
+    for (index = 0U; index < 8U; index++)
+    {
+        state[index].word = initialState[index];
+    }
+
+    // The constant tables are read with TBLRD too, so the table pointer is loaded again for every block
+    while (length >= BL_DIGEST_BLOCK_SIZE)
+    {
+        TBLPTRU = (uint8_t) (address >> 16U);
+        TBLPTRH = (uint8_t) (address >> 8U);
+        TBLPTRL = (uint8_t) address;
+        for (index = 0U; index < BL_DIGEST_BLOCK_SIZE; index++)
+        {
+            asm("TBLRD*+");
+            BL_DigestPut(index, TABLAT);
+        }
+        BL_DigestBlock();
+        address += BL_DIGEST_BLOCK_SIZE;
+        length -= BL_DIGEST_BLOCK_SIZE;
+        BL_TRACE_TICK();
+    }
+
+    // The rest of the range, the 0x80 padding byte, zeros and the bit length, in one or two blocks
+    TBLPTRU = (uint8_t) (address >> 16U);
+    TBLPTRH = (uint8_t) (address >> 8U);
+    TBLPTRL = (uint8_t) address;
+    for (index = 0U; index < (uint8_t) length; index++)
+    {
+        asm("TBLRD*+");
+        BL_DigestPut(index, TABLAT);
+    }
+    BL_DigestPut(index++, 0x80U);
+    if (index > BL_DIGEST_LENGTH_OFFSET)
+    {
+        while (index < BL_DIGEST_BLOCK_SIZE)
+        {
+            BL_DigestPut(index++, 0x00U);
+        }
+        BL_DigestBlock();
+        index = 0U;
+    }
+    while (index < BL_DIGEST_LENGTH_OFFSET)
+    {
+        BL_DigestPut(index++, 0x00U);
+    }
+    schedule[14].word = 0U;
+    schedule[15].word = bits;
+    BL_DigestBlock();
+
+    for (index = 0U; index < BL_DIGEST_SIZE; index++)
+    {
+        *digest++ = state[index >> 2U].bytes[3U - (index & 3U)];
+    }
+}
+#endif
@@ -0,0 +1,209 @@
+/**
+ *
+ * @file bl_ee_queue.c
+ *
+ * @ingroup generic_bootloader_8bit
+ *
+ * @brief This source file provides the EEPROM write queue of the 8-bit Bootloader library.
+ *        An EEPROM byte write takes milliseconds but leaves the CPU running, so WRITE_EE_DATA only queues its bytes
+ *        and replies. The queue is drained from the receive and transmit wait loops while the next frame arrives.
+ *
+ * @version BOOTLOADER Driver Version 3.0.0
+ */
+
+/*
+ [2023] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../bl_ee_queue.h"
+#include "../bl_trace.h"
+
+#if (BL_EE_QUEUE_ENABLE == 1U)
+
+#define BL_EE_QUEUE_MASK    ((uint16_t) (BL_EE_QUEUE_SIZE - 1U))
+// Set in the offset of a run whose bytes are not counted
+#define BL_EE_QUEUE_UNCOUNTED   (0x8000U)
+
+// Consecutive queued bytes programmed with one unlock key; offset is the EEPROM offset of the next byte to program
+typedef struct
+{
+    uint16_t offset;
+    uint16_t length;
+    uint16_t unlockKey;
+} bl_ee_queue_run_t;
+
+// Queued bytes in order, and the runs they belong to, oldest first
+static eeprom_data_t eeQueueData[BL_EE_QUEUE_SIZE];
+static uint16_t eeQueueHead = 0U;
+static uint16_t eeQueueTail = 0U;
+static uint16_t eeQueueCount = 0U;
+static bl_ee_queue_run_t eeQueueRuns[BL_EE_QUEUE_RUNS];
+static uint8_t eeRunHead = 0U;
+static uint8_t eeRunTail = 0U;
+static uint8_t eeRunCount = 0U;
+
+// Write started by the last service call whose result was not checked yet
+static bool eeWriteActive = false;
+static eeprom_address_t eeWriteAddress = 0U;
+static nvm_status_t eeQueueStatus = NVM_OK;
+static eeprom_address_t eeQueueErrorAddress = 0U;
+static uint16_t eeQueueProgrammed = 0U;
+static uint16_t eeQueueSkipped = 0U;
+
+void BL_EEQueueInitialize(void)
+{
+    eeQueueHead = 0U;
+    eeQueueTail = 0U;
+    eeQueueCount = 0U;
+    eeRunHead = 0U;
+    eeRunTail = 0U;
+    eeRunCount = 0U;
+    eeWriteActive = false;
+    eeQueueStatus = NVM_OK;
+    eeQueueProgrammed = 0U;
+    eeQueueSkipped = 0U;
+}
+
+void BL_EEQueueWrite(eeprom_address_t address, eeprom_data_t data, uint16_t unlockKey, bool counted)
+{
+    uint16_t offset = (uint16_t) (address - EEPROM_START_ADDRESS_U);
+    bl_ee_queue_run_t *run;
+
+    if (counted == false)
+    {
+        offset |= BL_EE_QUEUE_UNCOUNTED;
+    }
+    while (eeQueueCount == BL_EE_QUEUE_SIZE)
+    {
+        BL_EEQueueService();
+    }
+
+    // The newest run, if the byte continues it; the service may empty and drop it meanwhile
+    run = &eeQueueRuns[(eeRunHead + BL_EE_QUEUE_RUNS - 1U) % BL_EE_QUEUE_RUNS];
+    if ((eeRunCount == 0U) || (run->unlockKey != unlockKey) || ((uint16_t) (run->offset + run->length) != offset))
+    {
+        while (eeRunCount == BL_EE_QUEUE_RUNS)
+        {
+            BL_EEQueueService();
+        }
+        run = &eeQueueRuns[eeRunHead];
+        run->offset = offset;
+        run->length = 0U;
+        run->unlockKey = unlockKey;
+        eeRunHead = (uint8_t) ((eeRunHead + 1U) % BL_EE_QUEUE_RUNS);
+        eeRunCount++;
+    }
+    run->length++;
+    eeQueueData[eeQueueHead] = data;
+    eeQueueHead = (eeQueueHead + 1U) & BL_EE_QUEUE_MASK;
+    eeQueueCount++;
+
+    BL_EEQueueService();
+}
+
+void BL_EEQueueService(void)
+{
+    if (NVM_IsBusy() == true)
+    {
+        return;
+    }
+
+    if (eeWriteActive == true)
+    {
+        eeWriteActive = false;
+        if (NVM_StatusGet() != NVM_OK)
+        {
+            BL_TRACE_EVENT(BL_TRACE_EVENT_NVM_ERROR, (uint8_t) NVM_ERROR, eeWriteAddress);
+            NVM_StatusClear();
+            if (eeQueueStatus == NVM_OK)
+            {
+                eeQueueErrorAddress = eeWriteAddress;
+            }
+            eeQueueStatus = NVM_ERROR;
+        }
+    }
+
+    while ((eeQueueCount > 0U) && (eeWriteActive == false))
+    {
+        bl_ee_queue_run_t *run = &eeQueueRuns[eeRunTail];
+        bool counted = ((run->offset & BL_EE_QUEUE_UNCOUNTED) == 0U);
+
+        eeWriteAddress = EEPROM_START_ADDRESS_U + (run->offset & (uint16_t) ~BL_EE_QUEUE_UNCOUNTED);
+#if (BL_SKIP_UNCHANGED_ENABLE == 1U)
+        // The NVM is idle here, so the old byte can be read without disturbing a write
+        if (EEPROM_Read(eeWriteAddress) == eeQueueData[eeQueueTail])
+        {
+            eeQueueSkipped += counted ? 1U : 0U;
+        }
+        else
+#endif
+        {
+            NVM_UnlockKeySet(run->unlockKey);
+            EEPROM_Write(eeWriteAddress, eeQueueData[eeQueueTail]);
+            NVM_UnlockKeyClear();
+            eeWriteActive = true;
+            eeQueueProgrammed += counted ? 1U : 0U;
+        }
+
+        eeQueueTail = (eeQueueTail + 1U) & BL_EE_QUEUE_MASK;
+        eeQueueCount--;
+        run->offset++;
+        run->length--;
+        if (run->length == 0U)
+        {
+            // Do not keep the key in RAM longer than needed
+            run->unlockKey = 0U;
+            eeRunTail = (uint8_t) ((eeRunTail + 1U) % BL_EE_QUEUE_RUNS);
+            eeRunCount--;
+        }
+    }
+}
+
+void BL_EEQueueFlush(void)
+{
+    while ((eeQueueCount > 0U) || (eeWriteActive == true))
+    {
+        BL_EEQueueService();
+    }
+}
+
+nvm_status_t BL_EEQueueStatusGet(eeprom_address_t *address)
+{
+    nvm_status_t status = eeQueueStatus;
+
+    if (status != NVM_OK)
+    {
+        *address = eeQueueErrorAddress;
+    }
+    eeQueueStatus = NVM_OK;
+    return status;
+}
+
+void BL_EEQueueCountsGet(uint16_t *programmed, uint16_t *skipped)
+{
+    *programmed = eeQueueProgrammed;
+    *skipped = eeQueueSkipped;
+    eeQueueProgrammed = 0U;
+    eeQueueSkipped = 0U;
+}
+
+#endif
@@ -0,0 +1,118 @@
+/**
+ *
+ * @file bl_entry_request.c
+ *
+ * @ingroup generic_bootloader_8bit
+ *
+ * @brief This source file provides the application-requested bootloader entry of the 8-bit Bootloader library.
+ *        The application stores a magic value in a RAM word that the startup code of neither project clears,
+ *        or in an EEPROM cell, and executes RESET(). The bootloader checks for it before the pin settle delay
+ *        and the image verification, so a requested entry costs neither.
+ *
+ * @version BOOTLOADER Driver Version 3.0.0
+ */
+
+/*
+ [2023] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../bl_entry_request.h"
+#include "../bl_trace.h"
+
+#if (BL_ENTRY_REQUEST_ENABLE == 1U)
+
+// Absolute objects are not cleared by the runtime startup code
+static volatile uint32_t entryRequestWord __at(BL_ENTRY_REQUEST_RAM_ADDRESS);
+static bool eepromRequestPending = false;
+static uint16_t requestKey = 0U;
+
+uint8_t BL_EntryRequestCheck(void)
+{
+    uint8_t reason = BL_ENTRY_NONE;
+
+    // nRI is cleared by the RESET instruction and set again by any power-on or brown-out reset
+    if (PCON0bits.nRI == 0U)
+    {
+        if (entryRequestWord == BL_ENTRY_REQUEST_RAM_MAGIC)
+        {
+            reason = BL_ENTRY_RAM_REQUEST;
+        }
+        else if (entryRequestWord == BL_ENTRY_REQUEST_BREAK_MAGIC)
+        {
+            reason = BL_ENTRY_BREAK_REQUEST;
+        }
+        else if ((uint16_t) (entryRequestWord >> 16U) == BL_ENTRY_REQUEST_INSTALL_MAGIC)
+        {
+            reason = BL_ENTRY_INSTALL_REQUEST;
+            requestKey = (uint16_t) entryRequestWord;
+        }
+        else
+        {
+            // A reset of the application itself
+        }
+    }
+    if (reason != BL_ENTRY_NONE)
+    {
+        PCON0bits.nRI = 1U;
+    }
+    entryRequestWord = 0U;
+
+    if ((reason == BL_ENTRY_NONE)
+            && (EEPROM_Read((eeprom_address_t) BL_ENTRY_REQUEST_EEPROM) == BL_ENTRY_REQUEST_EEPROM_MAGIC))
+    {
+        eepromRequestPending = true;
+        reason = BL_ENTRY_EEPROM_REQUEST;
+    }
+
+    return reason;
+}
+
+uint16_t BL_EntryRequestKeyGet(void)
+{
+    return requestKey;
+}
+
+void BL_EntryRequestRelease(uint16_t unlockKey)
+{
+    nvm_status_t errorStatus;
+
+    if (eepromRequestPending == false)
+    {
+        return;
+    }
+    eepromRequestPending = false;
+
+    NVM_UnlockKeySet(unlockKey);
+    EEPROM_Write((eeprom_address_t) BL_ENTRY_REQUEST_EEPROM, 0xFFU);
+    NVM_UnlockKeyClear();
+    while (NVM_IsBusy() == true)
+    {
+    }
+    errorStatus = NVM_StatusGet();
+    if (errorStatus != NVM_OK)
+    {
+        BL_TRACE_EVENT(BL_TRACE_EVENT_NVM_ERROR, (uint8_t) errorStatus, (flash_address_t) BL_ENTRY_REQUEST_EEPROM);
+        NVM_StatusClear();
+    }
+}
+
+#endif
@@ -0,0 +1,204 @@
+/**
+ *
+ * @file bl_golden.c
+ *
+ * @ingroup generic_bootloader_8bit
+ *
+ * @brief This source file provides the golden image restore of the 8-bit Bootloader library.
+ *        The stream is expanded one page at a time. Back-references into earlier pages are read from the flash
+ *        that was already restored, so only one page of RAM is needed.
+ *
+ * @version BOOTLOADER Driver Version 3.0.0
+ */
+
+/*
+ [2023] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../bl_golden.h"
+#include "../bl_trace.h"
+
+#if (BL_GOLDEN_ENABLE == 1U)
+
+#define BL_GOLDEN_LENGTH_MASK       (0x0FU)
+#define BL_GOLDEN_LENGTH_EXTENDED   (0x0FU)
+#define BL_GOLDEN_MATCH_MIN         (3U)
+
+static flash_data_t goldenPage[PROGMEM_PAGE_SIZE];
+static flash_address_t goldenOut;
+static uint16_t goldenKey;
+static uint16_t goldenPages;
+static nvm_status_t goldenStatus;
+
+static uint32_t BL_GoldenRead32(flash_address_t address);
+static void BL_GoldenFlush(void);
+static void BL_GoldenPut(uint8_t data);
+static uint8_t BL_GoldenGet(flash_address_t address);
+
+static uint32_t BL_GoldenRead32(flash_address_t address)
+{
+    return (uint32_t) FLASH_Read(address) | ((uint32_t) FLASH_Read(address + 1U) << 8U)
+           | ((uint32_t) FLASH_Read(address + 2U) << 16U) | ((uint32_t) FLASH_Read(address + 3U) << 24U);
+}
+
+static void BL_GoldenFlush(void)
+{
+    flash_address_t pageAddress = goldenOut - PROGMEM_PAGE_SIZE;
+    bool changed = false;
+
+    for (uint16_t offset = 0U; offset < PROGMEM_PAGE_SIZE; offset++)
+    {
+        if (goldenPage[offset] != FLASH_Read(pageAddress + offset))
+        {
+            changed = true;
+        }
+    }
+    // Only the damaged pages are written
+    if ((changed == true) && (goldenStatus == NVM_OK))
+    {
+        NVM_UnlockKeySet(goldenKey);
+        goldenStatus = FLASH_PageErase(pageAddress);
+        NVM_UnlockKeyClear();
+        if (goldenStatus == NVM_OK)
+        {
+            NVM_UnlockKeySet(goldenKey);
+            goldenStatus = FLASH_RowWrite(pageAddress, goldenPage);
+            NVM_UnlockKeyClear();
+        }
+        if (goldenStatus != NVM_OK)
+        {
+            BL_TRACE_EVENT(BL_TRACE_EVENT_NVM_ERROR, (uint8_t) goldenStatus, pageAddress);
+            NVM_StatusClear();
+        }
+        else
+        {
+            goldenPages++;
+        }
+    }
+    BL_TRACE_TICK();
+}
+
+static void BL_GoldenPut(uint8_t data)
+{
+    goldenPage[goldenOut & (PROGMEM_PAGE_SIZE - 1U)] = data;
+    goldenOut++;
+    if ((goldenOut & (PROGMEM_PAGE_SIZE - 1U)) == 0U)
+    {
+        BL_GoldenFlush();
+    }
+}
+
+static uint8_t BL_GoldenGet(flash_address_t address)
+{
+    uint8_t data;
+
+    // The current page is still in RAM; everything before it is already in flash
+    if (address >= (goldenOut & ~((flash_address_t) PROGMEM_PAGE_SIZE - 1U)))
+    {
+        data = goldenPage[address & (PROGMEM_PAGE_SIZE - 1U)];
+    }
+    else
+    {
+        data = FLASH_Read(address);
+    }
+    return data;
+}
+
+uint8_t BL_GoldenRestore(void)
+{
+    flash_address_t in = BL_GOLDEN_ADDRESS + BL_GOLDEN_HEADER_SIZE;
+    flash_address_t end;
+    flash_address_t source;
+    uint32_t streamLength;
+    uint16_t streamSum = 0U;
+    uint16_t token;
+    uint16_t length;
+    uint8_t flags;
+    uint8_t result;
+
+    streamLength = BL_GoldenRead32(BL_GOLDEN_ADDRESS + 8U);
+    end = in + (flash_address_t) streamLength;
+    if (((FLASH_Read(BL_GOLDEN_ADDRESS) | ((uint16_t) FLASH_Read(BL_GOLDEN_ADDRESS + 1U) << 8U)) != BL_GOLDEN_MAGIC)
+            || (FLASH_Read(BL_GOLDEN_ADDRESS + 2U) != BL_GOLDEN_FORMAT)
+            || (BL_GoldenRead32(BL_GOLDEN_ADDRESS + 12U) != (BL_GOLDEN_ADDRESS - START_OF_APP))
+            || (streamLength > (PROGMEM_SIZE - BL_GOLDEN_ADDRESS - BL_GOLDEN_HEADER_SIZE)))
+    {
+        BL_TRACE_EVENT(BL_TRACE_EVENT_RESTORE, BL_GOLDEN_MISSING, 0U);
+        return BL_GOLDEN_MISSING;
+    }
+    for (source = in; source < end; source++)
+    {
+        streamSum += FLASH_Read(source);
+    }
+    if (streamSum != (FLASH_Read(BL_GOLDEN_ADDRESS + 6U) | ((uint16_t) FLASH_Read(BL_GOLDEN_ADDRESS + 7U) << 8U)))
+    {
+        BL_TRACE_EVENT(BL_TRACE_EVENT_RESTORE, BL_GOLDEN_MISSING, 0U);
+        return BL_GOLDEN_MISSING;
+    }
+
+    goldenKey = FLASH_Read(BL_GOLDEN_ADDRESS + 4U) | ((uint16_t) FLASH_Read(BL_GOLDEN_ADDRESS + 5U) << 8U);
+    goldenOut = START_OF_APP;
+    goldenPages = 0U;
+    goldenStatus = NVM_OK;
+
+    while ((in < end) && (goldenOut < BL_GOLDEN_ADDRESS) && (goldenStatus == NVM_OK))
+    {
+        flags = FLASH_Read(in++);
+        for (uint8_t item = 0U; (item < 8U) && (in < end) && (goldenOut < BL_GOLDEN_ADDRESS); item++)
+        {
+            if ((flags & 0x01U) != 0U)
+            {
+                BL_GoldenPut(FLASH_Read(in++));
+            }
+            else
+            {
+                token = FLASH_Read(in) | ((uint16_t) FLASH_Read(in + 1U) << 8U);
+                in += 2U;
+                length = (token & BL_GOLDEN_LENGTH_MASK) + BL_GOLDEN_MATCH_MIN;
+                if ((token & BL_GOLDEN_LENGTH_MASK) == BL_GOLDEN_LENGTH_EXTENDED)
+                {
+                    length += FLASH_Read(in++);
+                }
+                source = goldenOut - ((token >> 4U) + 1U);
+                // A distance before the application start only comes from a damaged stream
+                if (source < START_OF_APP)
+                {
+                    in = end;
+                    break;
+                }
+                while ((length > 0U) && (goldenOut < BL_GOLDEN_ADDRESS))
+                {
+                    BL_GoldenPut(BL_GoldenGet(source++));
+                    length--;
+                }
+            }
+            flags >>= 1U;
+        }
+    }
+
+    result = ((goldenOut == BL_GOLDEN_ADDRESS) && (goldenStatus == NVM_OK)) ? BL_GOLDEN_RESTORED : BL_GOLDEN_FAILED;
+    BL_TRACE_EVENT(BL_TRACE_EVENT_RESTORE, result, goldenPages);
+
+    return result;
+}
+
+#endif
@@ -0,0 +1,184 @@
+/**
+ *
+ * @file bl_journal.c
+ *
+ * @ingroup generic_bootloader_8bit
+ *
+ * @brief This source file provides the page journal of the 8-bit Bootloader library.
+ *
+ * @version BOOTLOADER Driver Version 3.0.0
+ */
+
+/*
+ [2023] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../bl_journal.h"
+#include "../bl_ee_queue.h"
+#include "../bl_trace.h"
+
+#if (BL_JOURNAL_ENABLE == 1U)
+
+#define BL_JOURNAL_BITMAP_ADDRESS   ((eeprom_address_t) BL_JOURNAL_ADDRESS + BL_JOURNAL_ID_SIZE)
+
+static nvm_status_t BL_JournalProgram(eeprom_address_t address, uint8_t data, uint16_t unlockKey);
+static eeprom_address_t BL_JournalBitAddress(flash_address_t pageAddress, uint8_t *mask);
+static nvm_status_t BL_JournalIdWrite(uint32_t imageId, uint16_t unlockKey);
+
+static nvm_status_t BL_JournalProgram(eeprom_address_t address, uint8_t data, uint16_t unlockKey)
+{
+    nvm_status_t errorStatus = NVM_OK;
+
+    if (EEPROM_Read(address) != data)
+    {
+        NVM_UnlockKeySet(unlockKey);
+        EEPROM_Write(address, data);
+        NVM_UnlockKeyClear();
+        while (NVM_IsBusy() == true)
+        {
+        }
+        errorStatus = NVM_StatusGet();
+        if (errorStatus != NVM_OK)
+        {
+            BL_TRACE_EVENT(BL_TRACE_EVENT_NVM_ERROR, (uint8_t) errorStatus, address);
+            NVM_StatusClear();
+        }
+    }
+    return errorStatus;
+}
+
+static eeprom_address_t BL_JournalBitAddress(flash_address_t pageAddress, uint8_t *mask)
+{
+    uint16_t page = (uint16_t) ((pageAddress - (flash_address_t) START_OF_APP) / PROGMEM_PAGE_SIZE);
+
+    *mask = (uint8_t) (1U << (page & 7U));
+    return BL_JOURNAL_BITMAP_ADDRESS + (page >> 3U);
+}
+
+static nvm_status_t BL_JournalIdWrite(uint32_t imageId, uint16_t unlockKey)
+{
+    nvm_status_t errorStatus = NVM_OK;
+
+    for (uint8_t i = 0U; (i < BL_JOURNAL_ID_SIZE) && (errorStatus == NVM_OK); i++)
+    {
+        errorStatus = BL_JournalProgram((eeprom_address_t) BL_JOURNAL_ADDRESS + i, (uint8_t) (imageId >> (8U * i)), unlockKey);
+    }
+    return errorStatus;
+}
+
+void BL_JournalPageCommitted(flash_address_t pageAddress, uint16_t unlockKey)
+{
+    eeprom_address_t address;
+    uint8_t mask;
+    uint8_t data;
+
+    if ((pageAddress < (flash_address_t) START_OF_APP) || (pageAddress >= (flash_address_t) PROGMEM_SIZE))
+    {
+        return;
+    }
+
+    address = BL_JournalBitAddress(pageAddress, &mask);
+    data = EEPROM_Read(address);
+    if ((data & mask) != 0U)
+    {
+        data &= (uint8_t) ~mask;
+#if (BL_EE_QUEUE_ENABLE == 1U)
+        // A failed write only makes the host send the page again
+        BL_EEQueueWrite(address, data, unlockKey, false);
+#else
+        (void) BL_JournalProgram(address, data, unlockKey);
+#endif
+    }
+}
+
+nvm_status_t BL_JournalPagesErased(flash_address_t pageAddress, uint16_t pages, uint16_t unlockKey)
+{
+    nvm_status_t errorStatus;
+    eeprom_address_t address;
+    eeprom_address_t byteAddress = 0U;
+    uint8_t mask;
+    uint8_t byteMask = 0U;
+
+    errorStatus = BL_JournalIdWrite(BL_JOURNAL_NO_IMAGE, unlockKey);
+
+    // The bits of the pages that share a bitmap byte are gathered, so each byte is programmed at most once
+    while ((pages > 0U) && (errorStatus == NVM_OK) && (pageAddress < (flash_address_t) PROGMEM_SIZE))
+    {
+        if (pageAddress >= (flash_address_t) START_OF_APP)
+        {
+            address = BL_JournalBitAddress(pageAddress, &mask);
+            if ((byteMask != 0U) && (address != byteAddress))
+            {
+                errorStatus = BL_JournalProgram(byteAddress, EEPROM_Read(byteAddress) | byteMask, unlockKey);
+                byteMask = 0U;
+            }
+            byteAddress = address;
+            byteMask |= mask;
+        }
+        pageAddress += PROGMEM_PAGE_SIZE;
+        pages--;
+    }
+    if ((byteMask != 0U) && (errorStatus == NVM_OK))
+    {
+        errorStatus = BL_JournalProgram(byteAddress, EEPROM_Read(byteAddress) | byteMask, unlockKey);
+    }
+    return errorStatus;
+}
+
+nvm_status_t BL_JournalBegin(uint32_t imageId, uint16_t unlockKey)
+{
+    nvm_status_t errorStatus;
+
+    if (imageId == BL_JOURNAL_NO_IMAGE)
+    {
+        return NVM_ERROR;
+    }
+
+    // The ID is cleared first and written last, so a reset in between leaves a journal of no image
+    errorStatus = BL_JournalIdWrite(BL_JOURNAL_NO_IMAGE, unlockKey);
+    for (uint16_t i = 0U; (i < BL_JOURNAL_BITMAP_SIZE) && (errorStatus == NVM_OK); i++)
+    {
+        errorStatus = BL_JournalProgram(BL_JOURNAL_BITMAP_ADDRESS + i, 0xFFU, unlockKey);
+    }
+    if (errorStatus == NVM_OK)
+    {
+        errorStatus = BL_JournalIdWrite(imageId, unlockKey);
+    }
+    return errorStatus;
+}
+
+uint16_t BL_JournalRead(uint8_t *data)
+{
+    for (uint8_t i = 0U; i < BL_JOURNAL_ID_SIZE; i++)
+    {
+        *data++ = EEPROM_Read((eeprom_address_t) BL_JOURNAL_ADDRESS + i);
+    }
+    *data++ = (uint8_t) BL_JOURNAL_PAGES;
+    *data++ = (uint8_t) (BL_JOURNAL_PAGES >> 8U);
+    for (uint16_t i = 0U; i < BL_JOURNAL_BITMAP_SIZE; i++)
+    {
+        *data++ = EEPROM_Read(BL_JOURNAL_BITMAP_ADDRESS + i);
+    }
+    return BL_JOURNAL_STATUS_SIZE;
+}
+
+#endif
@@ -0,0 +1,348 @@
+/**
+ *
+ * @file bl_log.c
+ *
+ * @ingroup generic_bootloader_8bit
+ *
+ * @brief This source file provides the record log of the 8-bit Bootloader library.
+ *
+ *        Record layout: KEY, VALUE (4 bytes, little endian), SEQUENCE (2 bytes, little endian), CHECK.
+ *        CHECK is the CRC-8 of the first 7 bytes with bit 7 cleared, so an erased check byte never matches.
+ *        The bytes are written in order, key first: a slot is in use as soon as its key is not 0xFF, and the
+ *        used slots of a bank always form one run from slot 0. A record torn by a reset keeps its slot but
+ *        fails the check and is ignored.
+ *
+ * @version BOOTLOADER Driver Version 3.0.0
+ */
+
+/*
+ [2023] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../bl_log.h"
+#include "../bl_trace.h"
+
+#if (BL_LOG_ENABLE == 1U)
+
+#define BL_LOG_SLOTS        ((uint8_t) (BL_LOG_BANK_SIZE / BL_LOG_RECORD_SIZE))
+#define BL_LOG_CRC_POLY     (0x07U)
+
+typedef struct
+{
+    uint8_t key;
+    uint32_t value;
+    uint16_t sequence;
+} bl_log_record_t;
+
+static bool logFormatted = false;
+static uint8_t logBank = 0U;
+static uint8_t logHead = 0U;
+static uint32_t logEpoch = 0U;
+static uint16_t logSequence = 0U;
+
+static eeprom_address_t BL_LogSlotAddress(uint8_t bank, uint8_t slot);
+static uint8_t BL_LogCheck(const uint8_t *data);
+static bool BL_LogSlotRead(uint8_t bank, uint8_t slot, bl_log_record_t *record);
+static nvm_status_t BL_LogProgram(eeprom_address_t address, const uint8_t *data, uint8_t length, uint16_t unlockKey);
+static nvm_status_t BL_LogSlotWrite(uint8_t bank, uint8_t slot, const bl_log_record_t *record, uint16_t unlockKey);
+static bool BL_LogBankHasKey(uint8_t bank, uint8_t slots, uint8_t key);
+static nvm_status_t BL_LogCompact(uint16_t unlockKey);
+
+static eeprom_address_t BL_LogSlotAddress(uint8_t bank, uint8_t slot)
+{
+    return (eeprom_address_t) BL_LOG_START_ADDRESS
+            + ((eeprom_address_t) bank * BL_LOG_BANK_SIZE)
+            + ((eeprom_address_t) slot * BL_LOG_RECORD_SIZE);
+}
+
+static uint8_t BL_LogCheck(const uint8_t *data)
+{
+    uint8_t crc = 0U;
+
+    for (uint8_t i = 0U; i < (BL_LOG_RECORD_SIZE - 1U); i++)
+    {
+        crc ^= data[i];
+        for (uint8_t bit = 0U; bit < 8U; bit++)
+        {
+            crc = ((crc & 0x80U) != 0U) ? (uint8_t) ((uint8_t) (crc << 1U) ^ BL_LOG_CRC_POLY) : (uint8_t) (crc << 1U);
+        }
+    }
+    return (uint8_t) (crc & 0x7FU);
+}
+
+static bool BL_LogSlotRead(uint8_t bank, uint8_t slot, bl_log_record_t *record)
+{
+    uint8_t raw[BL_LOG_RECORD_SIZE];
+    eeprom_address_t address = BL_LogSlotAddress(bank, slot);
+
+    for (uint8_t i = 0U; i < BL_LOG_RECORD_SIZE; i++)
+    {
+        raw[i] = EEPROM_Read(address + i);
+    }
+    if ((raw[0] == BL_LOG_KEY_FREE) || (BL_LogCheck(raw) != raw[BL_LOG_RECORD_SIZE - 1U]))
+    {
+        return false;
+    }
+
+    record->key = raw[0];
+    record->value = ((uint32_t) raw[4] << 24U) | ((uint32_t) raw[3] << 16U) | ((uint32_t) raw[2] << 8U) | (uint32_t) raw[1];
+    record->sequence = (uint16_t) (((uint16_t) raw[6] << 8U) | (uint16_t) raw[5]);
+    return true;
+}
+
+static nvm_status_t BL_LogProgram(eeprom_address_t address, const uint8_t *data, uint8_t length, uint16_t unlockKey)
+{
+    nvm_status_t errorStatus = NVM_OK;
+
+    for (uint8_t i = 0U; (i < length) && (errorStatus == NVM_OK); i++)
+    {
+        // Cells that already hold the byte are not worn again
+        if (EEPROM_Read(address) != data[i])
+        {
+            NVM_UnlockKeySet(unlockKey);
+            EEPROM_Write(address, data[i]);
+            NVM_UnlockKeyClear();
+            while (NVM_IsBusy() == true)
+            {
+            }
+            errorStatus = NVM_StatusGet();
+            if (errorStatus != NVM_OK)
+            {
+                BL_TRACE_EVENT(BL_TRACE_EVENT_NVM_ERROR, (uint8_t) errorStatus, address);
+                NVM_StatusClear();
+            }
+        }
+        address++;
+    }
+    return errorStatus;
+}
+
+static nvm_status_t BL_LogSlotWrite(uint8_t bank, uint8_t slot, const bl_log_record_t *record, uint16_t unlockKey)
+{
+    uint8_t raw[BL_LOG_RECORD_SIZE];
+
+    raw[0] = record->key;
+    raw[1] = (uint8_t) record->value;
+    raw[2] = (uint8_t) (record->value >> 8U);
+    raw[3] = (uint8_t) (record->value >> 16U);
+    raw[4] = (uint8_t) (record->value >> 24U);
+    raw[5] = (uint8_t) record->sequence;
+    raw[6] = (uint8_t) (record->sequence >> 8U);
+    raw[7] = BL_LogCheck(raw);
+
+    return BL_LogProgram(BL_LogSlotAddress(bank, slot), raw, BL_LOG_RECORD_SIZE, unlockKey);
+}
+
+static bool BL_LogBankHasKey(uint8_t bank, uint8_t slots, uint8_t key)
+{
+    for (uint8_t slot = 1U; slot < slots; slot++)
+    {
+        if (EEPROM_Read(BL_LogSlotAddress(bank, slot)) == key)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void BL_LogInitialize(void)
+{
+    bl_log_record_t header[2];
+    bool valid[2];
+    uint8_t low;
+    uint8_t high;
+    uint8_t middle;
+    bl_log_record_t record;
+
+    for (uint8_t bank = 0U; bank < 2U; bank++)
+    {
+        valid[bank] = BL_LogSlotRead(bank, 0U, &header[bank]) && (header[bank].key == BL_LOG_KEY_HEADER);
+    }
+
+    logFormatted = valid[0] || valid[1];
+    if (logFormatted == false)
+    {
+        return;
+    }
+
+    // The epoch wraps, so the newer header is the one ahead by less than half the range
+    if (valid[0] && valid[1])
+    {
+        logBank = ((int32_t) (header[1].value - header[0].value) > 0) ? 1U : 0U;
+    }
+    else
+    {
+        logBank = valid[1] ? 1U : 0U;
+    }
+    logEpoch = header[logBank].value;
+    logSequence = header[logBank].sequence;
+
+    // First free slot: the used slots form one run from slot 0
+    low = 1U;
+    high = BL_LOG_SLOTS;
+    while (low < high)
+    {
+        middle = (uint8_t) ((low + high) / 2U);
+        if (EEPROM_Read(BL_LogSlotAddress(logBank, middle)) == BL_LOG_KEY_FREE)
+        {
+            high = middle;
+        }
+        else
+        {
+            low = (uint8_t) (middle + 1U);
+        }
+    }
+    logHead = low;
+
+    // Continue the sequence after the newest intact record
+    for (uint8_t slot = logHead; slot > 1U;)
+    {
+        slot--;
+        if (BL_LogSlotRead(logBank, slot, &record) == true)
+        {
+            logSequence = record.sequence;
+            break;
+        }
+    }
+}
+
+bool BL_LogRead(uint8_t key, uint32_t *value)
+{
+    bl_log_record_t record;
+
+    if (logFormatted == false)
+    {
+        return false;
+    }
+
+    for (uint8_t slot = logHead; slot > 1U;)
+    {
+        slot--;
+        if ((BL_LogSlotRead(logBank, slot, &record) == true) && (record.key == key))
+        {
+            *value = record.value;
+            return true;
+        }
+    }
+    return false;
+}
+
+static nvm_status_t BL_LogCompact(uint16_t unlockKey)
+{
+    const uint8_t erased = BL_LOG_KEY_FREE;
+    uint8_t target = logBank ^ 1U;
+    uint8_t next = 1U;
+    nvm_status_t errorStatus = NVM_OK;
+    bl_log_record_t record;
+
+    // Erase the other bank; it is not active, so a reset here loses nothing
+    for (uint8_t i = 0U; (i < BL_LOG_BANK_SIZE) && (errorStatus == NVM_OK); i++)
+    {
+        errorStatus = BL_LogProgram(BL_LogSlotAddress(target, 0U) + i, &erased, 1U, unlockKey);
+    }
+
+    // Copy the newest intact record of each key, keeping its sequence number
+    for (uint8_t slot = logHead; (slot > 1U) && (errorStatus == NVM_OK);)
+    {
+        slot--;
+        if ((BL_LogSlotRead(logBank, slot, &record) == true) && (BL_LogBankHasKey(target, next, record.key) == false))
+        {
+            errorStatus = BL_LogSlotWrite(target, next, &record, unlockKey);
+            next++;
+        }
+    }
+
+    // The header is written last; until it is intact the old bank stays active
+    if (errorStatus == NVM_OK)
+    {
+        record.key = BL_LOG_KEY_HEADER;
+        record.value = logEpoch + 1U;
+        record.sequence = logSequence;
+        errorStatus = BL_LogSlotWrite(target, 0U, &record, unlockKey);
+    }
+
+    if (errorStatus == NVM_OK)
+    {
+        logBank = target;
+        logEpoch++;
+        logHead = next;
+        logFormatted = true;
+    }
+    return errorStatus;
+}
+
+nvm_status_t BL_LogWrite(uint8_t key, uint32_t value, uint16_t unlockKey)
+{
+    uint32_t current;
+    nvm_status_t errorStatus = NVM_OK;
+    bl_log_record_t record;
+
+    if ((key == BL_LOG_KEY_HEADER) || (key == BL_LOG_KEY_FREE))
+    {
+        return NVM_ERROR;
+    }
+    if ((BL_LogRead(key, &current) == true) && (current == value))
+    {
+        return NVM_OK;
+    }
+
+    if (logFormatted == false)
+    {
+        // Format by compacting an empty bank 1 into bank 0 with epoch 1
+        logBank = 1U;
+        logHead = 1U;
+        logEpoch = 0U;
+        logSequence = 0U;
+        errorStatus = BL_LogCompact(unlockKey);
+    }
+    else if (logHead >= BL_LOG_SLOTS)
+    {
+        errorStatus = BL_LogCompact(unlockKey);
+    }
+    else
+    {
+        // The active bank has room
+    }
+
+    if ((errorStatus == NVM_OK) && (logHead >= BL_LOG_SLOTS))
+    {
+        // Every slot holds the newest record of a different key
+        errorStatus = NVM_ERROR;
+    }
+
+    if (errorStatus == NVM_OK)
+    {
+        logSequence++;
+        record.key = key;
+        record.value = value;
+        record.sequence = logSequence;
+        errorStatus = BL_LogSlotWrite(logBank, logHead, &record, unlockKey);
+        // A record that failed after its key byte keeps its slot, so the used slots stay one run
+        if (EEPROM_Read(BL_LogSlotAddress(logBank, logHead)) != BL_LOG_KEY_FREE)
+        {
+            logHead++;
+        }
+    }
+    return errorStatus;
+}
+
+#endif
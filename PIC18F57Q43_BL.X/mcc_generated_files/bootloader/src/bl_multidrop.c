@@ -0,0 +1,177 @@
+/**
+ *
+ * @file bl_multidrop.c
+ *
+ * @ingroup generic_bootloader_8bit
+ *
+ * @brief This source file provides node addressing on a multi-drop (RS-485) bus for the 8-bit Bootloader library.
+ *        The node address travels in the otherwise unused ADDR_E header byte, so the frame layout is unchanged.
+ *
+ * @version BOOTLOADER Driver Version 3.0.0
+ */
+
+/*
+ [2023] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../bl_multidrop.h"
+
+#if (BL_MULTIDROP_ENABLE == 1U)
+
+static uint8_t nodeAddress = BL_NODE_ADDRESS;
+
+// Result of the broadcast frames since the last cleared POLL_STATUS
+static uint16_t broadcastFrames = 0U;
+static uint8_t broadcastStatus = COMMAND_SUCCESS;
+static uint8_t failedCommand = 0U;
+static uint8_t failedAddress_L = 0U;
+static uint8_t failedAddress_H = 0U;
+static uint8_t failedAddress_U = 0U;
+
+static void BL_MultidropClear(void);
+static bool BL_MultidropIsBroadcastCommand(uint8_t command);
+
+static void BL_MultidropClear(void)
+{
+    broadcastFrames = 0U;
+    broadcastStatus = COMMAND_SUCCESS;
+    failedCommand = 0U;
+    failedAddress_L = 0U;
+    failedAddress_H = 0U;
+    failedAddress_U = 0U;
+}
+
+static bool BL_MultidropIsBroadcastCommand(uint8_t command)
+{
+    // Only commands whose result can wait for a later poll may be broadcast
+    return ((command == WRITE_FLASH)
+            || (command == ERASE_FLASH)
+            || (command == WRITE_EE_DATA)
+            || (command == RESET_DEVICE));
+}
+
+void BL_MultidropInitialize(void)
+{
+    uint8_t storedAddress = EEPROM_Read(BL_NODE_ADDRESS_EEPROM);
+
+    // An erased or cleared cell leaves the build time address in place
+    if ((storedAddress != BL_NODE_LOCAL) && (storedAddress != BL_NODE_BROADCAST))
+    {
+        nodeAddress = storedAddress;
+    }
+    NVM_StatusClear();
+    BL_MultidropClear();
+}
+
+bl_route_t BL_MultidropRoute(const frame_t *frame)
+{
+    bl_route_t route;
+
+    if (BL_MULTIDROP_IS_REPLY(frame->command))
+    {
+        // Another node's reply, or the echo of our own on a half-duplex transceiver
+        route = BL_ROUTE_NONE;
+    }
+    else if (frame->address_E == BL_NODE_LOCAL)
+    {
+        route = BL_ROUTE_LOCAL;
+    }
+    else if (frame->address_E == BL_NODE_BROADCAST)
+    {
+        route = (BL_MultidropIsBroadcastCommand(frame->command) == true) ? BL_ROUTE_BROADCAST : BL_ROUTE_NONE;
+    }
+    else if ((frame->address_E == nodeAddress) && (nodeAddress != BL_NODE_LOCAL))
+    {
+        route = BL_ROUTE_NODE;
+    }
+    else
+    {
+        route = BL_ROUTE_NONE;
+    }
+
+    return route;
+}
+
+uint16_t BL_MultidropComplete(frame_t *frame, bl_route_t route, uint16_t length)
+{
+    if (route == BL_ROUTE_BROADCAST)
+    {
+        broadcastFrames++;
+        if ((broadcastStatus == COMMAND_SUCCESS) && (frame->data[0] != COMMAND_SUCCESS))
+        {
+            broadcastStatus = frame->data[0];
+            failedCommand = frame->command;
+            failedAddress_L = frame->address_L;
+            failedAddress_H = frame->address_H;
+            failedAddress_U = frame->address_U;
+        }
+        length = 0U;
+    }
+    else if (route == BL_ROUTE_NODE)
+    {
+        frame->command |= BL_REPLY_FLAG;
+        frame->data_length = length - BL_HEADER;
+    }
+    else
+    {
+        // BL_ROUTE_LOCAL replies are sent unchanged
+    }
+
+    return length;
+}
+
+// **************************************************************************************
+// Poll Status Payload
+// [NODE | BC_STATUS | BC_FRAMES_L | BC_FRAMES_H | FAIL_CMD | FAIL_ADDR_L | FAIL_ADDR_H | FAIL_ADDR_U]
+// BC_STATUS is the first non-success result among the broadcast frames since the last clear.
+// The host compares BC_FRAMES with the number it sent to find nodes that missed a frame.
+// **************************************************************************************
+uint16_t BL_MultidropStatus(uint8_t *data, bool clear)
+{
+    uint16_t dataIndex = 0U;
+
+    data[dataIndex] = nodeAddress;
+    dataIndex++;
+    data[dataIndex] = broadcastStatus;
+    dataIndex++;
+    data[dataIndex] = (uint8_t) broadcastFrames;
+    dataIndex++;
+    data[dataIndex] = (uint8_t) (broadcastFrames >> 8U);
+    dataIndex++;
+    data[dataIndex] = failedCommand;
+    dataIndex++;
+    data[dataIndex] = failedAddress_L;
+    dataIndex++;
+    data[dataIndex] = failedAddress_H;
+    dataIndex++;
+    data[dataIndex] = failedAddress_U;
+    dataIndex++;
+
+    if (clear == true)
+    {
+        BL_MultidropClear();
+    }
+
+    return dataIndex;
+}
+
+#endif
@@ -0,0 +1,259 @@
+/**
+ *
+ * @file bl_secure.c
+ *
+ * @ingroup generic_bootloader_8bit
+ *
+ * @brief This source file provides the AES-128-CCM page decryption of the SECURE_WRITE command.
+ *
+ * @version BOOTLOADER Driver Version 3.0.0
+ */
+
+/*
+ [2023] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#include <stdbool.h>
+#include "../bl_secure.h"
+
+#if (BL_CMD_SECURE_WRITE_ENABLE == 1U)
+
+#define BL_SECURE_ROUNDS        (10U)
+#define BL_SECURE_KEY_SIZE      (16U)
+#define BL_SECURE_SCHEDULE_SIZE ((BL_SECURE_ROUNDS + 1U) * BL_SECURE_BLOCK_SIZE)
+// CCM flags of the first authentication block: no associated data, M = 8 ((M - 2) / 2 << 3), L = 4 (L - 1)
+#define BL_SECURE_B0_FLAGS      (0x1BU)
+// CCM flags of the counter blocks: L = 4
+#define BL_SECURE_CTR_FLAGS     (0x03U)
+#define BL_SECURE_PAGE_BLOCKS   (PROGMEM_PAGE_SIZE / BL_SECURE_BLOCK_SIZE)
+// Multiplication by x in GF(2^8)
+#define BL_SECURE_XTIME(x)      ((uint8_t) (((uint8_t) ((x) << 1U)) ^ ((((x) & 0x80U) != 0U) ? 0x1BU : 0x00U)))
+
+#if (BL_SECURE_PAGE_BLOCKS > 255U)
+#error "BL_SecurePageOpen counts the blocks of a page in the last counter byte"
+#endif
+
+static void BL_SecureSubShift(uint8_t *block, const uint8_t *state);
+static void BL_SecureMixColumns(uint8_t *block);
+
+// Copied into RAM by BL_SecureInitialize: a RAM table is read with one indexed access, a flash table
+// with a table pointer load and TBLRD
+static const uint8_t sboxTable[256] = {
+    0x63U, 0x7CU, 0x77U, 0x7BU, 0xF2U, 0x6BU, 0x6FU, 0xC5U, 0x30U, 0x01U, 0x67U, 0x2BU, 0xFEU, 0xD7U, 0xABU, 0x76U,
+    0xCAU, 0x82U, 0xC9U, 0x7DU, 0xFAU, 0x59U, 0x47U, 0xF0U, 0xADU, 0xD4U, 0xA2U, 0xAFU, 0x9CU, 0xA4U, 0x72U, 0xC0U,
+    0xB7U, 0xFDU, 0x93U, 0x26U, 0x36U, 0x3FU, 0xF7U, 0xCCU, 0x34U, 0xA5U, 0xE5U, 0xF1U, 0x71U, 0xD8U, 0x31U, 0x15U,
+    0x04U, 0xC7U, 0x23U, 0xC3U, 0x18U, 0x96U, 0x05U, 0x9AU, 0x07U, 0x12U, 0x80U, 0xE2U, 0xEBU, 0x27U, 0xB2U, 0x75U,
+    0x09U, 0x83U, 0x2CU, 0x1AU, 0x1BU, 0x6EU, 0x5AU, 0xA0U, 0x52U, 0x3BU, 0xD6U, 0xB3U, 0x29U, 0xE3U, 0x2FU, 0x84U,
+    0x53U, 0xD1U, 0x00U, 0xEDU, 0x20U, 0xFCU, 0xB1U, 0x5BU, 0x6AU, 0xCBU, 0xBEU, 0x39U, 0x4AU, 0x4CU, 0x58U, 0xCFU,
+    0xD0U, 0xEFU, 0xAAU, 0xFBU, 0x43U, 0x4DU, 0x33U, 0x85U, 0x45U, 0xF9U, 0x02U, 0x7FU, 0x50U, 0x3CU, 0x9FU, 0xA8U,
+    0x51U, 0xA3U, 0x40U, 0x8FU, 0x92U, 0x9DU, 0x38U, 0xF5U, 0xBCU, 0xB6U, 0xDAU, 0x21U, 0x10U, 0xFFU, 0xF3U, 0xD2U,
+    0xCDU, 0x0CU, 0x13U, 0xECU, 0x5FU, 0x97U, 0x44U, 0x17U, 0xC4U, 0xA7U, 0x7EU, 0x3DU, 0x64U, 0x5DU, 0x19U, 0x73U,
+    0x60U, 0x81U, 0x4FU, 0xDCU, 0x22U, 0x2AU, 0x90U, 0x88U, 0x46U, 0xEEU, 0xB8U, 0x14U, 0xDEU, 0x5EU, 0x0BU, 0xDBU,
+    0xE0U, 0x32U, 0x3AU, 0x0AU, 0x49U, 0x06U, 0x24U, 0x5CU, 0xC2U, 0xD3U, 0xACU, 0x62U, 0x91U, 0x95U, 0xE4U, 0x79U,
+    0xE7U, 0xC8U, 0x37U, 0x6DU, 0x8DU, 0xD5U, 0x4EU, 0xA9U, 0x6CU, 0x56U, 0xF4U, 0xEAU, 0x65U, 0x7AU, 0xAEU, 0x08U,
+    0xBAU, 0x78U, 0x25U, 0x2EU, 0x1CU, 0xA6U, 0xB4U, 0xC6U, 0xE8U, 0xDDU, 0x74U, 0x1FU, 0x4BU, 0xBDU, 0x8BU, 0x8AU,
+    0x70U, 0x3EU, 0xB5U, 0x66U, 0x48U, 0x03U, 0xF6U, 0x0EU, 0x61U, 0x35U, 0x57U, 0xB9U, 0x86U, 0xC1U, 0x1DU, 0x9EU,
+    0xE1U, 0xF8U, 0x98U, 0x11U, 0x69U, 0xD9U, 0x8EU, 0x94U, 0x9BU, 0x1EU, 0x87U, 0xE9U, 0xCEU, 0x55U, 0x28U, 0xDFU,
+    0x8CU, 0xA1U, 0x89U, 0x0DU, 0xBFU, 0xE6U, 0x42U, 0x68U, 0x41U, 0x99U, 0x2DU, 0x0FU, 0xB0U, 0x54U, 0xBBU, 0x16U
+};
+
+static const uint8_t secureKey[BL_SECURE_KEY_SIZE] = BL_SECURE_KEY;
+
+static uint8_t sbox[256];
+static uint8_t roundKeys[BL_SECURE_SCHEDULE_SIZE];
+
+void BL_SecureInitialize(void)
+{
+    uint8_t rcon = 0x01U;
+    uint8_t t0;
+    uint8_t t1;
+    uint8_t t2;
+    uint8_t t3;
+
+    for (uint16_t i = 0U; i < 256U; i++)
+    {
+        sbox[i] = sboxTable[i];
+    }
+    for (uint8_t i = 0U; i < BL_SECURE_KEY_SIZE; i++)
+    {
+        roundKeys[i] = secureKey[i];
+    }
+    for (uint8_t i = BL_SECURE_KEY_SIZE; i < BL_SECURE_SCHEDULE_SIZE; i += 4U)
+    {
+        t0 = roundKeys[i - 4U];
+        t1 = roundKeys[i - 3U];
+        t2 = roundKeys[i - 2U];
+        t3 = roundKeys[i - 1U];
+        if ((i & (BL_SECURE_KEY_SIZE - 1U)) == 0U)
+        {
+            // RotWord, SubWord and the round constant
+            uint8_t first = t0;
+            t0 = sbox[t1] ^ rcon;
+            t1 = sbox[t2];
+            t2 = sbox[t3];
+            t3 = sbox[first];
+            rcon = BL_SECURE_XTIME(rcon);
+        }
+        roundKeys[i] = roundKeys[i - BL_SECURE_KEY_SIZE] ^ t0;
+        roundKeys[i + 1U] = roundKeys[i + 1U - BL_SECURE_KEY_SIZE] ^ t1;
+        roundKeys[i + 2U] = roundKeys[i + 2U - BL_SECURE_KEY_SIZE] ^ t2;
+        roundKeys[i + 3U] = roundKeys[i + 3U - BL_SECURE_KEY_SIZE] ^ t3;
+    }
+}
+
+static void BL_SecureMixColumns(uint8_t *block)
+{
+    uint8_t a0;
+    uint8_t a1;
+    uint8_t a2;
+    uint8_t a3;
+    uint8_t all;
+
+    for (uint8_t i = 0U; i < BL_SECURE_BLOCK_SIZE; i += 4U)
+    {
+        a0 = block[i];
+        a1 = block[i + 1U];
+        a2 = block[i + 2U];
+        a3 = block[i + 3U];
+        // 2a0 + 3a1 + a2 + a3 is a0 + (a0 + a1 + a2 + a3) + 2(a0 + a1), and so on for the other rows
+        all = a0 ^ a1 ^ a2 ^ a3;
+        block[i] = a0 ^ all ^ BL_SECURE_XTIME((uint8_t) (a0 ^ a1));
+        block[i + 1U] = a1 ^ all ^ BL_SECURE_XTIME((uint8_t) (a1 ^ a2));
+        block[i + 2U] = a2 ^ all ^ BL_SECURE_XTIME((uint8_t) (a2 ^ a3));
+        block[i + 3U] = a3 ^ all ^ BL_SECURE_XTIME((uint8_t) (a3 ^ a0));
+    }
+}
+
+static void BL_SecureSubShift(uint8_t *block, const uint8_t *state)
+{
+    // SubBytes and ShiftRows in one pass; the state is stored column by column
+    block[0] = sbox[state[0]];
+    block[1] = sbox[state[5]];
+    block[2] = sbox[state[10]];
+    block[3] = sbox[state[15]];
+    block[4] = sbox[state[4]];
+    block[5] = sbox[state[9]];
+    block[6] = sbox[state[14]];
+    block[7] = sbox[state[3]];
+    block[8] = sbox[state[8]];
+    block[9] = sbox[state[13]];
+    block[10] = sbox[state[2]];
+    block[11] = sbox[state[7]];
+    block[12] = sbox[state[12]];
+    block[13] = sbox[state[1]];
+    block[14] = sbox[state[6]];
+    block[15] = sbox[state[11]];
+}
+
+void BL_SecureBlockEncrypt(uint8_t *block)
+{
+    uint8_t state[BL_SECURE_BLOCK_SIZE];
+    const uint8_t *roundKey = roundKeys;
+
+    for (uint8_t i = 0U; i < BL_SECURE_BLOCK_SIZE; i++)
+    {
+        state[i] = block[i] ^ roundKey[i];
+    }
+    roundKey += BL_SECURE_BLOCK_SIZE;
+
+    for (uint8_t round = 1U; round < BL_SECURE_ROUNDS; round++)
+    {
+        BL_SecureSubShift(block, state);
+        BL_SecureMixColumns(block);
+        for (uint8_t i = 0U; i < BL_SECURE_BLOCK_SIZE; i++)
+        {
+            state[i] = block[i] ^ roundKey[i];
+        }
+        roundKey += BL_SECURE_BLOCK_SIZE;
+    }
+    // The last round has no MixColumns
+    BL_SecureSubShift(block, state);
+    for (uint8_t i = 0U; i < BL_SECURE_BLOCK_SIZE; i++)
+    {
+        block[i] ^= roundKey[i];
+    }
+}
+
+bool BL_SecurePageOpen(uint8_t *data, flash_address_t pageAddress)
+{
+    uint8_t counter[BL_SECURE_BLOCK_SIZE];
+    uint8_t stream[BL_SECURE_BLOCK_SIZE];
+    uint8_t mac[BL_SECURE_BLOCK_SIZE];
+    uint8_t *text = &data[BL_SECURE_NONCE_SIZE];
+    const uint8_t *tag = &data[BL_SECURE_NONCE_SIZE + PROGMEM_PAGE_SIZE];
+    uint8_t difference = 0U;
+
+    // Counter block A0 and authentication block B0: flags, image nonce, page address, then the counter
+    // or the message length, 4 bytes big-endian
+    counter[0] = BL_SECURE_CTR_FLAGS;
+    mac[0] = BL_SECURE_B0_FLAGS;
+    for (uint8_t i = 0U; i < BL_SECURE_NONCE_SIZE; i++)
+    {
+        counter[1U + i] = data[i];
+        mac[1U + i] = data[i];
+    }
+    counter[9] = (uint8_t) pageAddress;
+    counter[10] = (uint8_t) (pageAddress >> 8U);
+    counter[11] = (uint8_t) (pageAddress >> 16U);
+    mac[9] = counter[9];
+    mac[10] = counter[10];
+    mac[11] = counter[11];
+    counter[12] = 0U;
+    counter[13] = 0U;
+    counter[14] = 0U;
+    mac[12] = 0U;
+    mac[13] = 0U;
+    mac[14] = (uint8_t) (PROGMEM_PAGE_SIZE >> 8U);
+    mac[15] = (uint8_t) PROGMEM_PAGE_SIZE;
+    BL_SecureBlockEncrypt(mac);
+
+    // Decrypts each block with the keystream of counter 1 to n and adds the plaintext to the CBC-MAC
+    for (uint8_t block = 1U; block <= BL_SECURE_PAGE_BLOCKS; block++)
+    {
+        counter[15] = block;
+        for (uint8_t i = 0U; i < BL_SECURE_BLOCK_SIZE; i++)
+        {
+            stream[i] = counter[i];
+        }
+        BL_SecureBlockEncrypt(stream);
+        for (uint8_t i = 0U; i < BL_SECURE_BLOCK_SIZE; i++)
+        {
+            text[i] ^= stream[i];
+            mac[i] ^= text[i];
+        }
+        BL_SecureBlockEncrypt(mac);
+        text += BL_SECURE_BLOCK_SIZE;
+    }
+
+    // The tag is the CBC-MAC encrypted with the keystream of counter 0, compared without an early exit
+    counter[15] = 0U;
+    for (uint8_t i = 0U; i < BL_SECURE_BLOCK_SIZE; i++)
+    {
+        stream[i] = counter[i];
+    }
+    BL_SecureBlockEncrypt(stream);
+    for (uint8_t i = 0U; i < BL_SECURE_TAG_SIZE; i++)
+    {
+        difference |= (uint8_t) (mac[i] ^ stream[i] ^ tag[i]);
+    }
+
+    return (difference == 0U);
+}
+#endif
@@ -0,0 +1,231 @@
+/**
+ *
+ * @file bl_service.c
+ *
+ * @ingroup generic_bootloader_8bit
+ *
+ * @brief This source file provides the service table the 8-bit Bootloader library exports to the application.
+ *        The services run on the application clock and with its interrupts, and use the bootloader RAM only.
+ *
+ * @version BOOTLOADER Driver Version 3.0.0
+ */
+
+/*
+ [2023] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../bl_service.h"
+#include "../bl_log.h"
+
+#if (BL_SERVICE_ENABLE == 1U)
+
+static volatile bl_service_args_t serviceArgs __at(BL_SERVICE_ARGS_ADDRESS);
+
+const bl_service_header_t __at(BL_SERVICE_TABLE_ADDRESS) blServiceHeader __attribute__((used)) = {
+    .magic = BL_SERVICE_MAGIC,
+    .versionMajor = BL_SERVICE_VERSION_MAJOR,
+    .versionMinor = BL_SERVICE_VERSION_MINOR,
+    .count = BL_SERVICE_COUNT,
+    .reserved = {0xFFU, 0xFFU, 0xFFU},
+};
+
+void BL_ServiceCall(void) __attribute__((used));
+
+static bool BL_ServicePageCheck(void);
+static uint8_t BL_ServiceFlashRead(void);
+static uint8_t BL_ServiceFlashErase(void);
+static uint8_t BL_ServiceFlashWrite(void);
+static uint8_t BL_ServiceChecksum(void);
+static uint8_t BL_ServiceRecordRead(void);
+static uint8_t BL_ServiceRecordWrite(void);
+
+void __at(BL_SERVICE_ENTRY_ADDRESS) BL_ServiceCall(void)
+{
+    uint8_t status;
+
+    switch (serviceArgs.service)
+    {
+    case BL_SERVICE_FLASH_READ:
+        status = BL_ServiceFlashRead();
+        break;
+    case BL_SERVICE_FLASH_ERASE:
+        status = BL_ServiceFlashErase();
+        break;
+    case BL_SERVICE_FLASH_WRITE:
+        status = BL_ServiceFlashWrite();
+        break;
+    case BL_SERVICE_CHECKSUM:
+        status = BL_ServiceChecksum();
+        break;
+    case BL_SERVICE_RECORD_READ:
+        status = BL_ServiceRecordRead();
+        break;
+    case BL_SERVICE_RECORD_WRITE:
+        status = BL_ServiceRecordWrite();
+        break;
+    default:
+        status = ERROR_INVALID_COMMAND;
+        break;
+    }
+    serviceArgs.status = status;
+}
+
+static bool BL_ServicePageCheck(void)
+{
+    // The boot block, this table included, is never erased from the application
+    return (serviceArgs.address >= START_OF_APP) && (serviceArgs.address < PROGMEM_SIZE)
+           && ((serviceArgs.address & (PROGMEM_PAGE_SIZE - 1U)) == 0U);
+}
+
+static uint8_t BL_ServiceFlashRead(void)
+{
+    uint8_t *data = (uint8_t *) serviceArgs.buffer;
+    uint16_t length = serviceArgs.length;
+
+    if ((serviceArgs.address + length) > PROGMEM_SIZE)
+    {
+        return ERROR_ADDRESS_OUT_OF_RANGE;
+    }
+
+    // One table read with post-increment per byte, instead of reloading the table pointer like FLASH_Read
+    TBLPTRU = (uint8_t) (serviceArgs.address >> 16U);
+    TBLPTRH = (uint8_t) (serviceArgs.address >> 8U);
+    TBLPTRL = (uint8_t) serviceArgs.address;
+    while (length > 0U)
+    {
+        asm("TBLRD*+");
+        *data++ = TABLAT;
+        length--;
+    }
+    return COMMAND_SUCCESS;
+}
+
+static uint8_t BL_ServiceFlashErase(void)
+{
+    nvm_status_t errorStatus;
+
+    if (BL_ServicePageCheck() == false)
+    {
+        return ERROR_ADDRESS_OUT_OF_RANGE;
+    }
+
+    NVM_UnlockKeySet(serviceArgs.unlockKey);
+    errorStatus = FLASH_PageErase((flash_address_t) serviceArgs.address);
+    NVM_UnlockKeyClear();
+    NVM_StatusClear();
+
+    return (errorStatus == NVM_OK) ? COMMAND_SUCCESS : COMMAND_PROCESSING_ERROR;
+}
+
+static uint8_t BL_ServiceFlashWrite(void)
+{
+    nvm_status_t errorStatus;
+
+    if (BL_ServicePageCheck() == false)
+    {
+        return ERROR_ADDRESS_OUT_OF_RANGE;
+    }
+
+    NVM_UnlockKeySet(serviceArgs.unlockKey);
+    errorStatus = FLASH_PageErase((flash_address_t) serviceArgs.address);
+    NVM_UnlockKeyClear();
+    if (errorStatus == NVM_OK)
+    {
+        NVM_UnlockKeySet(serviceArgs.unlockKey);
+        errorStatus = FLASH_RowWrite((flash_address_t) serviceArgs.address, (flash_data_t *) serviceArgs.buffer);
+        NVM_UnlockKeyClear();
+    }
+    NVM_StatusClear();
+
+    return (errorStatus == NVM_OK) ? COMMAND_SUCCESS : COMMAND_PROCESSING_ERROR;
+}
+
+static uint8_t BL_ServiceChecksum(void)
+{
+    uint16_t checkSum = 0U;
+    uint16_t length = serviceArgs.length;
+
+    if ((serviceArgs.address + length) > PROGMEM_SIZE)
+    {
+        return ERROR_ADDRESS_OUT_OF_RANGE;
+    }
+
+    // Little-endian 16-bit words, the same sum as CALC_CHECKSUM
+    TBLPTRU = (uint8_t) (serviceArgs.address >> 16U);
+    TBLPTRH = (uint8_t) (serviceArgs.address >> 8U);
+    TBLPTRL = (uint8_t) serviceArgs.address;
+    while (length > 1U)
+    {
+        asm("TBLRD*+");
+        checkSum += (uint16_t) TABLAT;
+        asm("TBLRD*+");
+        checkSum += ((uint16_t) TABLAT) << 8U;
+        length -= 2U;
+    }
+    serviceArgs.value = checkSum;
+    return COMMAND_SUCCESS;
+}
+
+static uint8_t BL_ServiceRecordRead(void)
+{
+#if (BL_LOG_ENABLE == 1U)
+    uint32_t value;
+
+    if ((serviceArgs.address == BL_LOG_KEY_HEADER) || (serviceArgs.address >= BL_LOG_KEY_FREE))
+    {
+        return ERROR_ADDRESS_OUT_OF_RANGE;
+    }
+
+    // The log state in RAM is stale once the application has run
+    BL_LogInitialize();
+    if (BL_LogRead((uint8_t) serviceArgs.address, &value) == false)
+    {
+        return COMMAND_PROCESSING_ERROR;
+    }
+    serviceArgs.value = value;
+    return COMMAND_SUCCESS;
+#else
+    return ERROR_INVALID_COMMAND;
+#endif
+}
+
+static uint8_t BL_ServiceRecordWrite(void)
+{
+#if (BL_LOG_ENABLE == 1U)
+    nvm_status_t errorStatus;
+
+    if ((serviceArgs.address < BL_SERVICE_RECORD_KEY_FIRST) || (serviceArgs.address >= BL_LOG_KEY_FREE))
+    {
+        return ERROR_ADDRESS_OUT_OF_RANGE;
+    }
+
+    BL_LogInitialize();
+    errorStatus = BL_LogWrite((uint8_t) serviceArgs.address, serviceArgs.value, serviceArgs.unlockKey);
+    NVM_StatusClear();
+
+    return (errorStatus == NVM_OK) ? COMMAND_SUCCESS : COMMAND_PROCESSING_ERROR;
+#else
+    return ERROR_INVALID_COMMAND;
+#endif
+}
+
+#endif
@@ -0,0 +1,161 @@
+/**
+ *
+ * @file bl_slot.c
+ *
+ * @ingroup generic_bootloader_8bit
+ *
+ * @brief This source file provides the dual-slot install of the 8-bit Bootloader library.
+ *        Application images are linked to @ref START_OF_APP, so the download slot is copied into the execution
+ *        slot rather than started in place. The download slot itself is never written by the install.
+ *
+ * @version BOOTLOADER Driver Version 3.0.0
+ */
+
+/*
+ [2023] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../bl_slot.h"
+#include "../bl_trace.h"
+
+#if (BL_SLOT_ENABLE == 1U)
+
+static flash_data_t slotBuffer[PROGMEM_PAGE_SIZE];
+
+static nvm_status_t BL_SlotStateWrite(uint8_t offset, uint8_t data, uint16_t unlockKey);
+static nvm_status_t BL_SlotCopy(uint16_t unlockKey, uint16_t *pages);
+
+static nvm_status_t BL_SlotStateWrite(uint8_t offset, uint8_t data, uint16_t unlockKey)
+{
+    eeprom_address_t address = (eeprom_address_t) BL_SLOT_STATE_EEPROM + offset;
+    nvm_status_t errorStatus = NVM_OK;
+
+    if (EEPROM_Read(address) != data)
+    {
+        NVM_UnlockKeySet(unlockKey);
+        EEPROM_Write(address, data);
+        NVM_UnlockKeyClear();
+        while (NVM_IsBusy() == true)
+        {
+        }
+        errorStatus = NVM_StatusGet();
+        if (errorStatus != NVM_OK)
+        {
+            BL_TRACE_EVENT(BL_TRACE_EVENT_NVM_ERROR, (uint8_t) errorStatus, (flash_address_t) address);
+            NVM_StatusClear();
+        }
+    }
+    return errorStatus;
+}
+
+static nvm_status_t BL_SlotCopy(uint16_t unlockKey, uint16_t *pages)
+{
+    nvm_status_t errorStatus = NVM_OK;
+    flash_address_t target;
+    bool changed;
+
+    for (target = START_OF_APP; (target < BL_SLOT_B_ADDRESS) && (errorStatus == NVM_OK); target += PROGMEM_PAGE_SIZE)
+    {
+        changed = false;
+        for (uint16_t offset = 0U; offset < PROGMEM_PAGE_SIZE; offset++)
+        {
+            slotBuffer[offset] = FLASH_Read(target + BL_SLOT_SIZE + offset);
+            if (slotBuffer[offset] != FLASH_Read(target + offset))
+            {
+                changed = true;
+            }
+        }
+
+        // Pages copied before an interruption already match
+        if (changed == true)
+        {
+            NVM_UnlockKeySet(unlockKey);
+            errorStatus = FLASH_PageErase(target);
+            NVM_UnlockKeyClear();
+            if (errorStatus == NVM_OK)
+            {
+                NVM_UnlockKeySet(unlockKey);
+                errorStatus = FLASH_RowWrite(target, slotBuffer);
+                NVM_UnlockKeyClear();
+            }
+            if (errorStatus != NVM_OK)
+            {
+                BL_TRACE_EVENT(BL_TRACE_EVENT_NVM_ERROR, (uint8_t) errorStatus, target);
+                NVM_StatusClear();
+            }
+            else
+            {
+                (*pages)++;
+            }
+        }
+        BL_TRACE_TICK();
+    }
+    return errorStatus;
+}
+
+uint8_t BL_SlotInstall(bool requested, uint16_t unlockKey)
+{
+    uint8_t result;
+    uint16_t pages = 0U;
+    bool resumed = (EEPROM_Read((eeprom_address_t) BL_SLOT_STATE_EEPROM + 2U) == BL_SLOT_STATE_INSTALLING);
+
+    if (resumed == true)
+    {
+        unlockKey = (uint16_t) EEPROM_Read((eeprom_address_t) BL_SLOT_STATE_EEPROM)
+                    | ((uint16_t) EEPROM_Read((eeprom_address_t) BL_SLOT_STATE_EEPROM + 1U) << 8U);
+    }
+    else if (requested == false)
+    {
+        return BL_SLOT_NONE;
+    }
+    else
+    {
+        // A new request
+    }
+
+    if (BL_bootVerifyImage(BL_SLOT_B_ADDRESS) == false)
+    {
+        result = BL_SLOT_REJECTED;
+    }
+    else
+    {
+        result = BL_SLOT_FAILED;
+        // The key goes in before the state byte, so that a torn write leaves the state idle
+        if ((resumed == true)
+                || ((BL_SlotStateWrite(0U, (uint8_t) unlockKey, unlockKey) == NVM_OK)
+                    && (BL_SlotStateWrite(1U, (uint8_t) (unlockKey >> 8U), unlockKey) == NVM_OK)
+                    && (BL_SlotStateWrite(2U, BL_SLOT_STATE_INSTALLING, unlockKey) == NVM_OK)))
+        {
+            if ((BL_SlotCopy(unlockKey, &pages) == NVM_OK) && (BL_bootVerifyImage(START_OF_APP) == true))
+            {
+                result = (resumed == true) ? BL_SLOT_RESUMED : BL_SLOT_INSTALLED;
+            }
+        }
+    }
+
+    (void) BL_SlotStateWrite(2U, 0xFFU, unlockKey);
+    BL_TRACE_EVENT(BL_TRACE_EVENT_INSTALL, result, pages);
+
+    return result;
+}
+
+#endif
@@ -0,0 +1,151 @@
+/**
+ *
+ * @file bl_trace.c
+ *
+ * @ingroup generic_bootloader_8bit
+ *
+ * @brief This source file provides the protocol trace ring of the 8-bit Bootloader library.
+ *        Recording is a pointer bump and nine byte copies so that it can stay enabled in production.
+ *
+ * @version BOOTLOADER Driver Version 3.0.0
+ */
+
+/*
+ [2023] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#include <stdint.h>
+#include "../bl_trace.h"
+#include "../../timer/tmr0.h"
+
+#if (BL_TRACE_ENABLE == 1U)
+
+static bl_trace_record_t traceRing[BL_TRACE_DEPTH];
+static bl_trace_record_t *traceHead = traceRing;
+static uint16_t traceCount = 0U;
+// TMR0 wraps counted by BL_TraceTick, the upper byte of the timestamps
+static uint8_t traceOverflows = 0U;
+
+static bl_trace_record_t *BL_TraceNext(void);
+
+static bl_trace_record_t *BL_TraceNext(void)
+{
+    bl_trace_record_t *record = traceHead;
+    uint8_t overflows;
+
+    traceHead++;
+    if (traceHead == &traceRing[BL_TRACE_DEPTH])
+    {
+        traceHead = traceRing;
+    }
+    traceCount++;
+    // Read again if TMR0 wrapped around the read, so the count and the counter match
+    do
+    {
+        BL_TraceTick();
+        overflows = traceOverflows;
+        record->timestamp = TMR0_CounterGet();
+        BL_TraceTick();
+    } while (overflows != traceOverflows);
+    record->timestamp_U = overflows;
+
+    return record;
+}
+
+void BL_TraceTick(void)
+{
+    if (TMR0_OverflowStatusGet() == true)
+    {
+        TMR0_OverflowStatusClear();
+        traceOverflows++;
+    }
+}
+
+void BL_TraceClear(void)
+{
+    traceHead = traceRing;
+    traceCount = 0U;
+}
+
+void BL_TraceFrame(const frame_t *frame)
+{
+    bl_trace_record_t *record = BL_TraceNext();
+
+    record->command = frame->command;
+    record->status = frame->data[0];
+    record->length = frame->data_length;
+    record->address_L = frame->address_L;
+    record->address_H = frame->address_H;
+    record->address_U = frame->address_U;
+}
+
+void BL_TraceEvent(uint8_t event, uint8_t status, flash_address_t address)
+{
+    bl_trace_record_t *record = BL_TraceNext();
+
+    record->command = event;
+    record->status = status;
+    record->length = 0U;
+    record->address_L = (uint8_t) address;
+    record->address_H = (uint8_t) (address >> 8U);
+    record->address_U = (uint8_t) (address >> 16U);
+}
+
+// **************************************************************************************
+// Trace Dump Payload
+// [RECORD_SIZE | DEPTH | COUNT_L | COUNT_H | TICK_US | RESERVED | RECORD 0 |...| RECORD DEPTH-1]
+// COUNT is the total number of records logged since the last clear, so COUNT > DEPTH
+// means the oldest records were overwritten. Records are sent oldest first.
+// **************************************************************************************
+uint16_t BL_TraceRead(uint8_t *data)
+{
+    const uint8_t *source = (const uint8_t *) traceHead;
+    const uint8_t *ringEnd = (const uint8_t *) &traceRing[BL_TRACE_DEPTH];
+    uint16_t dataIndex = 0U;
+
+    data[dataIndex] = BL_TRACE_RECORD_SIZE;
+    dataIndex++;
+    data[dataIndex] = BL_TRACE_DEPTH;
+    dataIndex++;
+    data[dataIndex] = (uint8_t) traceCount;
+    dataIndex++;
+    data[dataIndex] = (uint8_t) (traceCount >> 8U);
+    dataIndex++;
+    data[dataIndex] = TMR0_TICK_PERIOD_US;
+    dataIndex++;
+    data[dataIndex] = 0U;
+    dataIndex++;
+
+    // The slot at the head is the oldest record once the ring has wrapped
+    for (uint16_t i = 0U; i < (BL_TRACE_DEPTH * BL_TRACE_RECORD_SIZE); i++)
+    {
+        data[dataIndex] = *source;
+        dataIndex++;
+        source++;
+        if (source == ringEnd)
+        {
+            source = (const uint8_t *) traceRing;
+        }
+    }
+
+    return dataIndex;
+}
+
+#endif
@@ -0,0 +1,225 @@
+/**
+ *
+ * @file bl_transport_spi.c
+ *
+ * @ingroup generic_bootloader_8bit
+ *
+ * @brief This source file provides the SPI1 target mode transport backend of the 8-bit Bootloader library.
+ *        DMA1 copies every received byte into a 256 byte ring, so the host may clock frames at several MHz
+ *        without the byte-wise frame loop having to keep up with each byte. DMA2 feeds the transmit FIFO:
+ *        with idle bytes while there is no reply, then with the reply itself.
+ *
+ *        The host sends a frame, then keeps clocking until it reads the STX byte (0x55) and clocks in the rest of
+ *        the reply. Bytes it clocks out meanwhile are idle bytes, which the wait for the next STX skips.
+ *
+ * @version BOOTLOADER Driver Version 3.0.0
+ */
+
+/*
+ [2023] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../bl_transport.h"
+
+#if (BL_TRANSPORT_SELECT == BL_TRANSPORT_SPI)
+
+#define  STX   0x55
+
+// DMA channels (DMASELECT values) and their start triggers (interrupt vector numbers of SPI1RX and SPI1TX)
+#define BL_SPI_RX_DMA               (0x00U)
+#define BL_SPI_TX_DMA               (0x01U)
+#define BL_SPI_RX_DMA_TRIGGER       (0x18U)
+#define BL_SPI_TX_DMA_TRIGGER       (0x19U)
+
+// Pin mapping: SCK on RC3, SDI on RC4, SDO on RC5 and SS on RA5; adjust to the board wiring
+#define BL_SPI_SCK_PPS_INPUT        (0x13U)
+#define BL_SPI_SDI_PPS_INPUT        (0x14U)
+#define BL_SPI_SS_PPS_INPUT         (0x05U)
+#define BL_SPI_SDO_PPS_OUTPUT       (0x32U)
+
+// Byte clocked out while no reply is pending; never equal to STX
+#define BL_SPI_IDLE                 (0x00U)
+
+// The uint8_t ring indexes wrap with it, so BL_TRANSPORT_RX_DEPTH stays 256
+static uint8_t spiRxRing[BL_TRANSPORT_RX_DEPTH];
+static uint8_t spiRxTail = 0U;
+static uint8_t spiIdle = BL_SPI_IDLE;
+
+static void BL_SpiInitialize(void);
+static void BL_SpiFrameSync(void);
+static void BL_SpiRead(uint8_t *data, size_t dataLength);
+static void BL_SpiWrite(uint8_t *data, size_t dataLength);
+static bool BL_SpiIsTxDone(void);
+static void BL_SpiTxIdle(void);
+
+const bl_transport_t BL_SPI_TRANSPORT = {
+    .Initialize = &BL_SpiInitialize,
+    .FrameSync = &BL_SpiFrameSync,
+    .Read = &BL_SpiRead,
+    .Write = &BL_SpiWrite,
+    .IsTxDone = &BL_SpiIsTxDone,
+};
+
+static void BL_SpiInitialize(void)
+{
+    // PPS and pin directions for SPI1 in target mode
+    ANSELCbits.ANSELC3 = 0U;
+    ANSELCbits.ANSELC4 = 0U;
+    ANSELCbits.ANSELC5 = 0U;
+    ANSELAbits.ANSELA5 = 0U;
+    TRISCbits.TRISC3 = 1U;
+    TRISCbits.TRISC4 = 1U;
+    TRISCbits.TRISC5 = 0U;
+    TRISAbits.TRISA5 = 1U;
+    SPI1SCKPPS = BL_SPI_SCK_PPS_INPUT;
+    SPI1SDIPPS = BL_SPI_SDI_PPS_INPUT;
+    SPI1SSPPS = BL_SPI_SS_PPS_INPUT;
+    RC5PPS = BL_SPI_SDO_PPS_OUTPUT;
+
+    // Target mode 0, 8-bit transfers, active-low SS, full duplex
+    SPI1CON0 = 0x00U;
+    SPI1CON1 = 0x44U;
+    SPI1CON2 = 0x03U;
+    SPI1TWIDTH = 0x00U;
+    SPI1STATUSbits.CLRBF = 1U;
+    SPI1CON0bits.BMODE = 1U;
+    SPI1CON0bits.EN = 1U;
+
+    // DMA only runs once the system arbiter priorities are locked
+    DMA1PR = 0x00U;
+    DMA2PR = 0x01U;
+    ISRPR = 0x02U;
+    MAINPR = 0x03U;
+    PRLOCK = 0x55U;
+    PRLOCK = 0xAAU;
+    PRLOCKbits.PRLOCKED = 1U;
+
+    // Receive ring: SPI1RXB -> spiRxRing, endless
+    DMASELECT = BL_SPI_RX_DMA;
+    DMAnCON0 = 0x00U;
+    DMAnCON1bits.DMODE = 1U;
+    DMAnCON1bits.DSTP = 0U;
+    DMAnCON1bits.SMR = 0U;
+    DMAnCON1bits.SMODE = 0U;
+    DMAnCON1bits.SSTP = 0U;
+    DMAnSSA = (uint24_t) &SPI1RXB;
+    DMAnSSZ = 1U;
+    DMAnDSA = (uint16_t) spiRxRing;
+    DMAnDSZ = sizeof(spiRxRing);
+    DMAnSIRQ = BL_SPI_RX_DMA_TRIGGER;
+    DMAnAIRQ = 0x00U;
+    DMAnCON0bits.EN = 1U;
+    DMAnCON0bits.SIRQEN = 1U;
+
+    BL_SpiTxIdle();
+}
+
+static void BL_SpiTxIdle(void)
+{
+    // spiIdle -> SPI1TXB whenever the transmit FIFO has room
+    DMASELECT = BL_SPI_TX_DMA;
+    DMAnCON0 = 0x00U;
+    DMAnCON1bits.DMODE = 0U;
+    DMAnCON1bits.DSTP = 0U;
+    DMAnCON1bits.SMR = 0U;
+    DMAnCON1bits.SMODE = 0U;
+    DMAnCON1bits.SSTP = 0U;
+    DMAnSSA = (uint24_t) &spiIdle;
+    DMAnSSZ = 1U;
+    DMAnDSA = (uint16_t) &SPI1TXB;
+    DMAnDSZ = 1U;
+    DMAnSIRQ = BL_SPI_TX_DMA_TRIGGER;
+    DMAnAIRQ = 0x00U;
+    DMAnCON0bits.EN = 1U;
+    DMAnCON0bits.SIRQEN = 1U;
+}
+
+static void BL_SpiFrameSync(void)
+{
+    uint8_t ch;
+
+    // The ring is not restarted: the next frame may already be arriving. If the idle bytes clocked for the last
+    // reply overran the ring, only the oldest of them are lost, as the unread bytes are the latest ones.
+    do
+    {
+        BL_SpiRead(&ch, 1U);
+    } while (ch != STX);
+}
+
+static void BL_SpiRead(uint8_t *data, size_t dataLength)
+{
+    uint8_t head;
+
+    DMASELECT = BL_SPI_RX_DMA;
+    while (dataLength > 0U)
+    {
+        head = (uint8_t) (DMAnDPTR - (uint16_t) spiRxRing);
+        if (head != spiRxTail)
+        {
+            *data++ = spiRxRing[spiRxTail];
+            spiRxTail++;
+            dataLength--;
+        }
+        else
+        {
+            BL_TRANSPORT_IDLE();
+        }
+    }
+}
+
+static void BL_SpiWrite(uint8_t *data, size_t dataLength)
+{
+    // Stop the idle bytes; the host drains the ones already queued while it polls
+    DMASELECT = BL_SPI_TX_DMA;
+    DMAnCON0bits.SIRQEN = 0U;
+    DMAnCON0bits.EN = 0U;
+    while (SPI1STATUSbits.TXBE == 0U)
+    {
+        BL_TRANSPORT_IDLE();
+    }
+
+    // data -> SPI1TXB, stopping after the last byte; armed before STX so that the reply follows it without a gap
+    DMAnCON1bits.SMODE = 1U;
+    DMAnCON1bits.SSTP = 1U;
+    DMAnSSA = (uint24_t) data;
+    DMAnSSZ = (uint16_t) dataLength;
+    DMAnCON0bits.EN = 1U;
+    SPI1TXB = STX;
+    DMAnCON0bits.SIRQEN = 1U;
+}
+
+static bool BL_SpiIsTxDone(void)
+{
+    bool status = false;
+
+    DMASELECT = BL_SPI_TX_DMA;
+    // SSTP clears SIRQEN once the last reply byte has been moved into the FIFO
+    if ((DMAnCON0bits.SIRQEN == 0U) && (SPI1STATUSbits.TXBE == 1U))
+    {
+        BL_SpiTxIdle();
+        status = true;
+    }
+
+    return status;
+}
+
+#endif
@@ -46,6 +46,7 @@ void SYSTEM_Initialize(void)
     PIN_MANAGER_Initialize();
     NVM_Initialize();
     UART1_Initialize();
+    TMR0_Initialize();
     INTERRUPT_Initialize();
     BL_Initialize();
 }
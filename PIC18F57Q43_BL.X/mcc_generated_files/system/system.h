@@ -46,6 +46,7 @@
 #include "../system/pins.h"
 #include "../nvm/nvm.h"
 #include "../uart/uart1.h"
+#include "../timer/tmr0.h"
 #include "../system/interrupt.h"
 #include "../bootloader/bl_bootload.h"
 
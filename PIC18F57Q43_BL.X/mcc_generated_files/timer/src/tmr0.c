@@ -0,0 +1,100 @@
+/**
+ * TMR0 Generated Driver File
+ * 
+ * @file tmr0.c
+ * 
+ * @ingroup tmr0
+ * 
+ * @brief This file contains the API implementations for the TMR0 driver.
+ *
+ * @version TMR0 Driver Version 3.0.0
+*/
+/*
+ [2023] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#include <xc.h>
+#include "../tmr0.h"
+
+void TMR0_Initialize(void)
+{
+    //TMR0H 0; 
+    TMR0H = 0x0;
+    //TMR0L 0; 
+    TMR0L = 0x0;
+    //T0CS FOSC/4; T0CKPS 1:256; T0ASYNC synchronised; 
+    T0CON1 = 0x48;
+    //TMR0IF cleared
+    PIR3bits.TMR0IF = 0;
+    //TMR0IE disabled
+    PIE3bits.TMR0IE = 0;
+    //T0OUTPS 1:1; T0EN enabled; T016BIT 16-bit; 
+    T0CON0 = 0x90;
+}
+
+void TMR0_Deinitialize(void)
+{
+    T0CON0bits.EN = 0;
+    PIR3bits.TMR0IF = 0;
+    PIE3bits.TMR0IE = 0;
+    T0CON0 = 0x0;
+    T0CON1 = 0x0;
+    TMR0H = 0xFF;
+    TMR0L = 0x0;
+}
+
+void TMR0_Start(void)
+{
+    T0CON0bits.EN = 1;
+}
+
+void TMR0_Stop(void)
+{
+    T0CON0bits.EN = 0;
+}
+
+uint16_t TMR0_CounterGet(void)
+{
+    uint16_t counterValue;
+    uint8_t counterLowByte;
+
+    // Reading TMR0L latches TMR0H in 16-bit mode
+    counterLowByte = TMR0L;
+    counterValue = ((uint16_t) TMR0H << 8U) | counterLowByte;
+
+    return counterValue;
+}
+
+void TMR0_CounterSet(uint16_t counterValue)
+{
+    // TMR0H is a write buffer that is transferred on the TMR0L write
+    TMR0H = (uint8_t) (counterValue >> 8U);
+    TMR0L = (uint8_t) counterValue;
+}
+
+bool TMR0_OverflowStatusGet(void)
+{
+    return (PIR3bits.TMR0IF == 1U);
+}
+
+void TMR0_OverflowStatusClear(void)
+{
+    PIR3bits.TMR0IF = 0;
+}
@@ -0,0 +1,111 @@
+/**
+ * TMR0 Generated Driver API Header File
+ * 
+ * @file tmr0.h
+ * 
+ * @defgroup tmr0 TMR0
+ * 
+ * @brief This file contains the API prototypes for the TMR0 driver.
+ *
+ * @version TMR0 Driver Version 3.0.0
+*/
+/*
+ [2023] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef TMR0_H
+#define TMR0_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @ingroup tmr0
+ * @def TMR0_TICK_PERIOD_US
+ * This is a macro for the period of one TMR0 count in microseconds (FOSC/4, 1:256 prescaler).
+ */
+#define TMR0_TICK_PERIOD_US     (16U)
+
+/**
+ * @ingroup tmr0
+ * @brief Initializes TMR0 as a free-running 16-bit counter and starts it.
+ * @param None
+ * @return None
+ */
+void TMR0_Initialize(void);
+
+/**
+ * @ingroup tmr0
+ * @brief Stops TMR0 and restores the registers to their reset values.
+ * @param None
+ * @return None
+ */
+void TMR0_Deinitialize(void);
+
+/**
+ * @ingroup tmr0
+ * @brief Starts TMR0.
+ * @param None
+ * @return None
+ */
+void TMR0_Start(void);
+
+/**
+ * @ingroup tmr0
+ * @brief Stops TMR0.
+ * @param None
+ * @return None
+ */
+void TMR0_Stop(void);
+
+/**
+ * @ingroup tmr0
+ * @brief Reads the 16-bit TMR0 counter value.
+ * @param None
+ * @return Current counter value
+ */
+uint16_t TMR0_CounterGet(void);
+
+/**
+ * @ingroup tmr0
+ * @brief Writes the 16-bit TMR0 counter value.
+ * @param [in] counterValue - Value to load into the counter
+ * @return None
+ */
+void TMR0_CounterSet(uint16_t counterValue);
+
+/**
+ * @ingroup tmr0
+ * @brief Reads the overflow flag (TMR0IF), set when the counter wraps from 0xFFFF to 0.
+ * @param None
+ * @retval true - The counter wrapped since the flag was last cleared
+ * @retval false - No wrap since the flag was last cleared
+ */
+bool TMR0_OverflowStatusGet(void);
+
+/**
+ * @ingroup tmr0
+ * @brief Clears the overflow flag (TMR0IF).
+ * @param None
+ * @return None
+ */
+void TMR0_OverflowStatusClear(void);
+
+#endif // TMR0_H
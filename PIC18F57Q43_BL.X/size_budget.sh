@@ -0,0 +1,110 @@
+#!/bin/bash
+#
+#  Program memory budget of the bootloader per feature, for each MPLAB configuration of this project.
+#
+#    ./size_budget.sh [CONF...]      (default: every configuration in nbproject/configurations.xml)
+#
+#  Needs xc8-cc on PATH. Set DFP to the xc8 directory of the PIC18F-Q_DFP pack if the compiler does not find the device.
+#  Each configuration is built once as configured, then once per feature toggle with that toggle flipped.
+#  The flipped builds may use the whole flash, so that a feature that does not fit is still measured.
+#
+
+set -u
+cd "$(dirname "$0")"
+
+CONFIG=nbproject/configurations.xml
+FEATURES="BL_TRACE_ENABLE BL_EE_QUEUE_ENABLE BL_SKIP_UNCHANGED_ENABLE BL_SKIP_BLANK_ENABLE BL_ERASED_MAP_ENABLE
+          BL_LOG_ENABLE BL_JOURNAL_ENABLE BL_ENTRY_REQUEST_ENABLE BL_SERVICE_ENABLE BL_SLOT_ENABLE BL_GOLDEN_ENABLE
+          BL_MULTIDROP_ENABLE BL_COMPACT_REPLY_ENABLE
+          BL_CMD_READ_FLASH_ENABLE BL_CMD_READ_EE_DATA_ENABLE BL_CMD_WRITE_EE_DATA_ENABLE
+          BL_CMD_READ_CONFIG_ENABLE BL_CMD_WRITE_CONFIG_ENABLE BL_CMD_CALC_CHECKSUM_ENABLE BL_CMD_BATCH_ENABLE
+          BL_CMD_BLANK_CHECK_ENABLE BL_CMD_PATCH_ENABLE BL_CMD_SECURE_WRITE_ENABLE BL_CMD_DIGEST_ENABLE
+          BL_DIGEST_VERIFY_ENABLE"
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+SOURCES=$(sed -n 's:.*<itemPath>\(.*\.c\)</itemPath>.*:\1:p' "$CONFIG")
+
+# Value of a property of a configuration; the value may sit on the line after the key
+property()
+{
+    awk -v conf="$1" -v key="$2" '
+        $0 ~ "<conf name=\"" conf "\"" { inside = 1 }
+        inside && $0 ~ "</conf>" { inside = 0 }
+        inside && $0 ~ "key=\"" key "\"" { pending = 1 }
+        pending && match($0, /value="[^"]*"/) { print substr($0, RSTART + 7, RLENGTH - 8); exit }
+    ' "$CONFIG"
+}
+
+# Bytes of program memory used, or nothing if the build failed
+build()
+{
+    local rom=$1
+    shift
+    xc8-cc -mcpu=18F57Q43 ${DFP:+-mdfp="$DFP"} -O2 -std=c99 -fshort-enums -mrom="$rom" "$@" \
+        -o "$WORK/bl.elf" $SOURCES > "$WORK/build.log" 2>&1 || return
+    sed -n 's/.*Program space *used *[0-9A-Fa-f]*h *( *\([0-9]*\)).*/\1/p' "$WORK/build.log"
+}
+
+# Highest program memory address in the HEX file of the last build
+highest()
+{
+    awk '
+        function hex(text,    value, i) {
+            value = 0
+            for (i = 1; i <= length(text); i++) { value = value * 16 + index("0123456789ABCDEF", toupper(substr(text, i, 1))) - 1 }
+            return value
+        }
+        /^:/ {
+            length_ = hex(substr($0, 2, 2)); address = hex(substr($0, 4, 4)); type = substr($0, 8, 2)
+            if (type == "04") { upper = hex(substr($0, 10, 4)) * 65536 }
+            if ((type == "00") && (length_ > 0) && ((upper + address) < 2097152) && ((upper + address + length_ - 1) > top)) { top = upper + address + length_ - 1 }
+        }
+        END { printf "%d\n", top }
+    ' "$WORK/bl.hex"
+}
+
+# Value of a toggle in a configuration: its -D override, else the default in bl_boot_config.h
+toggle()
+{
+    local defines=$1 name=$2 value
+    value=$(echo "$defines" | tr ';' '\n' | sed -n "s/^$name=\([01]\)U*$/\1/p")
+    if [ -z "$value" ]; then
+        value=$(sed -n "s/^#define $name *(\([01]\)U).*/\1/p" mcc_generated_files/bootloader/bl_boot_config.h)
+    fi
+    echo "$value"
+}
+
+CONFS=${*:-$(sed -n 's/.*<conf name="\([^"]*\)".*/\1/p' "$CONFIG")}
+for conf in $CONFS; do
+    defines=$(property "$conf" define-macros)
+    rom=$(property "$conf" code-model-rom)
+    flags=()
+    for define in $(echo "$defines" | tr ';' ' '); do
+        flags+=("-D$define")
+    done
+
+    used=$(build "$rom" "${flags[@]}")
+    if [ -z "$used" ]; then
+        echo "$conf: build failed with code-model-rom $rom"
+        tail -n 5 "$WORK/build.log"
+        continue
+    fi
+    top=$(highest)
+    printf '%s: %d bytes of program memory (code-model-rom %s), highest address 0x%04X\n' "$conf" "$used" "$rom" "$top"
+    printf '  smallest START_OF_APP: 0x%04X (next page boundary)\n' $(( (top + 0x100) & ~0xFF ))
+    printf '  %-30s %-5s %s\n' "feature" "state" "bytes"
+    for name in $FEATURES; do
+        value=$(toggle "$defines" "$name")
+        flipped=$(( 1 - ${value:-0} ))
+        size=$(build 0-1FFFF "${flags[@]}" "-D$name=${flipped}U")
+        state=$([ "${value:-0}" = 1 ] && echo on || echo off)
+        if [ -z "$size" ]; then
+            printf '  %-30s %-5s %s\n' "$name" "$state" "n/a (does not build when flipped)"
+        elif [ "$state" = on ]; then
+            printf '  %-30s %-5s %6d\n' "$name" "$state" $(( used - size ))
+        else
+            printf '  %-30s %-5s %6d if enabled\n' "$name" "$state" $(( size - used ))
+        fi
+    done
+done
@@ -0,0 +1,141 @@
+#!/bin/bash
+#
+#  Collects the records of the PIC18F57Q43_Bench firmware from a serial port into a regression table.
+#
+#    ./bench_collect.sh PORT [-b BAUD] [-p PASSES] [-o TABLE] [-c BASELINE] [-t PERCENT]
+#
+#  Each pass sends one byte to start the firmware and reads its records until the E line (see main.c).
+#  The table gives the time per operation of every primitive over all runs of all passes: minimum, median
+#  and maximum in microseconds. flash_read, uart_tx and secure_page are given per byte, checksum and digest per KB.
+#  -o writes the table to TABLE, to be used as -c BASELINE of a later run. With -c, the median of each primitive
+#  is compared with the baseline, and the script exits with 1 if one is more than PERCENT (default 5) slower.
+#
+
+set -u
+
+usage()
+{
+    echo "usage: $0 PORT [-b BAUD] [-p PASSES] [-o TABLE] [-c BASELINE] [-t PERCENT]" >&2
+    exit 2
+}
+
+[ $# -ge 1 ] || usage
+PORT=$1
+shift
+BAUD=115200
+PASSES=1
+OUTPUT=
+BASELINE=
+THRESHOLD=5
+while [ $# -gt 0 ]; do
+    [ $# -ge 2 ] || usage
+    case $1 in
+        -b) BAUD=$2 ;;
+        -p) PASSES=$2 ;;
+        -o) OUTPUT=$2 ;;
+        -c) BASELINE=$2 ;;
+        -t) THRESHOLD=$2 ;;
+        *) usage ;;
+    esac
+    shift 2
+done
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+stty -F "$PORT" "$BAUD" raw -echo cs8 -cstopb -parenb clocal || exit 1
+exec 3<> "$PORT"
+
+# Longest wait for one line; the checksum runs take the longest, well under a second each
+LINE_TIMEOUT=10
+
+for pass in $(seq 1 "$PASSES"); do
+    printf 'B' >&3
+    ended=0
+    while IFS= read -r -t "$LINE_TIMEOUT" line <&3; do
+        line=${line%$'\r'}
+        case $line in
+            H,*)
+                IFS=, read -r _ format fosc tick baud <<< "$line"
+                if [ "$format" != 1 ]; then
+                    echo "record format $format is not supported" >&2
+                    exit 1
+                fi
+                echo "$tick" > "$WORK/tick"
+                ;;
+            R,* | X,*)
+                echo "$line" >> "$WORK/records"
+                ;;
+            E,*)
+                ended=1
+                break
+                ;;
+        esac
+    done
+    if [ "$ended" != 1 ]; then
+        echo "pass $pass: no end record within ${LINE_TIMEOUT}s" >&2
+        exit 1
+    fi
+done
+
+[ -s "$WORK/tick" ] || { echo "no header record received" >&2; exit 1; }
+TICK_NS=$(cat "$WORK/tick")
+
+# Microseconds per unit of every successful run, sorted per primitive
+awk -F, -v tick="$TICK_NS" '
+    $1 == "R" {
+        scale = (($2 == "checksum") || ($2 == "digest")) ? 1024 : 1
+        printf "%s %.3f\n", $2, ($4 * tick / 1000.0) * scale / $3
+    }
+' "$WORK/records" | sort -k1,1 -k2,2n > "$WORK/runs"
+
+awk -F, '$1 == "X" { errors[$2]++ } END { for (name in errors) { print name, errors[name] } }' \
+    "$WORK/records" > "$WORK/errors"
+
+awk -v fosc="$fosc" -v baud="$baud" -v passes="$PASSES" '
+    FILENAME == ARGV[1] { errors[$1] = $2; next }
+    function unit(name) {
+        if ((name == "checksum") || (name == "digest")) { return "KB" }
+        if ((name == "flash_read") || (name == "uart_tx") || (name == "secure_page")) { return "byte" }
+        return "call"
+    }
+    function flush(    median) {
+        if (count == 0) { return }
+        median = (count % 2) ? value[(count + 1) / 2] : (value[count / 2] + value[count / 2 + 1]) / 2
+        printf "%-18s %-5s %5d %12.3f %12.3f %12.3f %6d\n", name, unit(name), count, value[1], median, value[count], errors[name] + 0
+        count = 0
+    }
+    BEGIN {
+        printf "# PIC18F57Q43_Bench, FOSC %d Hz, %d baud, %d pass(es); microseconds per unit\n", fosc, baud, passes
+        printf "%-18s %-5s %5s %12s %12s %12s %6s\n", "primitive", "unit", "runs", "min", "median", "max", "errors"
+    }
+    FILENAME == ARGV[2] {
+        if ($1 != name) { flush(); name = $1 }
+        value[++count] = $2
+    }
+    END { flush() }
+' "$WORK/errors" "$WORK/runs" > "$WORK/table"
+
+if [ -n "$OUTPUT" ]; then
+    cp "$WORK/table" "$OUTPUT"
+fi
+
+if [ -z "$BASELINE" ]; then
+    cat "$WORK/table"
+    exit 0
+fi
+
+# The table again with the baseline median and the change of the median against it
+awk -v threshold="$THRESHOLD" '
+    FILENAME == ARGV[1] { if (($0 !~ /^#/) && ($1 != "primitive")) { base[$1] = $5 }; next }
+    /^#/ { print; next }
+    $1 == "primitive" { printf "%s %12s %8s\n", $0, "baseline", "change"; next }
+    {
+        if (!($1 in base) || (base[$1] == 0)) { printf "%s %12s %8s\n", $0, "-", "new"; next }
+        change = 100.0 * ($5 - base[$1]) / base[$1]
+        flag = ""
+        if ((change > threshold) || ($7 > 0)) { flag = "  REGRESSION"; regressions++ }
+        printf "%s %12.3f %+7.1f%%%s\n", $0, base[$1], change, flag
+    }
+    END { exit (regressions > 0) ? 1 : 0 }
+' "$BASELINE" "$WORK/table"
@@ -0,0 +1,86 @@
+/**
+ *
+ * @file bench_timer.c
+ *
+ * @ingroup bench_timer
+ *
+ * @brief This file contains the TMR1 time base of the microbenchmarks and the interrupt that extends it to 32 bits.
+ *
+ * @version BENCH_TIMER Version 1.0.0
+ */
+
+/*
+ [2023] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip
+    software and any derivatives exclusively with Microchip products.
+    You are responsible for complying with 3rd party license terms
+    applicable to your use of 3rd party software (including open source
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.?
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR
+    THIS SOFTWARE.
+ */
+
+#include "bench_timer.h"
+
+// Upper 16 bits of the tick count
+static volatile uint16_t timerOverflows;
+
+// MVECEN is off in the configuration bits shared with the bootloader, so this is the single legacy vector
+void __interrupt() BENCH_InterruptManager(void)
+{
+    if ((PIE3bits.TMR1IE == 1U) && (PIR3bits.TMR1IF == 1U))
+    {
+        PIR3bits.TMR1IF = 0;
+        timerOverflows++;
+    }
+}
+
+void BENCH_TimerInitialize(void)
+{
+    T1CONbits.ON = 0;
+    //T1GE disabled
+    T1GCON = 0x0;
+    //CS FOSC/4
+    T1CLK = 0x1;
+    TMR1H = 0x0;
+    TMR1L = 0x0;
+    timerOverflows = 0U;
+    PIR3bits.TMR1IF = 0;
+    PIE3bits.TMR1IE = 1;
+    //CKPS 1:8; nSYNC synchronized; RD16 enabled; ON enabled
+    T1CON = 0x33;
+
+    INTCON0bits.IPEN = 0;
+    INTCON0bits.GIE = 1;
+}
+
+uint32_t BENCH_TimerGet(void)
+{
+    uint8_t globalInterruptBitValue = INTCON0bits.GIE;
+    uint16_t high;
+    uint16_t low;
+
+    INTCON0bits.GIE = 0;
+    high = timerOverflows;
+    // Reading TMR1L latches TMR1H in 16-bit read mode
+    low = TMR1L;
+    low |= (uint16_t) TMR1H << 8U;
+    // An overflow that is still pending belongs to a low half read after the wrap
+    if ((PIR3bits.TMR1IF == 1U) && (low < 0x8000U))
+    {
+        high++;
+    }
+    INTCON0bits.GIE = globalInterruptBitValue;
+
+    return ((uint32_t) high << 16U) | low;
+}
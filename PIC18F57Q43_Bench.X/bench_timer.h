@@ -0,0 +1,65 @@
+/**
+ *
+ * @file bench_timer.h
+ *
+ * @defgroup bench_timer BENCH_TIMER
+ *
+ * @brief This file contains the time base of the microbenchmarks: TMR1 on FOSC/4 with a 1:8 prescaler, extended
+ *        to 32 bits by its overflow interrupt. One tick is 0.5 us at 64 MHz and the counter wraps after 35 minutes.
+ *        TMR1 keeps counting while the CPU is stalled by a flash erase or write; its 32.8 ms overflow period is
+ *        longer than any such stall, so no overflow is missed.
+ *
+ * @version BENCH_TIMER Version 1.0.0
+ */
+
+/*
+ [2023] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip
+    software and any derivatives exclusively with Microchip products.
+    You are responsible for complying with 3rd party license terms
+    applicable to your use of 3rd party software (including open source
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.?
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR
+    THIS SOFTWARE.
+ */
+
+#ifndef BENCH_TIMER_H
+#define BENCH_TIMER_H
+
+#include <xc.h>
+#include <stdint.h>
+
+/**
+ * @ingroup bench_timer
+ * @def BENCH_TIMER_TICK_NS
+ * This is a macro for the duration of one timer tick in nanoseconds: 8 * 4 / 64 MHz.
+ */
+#define BENCH_TIMER_TICK_NS     (500U)
+
+/**
+ * @ingroup bench_timer
+ * @brief This API sets up TMR1 and its overflow interrupt, and enables the global interrupts.
+ * @param None.
+ * @return None.
+ */
+void BENCH_TimerInitialize(void);
+
+/**
+ * @ingroup bench_timer
+ * @brief This API returns the 32-bit tick count.
+ * @param None.
+ * @return Ticks since @ref BENCH_TimerInitialize.
+ */
+uint32_t BENCH_TimerGet(void);
+
+#endif // BENCH_TIMER_H
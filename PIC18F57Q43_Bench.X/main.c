@@ -0,0 +1,384 @@
+/**
+ *
+ * @file main.c
+ *
+ * @brief Microbenchmarks of the bootloader primitives on the target, built from the NVM, verification and
+ *        communication sources of PIC18F57Q43_BL.X with the bootloader's compiler options.
+ *
+ *        Every byte received on UART1 starts one pass: each primitive is timed BENCH_RUNS times with
+ *        bench_timer.h and reported as one line per run, at BENCH_BAUD_RATE 8N1 on the pins of the bootloader:
+ *
+ *          H,<format>,<FOSC Hz>,<ns per tick>,<baud>      once per pass
+ *          R,<primitive>,<operations>,<ticks>              one run: <operations> calls or bytes took <ticks>
+ *          X,<primitive>,<nvm_status_t>                    one run failed
+ *          E,<records>                                     end of the pass, after <records> R and X lines
+ *
+ *        Other lines (the UART TX payload) are to be ignored. bench_collect.sh turns the records into a table.
+ *        The flash primitives erase and program the last page of program memory and the EEPROM primitive
+ *        rewrites the last EEPROM byte, so run this on a device that holds nothing else of value.
+ *
+ * @version BENCH Version 1.0.0
+ */
+
+/*
+ [2023] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip
+    software and any derivatives exclusively with Microchip products.
+    You are responsible for complying with 3rd party license terms
+    applicable to your use of 3rd party software (including open source
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.?
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR
+    THIS SOFTWARE.
+ */
+
+#include "../PIC18F57Q43_BL.X/mcc_generated_files/system/system.h"
+#include "../PIC18F57Q43_BL.X/mcc_generated_files/bootloader/bl_communication_interface.h"
+#include "../PIC18F57Q43_BL.X/mcc_generated_files/bootloader/bl_secure.h"
+#include "../PIC18F57Q43_BL.X/mcc_generated_files/bootloader/bl_digest.h"
+#include "bench_timer.h"
+
+// Version of the record lines, raised when a field changes
+#define BENCH_RECORD_FORMAT     (1U)
+
+#ifndef BENCH_BAUD_RATE
+#define BENCH_BAUD_RATE         (115200UL)
+#endif
+
+#ifndef BENCH_RUNS
+#define BENCH_RUNS              (8U)
+#endif
+
+// Bytes read one at a time with FLASH_Read per run
+#define BENCH_READ_LENGTH       (1024U)
+// Bytes sent through the bootloader transport per run, without the STX it adds
+#define BENCH_TX_LENGTH         (256U)
+// Bytes hashed per digest run; bench_collect.sh reports the digest per KB
+#define BENCH_DIGEST_LENGTH     (1024U)
+#define BENCH_TX_FILL           ('#')
+
+#define BENCH_FLASH_ADDRESS     ((flash_address_t) (PROGMEM_SIZE - PROGMEM_PAGE_SIZE))
+#define BENCH_EEPROM_ADDRESS    ((eeprom_address_t) (EEPROM_START_ADDRESS + EEPROM_SIZE - 1U))
+
+typedef struct
+{
+    const char *name;
+    uint32_t operations;
+    nvm_status_t (*Run)(uint32_t *ticks);
+} bench_primitive_t;
+
+static nvm_status_t BENCH_FlashRead(uint32_t *ticks);
+static nvm_status_t BENCH_FlashRowRead(uint32_t *ticks);
+static nvm_status_t BENCH_FlashPageErase(uint32_t *ticks);
+static nvm_status_t BENCH_FlashRowWrite(uint32_t *ticks);
+static nvm_status_t BENCH_EepromWrite(uint32_t *ticks);
+static nvm_status_t BENCH_Checksum(uint32_t *ticks);
+static nvm_status_t BENCH_UartTx(uint32_t *ticks);
+#if (BL_CMD_SECURE_WRITE_ENABLE == 1U)
+static nvm_status_t BENCH_SecurePage(uint32_t *ticks);
+#endif
+#if (BL_DIGEST_INCLUDED == 1U)
+static nvm_status_t BENCH_Digest(uint32_t *ticks);
+#endif
+
+static const bench_primitive_t benchPrimitives[] = {
+    {"flash_read", BENCH_READ_LENGTH, &BENCH_FlashRead},
+    {"flash_row_read", 1U, &BENCH_FlashRowRead},
+    {"flash_page_erase", 1U, &BENCH_FlashPageErase},
+    {"flash_row_write", 1U, &BENCH_FlashRowWrite},
+    {"eeprom_write", 1U, &BENCH_EepromWrite},
+    // The boot verification sum over the whole application area
+    {"checksum", CHECKSUM_LENGTH, &BENCH_Checksum},
+    {"uart_tx", BENCH_TX_LENGTH + 1U, &BENCH_UartTx},
+#if (BL_CMD_SECURE_WRITE_ENABLE == 1U)
+    // The decryption and tag check of one SECURE_WRITE page
+    {"secure_page", PROGMEM_PAGE_SIZE, &BENCH_SecurePage},
+#endif
+#if (BL_DIGEST_INCLUDED == 1U)
+    // SHA-256 of 1 KB of the application area, as DIGEST and the digest boot verification read it
+    {"digest", BENCH_DIGEST_LENGTH, &BENCH_Digest},
+#endif
+};
+
+static flash_data_t benchBuffer[PROGMEM_PAGE_SIZE];
+static uint8_t eepromValue;
+#if (BL_CMD_SECURE_WRITE_ENABLE == 1U)
+static uint8_t secureBuffer[BL_SECURE_FRAME_SIZE];
+#endif
+#if (BL_DIGEST_INCLUDED == 1U)
+static uint8_t digestBuffer[BL_DIGEST_SIZE];
+#endif
+
+static void BENCH_PrintCharacter(char character)
+{
+    while (UART1_IsTxReady() == false)
+    {
+    }
+    UART1_Write((uint8_t) character);
+}
+
+static void BENCH_PrintText(const char *text)
+{
+    while (*text != '\0')
+    {
+        BENCH_PrintCharacter(*text++);
+    }
+}
+
+static void BENCH_PrintUnsigned(uint32_t value)
+{
+    char digits[10];
+    uint8_t count = 0U;
+
+    do
+    {
+        digits[count++] = (char) ('0' + (value % 10U));
+        value /= 10U;
+    } while (value != 0U);
+
+    while (count > 0U)
+    {
+        BENCH_PrintCharacter(digits[--count]);
+    }
+}
+
+static void BENCH_PrintEnd(void)
+{
+    BENCH_PrintText("\r\n");
+    // Nothing is timed while a record is still on its way out
+    while (UART1_IsTxDone() == false)
+    {
+    }
+}
+
+static nvm_status_t BENCH_FlashRead(uint32_t *ticks)
+{
+    flash_address_t address = BENCH_FLASH_ADDRESS;
+    uint32_t start = BENCH_TimerGet();
+
+    for (uint16_t i = 0U; i < BENCH_READ_LENGTH; i++)
+    {
+        benchBuffer[i & (PROGMEM_PAGE_SIZE - 1U)] = FLASH_Read(address + (i & (PROGMEM_PAGE_SIZE - 1U)));
+    }
+    *ticks = BENCH_TimerGet() - start;
+
+    return NVM_OK;
+}
+
+static nvm_status_t BENCH_FlashRowRead(uint32_t *ticks)
+{
+    nvm_status_t errorStatus;
+    uint32_t start = BENCH_TimerGet();
+
+    errorStatus = FLASH_RowRead(BENCH_FLASH_ADDRESS, benchBuffer);
+    *ticks = BENCH_TimerGet() - start;
+
+    return errorStatus;
+}
+
+static nvm_status_t BENCH_FlashPageErase(uint32_t *ticks)
+{
+    nvm_status_t errorStatus;
+    uint32_t start;
+
+    NVM_UnlockKeySet(UNLOCK_KEY);
+    start = BENCH_TimerGet();
+    errorStatus = FLASH_PageErase(BENCH_FLASH_ADDRESS);
+    *ticks = BENCH_TimerGet() - start;
+    NVM_UnlockKeyClear();
+    NVM_StatusClear();
+
+    return errorStatus;
+}
+
+static nvm_status_t BENCH_FlashRowWrite(uint32_t *ticks)
+{
+    nvm_status_t errorStatus;
+    uint32_t start;
+
+    // Programmed into an erased page, as the bootloader does; the erase is not part of the time
+    for (uint16_t i = 0U; i < PROGMEM_PAGE_SIZE; i++)
+    {
+        benchBuffer[i] = (flash_data_t) i;
+    }
+    NVM_UnlockKeySet(UNLOCK_KEY);
+    errorStatus = FLASH_PageErase(BENCH_FLASH_ADDRESS);
+    start = BENCH_TimerGet();
+    if (errorStatus == NVM_OK)
+    {
+        errorStatus = FLASH_RowWrite(BENCH_FLASH_ADDRESS, benchBuffer);
+    }
+    *ticks = BENCH_TimerGet() - start;
+    NVM_UnlockKeyClear();
+    NVM_StatusClear();
+
+    return errorStatus;
+}
+
+static nvm_status_t BENCH_EepromWrite(uint32_t *ticks)
+{
+    nvm_status_t errorStatus;
+    uint32_t start;
+
+    // A different value each run, so that every write changes the cell
+    eepromValue++;
+    NVM_UnlockKeySet(UNLOCK_KEY);
+    start = BENCH_TimerGet();
+    EEPROM_Write(BENCH_EEPROM_ADDRESS, eepromValue);
+    while (NVM_IsBusy())
+    {
+    }
+    *ticks = BENCH_TimerGet() - start;
+    NVM_UnlockKeyClear();
+    errorStatus = NVM_StatusGet();
+    NVM_StatusClear();
+
+    if ((errorStatus == NVM_OK) && (EEPROM_Read(BENCH_EEPROM_ADDRESS) != eepromValue))
+    {
+        errorStatus = NVM_ERROR;
+    }
+    return errorStatus;
+}
+
+static nvm_status_t BENCH_Checksum(uint32_t *ticks)
+{
+    uint32_t start = BENCH_TimerGet();
+
+    // The result does not matter, only the time of the sum
+    (void) BL_bootVerifyImage(START_OF_APP);
+    *ticks = BENCH_TimerGet() - start;
+
+    return NVM_OK;
+}
+
+static nvm_status_t BENCH_UartTx(uint32_t *ticks)
+{
+    uint32_t start;
+
+    for (uint16_t i = 0U; i < BENCH_TX_LENGTH; i++)
+    {
+        benchBuffer[i] = BENCH_TX_FILL;
+    }
+    start = BENCH_TimerGet();
+    BL_CommunicationModuleWrite(benchBuffer, BENCH_TX_LENGTH);
+    while (BL_CommunicationModuleIsReady() == false)
+    {
+    }
+    *ticks = BENCH_TimerGet() - start;
+    // Ends the payload line before the record
+    BENCH_PrintEnd();
+
+    return NVM_OK;
+}
+
+#if (BL_CMD_SECURE_WRITE_ENABLE == 1U)
+static nvm_status_t BENCH_SecurePage(uint32_t *ticks)
+{
+    uint32_t start;
+
+    for (uint16_t i = 0U; i < BL_SECURE_FRAME_SIZE; i++)
+    {
+        secureBuffer[i] = (uint8_t) i;
+    }
+    start = BENCH_TimerGet();
+    // The filler does not carry a valid tag; the page is opened in full and the tag compared either way
+    (void) BL_SecurePageOpen(secureBuffer, START_OF_APP);
+    *ticks = BENCH_TimerGet() - start;
+
+    return NVM_OK;
+}
+#endif
+
+#if (BL_DIGEST_INCLUDED == 1U)
+static nvm_status_t BENCH_Digest(uint32_t *ticks)
+{
+    uint32_t start = BENCH_TimerGet();
+
+    // 16 full blocks and the padding block, which a longer range pays only once
+    BL_DigestFlash(START_OF_APP, BENCH_DIGEST_LENGTH, digestBuffer);
+    *ticks = BENCH_TimerGet() - start;
+
+    return NVM_OK;
+}
+#endif
+
+static void BENCH_RunPass(void)
+{
+    uint16_t records = 0U;
+    uint32_t ticks;
+    nvm_status_t errorStatus;
+
+    BENCH_PrintText("H,");
+    BENCH_PrintUnsigned(BENCH_RECORD_FORMAT);
+    BENCH_PrintCharacter(',');
+    BENCH_PrintUnsigned(_XTAL_FREQ);
+    BENCH_PrintCharacter(',');
+    BENCH_PrintUnsigned(BENCH_TIMER_TICK_NS);
+    BENCH_PrintCharacter(',');
+    BENCH_PrintUnsigned(BENCH_BAUD_RATE);
+    BENCH_PrintEnd();
+
+    for (uint8_t p = 0U; p < (sizeof(benchPrimitives) / sizeof(benchPrimitives[0])); p++)
+    {
+        for (uint8_t run = 0U; run < BENCH_RUNS; run++)
+        {
+            errorStatus = benchPrimitives[p].Run(&ticks);
+            if (errorStatus == NVM_OK)
+            {
+                BENCH_PrintText("R,");
+                BENCH_PrintText(benchPrimitives[p].name);
+                BENCH_PrintCharacter(',');
+                BENCH_PrintUnsigned(benchPrimitives[p].operations);
+                BENCH_PrintCharacter(',');
+                BENCH_PrintUnsigned(ticks);
+            }
+            else
+            {
+                BENCH_PrintText("X,");
+                BENCH_PrintText(benchPrimitives[p].name);
+                BENCH_PrintCharacter(',');
+                BENCH_PrintUnsigned((uint32_t) errorStatus);
+            }
+            BENCH_PrintEnd();
+            records++;
+        }
+    }
+
+    BENCH_PrintText("E,");
+    BENCH_PrintUnsigned(records);
+    BENCH_PrintEnd();
+}
+
+int main(void)
+{
+    CLOCK_Initialize();
+    PIN_MANAGER_Initialize();
+    NVM_Initialize();
+    UART1_Initialize();
+    // Fixed rate instead of autobaud; BRGS is set, so the divider is 4
+    U1BRGL = (uint8_t) (((_XTAL_FREQ + (2UL * BENCH_BAUD_RATE)) / (4UL * BENCH_BAUD_RATE)) - 1UL);
+    U1BRGH = (uint8_t) ((((_XTAL_FREQ + (2UL * BENCH_BAUD_RATE)) / (4UL * BENCH_BAUD_RATE)) - 1UL) >> 8U);
+    BL_CommunicationModuleOpen();
+    BENCH_TimerInitialize();
+#if (BL_CMD_SECURE_WRITE_ENABLE == 1U)
+    BL_SecureInitialize();
+#endif
+
+    while (1)
+    {
+        if (UART1_IsRxReady())
+        {
+            (void) UART1_Read();
+            BENCH_RunPass();
+        }
+    }
+}
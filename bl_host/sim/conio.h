@@ -0,0 +1,6 @@
+/**
+ *
+ * @file conio.h
+ *
+ * @brief Stand-in for the XC8 console header included by system.h; bl_sim has no console I/O to add.
+ */
@@ -0,0 +1,132 @@
+/**
+ *
+ * @file sim.h
+ *
+ * @brief bl_sim: the bootloader firmware built as a Linux program. Flash, EEPROM and configuration memory
+ *        live in a memory-mapped file, UART1 is a pseudo-terminal. The file also carries the counters of the
+ *        simulated NVM and UART, so that bl_simbench can read them while bl_sim runs.
+ *
+ *        This header is shared by the C sources of bl_sim and the C++ sources of bl_simbench.
+ */
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** Sizes of the simulated memories; sim_nvm.c checks them against nvm.h. */
+#define SIM_FLASH_SIZE              (0x20000U)
+#define SIM_EEPROM_SIZE             (1024U)
+#define SIM_CONFIG_SIZE             (16U)
+#define SIM_CONFIG_ADDRESS          (0x300000U)
+#define SIM_DEVICE_ID_ADDRESS       (0x3FFFFEU)
+/** PIC18F57Q43 */
+#define SIM_DEVICE_ID               (0x74A0U)
+
+/** Marks an initialised memory file of this layout; a file without it is filled with erased memory. */
+#define SIM_MAGIC                   (0x4D49534DU)
+
+/**
+ * Data sheet erase and write times. The PIC18F57Q43 data sheet gives the same worst case for a page erase,
+ * a page write and an EEPROM or configuration byte write; bl_host uses it for its reply timeouts (NvmTiming).
+ */
+#define SIM_PAGE_ERASE_US           (11000U)
+#define SIM_PAGE_WRITE_US           (11000U)
+#define SIM_BYTE_WRITE_US           (11000U)
+
+/**
+ * @brief What the simulated device did since the counters were last cleared. bl_simbench clears them
+ *        by writing zeros while bl_sim waits for a frame.
+ */
+typedef struct
+{
+    uint64_t framesReceived; /**< Autobaud syncs, one per frame */
+    uint64_t bytesRx; /**< Including the sync byte */
+    uint64_t bytesTx; /**< Including the STX byte */
+    uint64_t pageErases;
+    uint64_t pageWrites;
+    uint64_t pageReads; /**< FLASH_RowRead calls */
+    uint64_t wordWrites;
+    uint64_t eepromWrites;
+    uint64_t configWrites;
+    uint64_t writeErrors; /**< Erases and writes refused because the unlock key was not set */
+    uint64_t nvmBusyUs; /**< Sum of the data sheet times of all erases and writes */
+    uint64_t resets;
+    uint64_t applicationStarts;
+} sim_counters_t;
+
+/**
+ * @brief Layout of the memory file.
+ */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t reserved;
+    sim_counters_t counters;
+    uint8_t flash[SIM_FLASH_SIZE];
+    uint8_t eeprom[SIM_EEPROM_SIZE];
+    uint8_t configuration[SIM_CONFIG_SIZE];
+} sim_memory_t;
+
+/** Power cut handler of SIM_CutAfter(); it must not return into the torn erase or write. */
+typedef void (*sim_power_cut_t)(void);
+
+/**
+ * Power-cut injection of sim_nvm.c: the erase or write after the next operationsLeft ones is torn, with bytes
+ * drawn from seed, and then powerCut is called. Page erases, row writes, word writes and EEPROM and configuration
+ * byte writes count, refused ones do not.
+ */
+void SIM_CutAfter(uint64_t operationsLeft, uint32_t seed, sim_power_cut_t powerCut);
+/** Cancels a cut that did not happen. */
+void SIM_CutDisarm(void);
+/**
+ * EEPROM probes of sim_nvm.c for bl_logsim: each byte write, torn ones included, adds 1 to its cell in wear
+ * (SIM_EEPROM_SIZE entries), and each EEPROM_Read adds 1 to reads. NULL stops the counting.
+ */
+void SIM_EepromTrack(uint64_t *wear, uint64_t *reads);
+
+#ifndef __cplusplus
+
+/** Erase and write times used by sim_nvm.c. */
+typedef struct
+{
+    uint32_t pageEraseUs;
+    uint32_t pageWriteUs;
+    uint32_t byteWriteUs;
+} sim_timing_t;
+
+extern sim_memory_t *simMemory;
+extern sim_timing_t simTiming;
+
+/** Table read of any address the device maps: flash, configuration, EEPROM and the device ID. */
+uint8_t SIM_TableRead(uint32_t address);
+
+/** Connects UART1 to the master side of the pseudo-terminal. */
+void SIM_UartAttach(int fd);
+/** Sends what UART1 still holds; called before a reset. */
+void SIM_UartFlush(void);
+/** Connects the SPI host to SPI1 (sim_spi1.c); the firmware only uses one of SPI1 and UART1. */
+void SIM_SpiAttach(int fd);
+
+/** Executes inline assembly of the firmware: the goto to the application and TBLRD. */
+void SIM_Asm(const char *text);
+/** The goto to the application: the application is not simulated, so bl_sim idles until it is stopped. */
+_Noreturn void SIM_StartApplication(uint32_t address);
+/** Reports a firmware action bl_sim cannot model and exits. */
+_Noreturn void SIM_Fatal(const char *message, const char *detail);
+/** RESET(): restarts bl_sim with the memory file and the pseudo-terminal, as a reset keeps NVM and the pins. */
+_Noreturn void SIM_Reset(void);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SIM_H
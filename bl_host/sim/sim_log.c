@@ -0,0 +1,99 @@
+/**
+ *
+ * @file sim_log.c
+ *
+ * @brief bl_logsim: runs the record log of bl_log.c, unchanged, on the simulated NVM of sim_nvm.c. A power cut
+ *        jumps back out of the firmware to SIM_LogWrite, which is only C frames, and the next SIM_LogBoot is the
+ *        next boot.
+ */
+
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nvm/nvm.h"
+#include "bootloader/bl_log.h"
+#include "sim_log.h"
+
+const uint32_t simLogBankSize = BL_LOG_BANK_SIZE;
+const uint32_t simLogSlots = BL_LOG_BANK_SIZE / BL_LOG_RECORD_SIZE;
+const uint32_t simLogOffset = BL_LOG_START_ADDRESS - EEPROM_START_ADDRESS;
+
+static sim_memory_t logMemory;
+sim_memory_t *simMemory = &logMemory;
+
+static jmp_buf logPowerCut;
+
+_Noreturn void SIM_Fatal(const char *message, const char *detail)
+{
+    fprintf(stderr, "bl_logsim: %s%s%s\n", message, (detail != NULL) ? ": " : "", (detail != NULL) ? detail : "");
+    exit(1);
+}
+
+static void SIM_LogPowerCut(void)
+{
+    longjmp(logPowerCut, 1);
+}
+
+sim_memory_t *SIM_LogMemory(void)
+{
+    return simMemory;
+}
+
+void SIM_LogReset(void)
+{
+    SIM_CutDisarm();
+    memset(simMemory, 0, sizeof(*simMemory));
+    simMemory->magic = SIM_MAGIC;
+    memset(simMemory->flash, 0xFF, sizeof(simMemory->flash));
+    memset(simMemory->eeprom, 0xFF, sizeof(simMemory->eeprom));
+    memset(simMemory->configuration, 0xFF, sizeof(simMemory->configuration));
+}
+
+void SIM_LogCutAfter(uint64_t writesLeft, uint32_t seed)
+{
+    SIM_CutAfter(writesLeft, seed, SIM_LogPowerCut);
+}
+
+void SIM_LogBoot(void)
+{
+    // The reset clears the unlock key and the NVM status with the rest of the RAM
+    NVM_UnlockKeyClear();
+    NVM_Initialize();
+    BL_LogInitialize();
+}
+
+bool SIM_LogRead(uint8_t key, uint32_t *value)
+{
+    return BL_LogRead(key, value);
+}
+
+bool SIM_LogWrite(uint8_t key, uint32_t value, bool *written)
+{
+    if (setjmp(logPowerCut) != 0)
+    {
+        simMemory->counters.resets++;
+        return false;
+    }
+    *written = (BL_LogWrite(key, value, UNLOCK_KEY) == NVM_OK);
+    return true;
+}
+
+uint32_t SIM_LogEpoch(void)
+{
+    uint32_t epoch = 0U;
+
+    for (uint32_t bank = 0U; bank < 2U; bank++)
+    {
+        const uint8_t *header = &simMemory->eeprom[simLogOffset + (bank * simLogBankSize)];
+        uint32_t value = (uint32_t) header[1] | ((uint32_t) header[2] << 8U) | ((uint32_t) header[3] << 16U)
+                         | ((uint32_t) header[4] << 24U);
+
+        if ((header[0] == BL_LOG_KEY_HEADER) && (value > epoch))
+        {
+            epoch = value;
+        }
+    }
+    return epoch;
+}
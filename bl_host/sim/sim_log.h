@@ -0,0 +1,52 @@
+/**
+ *
+ * @file sim_log.h
+ *
+ * @brief bl_logsim: the record log of bl_log.c compiled for Linux, on the simulated NVM of sim_nvm.c.
+ *        A power cut returns from SIM_LogWrite with everything but the NVM lost, as the reset of the device does.
+ *
+ *        This header is shared by sim_log.c and the C++ sources of bl_logsim.
+ */
+
+#ifndef SIM_LOG_H
+#define SIM_LOG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sim.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** BL_LOG_BANK_SIZE and the slots per bank of the build. */
+extern const uint32_t simLogBankSize;
+extern const uint32_t simLogSlots;
+/** BL_LOG_START_ADDRESS as an offset into the EEPROM of the memory. */
+extern const uint32_t simLogOffset;
+
+/** The memory the log works on. */
+sim_memory_t *SIM_LogMemory(void);
+/** Erases the memory, clears the counters and disarms the cut. */
+void SIM_LogReset(void);
+/** The EEPROM byte write after the next writesLeft ones is torn by a power cut. */
+void SIM_LogCutAfter(uint64_t writesLeft, uint32_t seed);
+/** Boots: the RAM of the log is lost, and BL_LogInitialize finds the active bank and its head again. */
+void SIM_LogBoot(void);
+/** BL_LogRead. */
+bool SIM_LogRead(uint8_t key, uint32_t *value);
+/**
+ * BL_LogWrite with the unlock key of a frame. Returns false if the power was cut, otherwise true with
+ * whether the firmware returned NVM_OK.
+ */
+bool SIM_LogWrite(uint8_t key, uint32_t value, bool *written);
+/** Epoch of the newer bank header: the compactions so far, the one that formatted the log included. */
+uint32_t SIM_LogEpoch(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SIM_LOG_H
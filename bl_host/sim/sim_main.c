@@ -0,0 +1,266 @@
+/**
+ *
+ * @file sim_main.c
+ *
+ * @brief bl_sim: runs the bootloader firmware (main.c and the bootloader sources, unchanged) on Linux.
+ *
+ *        bl_sim --nvm FILE [--link PATH] [--entry-pin] [--erase-us N] [--write-us N] [--byte-write-us N]
+ *
+ *        FILE holds flash, EEPROM, configuration memory and the counters (sim.h); it is created erased.
+ *        The slave side of the pseudo-terminal is printed on stdout (and symlinked to PATH with --link).
+ *        --entry-pin holds the bootloader entry pin low, so the bootloader runs even with a valid application.
+ *        --erase-us, --write-us and --byte-write-us replace the data sheet times added per page erase,
+ *        page write and EEPROM or configuration byte write.
+ *
+ *        RESET() starts bl_sim again on the same file and pseudo-terminal. The application is not simulated:
+ *        once the bootloader jumps to it, bl_sim reports the address and idles until it is stopped.
+ */
+
+#define _DEFAULT_SOURCE
+#define _XOPEN_SOURCE 700
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <xc.h>
+#include "sim.h"
+
+// main() of PIC18F57Q43_BL.X, renamed by the Makefile
+int SIM_FirmwareMain(void);
+
+sim_memory_t *simMemory;
+
+static int simArgc;
+static char **simArgv;
+static int ptyFd = -1;
+
+static void SIM_Usage(void)
+{
+    fprintf(stderr, "usage: bl_sim --nvm FILE [--link PATH] [--entry-pin] [--erase-us N] [--write-us N] [--byte-write-us N]\n");
+}
+
+_Noreturn void SIM_Fatal(const char *message, const char *detail)
+{
+    fprintf(stderr, "bl_sim: %s%s%s\n", message, (detail != NULL) ? ": " : "", (detail != NULL) ? detail : "");
+    exit(1);
+}
+
+static void SIM_MapMemory(const char *path)
+{
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    struct stat st;
+
+    if ((fd < 0) || (fstat(fd, &st) != 0))
+    {
+        SIM_Fatal(path, strerror(errno));
+    }
+    if (((size_t) st.st_size < sizeof(sim_memory_t)) && (ftruncate(fd, (off_t) sizeof(sim_memory_t)) != 0))
+    {
+        SIM_Fatal(path, strerror(errno));
+    }
+    simMemory = mmap(NULL, sizeof(sim_memory_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (simMemory == MAP_FAILED)
+    {
+        SIM_Fatal(path, strerror(errno));
+    }
+    close(fd);
+
+    if (simMemory->magic != SIM_MAGIC)
+    {
+        memset(&simMemory->counters, 0, sizeof(simMemory->counters));
+        memset(simMemory->flash, 0xFF, sizeof(simMemory->flash));
+        memset(simMemory->eeprom, 0xFF, sizeof(simMemory->eeprom));
+        memset(simMemory->configuration, 0xFF, sizeof(simMemory->configuration));
+        simMemory->magic = SIM_MAGIC;
+    }
+}
+
+static void SIM_OpenPty(const char *linkPath)
+{
+    struct termios tio;
+    const char *slavePath;
+    int slave;
+
+    ptyFd = posix_openpt(O_RDWR | O_NOCTTY);
+    if ((ptyFd < 0) || (grantpt(ptyFd) != 0) || (unlockpt(ptyFd) != 0))
+    {
+        SIM_Fatal("posix_openpt", strerror(errno));
+    }
+    slavePath = ptsname(ptyFd);
+
+    // Held open in raw mode, also across resets, so the host never sees a hang-up or an echoing line discipline
+    slave = open(slavePath, O_RDWR | O_NOCTTY);
+    if ((slave < 0) || (tcgetattr(slave, &tio) != 0))
+    {
+        SIM_Fatal(slavePath, strerror(errno));
+    }
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+
+    if (linkPath != NULL)
+    {
+        unlink(linkPath);
+        if (symlink(slavePath, linkPath) != 0)
+        {
+            SIM_Fatal(linkPath, strerror(errno));
+        }
+    }
+    printf("%s\n", slavePath);
+    fflush(stdout);
+}
+
+void SIM_Asm(const char *text)
+{
+    uint32_t tablePointer;
+
+    if (strncmp(text, "goto", 4U) == 0)
+    {
+        // "goto  (0x3000)" from str(NEW_RESET_VECTOR)
+        text += strspn(text + 4, " (") + 4U;
+        SIM_StartApplication((uint32_t) strtoul(text, NULL, 0));
+    }
+    else if (strncmp(text, "TBLRD*", 6U) == 0)
+    {
+        tablePointer = ((uint32_t) TBLPTRU << 16U) | ((uint32_t) TBLPTRH << 8U) | TBLPTRL;
+        TABLAT = SIM_TableRead(tablePointer);
+        if (text[6] == '+')
+        {
+            tablePointer++;
+            TBLPTRU = (uint8_t) (tablePointer >> 16U);
+            TBLPTRH = (uint8_t) (tablePointer >> 8U);
+            TBLPTRL = (uint8_t) tablePointer;
+        }
+    }
+    else
+    {
+        SIM_Fatal("unsupported inline assembly", text);
+    }
+}
+
+_Noreturn void SIM_StartApplication(uint32_t address)
+{
+    uint8_t discard[256];
+    struct pollfd pfd = {ptyFd, POLLIN, 0};
+
+    SIM_UartFlush();
+    simMemory->counters.applicationStarts++;
+    fprintf(stderr, "bl_sim: application started at 0x%05X\n", (unsigned) address);
+
+    // The application ignores the UART; it runs until bl_sim is stopped
+    while (1)
+    {
+        if ((poll(&pfd, 1U, -1) > 0) && (read(ptyFd, discard, sizeof(discard)) < 0) && (errno != EINTR))
+        {
+            exit(0);
+        }
+    }
+}
+
+_Noreturn void SIM_Reset(void)
+{
+    char fd[16];
+    char **args = calloc((size_t) simArgc + 3U, sizeof(char *));
+    int n = 0;
+
+    SIM_UartFlush();
+    simMemory->counters.resets++;
+
+    if (args == NULL)
+    {
+        SIM_Fatal("reset", strerror(errno));
+    }
+    for (int i = 0; i < simArgc; i++)
+    {
+        if ((strcmp(simArgv[i], "--pty") == 0) && ((i + 1) < simArgc))
+        {
+            i++;
+            continue;
+        }
+        args[n++] = simArgv[i];
+    }
+    snprintf(fd, sizeof(fd), "%d", ptyFd);
+    args[n++] = "--pty";
+    args[n++] = fd;
+    args[n] = NULL;
+
+    execv("/proc/self/exe", args);
+    SIM_Fatal("reset", strerror(errno));
+}
+
+int main(int argc, char **argv)
+{
+    const char *nvmPath = NULL;
+    const char *linkPath = NULL;
+    bool entryPin = false;
+
+    simArgc = argc;
+    simArgv = argv;
+    for (int i = 1; i < argc; i++)
+    {
+        if ((strcmp(argv[i], "--nvm") == 0) && ((i + 1) < argc))
+        {
+            nvmPath = argv[++i];
+        }
+        else if ((strcmp(argv[i], "--link") == 0) && ((i + 1) < argc))
+        {
+            linkPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--entry-pin") == 0)
+        {
+            entryPin = true;
+        }
+        else if ((strcmp(argv[i], "--erase-us") == 0) && ((i + 1) < argc))
+        {
+            simTiming.pageEraseUs = (uint32_t) strtoul(argv[++i], NULL, 0);
+        }
+        else if ((strcmp(argv[i], "--write-us") == 0) && ((i + 1) < argc))
+        {
+            simTiming.pageWriteUs = (uint32_t) strtoul(argv[++i], NULL, 0);
+        }
+        else if ((strcmp(argv[i], "--byte-write-us") == 0) && ((i + 1) < argc))
+        {
+            simTiming.byteWriteUs = (uint32_t) strtoul(argv[++i], NULL, 0);
+        }
+        else if ((strcmp(argv[i], "--pty") == 0) && ((i + 1) < argc))
+        {
+            // Internal: the pseudo-terminal kept open by SIM_Reset()
+            ptyFd = (int) strtol(argv[++i], NULL, 0);
+        }
+        else
+        {
+            SIM_Usage();
+            return 2;
+        }
+    }
+    if (nvmPath == NULL)
+    {
+        SIM_Usage();
+        return 2;
+    }
+
+    SIM_MapMemory(nvmPath);
+    if (ptyFd < 0)
+    {
+        SIM_OpenPty(linkPath);
+        // Power-on reset
+        PCON0bits.nRI = 1U;
+    }
+    else
+    {
+        // RESET instruction
+        PCON0bits.nRI = 0U;
+    }
+    PORTBbits.RB4 = entryPin ? 0U : 1U;
+    SIM_UartAttach(ptyFd);
+    SIM_SpiAttach(ptyFd);
+
+    return SIM_FirmwareMain();
+}
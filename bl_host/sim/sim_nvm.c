@@ -0,0 +1,320 @@
+/**
+ *
+ * @file sim_nvm.c
+ *
+ * @brief bl_sim replacement of nvm.c: flash, EEPROM and configuration memory in the memory file.
+ *        Erases and writes complete at once and add their data sheet time to the counters instead,
+ *        so NVM_IsBusy() is never true. A row write can only clear bits, as on the device, and every
+ *        erase or write is refused unless the unlock key was set.
+ *
+ *        SIM_CutAfter() tears a later erase or write, as a power cut in the middle of it would, and then calls
+ *        the power cut handler of the program instead of completing it.
+ */
+
+#include <string.h>
+
+#include "nvm/nvm.h"
+#include "sim.h"
+
+_Static_assert(SIM_FLASH_SIZE == PROGMEM_SIZE, "SIM_FLASH_SIZE must match nvm.h");
+_Static_assert(SIM_EEPROM_SIZE == EEPROM_SIZE, "SIM_EEPROM_SIZE must match nvm.h");
+
+sim_timing_t simTiming = {SIM_PAGE_ERASE_US, SIM_PAGE_WRITE_US, SIM_BYTE_WRITE_US};
+
+static uint16_t unlockKey;
+static nvm_status_t status = NVM_OK;
+
+static uint64_t *eepromWear = NULL;
+static uint64_t *eepromReads = NULL;
+
+static sim_power_cut_t cutHandler = NULL;
+static uint64_t cutCountdown = 0U;
+static uint32_t cutState = 1U;
+
+void SIM_CutAfter(uint64_t operationsLeft, uint32_t seed, sim_power_cut_t powerCut)
+{
+    cutHandler = powerCut;
+    cutCountdown = operationsLeft;
+    cutState = seed;
+}
+
+void SIM_CutDisarm(void)
+{
+    cutHandler = NULL;
+}
+
+void SIM_EepromTrack(uint64_t *wear, uint64_t *reads)
+{
+    eepromWear = wear;
+    eepromReads = reads;
+}
+
+// Returns true when this erase or write is the one the power cut tears
+static bool SIM_Cut(void)
+{
+    if (cutHandler == NULL)
+    {
+        return false;
+    }
+    if (cutCountdown == 0U)
+    {
+        return true;
+    }
+    cutCountdown--;
+    return false;
+}
+
+static uint8_t SIM_Garbage(void)
+{
+    cutState = (cutState * 1103515245U) + 12345U;
+    return (uint8_t) (cutState >> 16U);
+}
+
+// Calls the handler of the cut that tore the operation; it does not return
+static void SIM_PowerCut(void)
+{
+    sim_power_cut_t powerCut = cutHandler;
+
+    cutHandler = NULL;
+    powerCut();
+    SIM_Fatal("the power cut handler returned", NULL);
+}
+
+// Returns false and latches the error when the firmware did not set the unlock key before an erase or write
+static bool SIM_Unlocked(void)
+{
+    if (unlockKey != UNLOCK_KEY)
+    {
+        status = NVM_ERROR;
+        simMemory->counters.writeErrors++;
+        return false;
+    }
+    return true;
+}
+
+uint8_t SIM_TableRead(uint32_t address)
+{
+    uint8_t data = 0x00U;
+
+    if (address < SIM_FLASH_SIZE)
+    {
+        data = simMemory->flash[address];
+    }
+    else if ((address >= SIM_CONFIG_ADDRESS) && (address < (SIM_CONFIG_ADDRESS + SIM_CONFIG_SIZE)))
+    {
+        data = simMemory->configuration[address - SIM_CONFIG_ADDRESS];
+    }
+    else if ((address >= EEPROM_START_ADDRESS) && (address < (EEPROM_START_ADDRESS + SIM_EEPROM_SIZE)))
+    {
+        data = simMemory->eeprom[address - EEPROM_START_ADDRESS];
+    }
+    else if (address == SIM_DEVICE_ID_ADDRESS)
+    {
+        data = (uint8_t) SIM_DEVICE_ID;
+    }
+    else if (address == (SIM_DEVICE_ID_ADDRESS + 1U))
+    {
+        data = (uint8_t) (SIM_DEVICE_ID >> 8U);
+    }
+    else
+    {
+        // Unimplemented locations read as zero
+    }
+    return data;
+}
+
+void NVM_Initialize(void)
+{
+    NVM_StatusClear();
+}
+
+bool NVM_IsBusy(void)
+{
+    return false;
+}
+
+nvm_status_t NVM_StatusGet(void)
+{
+    return status;
+}
+
+void NVM_StatusClear(void)
+{
+    status = NVM_OK;
+}
+
+void NVM_UnlockKeySet(uint16_t key)
+{
+    unlockKey = key;
+}
+
+void NVM_UnlockKeyClear(void)
+{
+    unlockKey = 0x0000U;
+}
+
+flash_data_t FLASH_Read(flash_address_t address)
+{
+    return SIM_TableRead(address);
+}
+
+nvm_status_t FLASH_RowRead(flash_address_t address, flash_data_t *dataBuffer)
+{
+    flash_address_t page = FLASH_PageAddressGet(address);
+
+    memcpy(dataBuffer, &simMemory->flash[page], PROGMEM_PAGE_SIZE);
+    simMemory->counters.pageReads++;
+    return NVM_OK;
+}
+
+nvm_status_t FLASH_Write(flash_address_t address, uint16_t data)
+{
+    flash_address_t word = address & ~(flash_address_t) 1U;
+    bool cut;
+
+    if ((word >= PROGMEM_SIZE) || !SIM_Unlocked())
+    {
+        return NVM_ERROR;
+    }
+    cut = SIM_Cut();
+    if (cut)
+    {
+        data |= (uint16_t) (SIM_Garbage() | (SIM_Garbage() << 8U));
+    }
+    simMemory->flash[word] &= (uint8_t) data;
+    simMemory->flash[word + 1U] &= (uint8_t) (data >> 8U);
+    simMemory->counters.wordWrites++;
+    simMemory->counters.nvmBusyUs += simTiming.byteWriteUs;
+    if (cut)
+    {
+        SIM_PowerCut();
+    }
+    return NVM_OK;
+}
+
+nvm_status_t FLASH_RowWrite(flash_address_t address, flash_data_t *dataBuffer)
+{
+    flash_address_t page = FLASH_PageAddressGet(address);
+    uint16_t reached = PROGMEM_PAGE_SIZE;
+    bool cut;
+
+    if ((address >= PROGMEM_SIZE) || !SIM_Unlocked())
+    {
+        return NVM_ERROR;
+    }
+    cut = SIM_Cut();
+    if (cut)
+    {
+        reached = (uint16_t) (SIM_Garbage() % PROGMEM_PAGE_SIZE);
+    }
+    for (uint16_t i = 0U; i < PROGMEM_PAGE_SIZE; i++)
+    {
+        // A torn write leaves the rest of the row partly programmed
+        simMemory->flash[page + i] &= (i < reached) ? dataBuffer[i] : (uint8_t) (dataBuffer[i] | SIM_Garbage());
+    }
+    simMemory->counters.pageWrites++;
+    simMemory->counters.nvmBusyUs += simTiming.pageWriteUs;
+    if (cut)
+    {
+        SIM_PowerCut();
+    }
+    return NVM_OK;
+}
+
+nvm_status_t FLASH_PageErase(flash_address_t address)
+{
+    uint8_t *cell = &simMemory->flash[FLASH_PageAddressGet(address)];
+    bool cut;
+
+    if ((address >= PROGMEM_SIZE) || !SIM_Unlocked())
+    {
+        return NVM_ERROR;
+    }
+    cut = SIM_Cut();
+    if (cut)
+    {
+        // A torn erase leaves some bytes erased and some only partly
+        for (uint16_t i = 0U; i < PROGMEM_PAGE_SIZE; i++)
+        {
+            cell[i] = ((SIM_Garbage() & 1U) != 0U) ? 0xFFU : (uint8_t) (cell[i] | SIM_Garbage());
+        }
+    }
+    else
+    {
+        memset(cell, 0xFF, PROGMEM_PAGE_SIZE);
+    }
+    simMemory->counters.pageErases++;
+    simMemory->counters.nvmBusyUs += simTiming.pageEraseUs;
+    if (cut)
+    {
+        SIM_PowerCut();
+    }
+    return NVM_OK;
+}
+
+flash_address_t FLASH_PageAddressGet(flash_address_t address)
+{
+    return (flash_address_t) (address & ((PROGMEM_SIZE - 1U) ^ (PROGMEM_PAGE_SIZE - 1U)));
+}
+
+uint16_t FLASH_PageOffsetGet(flash_address_t address)
+{
+    return (uint16_t) (address & (PROGMEM_PAGE_SIZE - 1U));
+}
+
+eeprom_data_t EEPROM_Read(eeprom_address_t address)
+{
+    if (eepromReads != NULL)
+    {
+        (*eepromReads)++;
+    }
+    return SIM_TableRead(address);
+}
+
+void EEPROM_Write(eeprom_address_t address, eeprom_data_t data)
+{
+    if ((address < EEPROM_START_ADDRESS) || (address >= (EEPROM_START_ADDRESS + SIM_EEPROM_SIZE)) || !SIM_Unlocked())
+    {
+        return;
+    }
+    // The byte write erases the cell first, so a torn one leaves any value
+    bool cut = SIM_Cut();
+    simMemory->eeprom[address - EEPROM_START_ADDRESS] = cut ? SIM_Garbage() : data;
+    simMemory->counters.eepromWrites++;
+    if (eepromWear != NULL)
+    {
+        eepromWear[address - EEPROM_START_ADDRESS]++;
+    }
+    simMemory->counters.nvmBusyUs += simTiming.byteWriteUs;
+    if (cut)
+    {
+        SIM_PowerCut();
+    }
+}
+
+device_id_data_t DeviceID_Read(device_id_address_t address)
+{
+    return (device_id_data_t) (SIM_TableRead(address) | (SIM_TableRead(address + 1U) << 8U));
+}
+
+configuration_data_t CONFIGURATION_Read(configuration_address_t address)
+{
+    return SIM_TableRead(address);
+}
+
+void CONFIGURATION_Write(configuration_address_t address, configuration_data_t data)
+{
+    if ((address < SIM_CONFIG_ADDRESS) || (address >= (SIM_CONFIG_ADDRESS + SIM_CONFIG_SIZE)) || !SIM_Unlocked())
+    {
+        status = NVM_ERROR;
+        return;
+    }
+    bool cut = SIM_Cut();
+    simMemory->configuration[address - SIM_CONFIG_ADDRESS] = cut ? SIM_Garbage() : data;
+    simMemory->counters.configWrites++;
+    simMemory->counters.nvmBusyUs += simTiming.byteWriteUs;
+    if (cut)
+    {
+        SIM_PowerCut();
+    }
+}
@@ -0,0 +1,12 @@
+/**
+ *
+ * @file sim_registers.c
+ *
+ * @brief Storage of the special function registers declared by xc.h. Every process start of bl_sim is a
+ *        device reset, so the registers start at zero; sim_main.c sets the few that the firmware reads back.
+ */
+
+#include <xc.h>
+
+#define SIM_SFR(name)               volatile uint8_t name; volatile sim_bits_t name##bits;
+#include "sim_sfr.h"
@@ -0,0 +1,104 @@
+/**
+ *
+ * @file sim_sfr.h
+ *
+ * @brief Special function registers the firmware touches, expanded by xc.h and sim_registers.c.
+ */
+
+SIM_SFR(ACTCON)
+SIM_SFR(ANSELA)
+SIM_SFR(ANSELB)
+SIM_SFR(ANSELC)
+SIM_SFR(ANSELD)
+SIM_SFR(ANSELE)
+SIM_SFR(ANSELF)
+SIM_SFR(BSR)
+SIM_SFR(DMA1PR)
+SIM_SFR(DMA2PR)
+SIM_SFR(DMASELECT)
+SIM_SFR(INLVLA)
+SIM_SFR(INLVLB)
+SIM_SFR(INLVLC)
+SIM_SFR(INLVLD)
+SIM_SFR(INLVLE)
+SIM_SFR(INLVLF)
+SIM_SFR(INTCON0)
+SIM_SFR(IOCAF)
+SIM_SFR(IOCAN)
+SIM_SFR(IOCAP)
+SIM_SFR(IOCBF)
+SIM_SFR(IOCBN)
+SIM_SFR(IOCBP)
+SIM_SFR(IOCCF)
+SIM_SFR(IOCCN)
+SIM_SFR(IOCCP)
+SIM_SFR(IOCEF)
+SIM_SFR(IOCEN)
+SIM_SFR(IOCEP)
+SIM_SFR(ISRPR)
+SIM_SFR(LATA)
+SIM_SFR(LATB)
+SIM_SFR(LATC)
+SIM_SFR(LATD)
+SIM_SFR(LATE)
+SIM_SFR(LATF)
+SIM_SFR(MAINPR)
+SIM_SFR(ODCONA)
+SIM_SFR(ODCONB)
+SIM_SFR(ODCONC)
+SIM_SFR(ODCOND)
+SIM_SFR(ODCONE)
+SIM_SFR(ODCONF)
+SIM_SFR(OSCCON1)
+SIM_SFR(OSCCON3)
+SIM_SFR(OSCEN)
+SIM_SFR(OSCFRQ)
+SIM_SFR(OSCTUNE)
+SIM_SFR(PCON0)
+SIM_SFR(PIE3)
+SIM_SFR(PIR1)
+SIM_SFR(PIR10)
+SIM_SFR(PIR3)
+SIM_SFR(PIR6)
+SIM_SFR(PORTB)
+SIM_SFR(PRLOCK)
+SIM_SFR(RB1I2C)
+SIM_SFR(RB2I2C)
+SIM_SFR(RC3I2C)
+SIM_SFR(RC4I2C)
+SIM_SFR(RC5PPS)
+SIM_SFR(RF0PPS)
+SIM_SFR(SLRCONA)
+SIM_SFR(SLRCONB)
+SIM_SFR(SLRCONC)
+SIM_SFR(SLRCOND)
+SIM_SFR(SLRCONE)
+SIM_SFR(SLRCONF)
+SIM_SFR(SPI1CON1)
+SIM_SFR(SPI1CON2)
+SIM_SFR(SPI1SCKPPS)
+SIM_SFR(SPI1SDIPPS)
+SIM_SFR(SPI1SSPPS)
+SIM_SFR(SPI1TWIDTH)
+SIM_SFR(STKPTR)
+SIM_SFR(T0CON0)
+SIM_SFR(T0CON1)
+SIM_SFR(TABLAT)
+SIM_SFR(TBLPTRH)
+SIM_SFR(TBLPTRL)
+SIM_SFR(TBLPTRU)
+SIM_SFR(TMR0H)
+SIM_SFR(TMR0L)
+SIM_SFR(TRISA)
+SIM_SFR(TRISB)
+SIM_SFR(TRISC)
+SIM_SFR(TRISD)
+SIM_SFR(TRISE)
+SIM_SFR(TRISF)
+SIM_SFR(U1RXPPS)
+SIM_SFR(WPUA)
+SIM_SFR(WPUB)
+SIM_SFR(WPUC)
+SIM_SFR(WPUD)
+SIM_SFR(WPUE)
+SIM_SFR(WPUF)
@@ -0,0 +1,77 @@
+/**
+ *
+ * @file sim_slot.c
+ *
+ * @brief bl_slotsim: runs BL_SlotInstall of bl_slot.c, unchanged, on the simulated NVM of sim_nvm.c. A power cut
+ *        jumps back out of the firmware to SIM_SlotInstall, which is only C frames, and the next call is the
+ *        next boot.
+ */
+
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nvm/nvm.h"
+#include "bootloader/bl_slot.h"
+#include "sim_slot.h"
+
+const uint32_t simSlotStart = START_OF_APP;
+const uint32_t simSlotSize = BL_SLOT_SIZE;
+const uint8_t simSlotStateInstalling = BL_SLOT_STATE_INSTALLING;
+const uint32_t simSlotStateOffset = BL_SLOT_STATE_EEPROM - EEPROM_START_ADDRESS;
+
+static sim_memory_t slotMemory;
+sim_memory_t *simMemory = &slotMemory;
+
+static jmp_buf slotPowerCut;
+
+_Noreturn void SIM_Fatal(const char *message, const char *detail)
+{
+    fprintf(stderr, "bl_slotsim: %s%s%s\n", message, (detail != NULL) ? ": " : "", (detail != NULL) ? detail : "");
+    exit(1);
+}
+
+static void SIM_SlotPowerCut(void)
+{
+    longjmp(slotPowerCut, 1);
+}
+
+sim_memory_t *SIM_SlotMemory(void)
+{
+    return simMemory;
+}
+
+void SIM_SlotReset(void)
+{
+    SIM_CutDisarm();
+    memset(simMemory, 0, sizeof(*simMemory));
+    simMemory->magic = SIM_MAGIC;
+    memset(simMemory->flash, 0xFF, sizeof(simMemory->flash));
+    memset(simMemory->eeprom, 0xFF, sizeof(simMemory->eeprom));
+    memset(simMemory->configuration, 0xFF, sizeof(simMemory->configuration));
+}
+
+void SIM_SlotCutAfter(uint64_t operationsLeft, uint32_t seed)
+{
+    SIM_CutAfter(operationsLeft, seed, SIM_SlotPowerCut);
+}
+
+bool SIM_SlotInstall(bool requested, uint16_t unlockKey, uint8_t *result)
+{
+    // The reset clears the unlock key and the NVM status with the rest of the RAM
+    NVM_UnlockKeyClear();
+    NVM_Initialize();
+    if (setjmp(slotPowerCut) != 0)
+    {
+        simMemory->counters.resets++;
+        return false;
+    }
+    *result = BL_SlotInstall(requested, unlockKey);
+    return true;
+}
+
+bool SIM_SlotVerify(uint32_t imageAddress)
+{
+    return BL_bootVerifyImage((flash_address_t) imageAddress);
+}
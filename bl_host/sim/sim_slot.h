@@ -0,0 +1,49 @@
+/**
+ *
+ * @file sim_slot.h
+ *
+ * @brief bl_slotsim: BL_SlotInstall of bl_slot.c compiled for Linux, on the simulated NVM of sim_nvm.c.
+ *        A power cut returns from SIM_SlotInstall with everything but the NVM lost, as the reset of the device does.
+ *
+ *        This header is shared by sim_slot.c and the C++ sources of bl_slotsim.
+ */
+
+#ifndef SIM_SLOT_H
+#define SIM_SLOT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sim.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** START_OF_APP, BL_SLOT_SIZE and BL_SLOT_STATE_INSTALLING of the build. */
+extern const uint32_t simSlotStart;
+extern const uint32_t simSlotSize;
+extern const uint8_t simSlotStateInstalling;
+/** BL_SLOT_STATE_EEPROM as an offset into the EEPROM of the memory. */
+extern const uint32_t simSlotStateOffset;
+
+/** The memory BL_SlotInstall works on. */
+sim_memory_t *SIM_SlotMemory(void);
+/** Erases the memory, clears the counters and disarms the cut. */
+void SIM_SlotReset(void);
+/** The erase or write after the next operationsLeft ones of BL_SlotInstall is torn by a power cut. */
+void SIM_SlotCutAfter(uint64_t operationsLeft, uint32_t seed);
+/**
+ * Boots into BL_SlotInstall with the RAM request of the application, or without one.
+ * Returns false if the power was cut, otherwise true with the BL_SLOT_xxx result.
+ */
+bool SIM_SlotInstall(bool requested, uint16_t unlockKey, uint8_t *result);
+/** BL_bootVerifyImage. */
+bool SIM_SlotVerify(uint32_t imageAddress);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SIM_SLOT_H
@@ -0,0 +1,305 @@
+/**
+ *
+ * @file sim_spi1.c
+ *
+ * @brief bl_sim model of SPI1 in target mode and of the DMA channels, for bl_transport_spi.c (BL_TRANSPORT_SPI).
+ *        The SPI host is on the pseudo-terminal: every byte it writes is one byte it clocks, and bl_sim answers
+ *        each with the byte SPI1 shifted out, so a transfer of N bytes reads back N bytes. SpiPort of bl_host does
+ *        this when its spi: path is a terminal.
+ *
+ *        SPI1 shifts one byte of what the host sent, and the DMA runs, whenever the firmware accesses the DMA window
+ *        or SPI1STATUS: the CPU runs a few instructions per byte time, and the SPI clock stops while the firmware is
+ *        busy elsewhere. The transmit and receive FIFOs are two bytes
+ *        deep, and an empty transmit FIFO shifts out its last byte again. A DMA channel loads its pointers and
+ *        counters when it is enabled and moves one byte per start trigger: SPI1RX while a received byte waits,
+ *        SPI1TX while the transmit FIFO has room. A counter that runs out reloads its pointer and, with SSTP or
+ *        DSTP, clears SIRQEN. The DMA only runs once the priorities are locked.
+ */
+
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <xc.h>
+#include "sim.h"
+
+#define SIM_DMA_CHANNELS        (6U)
+#define SIM_SPI_FIFO_DEPTH      (2U)
+// Accesses without a byte from the host before one waits up to SIM_SPI_POLL_MS, so an idle bootloader does not spin
+#define SIM_SPI_IDLE_SPINS      (1000U)
+#define SIM_SPI_POLL_MS         (1)
+
+volatile sim_spi_con0_t simSpi1Con0;
+volatile uint8_t SPI1RXB;
+volatile uint16_t SPI1TXB = SIM_SPI_TXB_EMPTY;
+
+static volatile sim_spi_status_t spiStatus;
+static volatile sim_dma_t dma[SIM_DMA_CHANNELS];
+// EN of each channel as the last run saw it
+static bool dmaEnabled[SIM_DMA_CHANNELS];
+
+static int spiFd = -1;
+static unsigned idleSpins;
+// Bytes the host sent and the answers shifted out so far
+static uint8_t mosi[64];
+static uint8_t miso[sizeof(mosi)];
+static size_t mosiLength;
+static size_t shifted;
+static uint8_t txFifo[SIM_SPI_FIFO_DEPTH];
+static uint8_t txCount;
+static uint8_t txLast;
+static uint8_t rxFifo[SIM_SPI_FIFO_DEPTH];
+static uint8_t rxCount;
+
+void SIM_SpiAttach(int fd)
+{
+    spiFd = fd;
+}
+
+/*
+ * The firmware hands the DMA 16-bit or 24-bit addresses, which in bl_sim are the low bits of pointers. Its buffers
+ * and registers are statics of bl_sim, a few KB apart, so the pointer is the one nearest to SPI1RXB with these low
+ * 16 bits.
+ */
+static volatile uint8_t *SIM_DmaMemory(uint32_t address)
+{
+    uintptr_t reference = (uintptr_t) &SPI1RXB;
+    uintptr_t pointer = (reference & ~(uintptr_t) 0xFFFFU) | (address & 0xFFFFU);
+
+    if (pointer > (reference + 0x8000U))
+    {
+        pointer -= 0x10000U;
+    }
+    else if ((pointer + 0x8000U) < reference)
+    {
+        pointer += 0x10000U;
+    }
+    else
+    {
+        // Same 64 KB block
+    }
+    return (volatile uint8_t *) pointer;
+}
+
+static void SIM_SpiTxPush(uint8_t data)
+{
+    if (txCount < SIM_SPI_FIFO_DEPTH)
+    {
+        txFifo[txCount++] = data;
+    }
+    else
+    {
+        spiStatus.bits.TXWE = 1U;
+    }
+}
+
+static uint8_t SIM_DmaRead(uint32_t address)
+{
+    volatile uint8_t *memory = SIM_DmaMemory(address);
+    uint8_t data = *memory;
+
+    if (memory == &SPI1RXB)
+    {
+        data = rxFifo[0];
+        rxFifo[0] = rxFifo[1];
+        rxCount--;
+    }
+    return data;
+}
+
+static void SIM_DmaWrite(uint16_t address, uint8_t data)
+{
+    volatile uint8_t *memory = SIM_DmaMemory(address);
+
+    if (memory == (volatile uint8_t *) &SPI1TXB)
+    {
+        SIM_SpiTxPush(data);
+    }
+    else
+    {
+        *memory = data;
+    }
+}
+
+static bool SIM_DmaTriggered(volatile sim_dma_t *channel)
+{
+    return (channel->CON0.bits.EN == 1U) && (channel->CON0.bits.SIRQEN == 1U) && (PRLOCKbits.PRLOCKED == 1U)
+           && (((channel->SIRQ == SIM_IRQ_SPI1RX) && (rxCount > 0U))
+               || ((channel->SIRQ == SIM_IRQ_SPI1TX) && (txCount < SIM_SPI_FIFO_DEPTH)));
+}
+
+static void SIM_DmaMove(volatile sim_dma_t *channel)
+{
+    SIM_DmaWrite(channel->DPTR, SIM_DmaRead(channel->SPTR));
+    if (channel->CON1.bits.SMODE == 1U)
+    {
+        channel->SPTR++;
+    }
+    if (channel->CON1.bits.DMODE == 1U)
+    {
+        channel->DPTR++;
+    }
+    if (--channel->SCNT == 0U)
+    {
+        channel->SPTR = channel->SSA;
+        channel->SCNT = channel->SSZ;
+        if (channel->CON1.bits.SSTP == 1U)
+        {
+            channel->CON0.bits.SIRQEN = 0U;
+        }
+    }
+    if (--channel->DCNT == 0U)
+    {
+        channel->DPTR = channel->DSA;
+        channel->DCNT = channel->DSZ;
+        if (channel->CON1.bits.DSTP == 1U)
+        {
+            channel->CON0.bits.SIRQEN = 0U;
+        }
+    }
+}
+
+// Takes what the firmware wrote since the last run, then moves bytes until no channel is triggered
+static void SIM_SpiRun(void)
+{
+    bool moved = true;
+
+    if (spiStatus.bits.CLRBF == 1U)
+    {
+        txCount = 0U;
+        rxCount = 0U;
+        spiStatus.bits.CLRBF = 0U;
+    }
+    if (SPI1TXB != SIM_SPI_TXB_EMPTY)
+    {
+        SIM_SpiTxPush((uint8_t) SPI1TXB);
+        SPI1TXB = SIM_SPI_TXB_EMPTY;
+    }
+    for (uint8_t i = 0U; i < SIM_DMA_CHANNELS; i++)
+    {
+        if ((dma[i].CON0.bits.EN == 1U) && !dmaEnabled[i])
+        {
+            dma[i].SPTR = dma[i].SSA;
+            dma[i].SCNT = dma[i].SSZ;
+            dma[i].DPTR = dma[i].DSA;
+            dma[i].DCNT = dma[i].DSZ;
+        }
+        dmaEnabled[i] = (dma[i].CON0.bits.EN == 1U);
+        if (dmaEnabled[i] && (dma[i].CON0.bits.SIRQEN == 1U) && (dma[i].SIRQ != SIM_IRQ_SPI1RX)
+            && (dma[i].SIRQ != SIM_IRQ_SPI1TX))
+        {
+            // On the device the channel would wait for a source bl_sim does not model
+            SIM_Fatal("a DMA channel starts on neither SPI1RX nor SPI1TX", NULL);
+        }
+    }
+    while (moved)
+    {
+        moved = false;
+        for (uint8_t i = 0U; i < SIM_DMA_CHANNELS; i++)
+        {
+            if (SIM_DmaTriggered(&dma[i]))
+            {
+                SIM_DmaMove(&dma[i]);
+                moved = true;
+            }
+        }
+    }
+    spiStatus.bits.TXBE = (txCount == 0U) ? 1U : 0U;
+    spiStatus.bits.RXBF = (rxCount == SIM_SPI_FIFO_DEPTH) ? 1U : 0U;
+}
+
+// One byte clocked by the host
+static uint8_t SIM_SpiExchange(uint8_t mosi)
+{
+    if (simSpi1Con0.bits.EN == 0U)
+    {
+        return 0x00U;
+    }
+    if (txCount > 0U)
+    {
+        txLast = txFifo[0];
+        txFifo[0] = txFifo[1];
+        txCount--;
+    }
+    if (rxCount < SIM_SPI_FIFO_DEPTH)
+    {
+        rxFifo[rxCount++] = mosi;
+    }
+    else
+    {
+        spiStatus.bits.RXRE = 1U;
+    }
+    return txLast;
+}
+
+// Answers the bytes of the host once all of them were shifted
+static void SIM_SpiAnswer(void)
+{
+    size_t written = 0U;
+
+    simMemory->counters.bytesRx += mosiLength;
+    simMemory->counters.bytesTx += mosiLength;
+    while (written < mosiLength)
+    {
+        ssize_t n = write(spiFd, miso + written, mosiLength - written);
+        if (n > 0)
+        {
+            written += (size_t) n;
+        }
+        else if ((n < 0) && (errno != EAGAIN) && (errno != EINTR))
+        {
+            SIM_Fatal("pseudo-terminal write failed", NULL);
+        }
+    }
+    mosiLength = 0U;
+    shifted = 0U;
+}
+
+static void SIM_SpiService(void)
+{
+    struct pollfd pfd = {spiFd, POLLIN, 0};
+    ssize_t received = 0;
+
+    SIM_SpiRun();
+    if (spiFd < 0)
+    {
+        return;
+    }
+    if (mosiLength == 0U)
+    {
+        if (poll(&pfd, 1U, (idleSpins >= SIM_SPI_IDLE_SPINS) ? SIM_SPI_POLL_MS : 0) > 0)
+        {
+            received = read(spiFd, mosi, sizeof(mosi));
+        }
+        if (received <= 0)
+        {
+            idleSpins++;
+            return;
+        }
+        idleSpins = 0U;
+        mosiLength = (size_t) received;
+    }
+    miso[shifted] = SIM_SpiExchange(mosi[shifted]);
+    shifted++;
+    SIM_SpiRun();
+    if (shifted == mosiLength)
+    {
+        SIM_SpiAnswer();
+    }
+}
+
+volatile sim_spi_status_t *SIM_Spi1Status(void)
+{
+    SIM_SpiService();
+    return &spiStatus;
+}
+
+volatile sim_dma_t *SIM_DmaWindow(void)
+{
+    SIM_SpiService();
+    if (DMASELECT >= SIM_DMA_CHANNELS)
+    {
+        SIM_Fatal("DMASELECT selects no DMA channel", NULL);
+    }
+    return &dma[DMASELECT];
+}
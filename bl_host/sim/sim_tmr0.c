@@ -0,0 +1,95 @@
+/**
+ *
+ * @file sim_tmr0.c
+ *
+ * @brief bl_sim replacement of tmr0.c: the 16-bit counter and its overflow flag follow the monotonic clock of
+ *        the host at TMR0_TICK_PERIOD_US per count. As on the device, wraps between two clears of the flag
+ *        set it only once.
+ */
+
+// clock_gettime under -std=c99
+#define _DEFAULT_SOURCE
+
+#include <time.h>
+
+#include "timer/tmr0.h"
+
+static uint64_t tmr0StartUs = 0U;
+// Ticks counted while the timer is stopped or reloaded
+static uint64_t tmr0OffsetTicks = 0U;
+static bool tmr0Running = false;
+// Wraps up to the last clear of the overflow flag
+static uint64_t tmr0ClearedWraps = 0U;
+
+static uint64_t SIM_Tmr0NowUs(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t) now.tv_sec * 1000000U) + ((uint64_t) now.tv_nsec / 1000U);
+}
+
+static uint64_t SIM_Tmr0Ticks(void)
+{
+    uint64_t ticks = tmr0OffsetTicks;
+
+    if (tmr0Running)
+    {
+        ticks += (SIM_Tmr0NowUs() - tmr0StartUs) / TMR0_TICK_PERIOD_US;
+    }
+    return ticks;
+}
+
+void TMR0_Initialize(void)
+{
+    tmr0OffsetTicks = 0U;
+    tmr0ClearedWraps = 0U;
+    tmr0StartUs = SIM_Tmr0NowUs();
+    tmr0Running = true;
+}
+
+void TMR0_Deinitialize(void)
+{
+    tmr0Running = false;
+    tmr0OffsetTicks = 0U;
+    tmr0ClearedWraps = 0U;
+}
+
+void TMR0_Start(void)
+{
+    if (!tmr0Running)
+    {
+        tmr0StartUs = SIM_Tmr0NowUs();
+        tmr0Running = true;
+    }
+}
+
+void TMR0_Stop(void)
+{
+    tmr0OffsetTicks = SIM_Tmr0Ticks();
+    tmr0Running = false;
+}
+
+uint16_t TMR0_CounterGet(void)
+{
+    return (uint16_t) SIM_Tmr0Ticks();
+}
+
+void TMR0_CounterSet(uint16_t counterValue)
+{
+    uint64_t wraps = SIM_Tmr0Ticks() >> 16U;
+
+    // Keeps the wrap count, so the flag is not set by the reload itself
+    tmr0OffsetTicks = (wraps << 16U) | counterValue;
+    tmr0StartUs = SIM_Tmr0NowUs();
+}
+
+bool TMR0_OverflowStatusGet(void)
+{
+    return (SIM_Tmr0Ticks() >> 16U) != tmr0ClearedWraps;
+}
+
+void TMR0_OverflowStatusClear(void)
+{
+    tmr0ClearedWraps = SIM_Tmr0Ticks() >> 16U;
+}
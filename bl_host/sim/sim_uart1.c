@@ -0,0 +1,247 @@
+/**
+ *
+ * @file sim_uart1.c
+ *
+ * @brief bl_sim replacement of uart1.c: UART1 on the master side of a pseudo-terminal.
+ *        Autobaud completes on the first byte after it was armed and consumes that byte, as the
+ *        hardware does with the 0x55 sync character. Transmitted bytes are collected and sent once the
+ *        firmware asks whether transmission is done. The bit rate is whatever the host sets on its side.
+ */
+
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include "uart/uart1.h"
+#include "sim.h"
+
+// Longest wait for the host in one receive poll, so an idle bootloader does not spin
+#define SIM_UART_POLL_MS        (1)
+
+const uart_drv_interface_t UART1 = {
+    .Initialize = &UART1_Initialize,
+    .Deinitialize = &UART1_Deinitialize,
+    .Read = &UART1_Read,
+    .Write = &UART1_Write,
+    .IsRxReady = &UART1_IsRxReady,
+    .IsTxReady = &UART1_IsTxReady,
+    .IsTxDone = &UART1_IsTxDone,
+    .TransmitEnable = &UART1_TransmitEnable,
+    .TransmitDisable = &UART1_TransmitDisable,
+    .AutoBaudSet = &UART1_AutoBaudSet,
+    .AutoBaudQuery = &UART1_AutoBaudQuery,
+    .BRGCountSet = NULL,
+    .BRGCountGet = NULL,
+    .BaudRateSet = NULL,
+    .BaudRateGet = NULL,
+    .AutoBaudEventEnableGet = NULL,
+    .ErrorGet = &UART1_ErrorGet,
+    .TxCompleteCallbackRegister = NULL,
+    .RxCompleteCallbackRegister = NULL,
+    .TxCollisionCallbackRegister = NULL,
+    .FramingErrorCallbackRegister = &UART1_FramingErrorCallbackRegister,
+    .OverrunErrorCallbackRegister = &UART1_OverrunErrorCallbackRegister,
+    .ParityErrorCallbackRegister = &UART1_ParityErrorCallbackRegister,
+    .EventCallbackRegister = NULL,
+};
+
+static int uartFd = -1;
+static uint8_t rxBuffer[512];
+static size_t rxHead;
+static size_t rxTail;
+static uint8_t txBuffer[1024];
+static size_t txLength;
+static bool autoBaudArmed;
+static bool autoBaudDone;
+
+void SIM_UartAttach(int fd)
+{
+    uartFd = fd;
+}
+
+void SIM_UartFlush(void)
+{
+    size_t written = 0U;
+
+    // Counted first: the host may act on the reply before this function returns
+    simMemory->counters.bytesTx += txLength;
+    while (written < txLength)
+    {
+        ssize_t n = write(uartFd, txBuffer + written, txLength - written);
+        if (n > 0)
+        {
+            written += (size_t) n;
+        }
+        else if ((n < 0) && (errno != EAGAIN) && (errno != EINTR))
+        {
+            SIM_Fatal("pseudo-terminal write failed", NULL);
+        }
+    }
+    txLength = 0U;
+}
+
+// Refills the receive buffer, waiting up to SIM_UART_POLL_MS for the host
+static bool SIM_UartReceive(void)
+{
+    struct pollfd pfd = {uartFd, POLLIN, 0};
+
+    if (rxHead != rxTail)
+    {
+        return true;
+    }
+    // Whatever the firmware queued has to reach the host before the firmware can expect an answer
+    SIM_UartFlush();
+    if (poll(&pfd, 1U, SIM_UART_POLL_MS) > 0)
+    {
+        ssize_t n = read(uartFd, rxBuffer, sizeof(rxBuffer));
+        if (n > 0)
+        {
+            rxHead = (size_t) n;
+            rxTail = 0U;
+            simMemory->counters.bytesRx += (uint64_t) n;
+        }
+    }
+    return rxHead != rxTail;
+}
+
+void UART1_Initialize(void)
+{
+    rxHead = 0U;
+    rxTail = 0U;
+    txLength = 0U;
+    autoBaudArmed = false;
+    autoBaudDone = false;
+}
+
+void UART1_Deinitialize(void)
+{
+    SIM_UartFlush();
+}
+
+void UART1_Enable(void)
+{
+}
+
+void UART1_Disable(void)
+{
+}
+
+void UART1_TransmitEnable(void)
+{
+}
+
+void UART1_TransmitDisable(void)
+{
+}
+
+void UART1_ReceiveEnable(void)
+{
+}
+
+void UART1_ReceiveDisable(void)
+{
+}
+
+void UART1_SendBreakControlEnable(void)
+{
+}
+
+void UART1_SendBreakControlDisable(void)
+{
+}
+
+void UART1_AutoBaudSet(bool enable)
+{
+    autoBaudArmed = enable;
+    if (enable)
+    {
+        autoBaudDone = false;
+    }
+}
+
+bool UART1_AutoBaudQuery(void)
+{
+    if (autoBaudArmed && SIM_UartReceive())
+    {
+        // The sync character sets the bit rate and is not received
+        rxTail++;
+        autoBaudArmed = false;
+        autoBaudDone = true;
+        simMemory->counters.framesReceived++;
+    }
+    return autoBaudDone;
+}
+
+void UART1_AutoBaudDetectCompleteReset(void)
+{
+    autoBaudDone = false;
+}
+
+bool UART1_IsAutoBaudDetectOverflow(void)
+{
+    return false;
+}
+
+void UART1_AutoBaudDetectOverflowReset(void)
+{
+}
+
+bool UART1_IsRxReady(void)
+{
+    return SIM_UartReceive();
+}
+
+bool UART1_IsTxReady(void)
+{
+    if (txLength == sizeof(txBuffer))
+    {
+        SIM_UartFlush();
+    }
+    return true;
+}
+
+bool UART1_IsTxDone(void)
+{
+    SIM_UartFlush();
+    return true;
+}
+
+size_t UART1_ErrorGet(void)
+{
+    return 0U;
+}
+
+uint8_t UART1_Read(void)
+{
+    uint8_t data = 0x00U;
+
+    if (SIM_UartReceive())
+    {
+        data = rxBuffer[rxTail++];
+    }
+    return data;
+}
+
+void UART1_Write(uint8_t txData)
+{
+    if (txLength == sizeof(txBuffer))
+    {
+        SIM_UartFlush();
+    }
+    txBuffer[txLength++] = txData;
+}
+
+void UART1_FramingErrorCallbackRegister(void (* callbackHandler)(void))
+{
+    (void) callbackHandler;
+}
+
+void UART1_OverrunErrorCallbackRegister(void (* callbackHandler)(void))
+{
+    (void) callbackHandler;
+}
+
+void UART1_ParityErrorCallbackRegister(void (* callbackHandler)(void))
+{
+    (void) callbackHandler;
+}
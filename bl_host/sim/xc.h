@@ -0,0 +1,189 @@
+/**
+ *
+ * @file xc.h
+ *
+ * @brief Stand-in for the XC8 device header when the firmware is compiled for bl_sim.
+ *        Special function registers are plain variables (sim_registers.c). The named bits of every
+ *        register share one bit-field layout, so a register and its bits are separate storage and bit
+ *        positions do not follow the data sheet; the firmware only needs each bit to keep its value.
+ *        SPI1 and the DMA registers are the exception (sim_spi1.c).
+ */
+
+#ifndef SIM_XC_H
+#define SIM_XC_H
+
+#include <stdint.h>
+
+typedef uint32_t uint24_t;
+
+#define __near
+#define __persistent
+#define __at(address)
+#define __section(name)
+#define __interrupt(...)
+#define ___mkstr1(x)                #x
+#define ___mkstr(x)                 ___mkstr1(x)
+#define __delay_ms(ms)              ((void) 0)
+#define __delay_us(us)              ((void) 0)
+#define NOP()                       ((void) 0)
+#define CLRWDT()                    ((void) 0)
+#define RESET()                     SIM_Reset()
+#define asm(text)                   SIM_Asm(text)
+// XC8 compiles the inline declarations of uart1.h as ordinary functions; so does bl_sim
+#define inline
+
+void SIM_Asm(const char *text);
+_Noreturn void SIM_Reset(void);
+
+typedef struct
+{
+    unsigned ANSELA5 : 1;
+    unsigned ANSELC3 : 1;
+    unsigned ANSELC4 : 1;
+    unsigned ANSELC5 : 1;
+    unsigned EN : 1;
+    unsigned GIE : 1;
+    unsigned INT0EDG : 1;
+    unsigned INT0IF : 1;
+    unsigned INT1EDG : 1;
+    unsigned INT1IF : 1;
+    unsigned INT2EDG : 1;
+    unsigned INT2IF : 1;
+    unsigned IPEN : 1;
+    unsigned LATF3 : 1;
+    unsigned nRI : 1;
+    unsigned PRLOCKED : 1;
+    unsigned RB4 : 1;
+    unsigned TMR0IE : 1;
+    unsigned TMR0IF : 1;
+    unsigned TRISA5 : 1;
+    unsigned TRISC3 : 1;
+    unsigned TRISC4 : 1;
+    unsigned TRISC5 : 1;
+} sim_bits_t;
+
+#define SIM_SFR(name)               extern volatile uint8_t name; extern volatile sim_bits_t name##bits;
+#include "sim_sfr.h"
+#undef SIM_SFR
+
+/*
+ * SPI1 and the DMA channels, modelled by sim_spi1.c for bl_transport_spi.c. The SPI backend writes whole control
+ * registers and single bits of the same ones, so these registers overlay their bits at the data sheet positions.
+ * The DMA registers are a window onto the channel DMASELECT selects. Every access to the window or to SPI1STATUS
+ * first lets SPI1 and the DMA run, as they run alongside the CPU on the device.
+ */
+typedef union
+{
+    uint8_t reg;
+    struct
+    {
+        uint8_t BMODE : 1;
+        uint8_t MST : 1;
+        uint8_t LSBF : 1;
+        uint8_t : 4;
+        uint8_t EN : 1;
+    } bits;
+} sim_spi_con0_t;
+
+typedef union
+{
+    uint8_t reg;
+    struct
+    {
+        uint8_t RXBF : 1;
+        uint8_t : 1;
+        uint8_t CLRBF : 1;
+        uint8_t RXRE : 1;
+        uint8_t : 1;
+        uint8_t TXBE : 1;
+        uint8_t : 1;
+        uint8_t TXWE : 1;
+    } bits;
+} sim_spi_status_t;
+
+typedef union
+{
+    uint8_t reg;
+    struct
+    {
+        uint8_t XIP : 1;
+        uint8_t : 1;
+        uint8_t AIRQEN : 1;
+        uint8_t : 2;
+        uint8_t DGO : 1;
+        uint8_t SIRQEN : 1;
+        uint8_t EN : 1;
+    } bits;
+} sim_dma_con0_t;
+
+typedef union
+{
+    uint8_t reg;
+    struct
+    {
+        uint8_t SSTP : 1;
+        uint8_t SMODE : 2;
+        uint8_t SMR : 2;
+        uint8_t DSTP : 1;
+        uint8_t DMODE : 2;
+    } bits;
+} sim_dma_con1_t;
+
+// Ordered without padding, so that sim_spi1.c and the firmware objects built with -fpack-struct agree
+typedef struct
+{
+    uint24_t SSA;
+    uint24_t SPTR;
+    uint16_t SSZ;
+    uint16_t SCNT;
+    uint16_t DSA;
+    uint16_t DSZ;
+    uint16_t DPTR;
+    uint16_t DCNT;
+    sim_dma_con0_t CON0;
+    sim_dma_con1_t CON1;
+    uint8_t SIRQ;
+    uint8_t AIRQ;
+} sim_dma_t;
+
+/*
+ * Interrupt vector numbers, which are also the DMA trigger sources, from the vector table of the PIC18F27/47/57Q43
+ * data sheet (DS40002147). sim_spi1.c starts a channel on these, not on the values of bl_transport_spi.c.
+ */
+#define SIM_IRQ_DMA1SCNT            (0x14U)
+#define SIM_IRQ_DMA1DCNT            (0x15U)
+#define SIM_IRQ_DMA1OR              (0x16U)
+#define SIM_IRQ_DMA1A               (0x17U)
+#define SIM_IRQ_SPI1RX              (0x18U)
+#define SIM_IRQ_SPI1TX              (0x19U)
+#define SIM_IRQ_SPI1                (0x1AU)
+
+/** SPI1TXB holds this until the firmware writes a byte, which SPI1 then moves into its transmit FIFO. */
+#define SIM_SPI_TXB_EMPTY           (0xFFFFU)
+
+extern volatile sim_spi_con0_t simSpi1Con0;
+extern volatile uint8_t SPI1RXB;
+extern volatile uint16_t SPI1TXB;
+
+/** Runs SPI1 and the DMA, then returns the status register or the DMA channel DMASELECT selects. */
+volatile sim_spi_status_t *SIM_Spi1Status(void);
+volatile sim_dma_t *SIM_DmaWindow(void);
+
+#define SPI1CON0                    (simSpi1Con0.reg)
+#define SPI1CON0bits                (simSpi1Con0.bits)
+#define SPI1STATUS                  (SIM_Spi1Status()->reg)
+#define SPI1STATUSbits              (SIM_Spi1Status()->bits)
+#define DMAnCON0                    (SIM_DmaWindow()->CON0.reg)
+#define DMAnCON0bits                (SIM_DmaWindow()->CON0.bits)
+#define DMAnCON1                    (SIM_DmaWindow()->CON1.reg)
+#define DMAnCON1bits                (SIM_DmaWindow()->CON1.bits)
+#define DMAnSSA                     (SIM_DmaWindow()->SSA)
+#define DMAnSSZ                     (SIM_DmaWindow()->SSZ)
+#define DMAnDSA                     (SIM_DmaWindow()->DSA)
+#define DMAnDSZ                     (SIM_DmaWindow()->DSZ)
+#define DMAnSIRQ                    (SIM_DmaWindow()->SIRQ)
+#define DMAnAIRQ                    (SIM_DmaWindow()->AIRQ)
+#define DMAnSPTR                    (SIM_DmaWindow()->SPTR)
+#define DMAnDPTR                    (SIM_DmaWindow()->DPTR)
+
+#endif // SIM_XC_H
@@ -0,0 +1,614 @@
+/**
+ *
+ * @file bl_protocol.cpp
+ *
+ * @brief Frame encoding helpers for the 8-bit bootloader protocol.
+ */
+
+#include "bl_protocol.hpp"
+
+#include <cstdio>
+
+namespace blhost
+{
+
+namespace
+{
+
+// Fixed part of every reply timeout: UART turnaround plus host scheduling
+constexpr unsigned BASE_TIMEOUT_MS = 500U;
+// Upper bound of the page read and scan BLANK_CHECK spends on each page
+constexpr unsigned BLANK_CHECK_PAGE_US = 500U;
+
+unsigned UsToMs(uint64_t us)
+{
+    return static_cast<unsigned>((us + 999U) / 1000U);
+}
+
+uint32_t GetLittleEndian(const uint8_t *data, size_t size)
+{
+    uint32_t value = 0U;
+
+    for (size_t i = size; i > 0U; i--)
+    {
+        value = (value << 8U) | data[i - 1U];
+    }
+    return value;
+}
+
+}
+
+std::vector<uint8_t> Frame::Encode() const
+{
+    std::vector<uint8_t> out;
+
+    out.reserve(1U + BL_HEADER + data.size());
+    out.push_back(STX);
+    out.push_back(command);
+    out.push_back(static_cast<uint8_t>(dataLength));
+    out.push_back(static_cast<uint8_t>(dataLength >> 8U));
+    out.push_back(static_cast<uint8_t>(key));
+    out.push_back(static_cast<uint8_t>(key >> 8U));
+    out.push_back(static_cast<uint8_t>(address));
+    out.push_back(static_cast<uint8_t>(address >> 8U));
+    out.push_back(static_cast<uint8_t>(address >> 16U));
+    out.push_back(static_cast<uint8_t>(address >> 24U));
+    out.insert(out.end(), data.begin(), data.end());
+
+    return out;
+}
+
+Frame MakeReadVersion()
+{
+    Frame frame;
+
+    frame.command = READ_VERSION;
+    frame.expectedReplyLength = BL_HEADER + 16U;
+    frame.timeoutMs = BASE_TIMEOUT_MS;
+    return frame;
+}
+
+Frame MakeReadCapabilities()
+{
+    Frame frame = MakeReadVersion();
+
+    frame.address = VERSION_CAPABILITIES;
+    frame.expectedReplyLength = BL_HEADER + VERSION_DATA_SIZE + CAPABILITY_SIZE;
+    return frame;
+}
+
+Capabilities ParseCapabilities(const Reply &reply)
+{
+    Capabilities capabilities;
+
+    if (!reply.Valid() || (reply.Command() != READ_VERSION) || (reply.DataLength() < VERSION_DATA_SIZE))
+    {
+        return capabilities;
+    }
+    const uint8_t *data = reply.Data();
+    size_t size = data[5];
+    // Bytes 4 and 5 were zero before the block existed
+    if ((data[4] < CAPABILITY_VERSION) || (size < CAPABILITY_SIZE) ||
+        (reply.DataLength() < (VERSION_DATA_SIZE + size)))
+    {
+        return capabilities;
+    }
+    const uint8_t *block = data + VERSION_DATA_SIZE;
+    capabilities.present = true;
+    capabilities.version = block[0];
+    capabilities.commands = GetLittleEndian(&block[2], 4U);
+    capabilities.features = GetLittleEndian(&block[6], 4U);
+    capabilities.maxFrameData = static_cast<uint16_t>(GetLittleEndian(&block[10], 2U));
+    capabilities.verifyScheme = block[12];
+    capabilities.frameWindow = block[13];
+    capabilities.rxDepth = static_cast<uint16_t>(GetLittleEndian(&block[14], 2U));
+    capabilities.eeQueueSize = static_cast<uint16_t>(GetLittleEndian(&block[16], 2U));
+    capabilities.transport = block[18];
+    capabilities.baudMin = GetLittleEndian(&block[20], 4U);
+    capabilities.baudMax = GetLittleEndian(&block[24], 4U);
+    capabilities.startOfApp = GetLittleEndian(&block[28], 4U);
+    return capabilities;
+}
+
+Frame MakeReadFlash(uint32_t address, uint16_t length)
+{
+    Frame frame;
+
+    frame.command = READ_FLASH;
+    frame.dataLength = length;
+    frame.address = address;
+    frame.expectedReplyLength = BL_HEADER + 1U + length;
+    frame.timeoutMs = BASE_TIMEOUT_MS;
+    return frame;
+}
+
+Frame MakeWriteFlash(uint32_t address, const uint8_t *data, uint16_t length, const NvmTiming &timing)
+{
+    Frame frame;
+
+    frame.command = WRITE_FLASH;
+    frame.dataLength = length;
+    frame.key = UNLOCK_KEY;
+    frame.address = address;
+    frame.data.assign(data, data + length);
+    frame.expectedReplyLength = BL_HEADER + 1U;
+    frame.busyUs = static_cast<uint64_t>(timing.pageEraseUs) + timing.pageWriteUs;
+    frame.timeoutMs = BASE_TIMEOUT_MS + UsToMs(frame.busyUs);
+    return frame;
+}
+
+Frame MakeEraseFlash(uint32_t address, uint16_t pages, const NvmTiming &timing)
+{
+    Frame frame;
+
+    frame.command = ERASE_FLASH;
+    frame.dataLength = pages;
+    frame.key = UNLOCK_KEY;
+    frame.address = address;
+    frame.expectedReplyLength = BL_HEADER + 1U + ERASE_COUNTS_SIZE;
+    // Devices with the page journal first clear the image ID and the bits of the erased pages
+    frame.busyUs = (static_cast<uint64_t>(timing.pageEraseUs) * pages)
+                   + (static_cast<uint64_t>(timing.eepromByteWriteUs) * (JOURNAL_ID_SIZE + ((pages + 7U) / 8U)));
+    frame.timeoutMs = BASE_TIMEOUT_MS + UsToMs(frame.busyUs);
+    return frame;
+}
+
+Frame MakeBlankCheck(uint32_t address, uint16_t pages)
+{
+    Frame frame;
+
+    frame.command = BLANK_CHECK;
+    frame.dataLength = pages;
+    frame.address = address;
+    frame.expectedReplyLength = BL_HEADER + 3U + ((pages + 7U) / 8U);
+    frame.timeoutMs = BASE_TIMEOUT_MS + UsToMs(static_cast<uint64_t>(BLANK_CHECK_PAGE_US) * pages);
+    return frame;
+}
+
+Frame MakePatch(uint32_t address, const std::vector<uint8_t> &stream, const NvmTiming &timing)
+{
+    Frame frame;
+
+    frame.command = PATCH;
+    frame.dataLength = static_cast<uint16_t>(stream.size());
+    frame.key = UNLOCK_KEY;
+    frame.address = address;
+    frame.data = stream;
+    frame.expectedReplyLength = BL_HEADER + 1U;
+    frame.busyUs = static_cast<uint64_t>(timing.pageEraseUs) + timing.pageWriteUs;
+    frame.timeoutMs = BASE_TIMEOUT_MS + UsToMs(frame.busyUs);
+    return frame;
+}
+
+Frame MakeSecureWrite(uint32_t address, const std::vector<uint8_t> &sealed, const NvmTiming &timing)
+{
+    Frame frame;
+
+    frame.command = SECURE_WRITE;
+    frame.dataLength = static_cast<uint16_t>(sealed.size());
+    frame.key = UNLOCK_KEY;
+    frame.address = address;
+    frame.data = sealed;
+    frame.expectedReplyLength = BL_HEADER + 1U;
+    frame.busyUs = static_cast<uint64_t>(timing.pageEraseUs) + timing.pageWriteUs;
+    frame.timeoutMs = BASE_TIMEOUT_MS + UsToMs(frame.busyUs);
+    return frame;
+}
+
+Frame MakeReadEeprom(uint32_t address, uint16_t length)
+{
+    Frame frame;
+
+    frame.command = READ_EE_DATA;
+    frame.dataLength = length;
+    frame.address = address;
+    frame.expectedReplyLength = BL_HEADER + 1U + length;
+    frame.timeoutMs = BASE_TIMEOUT_MS;
+    return frame;
+}
+
+Frame MakeWriteEeprom(uint32_t address, const uint8_t *data, uint16_t length, const NvmTiming &timing)
+{
+    Frame frame;
+
+    frame.command = WRITE_EE_DATA;
+    frame.dataLength = length;
+    frame.key = UNLOCK_KEY;
+    frame.address = address;
+    frame.data.assign(data, data + length);
+    frame.expectedReplyLength = BL_HEADER + 1U + WRITE_COUNTS_SIZE;
+    frame.busyUs = static_cast<uint64_t>(timing.eepromByteWriteUs) * length;
+    frame.timeoutMs = BASE_TIMEOUT_MS + UsToMs(frame.busyUs);
+    return frame;
+}
+
+Frame MakeEepromBarrier(const NvmTiming &timing)
+{
+    Frame frame;
+
+    // Bootloaders without the queue program the bytes before replying and accept DATALEN 0 as a no-op
+    frame.command = WRITE_EE_DATA;
+    frame.key = UNLOCK_KEY;
+    frame.address = EEPROM_START_ADDRESS;
+    frame.expectedReplyLength = BL_HEADER + 1U + WRITE_COUNTS_SIZE;
+    // A full queue may be ahead of it; paced broadcast frames have already left the queue empty
+    frame.timeoutMs = BASE_TIMEOUT_MS + UsToMs(static_cast<uint64_t>(timing.eepromByteWriteUs) * EE_QUEUE_SIZE);
+    return frame;
+}
+
+Frame MakeWriteConfig(uint32_t address, const uint8_t *data, uint16_t length, const NvmTiming &timing)
+{
+    Frame frame;
+
+    frame.command = WRITE_CONFIG;
+    frame.dataLength = length;
+    frame.key = UNLOCK_KEY;
+    frame.address = address;
+    frame.data.assign(data, data + length);
+    frame.expectedReplyLength = BL_HEADER + 1U + WRITE_COUNTS_SIZE;
+    frame.busyUs = static_cast<uint64_t>(timing.eepromByteWriteUs) * length;
+    frame.timeoutMs = BASE_TIMEOUT_MS + UsToMs(frame.busyUs);
+    return frame;
+}
+
+Frame MakeCalcChecksum(uint32_t address, uint32_t length)
+{
+    Frame frame;
+
+    // Bits 16..23 of the length travel in the KEY_L field
+    frame.command = CALC_CHECKSUM;
+    frame.dataLength = static_cast<uint16_t>(length);
+    frame.key = static_cast<uint16_t>((length >> 16U) & 0xFFU);
+    frame.address = address;
+    frame.expectedReplyLength = BL_HEADER + 2U;
+    // FLASH_Read costs a few microseconds per byte on the device
+    frame.timeoutMs = BASE_TIMEOUT_MS + (length / 100U);
+    return frame;
+}
+
+Frame MakeDigest(uint32_t address, uint32_t length)
+{
+    Frame frame;
+
+    frame.command = DIGEST;
+    frame.dataLength = static_cast<uint16_t>(length);
+    frame.key = static_cast<uint16_t>((length >> 16U) & 0xFFU);
+    frame.address = address;
+    frame.expectedReplyLength = BL_HEADER + 1U + DIGEST_SIZE;
+    // SHA-256 takes several times longer per byte than the checksum
+    frame.timeoutMs = BASE_TIMEOUT_MS + (length / 8U);
+    return frame;
+}
+
+Frame MakeResetDevice()
+{
+    Frame frame;
+
+    frame.command = RESET_DEVICE;
+    frame.expectedReplyLength = BL_HEADER + 1U;
+    frame.timeoutMs = BASE_TIMEOUT_MS;
+    return frame;
+}
+
+Frame MakeReadTrace(bool clear)
+{
+    Frame frame;
+
+    frame.command = READ_TRACE;
+    frame.dataLength = clear ? 1U : 0U;
+    frame.expectedReplyLength = 0U;
+    frame.timeoutMs = BASE_TIMEOUT_MS;
+    return frame;
+}
+
+Frame MakePollStatus(bool clear)
+{
+    Frame frame;
+
+    frame.command = POLL_STATUS;
+    frame.dataLength = clear ? 1U : 0U;
+    frame.expectedReplyLength = BL_HEADER + 1U + POLL_STATUS_SIZE;
+    frame.timeoutMs = BASE_TIMEOUT_MS;
+    return frame;
+}
+
+Frame MakeReadJournal()
+{
+    Frame frame;
+
+    frame.command = JOURNAL;
+    frame.expectedReplyLength = BL_HEADER + 1U + JOURNAL_STATUS_SIZE;
+    frame.timeoutMs = BASE_TIMEOUT_MS;
+    return frame;
+}
+
+Frame MakeStartJournal(uint32_t imageId, const NvmTiming &timing)
+{
+    Frame frame;
+
+    frame.command = JOURNAL;
+    frame.dataLength = static_cast<uint16_t>(JOURNAL_ID_SIZE);
+    frame.key = UNLOCK_KEY;
+    for (size_t i = 0U; i < JOURNAL_ID_SIZE; i++)
+    {
+        frame.data.push_back(static_cast<uint8_t>(imageId >> (8U * i)));
+    }
+    frame.expectedReplyLength = BL_HEADER + 1U + JOURNAL_STATUS_SIZE;
+    // The ID is cleared, the bitmap set and the ID written
+    frame.busyUs = static_cast<uint64_t>(timing.eepromByteWriteUs) * ((2U * JOURNAL_ID_SIZE) + JOURNAL_BITMAP_SIZE);
+    frame.timeoutMs = BASE_TIMEOUT_MS + UsToMs(frame.busyUs);
+    return frame;
+}
+
+Frame MakeBatch(const std::vector<Frame> &frames)
+{
+    Frame batch;
+
+    batch.command = BATCH;
+    batch.expectedReplyLength = BL_HEADER + BATCH_REPLY_SIZE;
+    batch.timeoutMs = BASE_TIMEOUT_MS;
+    for (const Frame &frame : frames)
+    {
+        std::vector<uint8_t> wire = frame.Encode();
+        // Without the sync byte, which only precedes the BATCH frame itself
+        batch.data.insert(batch.data.end(), wire.begin() + 1, wire.end());
+        batch.busyUs += frame.busyUs;
+        batch.timeoutMs += (frame.timeoutMs > BASE_TIMEOUT_MS) ? (frame.timeoutMs - BASE_TIMEOUT_MS) : 0U;
+    }
+    batch.dataLength = static_cast<uint16_t>(batch.data.size());
+    return batch;
+}
+
+std::vector<Frame> PackBatches(const std::vector<Frame> &frames)
+{
+    std::vector<Frame> packed;
+    std::vector<Frame> group;
+    size_t groupSize = 0U;
+
+    auto flush = [&]() {
+        if (group.size() == 1U)
+        {
+            packed.push_back(group[0]);
+        }
+        else if (!group.empty())
+        {
+            packed.push_back(MakeBatch(group));
+        }
+        group.clear();
+        groupSize = 0U;
+    };
+    for (const Frame &frame : frames)
+    {
+        size_t size = BL_HEADER + frame.data.size();
+        if ((groupSize + size) > BL_FRAME_DATA_SIZE)
+        {
+            flush();
+        }
+        if (size > BL_FRAME_DATA_SIZE)
+        {
+            packed.push_back(frame);
+            continue;
+        }
+        group.push_back(frame);
+        groupSize += size;
+    }
+    flush();
+    return packed;
+}
+
+Frame MakeReplyMode(uint8_t mode)
+{
+    Frame frame;
+
+    frame.command = REPLY_MODE;
+    frame.address = mode;
+    frame.expectedReplyLength = BL_HEADER + REPLY_MODE_SIZE;
+    frame.timeoutMs = BASE_TIMEOUT_MS;
+    return frame;
+}
+
+uint16_t Checksum16(const uint8_t *data, size_t length)
+{
+    uint16_t checkSum = 0U;
+
+    for (size_t i = 0U; (i + 1U) < length; i += 2U)
+    {
+        checkSum = static_cast<uint16_t>(checkSum + data[i] + (static_cast<uint16_t>(data[i + 1U]) << 8U));
+    }
+    if ((length & 1U) != 0U)
+    {
+        // The device reads one byte past an odd length range; hosts keep ranges even
+        checkSum = static_cast<uint16_t>(checkSum + data[length - 1U]);
+    }
+    return checkSum;
+}
+
+std::string CommandName(uint8_t command)
+{
+    switch (command)
+    {
+    case READ_VERSION:
+        return "READ_VERSION";
+    case READ_FLASH:
+        return "READ_FLASH";
+    case WRITE_FLASH:
+        return "WRITE_FLASH";
+    case ERASE_FLASH:
+        return "ERASE_FLASH";
+    case READ_EE_DATA:
+        return "READ_EE_DATA";
+    case WRITE_EE_DATA:
+        return "WRITE_EE_DATA";
+    case READ_CONFIG:
+        return "READ_CONFIG";
+    case WRITE_CONFIG:
+        return "WRITE_CONFIG";
+    case CALC_CHECKSUM:
+        return "CALC_CHECKSUM";
+    case RESET_DEVICE:
+        return "RESET_DEVICE";
+    case READ_TRACE:
+        return "READ_TRACE";
+    case POLL_STATUS:
+        return "POLL_STATUS";
+    case JOURNAL:
+        return "JOURNAL";
+    case BATCH:
+        return "BATCH";
+    case REPLY_MODE:
+        return "REPLY_MODE";
+    case BLANK_CHECK:
+        return "BLANK_CHECK";
+    case PATCH:
+        return "PATCH";
+    case SECURE_WRITE:
+        return "SECURE_WRITE";
+    case DIGEST:
+        return "DIGEST";
+    case BL_TRACE_EVENT_NVM_ERROR:
+        return "NVM_ERROR";
+    case BL_TRACE_EVENT_ENTRY:
+        return "ENTRY";
+    case BL_TRACE_EVENT_INSTALL:
+        return "INSTALL";
+    case BL_TRACE_EVENT_RESTORE:
+        return "RESTORE";
+    default:
+        break;
+    }
+
+    char name[16];
+    std::snprintf(name, sizeof(name), "CMD_0x%02X", command);
+    return name;
+}
+
+std::string StatusName(uint8_t status)
+{
+    switch (status)
+    {
+    case COMMAND_SUCCESS:
+        return "SUCCESS";
+    case COMMAND_OVERLOAD_ERROR:
+        return "OVERLOAD_ERROR";
+    case COMMAND_PROCESSING_ERROR:
+        return "PROCESSING_ERROR";
+    case ERROR_ADDRESS_OUT_OF_RANGE:
+        return "ADDRESS_OUT_OF_RANGE";
+    case ERROR_INVALID_COMMAND:
+        return "INVALID_COMMAND";
+    default:
+        break;
+    }
+
+    char name[8];
+    std::snprintf(name, sizeof(name), "0x%02X", status);
+    return name;
+}
+
+std::string EntryReasonName(uint8_t reason)
+{
+    switch (reason)
+    {
+    case BL_ENTRY_PIN:
+        return "PIN";
+    case BL_ENTRY_INVALID_IMAGE:
+        return "INVALID_IMAGE";
+    case BL_ENTRY_RAM_REQUEST:
+        return "RAM_REQUEST";
+    case BL_ENTRY_EEPROM_REQUEST:
+        return "EEPROM_REQUEST";
+    case BL_ENTRY_BREAK_REQUEST:
+        return "BREAK_REQUEST";
+    case BL_ENTRY_INSTALL_REQUEST:
+        return "INSTALL_REQUEST";
+    default:
+        break;
+    }
+
+    char name[8];
+    std::snprintf(name, sizeof(name), "0x%02X", reason);
+    return name;
+}
+
+std::string SlotResultName(uint8_t result)
+{
+    switch (result)
+    {
+    case BL_SLOT_NONE:
+        return "NONE";
+    case BL_SLOT_INSTALLED:
+        return "INSTALLED";
+    case BL_SLOT_REJECTED:
+        return "REJECTED";
+    case BL_SLOT_FAILED:
+        return "FAILED";
+    case BL_SLOT_RESUMED:
+        return "RESUMED";
+    default:
+        break;
+    }
+
+    char name[8];
+    std::snprintf(name, sizeof(name), "0x%02X", result);
+    return name;
+}
+
+std::string GoldenResultName(uint8_t result)
+{
+    switch (result)
+    {
+    case BL_GOLDEN_RESTORED:
+        return "RESTORED";
+    case BL_GOLDEN_MISSING:
+        return "MISSING";
+    case BL_GOLDEN_FAILED:
+        return "FAILED";
+    default:
+        break;
+    }
+
+    char name[8];
+    std::snprintf(name, sizeof(name), "0x%02X", result);
+    return name;
+}
+
+std::string FeatureNames(uint32_t features)
+{
+    static const struct
+    {
+        uint32_t bit;
+        const char *name;
+    } names[] = {
+        {FEATURE_EE_QUEUE, "ee_queue"},
+        {FEATURE_SKIP_UNCHANGED, "skip_unchanged"},
+        {FEATURE_LOG, "log"},
+        {FEATURE_ENTRY_REQUEST, "entry_request"},
+        {FEATURE_SERVICE, "service"},
+        {FEATURE_SLOT, "slot"},
+        {FEATURE_GOLDEN, "golden"},
+        {FEATURE_MULTIDROP, "multidrop"},
+        {FEATURE_COMPACT_REPLY, "compact_reply"},
+        {FEATURE_SKIP_BLANK, "skip_blank"},
+    };
+    std::string text;
+
+    for (const auto &entry : names)
+    {
+        if ((features & entry.bit) != 0U)
+        {
+            text += text.empty() ? "" : " ";
+            text += entry.name;
+            features &= ~entry.bit;
+        }
+    }
+    if (features != 0U)
+    {
+        char unknown[24];
+        std::snprintf(unknown, sizeof(unknown), "0x%08X", static_cast<unsigned>(features));
+        text += text.empty() ? "" : " ";
+        text += unknown;
+    }
+    return text.empty() ? "none" : text;
+}
+
+}
@@ -0,0 +1,296 @@
+/**
+ *
+ * @file bl_protocol.hpp
+ *
+ * @brief Host side definitions of the 8-bit bootloader frame protocol.
+ *        The command codes and the memory map mirror bl_bootload.h and bl_boot_config.h
+ *        of PIC18F57Q43_BL.X and must be kept in sync with them.
+ */
+
+#ifndef BL_PROTOCOL_HPP
+#define BL_PROTOCOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace blhost
+{
+
+// Device memory map (PIC18F57Q43_BL.X)
+constexpr uint32_t PROGMEM_PAGE_SIZE = 256U;
+constexpr uint32_t PROGMEM_SIZE = 0x20000U;
+// START_OF_APP of the bootloader build; make START_OF_APP=... for another one, such as the Size configuration
+#ifndef BL_START_OF_APP
+#define BL_START_OF_APP 0x3000U
+#endif
+constexpr uint32_t START_OF_APP = BL_START_OF_APP;
+constexpr uint32_t USER_ID_START = 0x200000U;
+constexpr uint32_t CONFIGURATION_BYTES_START = 0x300000U;
+constexpr uint32_t CONFIGURATION_BYTES_SIZE = 10U;
+constexpr uint32_t EEPROM_START_ADDRESS = 0x380000U;
+constexpr uint32_t EEPROM_SIZE = 0x400U;
+constexpr uint16_t UNLOCK_KEY = 0xAA55U;
+
+// Frame layout
+constexpr uint8_t STX = 0x55U;
+constexpr size_t BL_HEADER = 9U;
+constexpr size_t BL_FRAME_DATA_SIZE = PROGMEM_PAGE_SIZE;
+
+// Command codes
+constexpr uint8_t READ_VERSION = 0x00U;
+constexpr uint8_t READ_FLASH = 0x01U;
+constexpr uint8_t WRITE_FLASH = 0x02U;
+constexpr uint8_t ERASE_FLASH = 0x03U;
+constexpr uint8_t READ_EE_DATA = 0x04U;
+constexpr uint8_t WRITE_EE_DATA = 0x05U;
+constexpr uint8_t READ_CONFIG = 0x06U;
+constexpr uint8_t WRITE_CONFIG = 0x07U;
+constexpr uint8_t CALC_CHECKSUM = 0x08U;
+constexpr uint8_t RESET_DEVICE = 0x09U;
+constexpr uint8_t READ_TRACE = 0x0AU;
+constexpr uint8_t POLL_STATUS = 0x0BU;
+constexpr uint8_t JOURNAL = 0x0CU;
+constexpr uint8_t BATCH = 0x0DU;
+constexpr uint8_t REPLY_MODE = 0x0EU;
+constexpr uint8_t BLANK_CHECK = 0x0FU;
+constexpr uint8_t PATCH = 0x10U;
+constexpr uint8_t SECURE_WRITE = 0x11U;
+constexpr uint8_t DIGEST = 0x12U;
+
+// PATCH instructions (bl_bootload.h): [op][LEN] and its operands; LEN 0 stands for 256
+constexpr uint8_t PATCH_COPY = 0x00U;
+constexpr uint8_t PATCH_ADD = 0x01U;
+constexpr uint8_t PATCH_RUN = 0x02U;
+
+// SECURE_WRITE data (bl_bootload.h): [NONCE][CIPHERTEXT of one page][TAG]
+constexpr size_t SECURE_NONCE_SIZE = 8U;
+constexpr size_t SECURE_TAG_SIZE = 8U;
+constexpr size_t SECURE_FRAME_SIZE = SECURE_NONCE_SIZE + PROGMEM_PAGE_SIZE + SECURE_TAG_SIZE;
+
+// DIGEST reply (bl_bootload.h): status and the SHA-256 digest of the range
+constexpr size_t DIGEST_SIZE = 32U;
+
+// BATCH reply (bl_bootload.h): status and index of the first frame that failed, then the last CALC_CHECKSUM result
+constexpr size_t BATCH_REPLY_SIZE = 4U;
+
+// Reply mode bits of REPLY_MODE (bl_bootload.h). A compact reply is [COMPACT_REPLY_FLAG | COMMAND][SEQUENCE] after STX
+// and stands for the header and COMMAND_SUCCESS; SEQUENCE counts the compact replies since the mode was set.
+// REPLY_COUNTS appends the write and erase counts to the replies that have them; without it they are status replies.
+constexpr uint8_t REPLY_FULL = 0x00U;
+constexpr uint8_t REPLY_COMPACT = 0x01U;
+constexpr uint8_t REPLY_COUNTS = 0x02U;
+constexpr uint8_t COMPACT_REPLY_FLAG = 0x40U;
+constexpr size_t COMPACT_REPLY_SIZE = 2U;
+constexpr size_t REPLY_MODE_SIZE = 3U;
+
+// READ_VERSION data, and the capability block after it with ADDR VERSION_CAPABILITIES (bl_bootload.h)
+constexpr size_t VERSION_DATA_SIZE = 16U;
+constexpr uint32_t VERSION_CAPABILITIES = 0x01U;
+constexpr uint8_t CAPABILITY_VERSION = 0x01U;
+constexpr size_t CAPABILITY_SIZE = 32U;
+constexpr uint32_t FEATURE_EE_QUEUE = 0x00000001U;
+constexpr uint32_t FEATURE_SKIP_UNCHANGED = 0x00000002U;
+constexpr uint32_t FEATURE_LOG = 0x00000004U;
+constexpr uint32_t FEATURE_ENTRY_REQUEST = 0x00000008U;
+constexpr uint32_t FEATURE_SERVICE = 0x00000010U;
+constexpr uint32_t FEATURE_SLOT = 0x00000020U;
+constexpr uint32_t FEATURE_GOLDEN = 0x00000040U;
+constexpr uint32_t FEATURE_MULTIDROP = 0x00000080U;
+constexpr uint32_t FEATURE_COMPACT_REPLY = 0x00000100U;
+constexpr uint32_t FEATURE_SKIP_BLANK = 0x00000200U;
+constexpr uint8_t VERIFY_CHECKSUM16 = 0x01U;
+constexpr uint8_t VERIFY_SHA256 = 0x02U;
+constexpr uint8_t TRANSPORT_UART = 0x00U;
+constexpr uint8_t TRANSPORT_SPI = 0x01U;
+
+// Multi-drop addressing in ADDR_E (bl_multidrop.h)
+constexpr uint8_t NODE_LOCAL = 0x00U;
+constexpr uint8_t NODE_BROADCAST = 0xFFU;
+constexpr uint8_t REPLY_FLAG = 0x80U;
+constexpr size_t POLL_STATUS_SIZE = 8U;
+
+// EEPROM write queue (BL_EE_QUEUE_SIZE in bl_boot_config.h)
+constexpr size_t EE_QUEUE_SIZE = 256U;
+
+// Bytes programmed and skipped after the status of WRITE_EE_DATA and WRITE_CONFIG replies (BL_SKIP_UNCHANGED_ENABLE,
+// REPLY_COUNTS)
+constexpr size_t WRITE_COUNTS_SIZE = 4U;
+
+// Pages erased and blank pages left as they were after the status of ERASE_FLASH replies (BL_SKIP_BLANK_ENABLE,
+// REPLY_COUNTS)
+constexpr size_t ERASE_COUNTS_SIZE = 4U;
+
+// Page journal (bl_journal.h): image ID, page count, then one bit per application page, cleared once committed
+constexpr size_t JOURNAL_ID_SIZE = 4U;
+constexpr uint32_t JOURNAL_NO_IMAGE = 0xFFFFFFFFU;
+constexpr uint32_t JOURNAL_PAGES = (PROGMEM_SIZE - START_OF_APP) / PROGMEM_PAGE_SIZE;
+constexpr size_t JOURNAL_BITMAP_SIZE = (JOURNAL_PAGES + 7U) / 8U;
+constexpr size_t JOURNAL_STATUS_SIZE = JOURNAL_ID_SIZE + 2U + JOURNAL_BITMAP_SIZE;
+
+// Status codes in the first reply data byte
+constexpr uint8_t COMMAND_SUCCESS = 0x01U;
+constexpr uint8_t COMMAND_OVERLOAD_ERROR = 0xFCU;
+constexpr uint8_t COMMAND_PROCESSING_ERROR = 0xFDU;
+constexpr uint8_t ERROR_ADDRESS_OUT_OF_RANGE = 0xFEU;
+constexpr uint8_t ERROR_INVALID_COMMAND = 0xFFU;
+
+// Trace records (bl_trace.h)
+constexpr uint8_t BL_TRACE_EVENT_NVM_ERROR = 0xE0U;
+constexpr uint8_t BL_TRACE_EVENT_ENTRY = 0xE1U;
+constexpr uint8_t BL_TRACE_EVENT_INSTALL = 0xE2U;
+constexpr uint8_t BL_TRACE_EVENT_RESTORE = 0xE3U;
+
+// Entry reasons in the status of an ENTRY trace record (bl_entry_request.h)
+constexpr uint8_t BL_ENTRY_PIN = 0x01U;
+constexpr uint8_t BL_ENTRY_INVALID_IMAGE = 0x02U;
+constexpr uint8_t BL_ENTRY_RAM_REQUEST = 0x03U;
+constexpr uint8_t BL_ENTRY_EEPROM_REQUEST = 0x04U;
+constexpr uint8_t BL_ENTRY_BREAK_REQUEST = 0x05U;
+constexpr uint8_t BL_ENTRY_INSTALL_REQUEST = 0x06U;
+
+// Results in the status of an INSTALL trace record (bl_slot.h)
+constexpr uint8_t BL_SLOT_NONE = 0x00U;
+constexpr uint8_t BL_SLOT_INSTALLED = 0x01U;
+constexpr uint8_t BL_SLOT_REJECTED = 0x02U;
+constexpr uint8_t BL_SLOT_FAILED = 0x03U;
+constexpr uint8_t BL_SLOT_RESUMED = 0x04U;
+
+// Results in the status of a RESTORE trace record (bl_golden.h)
+constexpr uint8_t BL_GOLDEN_RESTORED = 0x01U;
+constexpr uint8_t BL_GOLDEN_MISSING = 0x02U;
+constexpr uint8_t BL_GOLDEN_FAILED = 0x03U;
+
+/**
+ * @brief One request frame: [<COMMAND><DATALEN><KEY_L><KEY_H><ADDR_L><ADDR_H><ADDR_U><ADDR_E><...DATA...>]
+ *        ADDR_E carries the node address on a multi-drop bus; DeviceLink fills it in.
+ */
+struct Frame
+{
+    uint8_t command = READ_VERSION;
+    uint16_t dataLength = 0U;
+    uint16_t key = 0U;
+    uint32_t address = 0U;
+    std::vector<uint8_t> data;
+
+    /** Number of reply bytes after STX when the command succeeds, 0 if it is not known up front. */
+    size_t expectedReplyLength = 0U;
+    /** Upper bound on the time the device needs to execute the command. */
+    unsigned timeoutMs = 1000U;
+    /** Worst-case NVM time the device spends on the command, for pacing frames that get no reply. */
+    uint64_t busyUs = 0U;
+
+    /** Serialises the frame including the leading autobaud sync byte. */
+    std::vector<uint8_t> Encode() const;
+};
+
+/**
+ * @brief A reply as received from the device, STX stripped.
+ */
+struct Reply
+{
+    std::vector<uint8_t> bytes;
+
+    bool Valid() const { return bytes.size() > BL_HEADER; }
+    uint8_t Command() const { return bytes[0]; }
+    /** ADDR_L to ADDR_U; a failed WRITE_EE_DATA or BATCH puts the address of the byte or frame that failed here. */
+    uint32_t Address() const { return static_cast<uint32_t>(bytes[5] | (bytes[6] << 8U) | (bytes[7] << 16U)); }
+    uint8_t Status() const { return bytes[BL_HEADER]; }
+    const uint8_t *Data() const { return &bytes[BL_HEADER]; }
+    size_t DataLength() const { return bytes.size() - BL_HEADER; }
+};
+
+/**
+ * @brief Datasheet based worst-case NVM timings used for reply timeouts.
+ */
+struct NvmTiming
+{
+    unsigned pageEraseUs = 11000U;
+    unsigned pageWriteUs = 11000U;
+    unsigned eepromByteWriteUs = 11000U;
+};
+
+/**
+ * @brief What a bootloader build supports, from the capability block of READ_VERSION.
+ *        present is false for bootloaders without the block; the other fields are then left at their defaults.
+ */
+struct Capabilities
+{
+    bool present = false;
+    uint8_t version = 0U;
+    /** Bit n set if command code n is built in. */
+    uint32_t commands = 0U;
+    uint32_t features = 0U;
+    uint16_t maxFrameData = 0U;
+    uint8_t verifyScheme = 0U;
+    uint8_t frameWindow = 1U;
+    uint16_t rxDepth = 0U;
+    uint16_t eeQueueSize = 0U;
+    uint8_t transport = TRANSPORT_UART;
+    /** Bit rate range the device locks on to; 0 when the host drives the clock. */
+    uint32_t baudMin = 0U;
+    uint32_t baudMax = 0U;
+    uint32_t startOfApp = 0U;
+
+    bool HasCommand(uint8_t command) const { return (command < 32U) && (((commands >> command) & 1U) != 0U); }
+    bool HasFeature(uint32_t feature) const { return (features & feature) == feature; }
+};
+
+Frame MakeReadVersion();
+/** READ_VERSION with ADDR VERSION_CAPABILITIES; older bootloaders ignore ADDR and send the 16 version bytes only. */
+Frame MakeReadCapabilities();
+/** Decodes the capability block of a READ_VERSION reply; fields of a newer block version past version 1 are skipped. */
+Capabilities ParseCapabilities(const Reply &reply);
+Frame MakeReadFlash(uint32_t address, uint16_t length);
+Frame MakeWriteFlash(uint32_t address, const uint8_t *data, uint16_t length, const NvmTiming &timing);
+/** ERASE_FLASH; the reply is read up to the erase counts, and ends after the status on bootloaders without them. */
+Frame MakeEraseFlash(uint32_t address, uint16_t pages, const NvmTiming &timing);
+/** BLANK_CHECK of pages from address; the reply holds the number of blank pages and a bitmap, bit set when blank. */
+Frame MakeBlankCheck(uint32_t address, uint16_t pages);
+
+/** PATCH of the page at address with a stream of PATCH_COPY, PATCH_ADD and PATCH_RUN instructions. */
+Frame MakePatch(uint32_t address, const std::vector<uint8_t> &stream, const NvmTiming &timing);
+/** SECURE_WRITE of the page at address; sealed is the SECURE_FRAME_SIZE bytes of SealPage (secure.hpp). */
+Frame MakeSecureWrite(uint32_t address, const std::vector<uint8_t> &sealed, const NvmTiming &timing);
+Frame MakeReadEeprom(uint32_t address, uint16_t length);
+Frame MakeWriteEeprom(uint32_t address, const uint8_t *data, uint16_t length, const NvmTiming &timing);
+/** Zero-length WRITE_EE_DATA: replies once every queued EEPROM byte is programmed, with their result. */
+Frame MakeEepromBarrier(const NvmTiming &timing);
+Frame MakeWriteConfig(uint32_t address, const uint8_t *data, uint16_t length, const NvmTiming &timing);
+Frame MakeCalcChecksum(uint32_t address, uint32_t length);
+/** DIGEST of length bytes from address; bits 16..23 of the length travel in KEY_L as for CALC_CHECKSUM. */
+Frame MakeDigest(uint32_t address, uint32_t length);
+Frame MakeResetDevice();
+Frame MakeReadTrace(bool clear);
+Frame MakePollStatus(bool clear);
+/** JOURNAL without data; bootloaders without BL_JOURNAL_ENABLE reply INVALID_COMMAND. */
+Frame MakeReadJournal();
+/** JOURNAL with the image ID; only sent once MakeReadJournal showed that the device keeps a journal. */
+Frame MakeStartJournal(uint32_t imageId, const NvmTiming &timing);
+
+/**
+ * BATCH running the given frames in order; the device stops at the first one that fails.
+ * Only WRITE_FLASH, ERASE_FLASH, WRITE_EE_DATA, WRITE_CONFIG, CALC_CHECKSUM and RESET_DEVICE may be batched,
+ * and their headers and data together must fit BL_FRAME_DATA_SIZE.
+ */
+Frame MakeBatch(const std::vector<Frame> &frames);
+/** Groups consecutive frames into BATCH frames as far as they fit; frames that fit nothing else are kept as they are. */
+std::vector<Frame> PackBatches(const std::vector<Frame> &frames);
+/** REPLY_MODE; its own reply is always full. Only sent to devices that list the command in their capability block. */
+Frame MakeReplyMode(uint8_t mode);
+
+/** Additive 16-bit checksum over little-endian words, as computed by CALC_CHECKSUM. */
+uint16_t Checksum16(const uint8_t *data, size_t length);
+
+std::string CommandName(uint8_t command);
+std::string StatusName(uint8_t status);
+std::string EntryReasonName(uint8_t reason);
+std::string SlotResultName(uint8_t result);
+std::string GoldenResultName(uint8_t result);
+/** Names of the FEATURE_xxx bits, space separated. */
+std::string FeatureNames(uint32_t features);
+
+}
+
+#endif // BL_PROTOCOL_HPP
@@ -0,0 +1,220 @@
+/**
+ *
+ * @file bus.cpp
+ *
+ * @brief Programs every node of a multi-drop (RS-485) bus with one broadcast transfer,
+ *        then collects a per-node acknowledgement with POLL_STATUS and repairs the nodes that missed frames.
+ */
+
+#include "bus.hpp"
+
+#include <chrono>
+#include <cstdio>
+
+namespace blhost
+{
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+double Seconds(Clock::time_point start, Clock::time_point end)
+{
+    return std::chrono::duration<double>(end - start).count();
+}
+
+}
+
+void BusReport::Print(const std::string &label) const
+{
+    unsigned ok = 0U;
+    unsigned present = 0U;
+
+    std::printf("%s\n", label.c_str());
+    std::printf("  %-6s %-9s %10s %-22s %8s  %s\n", "node", "result", "bc frames", "bc status", "checksum", "detail");
+    for (const NodeResult &node : nodes)
+    {
+        const char *result = !node.present ? "ABSENT" : (!node.ok ? "FAIL" : (node.repaired ? "repaired" : "ok"));
+        std::printf("  %-6u %-9s %5u/%-4u %-22s   0x%04X  %s\n", node.node, result, node.broadcastFrames, broadcastFrames,
+                    StatusName(node.broadcastStatus).c_str(), node.checksum, node.error.c_str());
+        if (node.ok)
+        {
+            ok++;
+        }
+        if (node.present)
+        {
+            present++;
+        }
+    }
+
+    // Programming the nodes one at a time would repeat the broadcast phase once per node
+    std::printf("  broadcast %.3f s (%u frames, %llu bytes) for %u node(s); one at a time would take about %.3f s\n",
+                broadcastSeconds, broadcastFrames, static_cast<unsigned long long>(broadcastWireBytes), present,
+                broadcastSeconds * static_cast<double>(present));
+    std::printf("  repair %.3f s, total %.3f s, %llu frames, %llu bytes tx, %llu bytes rx, %llu retries\n", repairSeconds,
+                totalSeconds, static_cast<unsigned long long>(link.frames), static_cast<unsigned long long>(link.bytesTx),
+                static_cast<unsigned long long>(link.bytesRx), static_cast<unsigned long long>(link.retries));
+    std::printf("  %u/%zu nodes programmed\n", ok, nodes.size());
+}
+
+BusReport BusProgrammer::Program(const PackedImage &packed, const std::vector<uint8_t> &nodes)
+{
+    BusReport report;
+    auto start = Clock::now();
+
+    // Find the nodes and start a fresh broadcast record on each
+    for (uint8_t node : nodes)
+    {
+        NodeResult result;
+        result.node = node;
+        result.present = Poll(result, true);
+        report.nodes.push_back(result);
+    }
+
+    auto broadcastStart = Clock::now();
+    if (options.program.erase)
+    {
+        uint16_t pages = static_cast<uint16_t>((PROGMEM_SIZE - START_OF_APP) / PROGMEM_PAGE_SIZE);
+        Broadcast(PreparedFrame(MakeEraseFlash(START_OF_APP, pages, options.program.timing)), report);
+    }
+    for (const PreparedFrame &prepared : packed.flashFrames)
+    {
+        Broadcast(prepared, report);
+    }
+    for (const PreparedFrame &prepared : packed.eepromFrames)
+    {
+        Broadcast(prepared, report);
+    }
+    report.broadcastSeconds = Seconds(broadcastStart, Clock::now());
+
+    auto repairStart = Clock::now();
+    for (NodeResult &result : report.nodes)
+    {
+        if (!result.present)
+        {
+            continue;
+        }
+        if (!Poll(result, true))
+        {
+            continue;
+        }
+
+        bool complete = (result.broadcastFrames == static_cast<uint16_t>(report.broadcastFrames))
+                        && (result.broadcastStatus == COMMAND_SUCCESS);
+        if (!complete)
+        {
+            if (!options.repair)
+            {
+                result.error = "missed or failed broadcast frames";
+                continue;
+            }
+            Repair(packed, result);
+        }
+    }
+    report.repairSeconds = Seconds(repairStart, Clock::now());
+
+    for (NodeResult &result : report.nodes)
+    {
+        if (result.present && result.error.empty())
+        {
+            Finish(packed, result);
+        }
+    }
+
+    link.SetNode(NODE_LOCAL);
+    report.link = link.Stats();
+    report.totalSeconds = Seconds(start, Clock::now());
+    return report;
+}
+
+bool BusProgrammer::Poll(NodeResult &result, bool clear)
+{
+    link.SetNode(result.node);
+    try
+    {
+        Reply reply = link.Transact(MakePollStatus(clear));
+        if ((reply.DataLength() < (1U + POLL_STATUS_SIZE)) || (reply.Status() != COMMAND_SUCCESS))
+        {
+            result.error = "POLL_STATUS not supported (BL_MULTIDROP_ENABLE)";
+            return false;
+        }
+        const uint8_t *data = reply.Data();
+        result.broadcastStatus = data[2];
+        result.broadcastFrames = static_cast<uint16_t>(data[3] | (data[4] << 8U));
+    }
+    catch (const LinkError &error)
+    {
+        result.error = error.what();
+        return false;
+    }
+    return true;
+}
+
+void BusProgrammer::Broadcast(const PreparedFrame &prepared, BusReport &report)
+{
+    link.Broadcast(prepared, options.guardUs);
+    report.broadcastFrames++;
+    report.broadcastWireBytes += prepared.wire.size();
+}
+
+void BusProgrammer::Repair(const PackedImage &packed, NodeResult &result)
+{
+    ProgramOptions repair = options.program;
+
+    // Verification and reset are done for all nodes alike in Finish
+    repair.verify = false;
+    repair.reset = false;
+    link.SetNode(result.node);
+    try
+    {
+        Programmer(link, repair).Program(packed);
+        result.repaired = true;
+    }
+    catch (const std::exception &error)
+    {
+        result.error = std::string("repair: ") + error.what();
+    }
+}
+
+void BusProgrammer::Finish(const PackedImage &packed, NodeResult &result)
+{
+    link.SetNode(result.node);
+    try
+    {
+        // Configuration bytes are never broadcast; a repaired node already has them
+        if (!result.repaired)
+        {
+            for (const PreparedFrame &prepared : packed.configFrames)
+            {
+                CheckStatus(link.Transact(prepared), "config");
+            }
+        }
+        if (options.program.verify)
+        {
+            Reply reply = link.Transact(MakeCalcChecksum(START_OF_APP, PROGMEM_SIZE - START_OF_APP));
+            if (reply.DataLength() < 2U)
+            {
+                throw ProgramError("verify: " + StatusName(reply.Status()));
+            }
+            result.checksum = static_cast<uint16_t>(reply.Data()[0] | (reply.Data()[1] << 8U));
+            if (result.checksum != packed.expectedChecksum)
+            {
+                char message[64];
+                std::snprintf(message, sizeof(message), "verify: expected checksum 0x%04X", packed.expectedChecksum);
+                throw ProgramError(message);
+            }
+        }
+        if (options.program.reset)
+        {
+            CheckStatus(link.Transact(MakeResetDevice()), "reset");
+        }
+        result.ok = true;
+    }
+    catch (const std::exception &error)
+    {
+        result.error = error.what();
+    }
+}
+
+}
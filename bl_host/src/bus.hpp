@@ -0,0 +1,77 @@
+/**
+ *
+ * @file bus.hpp
+ *
+ * @brief Programs every node of a multi-drop (RS-485) bus with one broadcast transfer,
+ *        then collects a per-node acknowledgement with POLL_STATUS and repairs the nodes that missed frames.
+ */
+
+#ifndef BUS_HPP
+#define BUS_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "device_link.hpp"
+#include "programmer.hpp"
+
+namespace blhost
+{
+
+struct BusOptions
+{
+    ProgramOptions program;
+    /** Extra wait after each broadcast frame, on top of its wire and NVM busy time. */
+    unsigned guardUs = 2000U;
+    /** Reprogram nodes that missed or failed a broadcast frame with addressed frames. */
+    bool repair = true;
+};
+
+struct NodeResult
+{
+    uint8_t node = NODE_LOCAL;
+    bool present = false;
+    bool ok = false;
+    bool repaired = false;
+    /** Broadcast frames the node reported, and the first error among them. */
+    uint16_t broadcastFrames = 0U;
+    uint8_t broadcastStatus = COMMAND_SUCCESS;
+    uint16_t checksum = 0U;
+    std::string error;
+};
+
+struct BusReport
+{
+    std::vector<NodeResult> nodes;
+    uint32_t broadcastFrames = 0U;
+    uint64_t broadcastWireBytes = 0U;
+    double broadcastSeconds = 0.0;
+    double repairSeconds = 0.0;
+    double totalSeconds = 0.0;
+    LinkStats link;
+
+    void Print(const std::string &label) const;
+};
+
+class BusProgrammer
+{
+public:
+    BusProgrammer(DeviceLink &link, const BusOptions &options) : link(link), options(options) {}
+
+    /** Programs the packed image into the given node addresses. */
+    BusReport Program(const PackedImage &packed, const std::vector<uint8_t> &nodes);
+
+private:
+    bool Poll(NodeResult &result, bool clear);
+    void Broadcast(const PreparedFrame &prepared, BusReport &report);
+    void Repair(const PackedImage &packed, NodeResult &result);
+    void Finish(const PackedImage &packed, NodeResult &result);
+
+    DeviceLink &link;
+    BusOptions options;
+};
+
+}
+
+#endif // BUS_HPP
@@ -0,0 +1,295 @@
+/**
+ *
+ * @file delta.cpp
+ *
+ * @brief Delta of two application images as PATCH instruction streams, one per changed page, and the model of
+ *        BL_Patch that applies them.
+ */
+
+#include "delta.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace blhost
+{
+
+namespace
+{
+
+constexpr size_t PAGE = PROGMEM_PAGE_SIZE;
+/** Longest COPY, ADD or RUN: LEN 0 stands for 256. */
+constexpr size_t INSTRUCTION_MAX = 256U;
+/** Shortest COPY and RUN worth breaking a literal run for: they cost 5 and 3 bytes. */
+constexpr size_t COPY_MIN = 6U;
+constexpr size_t RUN_MIN = 4U;
+/** Candidates tried per position, newest first. */
+constexpr unsigned CHAIN_LIMIT = 32U;
+
+uint32_t Key(const uint8_t *data)
+{
+    return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8U) | (static_cast<uint32_t>(data[2]) << 16U)
+           | (static_cast<uint32_t>(data[3]) << 24U);
+}
+
+/**
+ * @brief Positions of the 4-byte sequences of the modelled flash. Positions whose bytes were rewritten stay in the
+ *        index; matches are measured on the flash itself, so such an entry only yields a short match.
+ */
+class MatchIndex
+{
+public:
+    explicit MatchIndex(const std::vector<uint8_t> &flash) : flash(flash) {}
+
+    /** Indexes the sequences that start in [start, end). */
+    void Add(size_t start, size_t end)
+    {
+        end = std::min(end, (flash.size() >= 4U) ? (flash.size() - 3U) : 0U);
+        for (size_t position = start; position < end; position++)
+        {
+            const uint8_t *data = flash.data() + position;
+            // Runs of one byte are left to RUN
+            if ((data[0] != data[1]) || (data[1] != data[2]) || (data[2] != data[3]))
+            {
+                positions[Key(data)].push_back(static_cast<uint32_t>(position));
+            }
+        }
+    }
+
+    const std::vector<uint32_t> *Find(const uint8_t *data) const
+    {
+        auto it = positions.find(Key(data));
+        return (it == positions.end()) ? nullptr : &it->second;
+    }
+
+private:
+    const std::vector<uint8_t> &flash;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> positions;
+};
+
+size_t MatchLength(const std::vector<uint8_t> &flash, size_t source, const uint8_t *target, size_t limit)
+{
+    size_t length = 0U;
+
+    limit = std::min(limit, flash.size() - source);
+    while ((length < limit) && (flash[source + length] == target[length]))
+    {
+        length++;
+    }
+    return length;
+}
+
+void PutInstruction(std::vector<uint8_t> &stream, uint8_t instruction, size_t length)
+{
+    stream.push_back(instruction);
+    stream.push_back(static_cast<uint8_t>(length));
+}
+
+void FlushLiterals(std::vector<uint8_t> &stream, std::vector<uint8_t> &literals, Delta &delta)
+{
+    if (!literals.empty())
+    {
+        PutInstruction(stream, PATCH_ADD, literals.size());
+        stream.insert(stream.end(), literals.begin(), literals.end());
+        delta.addBytes += literals.size();
+        literals.clear();
+    }
+}
+
+/** PATCH stream that turns the page at offset of the flash into target. */
+std::vector<uint8_t> PatchStream(const std::vector<uint8_t> &flash, const MatchIndex &index, size_t offset, const uint8_t *target,
+                                 Delta &delta)
+{
+    std::vector<uint8_t> stream;
+    std::vector<uint8_t> literals;
+    size_t nextSource = offset;
+    size_t i = 0U;
+
+    while (i < PAGE)
+    {
+        size_t limit = std::min(PAGE - i, INSTRUCTION_MAX);
+        size_t run = 1U;
+        while ((run < limit) && (target[i + run] == target[i]))
+        {
+            run++;
+        }
+
+        // The same place in the old page and the continuation of the last copy first, then the index
+        size_t bestLength = 0U;
+        size_t bestSource = 0U;
+        for (size_t source : {offset + i, nextSource})
+        {
+            if (source < flash.size())
+            {
+                size_t length = MatchLength(flash, source, target + i, limit);
+                if (length > bestLength)
+                {
+                    bestLength = length;
+                    bestSource = source;
+                }
+            }
+        }
+        const std::vector<uint32_t> *chain = ((limit >= 4U) && (bestLength < limit)) ? index.Find(target + i) : nullptr;
+        if (chain != nullptr)
+        {
+            unsigned tried = 0U;
+            for (auto it = chain->rbegin(); (it != chain->rend()) && (tried < CHAIN_LIMIT) && (bestLength < limit); ++it, tried++)
+            {
+                size_t length = MatchLength(flash, *it, target + i, limit);
+                if (length > bestLength)
+                {
+                    bestLength = length;
+                    bestSource = *it;
+                }
+            }
+        }
+
+        if ((run >= RUN_MIN) && (run >= bestLength))
+        {
+            FlushLiterals(stream, literals, delta);
+            PutInstruction(stream, PATCH_RUN, run);
+            stream.push_back(target[i]);
+            delta.runBytes += run;
+            i += run;
+        }
+        else if (bestLength >= COPY_MIN)
+        {
+            uint32_t address = START_OF_APP + static_cast<uint32_t>(bestSource);
+            FlushLiterals(stream, literals, delta);
+            PutInstruction(stream, PATCH_COPY, bestLength);
+            stream.push_back(static_cast<uint8_t>(address));
+            stream.push_back(static_cast<uint8_t>(address >> 8U));
+            stream.push_back(static_cast<uint8_t>(address >> 16U));
+            delta.copyBytes += bestLength;
+            nextSource = bestSource + bestLength;
+            i += bestLength;
+        }
+        else
+        {
+            literals.push_back(target[i]);
+            if (literals.size() == INSTRUCTION_MAX)
+            {
+                FlushLiterals(stream, literals, delta);
+            }
+            nextSource++;
+            i++;
+        }
+    }
+    FlushLiterals(stream, literals, delta);
+    return stream;
+}
+
+}
+
+Delta MakeDelta(const std::vector<uint8_t> &oldFlat, const std::vector<uint8_t> &newFlat)
+{
+    Delta delta;
+    // The flash as the device holds it when the next page is patched
+    std::vector<uint8_t> flash = oldFlat;
+    MatchIndex index(flash);
+
+    index.Add(0U, flash.size());
+    for (size_t offset = 0U; (offset + PAGE) <= newFlat.size(); offset += PAGE)
+    {
+        const uint8_t *target = newFlat.data() + offset;
+        if (std::equal(target, target + PAGE, flash.begin() + static_cast<std::ptrdiff_t>(offset)))
+        {
+            delta.pagesUnchanged++;
+            continue;
+        }
+
+        Delta counts;
+        PagePatch page;
+        page.address = START_OF_APP + static_cast<uint32_t>(offset);
+        page.data = PatchStream(flash, index, offset, target, counts);
+        // A stream as long as the page saves nothing over WRITE_FLASH, and would not fit one frame beyond it
+        if (page.data.size() >= PAGE)
+        {
+            page.write = true;
+            page.data.assign(target, target + PAGE);
+            delta.pagesWritten++;
+        }
+        else
+        {
+            delta.pagesPatched++;
+            delta.copyBytes += counts.copyBytes;
+            delta.addBytes += counts.addBytes;
+            delta.runBytes += counts.runBytes;
+        }
+        delta.dataBytes += page.data.size();
+        delta.pages.push_back(std::move(page));
+
+        std::copy(target, target + PAGE, flash.begin() + static_cast<std::ptrdiff_t>(offset));
+        // The sequences that now start in or run into the page
+        index.Add((offset >= 3U) ? (offset - 3U) : 0U, offset + PAGE);
+    }
+    return delta;
+}
+
+bool ApplyDelta(std::vector<uint8_t> &flat, const Delta &delta)
+{
+    for (const PagePatch &page : delta.pages)
+    {
+        size_t offset = page.address - START_OF_APP;
+        std::vector<uint8_t> buffer;
+
+        if ((page.address < START_OF_APP) || ((offset + PAGE) > flat.size()))
+        {
+            return false;
+        }
+        if (page.write)
+        {
+            buffer = page.data;
+        }
+        else
+        {
+            const std::vector<uint8_t> &stream = page.data;
+            size_t in = 0U;
+            while ((in + 2U) <= stream.size())
+            {
+                uint8_t instruction = stream[in];
+                size_t length = (stream[in + 1U] == 0U) ? 256U : stream[in + 1U];
+                in += 2U;
+                if (length > (PAGE - buffer.size()))
+                {
+                    return false;
+                }
+                if ((instruction == PATCH_COPY) && ((in + 3U) <= stream.size()))
+                {
+                    uint32_t source = stream[in] | (static_cast<uint32_t>(stream[in + 1U]) << 8U)
+                                      | (static_cast<uint32_t>(stream[in + 2U]) << 16U);
+                    in += 3U;
+                    if ((source < START_OF_APP) || (source > (PROGMEM_SIZE - length)))
+                    {
+                        return false;
+                    }
+                    auto from = flat.begin() + static_cast<std::ptrdiff_t>(source - START_OF_APP);
+                    buffer.insert(buffer.end(), from, from + static_cast<std::ptrdiff_t>(length));
+                }
+                else if ((instruction == PATCH_ADD) && ((in + length) <= stream.size()))
+                {
+                    buffer.insert(buffer.end(), stream.begin() + static_cast<std::ptrdiff_t>(in),
+                                  stream.begin() + static_cast<std::ptrdiff_t>(in + length));
+                    in += length;
+                }
+                else if ((instruction == PATCH_RUN) && ((in + 1U) <= stream.size()))
+                {
+                    buffer.insert(buffer.end(), length, stream[in]);
+                    in++;
+                }
+                else
+                {
+                    return false;
+                }
+            }
+            if ((in != stream.size()) || (buffer.size() != PAGE))
+            {
+                return false;
+            }
+        }
+        std::copy(buffer.begin(), buffer.end(), flat.begin() + static_cast<std::ptrdiff_t>(offset));
+    }
+    return true;
+}
+
+}
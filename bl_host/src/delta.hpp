@@ -0,0 +1,62 @@
+/**
+ *
+ * @file delta.hpp
+ *
+ * @brief Delta of two application images as PATCH instruction streams, one per changed page, and the model of
+ *        BL_Patch that applies them.
+ */
+
+#ifndef DELTA_HPP
+#define DELTA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "bl_protocol.hpp"
+
+namespace blhost
+{
+
+/**
+ * @brief One changed page: a PATCH stream, or the full page for WRITE_FLASH when the stream would not be shorter.
+ */
+struct PagePatch
+{
+    uint32_t address = 0U;
+    bool write = false;
+    /** PATCH stream, or the page content when write is set. */
+    std::vector<uint8_t> data;
+};
+
+struct Delta
+{
+    /** Changed pages in ascending address order, the order they have to be sent in. */
+    std::vector<PagePatch> pages;
+    uint32_t pagesUnchanged = 0U;
+    uint32_t pagesPatched = 0U;
+    uint32_t pagesWritten = 0U;
+    /** Bytes of the streams and of the full pages. */
+    uint64_t dataBytes = 0U;
+    /** Page bytes produced by the COPY, ADD and RUN instructions of all streams. */
+    uint64_t copyBytes = 0U;
+    uint64_t addBytes = 0U;
+    uint64_t runBytes = 0U;
+};
+
+/**
+ * Delta from the application area of the old image to that of the new one; both are flattened from START_OF_APP
+ * to PROGMEM_SIZE. COPY instructions only read pages that hold their final content by the time the page is patched:
+ * the ones below it, patched before, and the ones from it up, which still hold the old image.
+ */
+Delta MakeDelta(const std::vector<uint8_t> &oldFlat, const std::vector<uint8_t> &newFlat);
+
+/**
+ * Applies the delta to a flattened application area the way the bootloader does, page by page;
+ * returns false on a stream BL_Patch would reject.
+ */
+bool ApplyDelta(std::vector<uint8_t> &flat, const Delta &delta);
+
+}
+
+#endif // DELTA_HPP
@@ -0,0 +1,143 @@
+/**
+ *
+ * @file delta_main.cpp
+ *
+ * @brief bl_delta: compares a full update with a PATCH delta update (BL_CMD_PATCH_ENABLE) for two application images.
+ *
+ *        bl_delta OLD.hex NEW.hex [-b BAUD]
+ *
+ *        The delta from the application area of OLD.hex to that of NEW.hex is built as bl_host program --patch-from
+ *        builds it, applied to a model of the flash and compared with NEW.hex. Both updates are then estimated from
+ *        the bytes they put on the wire at BAUD (10 bits per byte, replies included) and the worst-case NVM timings:
+ *        the full update erases the pages OLD.hex used and writes those of NEW.hex, the delta update erases and
+ *        writes the changed pages. Link latency, EEPROM and the final verify are the same for both and left out.
+ */
+
+#include "delta.hpp"
+#include "device_link.hpp"
+#include "hex_file.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+struct Estimate
+{
+    uint64_t frames = 0U;
+    uint64_t wireBytes = 0U;
+    uint64_t erases = 0U;
+    uint64_t writes = 0U;
+
+    void Add(const blhost::Frame &frame)
+    {
+        frames++;
+        // The frame, STX and the reply
+        wireBytes += blhost::PreparedFrame(frame).wire.size() + 1U + frame.expectedReplyLength;
+    }
+
+    void Print(const char *label, unsigned baudRate) const
+    {
+        blhost::NvmTiming timing;
+        double wireSeconds = static_cast<double>(wireBytes) * 10.0 / baudRate;
+        double nvmSeconds = (static_cast<double>(erases) * timing.pageEraseUs + static_cast<double>(writes) * timing.pageWriteUs) / 1e6;
+
+        std::printf("%-6s %6llu frames %9llu bytes %5llu erases %5llu writes   %7.3f s wire + %7.3f s NVM = %7.3f s\n", label,
+                    static_cast<unsigned long long>(frames), static_cast<unsigned long long>(wireBytes),
+                    static_cast<unsigned long long>(erases), static_cast<unsigned long long>(writes), wireSeconds, nvmSeconds,
+                    wireSeconds + nvmSeconds);
+    }
+};
+
+void Usage()
+{
+    std::fprintf(stderr, "usage: bl_delta OLD.hex NEW.hex [-b BAUD]\n");
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<std::string> paths;
+    unsigned baudRate = 115200U;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if ((arg == "-b") && ((i + 1) < argc))
+        {
+            baudRate = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 0));
+        }
+        else if ((arg[0] != '-') && (paths.size() < 2U))
+        {
+            paths.push_back(arg);
+        }
+        else
+        {
+            Usage();
+            return 2;
+        }
+    }
+    if ((paths.size() != 2U) || (baudRate == 0U))
+    {
+        Usage();
+        return 2;
+    }
+
+    try
+    {
+        blhost::MemoryImage oldImage = blhost::MemoryImage::FromHexFile(paths[0]);
+        blhost::MemoryImage newImage = blhost::MemoryImage::FromHexFile(paths[1]);
+        std::vector<uint8_t> oldFlat = oldImage.Flatten(blhost::START_OF_APP, blhost::PROGMEM_SIZE);
+        std::vector<uint8_t> newFlat = newImage.Flatten(blhost::START_OF_APP, blhost::PROGMEM_SIZE);
+        blhost::NvmTiming timing;
+        Estimate full;
+        Estimate patch;
+
+        for (uint32_t page : oldImage.PagesIn(blhost::START_OF_APP, blhost::PROGMEM_SIZE))
+        {
+            // Blank pages are not erased (BL_SKIP_BLANK_ENABLE)
+            full.erases += oldImage.PageAt(page).IsBlank() ? 0U : 1U;
+        }
+        for (uint32_t page : newImage.PagesIn(blhost::START_OF_APP, blhost::PROGMEM_SIZE))
+        {
+            // Written into pages erased before (BL_ERASED_MAP_ENABLE)
+            if (!newImage.PageAt(page).IsBlank())
+            {
+                full.Add(blhost::MakeWriteFlash(page, newImage.PageAt(page).data.data(),
+                                                static_cast<uint16_t>(blhost::PROGMEM_PAGE_SIZE), timing));
+                full.writes++;
+            }
+        }
+
+        blhost::Delta delta = blhost::MakeDelta(oldFlat, newFlat);
+        for (const blhost::PagePatch &page : delta.pages)
+        {
+            patch.Add(page.write ? blhost::MakeWriteFlash(page.address, page.data.data(), static_cast<uint16_t>(page.data.size()), timing)
+                                 : blhost::MakePatch(page.address, page.data, timing));
+            patch.erases++;
+            patch.writes++;
+        }
+        std::vector<uint8_t> applied = oldFlat;
+        bool match = blhost::ApplyDelta(applied, delta) && (applied == newFlat);
+
+        std::printf("delta %s -> %s: %u page(s) patched, %u written in full, %u unchanged\n", paths[0].c_str(), paths[1].c_str(),
+                    delta.pagesPatched, delta.pagesWritten, delta.pagesUnchanged);
+        std::printf("  %llu bytes of page data; patched pages from %llu copied, %llu literal and %llu run bytes\n",
+                    static_cast<unsigned long long>(delta.dataBytes), static_cast<unsigned long long>(delta.copyBytes),
+                    static_cast<unsigned long long>(delta.addBytes), static_cast<unsigned long long>(delta.runBytes));
+        std::printf("estimate at %u baud, page erase/write %u/%u us:\n", baudRate, timing.pageEraseUs, timing.pageWriteUs);
+        full.Print("full", baudRate);
+        patch.Print("delta", baudRate);
+        std::printf("applied delta %s\n", match ? "matches NEW" : "does NOT match NEW");
+        return match ? 0 : 1;
+    }
+    catch (const std::exception &error)
+    {
+        std::fprintf(stderr, "bl_delta: %s\n", error.what());
+        return 1;
+    }
+}
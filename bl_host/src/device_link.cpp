@@ -0,0 +1,179 @@
+/**
+ *
+ * @file device_link.cpp
+ *
+ * @brief Request/reply transport for bootloader frames over a serial or SPI port.
+ */
+
+#include "device_link.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace blhost
+{
+
+namespace
+{
+
+// Short error replies (status only) end early; this gap marks the end of such a reply
+constexpr unsigned MIN_IDLE_MS = 20U;
+constexpr size_t MAX_REPLY_LENGTH = BL_HEADER + 1U + BL_FRAME_DATA_SIZE + 64U;
+
+}
+
+Reply DeviceLink::Transact(const PreparedFrame &prepared)
+{
+    Reply reply;
+
+    for (unsigned attempt = 0U; attempt <= retries; attempt++)
+    {
+        if (attempt > 0U)
+        {
+            stats.retries++;
+            port.Flush();
+        }
+        if (TryTransact(prepared, reply))
+        {
+            return reply;
+        }
+    }
+
+    std::string target = port.Path();
+    if (node != NODE_LOCAL)
+    {
+        target += " node " + std::to_string(node);
+    }
+    throw LinkError(target + ": no reply to " + CommandName(prepared.frame.command));
+}
+
+void DeviceLink::Broadcast(const PreparedFrame &prepared, unsigned guardUs)
+{
+    std::vector<uint8_t> wire = Addressed(prepared, NODE_BROADCAST);
+
+    port.Write(wire.data(), wire.size());
+    stats.frames++;
+    stats.broadcasts++;
+    stats.bytesTx += wire.size();
+
+    // Nodes do not listen while they program; the slowest one sets the pace
+    double wireUs = static_cast<double>(wire.size()) * port.ByteTime() * 1000000.0;
+    std::this_thread::sleep_for(std::chrono::microseconds(static_cast<uint64_t>(wireUs) + prepared.frame.busyUs + guardUs));
+}
+
+std::vector<uint8_t> DeviceLink::Addressed(const PreparedFrame &prepared, uint8_t address) const
+{
+    std::vector<uint8_t> wire = prepared.wire;
+
+    // ADDR_E is the last header byte, after STX
+    wire[BL_HEADER] = address;
+    return wire;
+}
+
+bool DeviceLink::TryTransact(const PreparedFrame &prepared, Reply &reply)
+{
+    const Frame &frame = prepared.frame;
+    unsigned idleMs = std::max(MIN_IDLE_MS, static_cast<unsigned>(port.ByteTime() * 50000.0));
+    uint8_t stx = 0U;
+
+    if (node != NODE_LOCAL)
+    {
+        std::vector<uint8_t> wire = Addressed(prepared, node);
+        port.Write(wire.data(), wire.size());
+    }
+    else
+    {
+        port.Write(prepared.wire.data(), prepared.wire.size());
+    }
+    stats.frames++;
+    stats.bytesTx += prepared.wire.size();
+
+    // The device may still be busy on the command; only the first byte waits for the full timeout
+    do
+    {
+        if (port.Read(&stx, 1U, frame.timeoutMs, 0U) != 1U)
+        {
+            return false;
+        }
+        stats.bytesRx++;
+    } while (stx != STX);
+
+    if (node != NODE_LOCAL)
+    {
+        return ReadTaggedReply(frame, reply);
+    }
+
+    reply.bytes.clear();
+    if ((replyMode & REPLY_COMPACT) != 0U)
+    {
+        // Command codes stay below COMPACT_REPLY_FLAG, so the first byte tells the two forms apart
+        uint8_t first = 0U;
+        if (port.Read(&first, 1U, frame.timeoutMs, 0U) != 1U)
+        {
+            return false;
+        }
+        stats.bytesRx++;
+        if (first == (frame.command | COMPACT_REPLY_FLAG))
+        {
+            return ReadCompactReply(prepared, reply);
+        }
+        reply.bytes.push_back(first);
+    }
+
+    size_t wanted = (frame.expectedReplyLength != 0U) ? frame.expectedReplyLength : MAX_REPLY_LENGTH;
+    size_t have = reply.bytes.size();
+    reply.bytes.resize(std::max(wanted, have));
+    size_t received = port.Read(reply.bytes.data() + have, reply.bytes.size() - have, frame.timeoutMs, idleMs);
+    reply.bytes.resize(have + received);
+    stats.bytesRx += received;
+
+    return reply.Valid() && (reply.Command() == frame.command);
+}
+
+bool DeviceLink::ReadTaggedReply(const Frame &frame, Reply &reply)
+{
+    // A node reply carries its payload length in DATALEN, so no idle gap is needed to find its end
+    reply.bytes.resize(BL_HEADER);
+    size_t received = port.Read(reply.bytes.data(), BL_HEADER, frame.timeoutMs, 0U);
+    stats.bytesRx += received;
+    if ((received != BL_HEADER) || (reply.bytes[0] != (frame.command | REPLY_FLAG)) || (reply.bytes[8] != node))
+    {
+        return false;
+    }
+
+    size_t length = static_cast<size_t>(reply.bytes[1] | (reply.bytes[2] << 8U));
+    reply.bytes.resize(BL_HEADER + length);
+    received = port.Read(&reply.bytes[BL_HEADER], length, frame.timeoutMs, 0U);
+    stats.bytesRx += received;
+    if (received != length)
+    {
+        return false;
+    }
+
+    // Hand the reply on in the point-to-point form
+    reply.bytes[0] = frame.command;
+    return reply.Valid();
+}
+
+bool DeviceLink::ReadCompactReply(const PreparedFrame &prepared, Reply &reply)
+{
+    uint8_t sequence = 0U;
+
+    if (port.Read(&sequence, 1U, prepared.frame.timeoutMs, 0U) != 1U)
+    {
+        return false;
+    }
+    stats.bytesRx++;
+    stats.compactReplies++;
+    // A gap means the device acted on a frame whose reply never arrived, such as one that was sent again
+    stats.lostReplies += static_cast<uint8_t>(sequence - replySequence - 1U);
+    replySequence = sequence;
+
+    // Hand the reply on in the full form; the device echoes the request header
+    reply.bytes.assign(prepared.wire.begin() + 1, prepared.wire.begin() + 1 + BL_HEADER);
+    reply.bytes.push_back(COMMAND_SUCCESS);
+    return true;
+}
+
+}
@@ -0,0 +1,101 @@
+/**
+ *
+ * @file device_link.hpp
+ *
+ * @brief Request/reply transport for bootloader frames over a serial or SPI port.
+ */
+
+#ifndef DEVICE_LINK_HPP
+#define DEVICE_LINK_HPP
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "bl_protocol.hpp"
+#include "port.hpp"
+
+namespace blhost
+{
+
+/**
+ * @brief A frame together with its serialised bytes, so encoding can happen away from the I/O path.
+ */
+struct PreparedFrame
+{
+    Frame frame;
+    std::vector<uint8_t> wire;
+
+    PreparedFrame() = default;
+    explicit PreparedFrame(Frame source) : frame(std::move(source)), wire(frame.Encode()) {}
+};
+
+struct LinkStats
+{
+    uint64_t frames = 0U;
+    uint64_t bytesTx = 0U;
+    uint64_t bytesRx = 0U;
+    uint64_t retries = 0U;
+    uint64_t broadcasts = 0U;
+    /** Replies received in the compact form, and compact replies missing from their sequence. */
+    uint64_t compactReplies = 0U;
+    uint64_t lostReplies = 0U;
+};
+
+class LinkError : public std::runtime_error
+{
+public:
+    using std::runtime_error::runtime_error;
+};
+
+class DeviceLink
+{
+public:
+    DeviceLink(Port &port, unsigned retries) : port(port), retries(retries) {}
+
+    /** Sends a frame and waits for its reply. Throws LinkError when every attempt timed out. */
+    Reply Transact(const PreparedFrame &prepared);
+    Reply Transact(const Frame &frame) { return Transact(PreparedFrame(frame)); }
+
+    /**
+     * Sends a frame to every node of a multi-drop bus. No node replies, so this waits for the
+     * frame to leave the wire plus its NVM busy time and guardUs before returning.
+     */
+    void Broadcast(const PreparedFrame &prepared, unsigned guardUs);
+
+    /** Addresses all following frames to one node of a multi-drop bus (NODE_LOCAL for a point-to-point link). */
+    void SetNode(uint8_t address) { node = address; }
+    uint8_t Node() const { return node; }
+
+    /**
+     * Follows a REPLY_MODE the device acknowledged with the given mode and sequence number. With REPLY_COMPACT a
+     * compact reply is handed on as the request header followed by COMMAND_SUCCESS.
+     */
+    void SetReplyMode(uint8_t mode, uint8_t sequence)
+    {
+        replyMode = mode;
+        replySequence = sequence;
+    }
+    uint8_t ReplyMode() const { return replyMode; }
+
+    const LinkStats &Stats() const { return stats; }
+    Port &Transport() { return port; }
+
+private:
+    bool TryTransact(const PreparedFrame &prepared, Reply &reply);
+    bool ReadTaggedReply(const Frame &frame, Reply &reply);
+    bool ReadCompactReply(const PreparedFrame &prepared, Reply &reply);
+    std::vector<uint8_t> Addressed(const PreparedFrame &prepared, uint8_t address) const;
+
+    Port &port;
+    unsigned retries;
+    uint8_t node = NODE_LOCAL;
+    uint8_t replyMode = REPLY_FULL;
+    uint8_t replySequence = 0U;
+    LinkStats stats;
+};
+
+}
+
+#endif // DEVICE_LINK_HPP
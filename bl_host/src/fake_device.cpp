@@ -0,0 +1,948 @@
+/**
+ *
+ * @file fake_device.cpp
+ *
+ * @brief Behavioural model of the PIC18F57Q43 bootloader, used to exercise hosts without hardware.
+ *        Command handling follows 8bit_bootloader.c; frames are resynchronised on the 0x55 autobaud byte.
+ */
+
+#include "fake_device.hpp"
+
+#include <algorithm>
+
+namespace blhost
+{
+
+namespace
+{
+
+constexpr uint16_t DEVICE_ID = 0x74A0U;
+constexpr uint8_t MINOR_VERSION = 0x08U;
+constexpr uint8_t MAJOR_VERSION = 0x00U;
+// BL_JOURNAL_ADDRESS in bl_boot_config.h, as an EEPROM offset
+constexpr uint32_t JOURNAL_OFFSET = 0x280U;
+constexpr uint32_t JOURNAL_BITMAP_OFFSET = JOURNAL_OFFSET + JOURNAL_ID_SIZE;
+
+}
+
+FakeDevice::FakeDevice()
+    : flash(PROGMEM_SIZE, 0xFFU), eeprom(EEPROM_SIZE, 0xFFU), config(CONFIGURATION_BYTES_SIZE, 0xFFU),
+      erasedPages(PROGMEM_SIZE / PROGMEM_PAGE_SIZE, false)
+{
+    buffer.reserve(BL_HEADER + SECURE_FRAME_SIZE + 1U);
+}
+
+bool FakeDevice::Receive(uint8_t byte, std::vector<uint8_t> &reply, uint64_t &nvmBusyUs)
+{
+    // BL_CommunicationModuleInit waits for the autobaud character before every frame
+    if (!synced)
+    {
+        synced = (byte == STX);
+        buffer.clear();
+        messageLength = BL_HEADER;
+        return false;
+    }
+
+    buffer.push_back(byte);
+    if (buffer.size() == 5U)
+    {
+        uint8_t command = buffer[0];
+        bool tagged = multidrop && ((command & REPLY_FLAG) != 0U);
+        if (CarriesData(command) || tagged)
+        {
+            messageLength += DataLength();
+        }
+    }
+    if (buffer.size() < messageLength)
+    {
+        return false;
+    }
+
+    synced = false;
+    if (lossPercent != 0U)
+    {
+        lossState ^= lossState << 13U;
+        lossState ^= lossState >> 17U;
+        lossState ^= lossState << 5U;
+        if ((lossState % 100U) < lossPercent)
+        {
+            stats.framesLost++;
+            return false;
+        }
+    }
+
+    // Routing follows BL_MultidropRoute
+    uint8_t command = buffer[0];
+    uint8_t target = buffer[8];
+    bool broadcast = false;
+    if (multidrop)
+    {
+        bool broadcastCommand = (command == WRITE_FLASH) || (command == ERASE_FLASH) || (command == WRITE_EE_DATA)
+                                || (command == RESET_DEVICE);
+        if ((command & REPLY_FLAG) != 0U)
+        {
+            return false;
+        }
+        broadcast = (target == NODE_BROADCAST);
+        if ((broadcast && !broadcastCommand) || (!broadcast && (target != NODE_LOCAL) && ((target != node) || (node == NODE_LOCAL))))
+        {
+            return false;
+        }
+    }
+
+    buffer.resize(BufferSize(), 0U);
+    nvmBusyUs = 0U;
+    journalQueuedUs = 0U;
+    size_t length = Process(nvmBusyUs);
+    if (powerCut)
+    {
+        // Queued EEPROM bytes were lost with the RAM
+        eepromBacklogUs = 0U;
+        return false;
+    }
+    stats.frames++;
+    // BATCH accounts for the queue frame by frame
+    if (eepromQueue && (command != BATCH))
+    {
+        nvmBusyUs = QueueEeprom(command, nvmBusyUs);
+        eepromBacklogUs += journalQueuedUs;
+    }
+
+    if (broadcast)
+    {
+        RecordBroadcast();
+        return true;
+    }
+    if (multidrop && (target != NODE_LOCAL))
+    {
+        buffer[0] = static_cast<uint8_t>(command | REPLY_FLAG);
+        buffer[1] = static_cast<uint8_t>(length - BL_HEADER);
+        buffer[2] = static_cast<uint8_t>((length - BL_HEADER) >> 8U);
+    }
+    length = CompactReply(length);
+    if (resetRequested)
+    {
+        // The reset clears the reply mode with the rest of the RAM
+        resetRequested = false;
+        replyMode = REPLY_FULL;
+        std::fill(erasedPages.begin(), erasedPages.end(), false);
+    }
+    reply.push_back(STX);
+    reply.insert(reply.end(), buffer.begin(), buffer.begin() + static_cast<long>(length));
+    return true;
+}
+
+bool FakeDevice::TakePowerCut()
+{
+    bool cut = powerCut;
+
+    powerCut = false;
+    if (cut)
+    {
+        std::fill(erasedPages.begin(), erasedPages.end(), false);
+    }
+    return cut;
+}
+
+uint64_t FakeDevice::JournalProgram(uint32_t offset, uint8_t value)
+{
+    if (eeprom[offset] == value)
+    {
+        return 0U;
+    }
+    eeprom[offset] = value;
+    stats.eepromWrites++;
+    return timing.eepromByteWriteUs;
+}
+
+void FakeDevice::JournalErase(uint32_t pageAddress, uint16_t pages, uint64_t &nvmBusyUs)
+{
+    for (uint32_t i = 0U; i < JOURNAL_ID_SIZE; i++)
+    {
+        nvmBusyUs += JournalProgram(JOURNAL_OFFSET + i, 0xFFU);
+    }
+    for (uint16_t i = 0U; (i < pages) && (pageAddress < PROGMEM_SIZE); i++)
+    {
+        uint32_t page = (pageAddress - START_OF_APP) / PROGMEM_PAGE_SIZE;
+        uint32_t offset = JOURNAL_BITMAP_OFFSET + (page / 8U);
+        nvmBusyUs += JournalProgram(offset, static_cast<uint8_t>(eeprom[offset] | (1U << (page % 8U))));
+        pageAddress += PROGMEM_PAGE_SIZE;
+    }
+}
+
+size_t FakeDevice::Journal(uint8_t *data, uint64_t &nvmBusyUs)
+{
+    if (DataLength() == JOURNAL_ID_SIZE)
+    {
+        uint32_t imageId = static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8U)
+                           | (static_cast<uint32_t>(data[2]) << 16U) | (static_cast<uint32_t>(data[3]) << 24U);
+        if (!HasUnlockKey() || (imageId == JOURNAL_NO_IMAGE))
+        {
+            return Status(COMMAND_PROCESSING_ERROR);
+        }
+        for (uint32_t i = 0U; i < JOURNAL_ID_SIZE; i++)
+        {
+            nvmBusyUs += JournalProgram(JOURNAL_OFFSET + i, 0xFFU);
+        }
+        for (uint32_t i = 0U; i < JOURNAL_BITMAP_SIZE; i++)
+        {
+            nvmBusyUs += JournalProgram(JOURNAL_BITMAP_OFFSET + i, 0xFFU);
+        }
+        for (uint32_t i = 0U; i < JOURNAL_ID_SIZE; i++)
+        {
+            nvmBusyUs += JournalProgram(JOURNAL_OFFSET + i, static_cast<uint8_t>(imageId >> (8U * i)));
+        }
+    }
+    else if (DataLength() != 0U)
+    {
+        return Status(COMMAND_PROCESSING_ERROR);
+    }
+
+    data[0] = COMMAND_SUCCESS;
+    std::copy(eeprom.begin() + JOURNAL_OFFSET, eeprom.begin() + JOURNAL_OFFSET + JOURNAL_ID_SIZE, data + 1);
+    data[1U + JOURNAL_ID_SIZE] = static_cast<uint8_t>(JOURNAL_PAGES);
+    data[2U + JOURNAL_ID_SIZE] = static_cast<uint8_t>(JOURNAL_PAGES >> 8U);
+    std::copy(eeprom.begin() + JOURNAL_BITMAP_OFFSET, eeprom.begin() + JOURNAL_BITMAP_OFFSET + JOURNAL_BITMAP_SIZE,
+              data + 3U + JOURNAL_ID_SIZE);
+    return BL_HEADER + 1U + JOURNAL_STATUS_SIZE;
+}
+
+void FakeDevice::RecordBroadcast()
+{
+    stats.broadcasts++;
+    broadcastFrames++;
+    if ((broadcastStatus == COMMAND_SUCCESS) && (buffer[BL_HEADER] != COMMAND_SUCCESS))
+    {
+        broadcastStatus = buffer[BL_HEADER];
+        failedCommand = buffer[0];
+        failedAddress = Address();
+    }
+}
+
+size_t FakeDevice::PollStatus(uint8_t *data)
+{
+    const uint8_t status[POLL_STATUS_SIZE] = {node, broadcastStatus,
+                                              static_cast<uint8_t>(broadcastFrames), static_cast<uint8_t>(broadcastFrames >> 8U),
+                                              failedCommand,
+                                              static_cast<uint8_t>(failedAddress), static_cast<uint8_t>(failedAddress >> 8U),
+                                              static_cast<uint8_t>(failedAddress >> 16U)};
+
+    data[0] = COMMAND_SUCCESS;
+    std::copy(status, status + POLL_STATUS_SIZE, data + 1);
+    if (DataLength() != 0U)
+    {
+        broadcastFrames = 0U;
+        broadcastStatus = COMMAND_SUCCESS;
+        failedCommand = 0U;
+        failedAddress = 0U;
+    }
+    return BL_HEADER + 1U + POLL_STATUS_SIZE;
+}
+
+size_t FakeDevice::CapabilityBlock(uint8_t *data) const
+{
+    uint32_t commands = 0U;
+    uint32_t features = FEATURE_ENTRY_REQUEST;
+    // 64 MHz autobaud range of the UART backend, as BL_TRANSPORT_BAUD_MIN and BL_TRANSPORT_BAUD_MAX
+    const uint32_t baudMin = (64000000U / 262144U) + 1U;
+    const uint32_t baudMax = 64000000U / 128U;
+
+    for (uint8_t command = READ_VERSION; command <= RESET_DEVICE; command++)
+    {
+        commands |= 1U << command;
+    }
+    commands |= multidrop ? (1U << POLL_STATUS) : 0U;
+    commands |= journal ? (1U << JOURNAL) : 0U;
+    commands |= batch ? (1U << BATCH) : 0U;
+    commands |= 1U << BLANK_CHECK;
+    commands |= (patch && plaintextFlash) ? (1U << PATCH) : 0U;
+    commands |= secureWrite ? (1U << SECURE_WRITE) : 0U;
+    commands |= digest ? (1U << DIGEST) : 0U;
+    commands &= plaintextFlash ? ~0U : ~((1U << READ_FLASH) | (1U << WRITE_FLASH));
+    commands |= (ReplyModes() != 0U) ? (1U << REPLY_MODE) : 0U;
+    features |= eepromQueue ? FEATURE_EE_QUEUE : 0U;
+    features |= skipUnchanged ? FEATURE_SKIP_UNCHANGED : 0U;
+    features |= skipBlank ? FEATURE_SKIP_BLANK : 0U;
+    features |= multidrop ? FEATURE_MULTIDROP : 0U;
+    features |= (compactReplies && !multidrop) ? FEATURE_COMPACT_REPLY : 0U;
+
+    const uint32_t fields[][2] = {
+        {CAPABILITY_VERSION, 1U}, {static_cast<uint32_t>(CAPABILITY_SIZE), 1U}, {commands, 4U}, {features, 4U},
+        {static_cast<uint32_t>(BL_FRAME_DATA_SIZE), 2U}, {VERIFY_CHECKSUM16, 1U}, {1U, 1U}, {2U, 2U},
+        {eepromQueue ? static_cast<uint32_t>(EE_QUEUE_SIZE) : 0U, 2U}, {TRANSPORT_UART, 1U}, {0U, 1U},
+        {baudMin, 4U}, {baudMax, 4U}, {START_OF_APP, 4U}};
+    size_t index = 0U;
+    for (const auto &field : fields)
+    {
+        for (uint32_t i = 0U; i < field[1]; i++)
+        {
+            data[index] = static_cast<uint8_t>(field[0] >> (8U * i));
+            index++;
+        }
+    }
+    return index;
+}
+
+bool FakeDevice::CarriesData(uint8_t command) const
+{
+    return (command == WRITE_FLASH) || (command == WRITE_EE_DATA) || (command == WRITE_CONFIG)
+           || (journal && (command == JOURNAL)) || (batch && (command == BATCH)) || (patch && (command == PATCH))
+           || (command == SECURE_WRITE);
+}
+
+size_t FakeDevice::BufferSize() const
+{
+    return BL_HEADER + (secureWrite ? SECURE_FRAME_SIZE : BL_FRAME_DATA_SIZE) + 1U;
+}
+
+uint8_t FakeDevice::ReplyModes() const
+{
+    uint8_t modes = REPLY_FULL;
+
+    modes |= (compactReplies && !multidrop) ? REPLY_COMPACT : 0U;
+    modes |= (skipUnchanged || skipBlank) ? REPLY_COUNTS : 0U;
+    return modes;
+}
+
+size_t FakeDevice::ReplyMode(uint8_t *data)
+{
+    if ((Address() & ~static_cast<uint32_t>(ReplyModes())) != 0U)
+    {
+        return Status(ERROR_ADDRESS_OUT_OF_RANGE);
+    }
+    replyMode = static_cast<uint8_t>(Address());
+    replySequence = 0U;
+    data[0] = COMMAND_SUCCESS;
+    data[1] = replyMode;
+    data[2] = replySequence;
+    return BL_HEADER + REPLY_MODE_SIZE;
+}
+
+size_t FakeDevice::CompactReply(size_t length)
+{
+    if (((replyMode & REPLY_COMPACT) != 0U) && (length == (BL_HEADER + 1U)) && (buffer[BL_HEADER] == COMMAND_SUCCESS))
+    {
+        replySequence++;
+        buffer[0] = static_cast<uint8_t>(buffer[0] | COMPACT_REPLY_FLAG);
+        buffer[1] = replySequence;
+        return COMPACT_REPLY_SIZE;
+    }
+    return length;
+}
+
+size_t FakeDevice::Patch(uint64_t &nvmBusyUs)
+{
+    uint32_t address = Address();
+    uint16_t length = DataLength();
+    const uint8_t *stream = buffer.data() + BL_HEADER;
+    std::vector<uint8_t> page;
+    size_t in = 0U;
+
+    if (!HasUnlockKey())
+    {
+        return Status(COMMAND_PROCESSING_ERROR);
+    }
+    if (length > BL_FRAME_DATA_SIZE)
+    {
+        return Status(COMMAND_OVERLOAD_ERROR);
+    }
+    if ((address < START_OF_APP) || (address >= PROGMEM_SIZE) || ((address & (PROGMEM_PAGE_SIZE - 1U)) != 0U))
+    {
+        return Status(ERROR_ADDRESS_OUT_OF_RANGE);
+    }
+    while ((in + 2U) <= length)
+    {
+        uint8_t instruction = stream[in];
+        size_t count = (stream[in + 1U] == 0U) ? 256U : stream[in + 1U];
+        in += 2U;
+        if (count > (PROGMEM_PAGE_SIZE - page.size()))
+        {
+            return Status(COMMAND_PROCESSING_ERROR);
+        }
+        if ((instruction == PATCH_COPY) && ((in + 3U) <= length))
+        {
+            uint32_t source = stream[in] | (static_cast<uint32_t>(stream[in + 1U]) << 8U) | (static_cast<uint32_t>(stream[in + 2U]) << 16U);
+            in += 3U;
+            if ((source < START_OF_APP) || (source > (PROGMEM_SIZE - count)))
+            {
+                return Status(ERROR_ADDRESS_OUT_OF_RANGE);
+            }
+            page.insert(page.end(), flash.begin() + source, flash.begin() + source + count);
+        }
+        else if ((instruction == PATCH_ADD) && ((in + count) <= length))
+        {
+            page.insert(page.end(), stream + in, stream + in + count);
+            in += count;
+        }
+        else if ((instruction == PATCH_RUN) && ((in + 1U) <= length))
+        {
+            page.insert(page.end(), count, stream[in]);
+            in++;
+        }
+        else
+        {
+            return Status(COMMAND_PROCESSING_ERROR);
+        }
+    }
+    if ((in != length) || (page.size() != PROGMEM_PAGE_SIZE))
+    {
+        return Status(COMMAND_PROCESSING_ERROR);
+    }
+
+    bool erased = erasedMap && erasedPages[address / PROGMEM_PAGE_SIZE];
+    erasedPages[address / PROGMEM_PAGE_SIZE] = false;
+    if (!erased)
+    {
+        stats.pageErases++;
+        nvmBusyUs += timing.pageEraseUs;
+    }
+    std::copy(page.begin(), page.end(), flash.begin() + address);
+    stats.pageWrites++;
+    nvmBusyUs += timing.pageWriteUs;
+    if (journal)
+    {
+        JournalPageCommitted(address, nvmBusyUs);
+    }
+    return Status(COMMAND_SUCCESS);
+}
+
+void FakeDevice::JournalPageCommitted(uint32_t pageAddress, uint64_t &nvmBusyUs)
+{
+    uint32_t bit = (pageAddress - START_OF_APP) / PROGMEM_PAGE_SIZE;
+    uint32_t byte = JOURNAL_BITMAP_OFFSET + (bit / 8U);
+    uint64_t journalUs = JournalProgram(byte, static_cast<uint8_t>(eeprom[byte] & ~(1U << (bit % 8U))));
+
+    if (eepromQueue)
+    {
+        journalQueuedUs = journalUs;
+    }
+    else
+    {
+        nvmBusyUs += journalUs;
+    }
+}
+
+size_t FakeDevice::SecureWrite(uint64_t &nvmBusyUs)
+{
+    uint32_t address = Address();
+    std::vector<uint8_t> page(PROGMEM_PAGE_SIZE);
+
+    if (!HasUnlockKey())
+    {
+        return Status(COMMAND_PROCESSING_ERROR);
+    }
+    if ((address < START_OF_APP) || (address >= PROGMEM_SIZE) || ((address & (PROGMEM_PAGE_SIZE - 1U)) != 0U))
+    {
+        return Status(ERROR_ADDRESS_OUT_OF_RANGE);
+    }
+    if (DataLength() != SECURE_FRAME_SIZE)
+    {
+        return Status(COMMAND_OVERLOAD_ERROR);
+    }
+    // The tag is checked before the page is erased
+    if (!OpenPage(Aes128(secureKey), buffer.data() + BL_HEADER, address, page.data()))
+    {
+        return Status(COMMAND_PROCESSING_ERROR);
+    }
+    flashWrites++;
+    if (flashWrites == cutAtWrite)
+    {
+        std::fill(flash.begin() + address, flash.begin() + address + PROGMEM_PAGE_SIZE, 0xFFU);
+        stats.pageErases++;
+        powerCut = true;
+        return 0U;
+    }
+
+    bool erased = erasedMap && erasedPages[address / PROGMEM_PAGE_SIZE];
+    erasedPages[address / PROGMEM_PAGE_SIZE] = false;
+    if (!erased)
+    {
+        stats.pageErases++;
+        nvmBusyUs += timing.pageEraseUs;
+    }
+    std::copy(page.begin(), page.end(), flash.begin() + address);
+    stats.pageWrites++;
+    nvmBusyUs += timing.pageWriteUs;
+    if (journal)
+    {
+        JournalPageCommitted(address, nvmBusyUs);
+    }
+    return Status(COMMAND_SUCCESS);
+}
+
+size_t FakeDevice::Batch(uint64_t &nvmBusyUs)
+{
+    std::vector<uint8_t> header(buffer.begin(), buffer.begin() + BL_HEADER);
+    const std::vector<uint8_t> frames(buffer.begin() + BL_HEADER, buffer.begin() + BL_HEADER + DataLength());
+    size_t offset = 0U;
+    uint8_t status = COMMAND_SUCCESS;
+    uint8_t index = 0U;
+    uint16_t checkSum = 0U;
+
+    if (eepromQueue)
+    {
+        nvmBusyUs += eepromBacklogUs;
+        eepromBacklogUs = 0U;
+    }
+    while (offset < frames.size())
+    {
+        if ((frames.size() - offset) < BL_HEADER)
+        {
+            status = COMMAND_OVERLOAD_ERROR;
+            break;
+        }
+        std::copy(frames.begin() + static_cast<long>(offset), frames.begin() + static_cast<long>(offset + BL_HEADER), buffer.begin());
+        offset += BL_HEADER;
+        uint8_t command = buffer[0];
+        size_t dataLength = CarriesData(command) ? DataLength() : 0U;
+        if (dataLength > (frames.size() - offset))
+        {
+            status = COMMAND_OVERLOAD_ERROR;
+            break;
+        }
+        std::copy(frames.begin() + static_cast<long>(offset), frames.begin() + static_cast<long>(offset + dataLength),
+                  buffer.begin() + BL_HEADER);
+        offset += dataLength;
+
+        uint64_t busyUs = 0U;
+        size_t length = 0U;
+        if ((command == WRITE_FLASH) || (command == ERASE_FLASH) || (command == WRITE_EE_DATA) || (command == WRITE_CONFIG)
+            || (command == CALC_CHECKSUM) || (command == RESET_DEVICE) || (command == PATCH))
+        {
+            length = Process(busyUs);
+        }
+        else
+        {
+            // Not before Process: the status overlays the first data byte of the frame
+            length = Status(ERROR_INVALID_COMMAND);
+        }
+        if (powerCut)
+        {
+            return 0U;
+        }
+        nvmBusyUs += eepromQueue ? QueueEeprom(command, busyUs) : busyUs;
+        if ((command == CALC_CHECKSUM) && (length > (BL_HEADER + 1U)))
+        {
+            checkSum = static_cast<uint16_t>(buffer[BL_HEADER] | (buffer[BL_HEADER + 1U] << 8U));
+            status = COMMAND_SUCCESS;
+        }
+        else
+        {
+            status = buffer[BL_HEADER];
+        }
+        if (status != COMMAND_SUCCESS)
+        {
+            // The reply carries ADDR_L to ADDR_U of the frame that failed
+            std::copy(buffer.begin() + 5, buffer.begin() + 8, header.begin() + 5);
+            break;
+        }
+        index++;
+    }
+
+    std::copy(header.begin(), header.end(), buffer.begin());
+    buffer[BL_HEADER] = status;
+    buffer[BL_HEADER + 1U] = index;
+    buffer[BL_HEADER + 2U] = static_cast<uint8_t>(checkSum);
+    buffer[BL_HEADER + 3U] = static_cast<uint8_t>(checkSum >> 8U);
+    return BL_HEADER + BATCH_REPLY_SIZE;
+}
+
+uint32_t FakeDevice::Address() const
+{
+    return static_cast<uint32_t>(buffer[5]) | (static_cast<uint32_t>(buffer[6]) << 8U) | (static_cast<uint32_t>(buffer[7]) << 16U);
+}
+
+uint16_t FakeDevice::DataLength() const
+{
+    return static_cast<uint16_t>(buffer[1] | (buffer[2] << 8U));
+}
+
+bool FakeDevice::HasUnlockKey() const
+{
+    return static_cast<uint16_t>(buffer[3] | (buffer[4] << 8U)) == UNLOCK_KEY;
+}
+
+bool FakeDevice::PageBlank(uint32_t page) const
+{
+    return std::all_of(flash.begin() + page, flash.begin() + page + PROGMEM_PAGE_SIZE,
+                       [](uint8_t value) { return value == 0xFFU; });
+}
+
+size_t FakeDevice::Status(uint8_t status)
+{
+    buffer[BL_HEADER] = status;
+    return BL_HEADER + 1U;
+}
+
+void FakeDevice::Elapse(uint64_t elapsedUs)
+{
+    eepromBacklogUs -= std::min(eepromBacklogUs, elapsedUs);
+}
+
+uint64_t FakeDevice::QueueEeprom(uint8_t command, uint64_t nvmBusyUs)
+{
+    uint64_t capacityUs = static_cast<uint64_t>(timing.eepromByteWriteUs) * EE_QUEUE_SIZE;
+
+    // Every command but a data carrying WRITE_EE_DATA flushes the queue before it runs
+    if ((command != WRITE_EE_DATA) || (DataLength() == 0U))
+    {
+        nvmBusyUs += eepromBacklogUs;
+        eepromBacklogUs = 0U;
+        return nvmBusyUs;
+    }
+
+    // The reply only waits until the last byte of the frame has a queue slot
+    eepromBacklogUs += nvmBusyUs;
+    uint64_t waitUs = (eepromBacklogUs > capacityUs) ? (eepromBacklogUs - capacityUs) : 0U;
+    eepromBacklogUs -= waitUs;
+    return waitUs;
+}
+
+size_t FakeDevice::WriteStatus(uint8_t status, uint16_t programmed, uint16_t skipped)
+{
+    uint8_t *data = &buffer[BL_HEADER];
+
+    if (!skipUnchanged || ((replyMode & REPLY_COUNTS) == 0U))
+    {
+        return Status(status);
+    }
+    data[0] = status;
+    data[1] = static_cast<uint8_t>(programmed);
+    data[2] = static_cast<uint8_t>(programmed >> 8U);
+    data[3] = static_cast<uint8_t>(skipped);
+    data[4] = static_cast<uint8_t>(skipped >> 8U);
+    return BL_HEADER + 1U + WRITE_COUNTS_SIZE;
+}
+
+size_t FakeDevice::Process(uint64_t &nvmBusyUs)
+{
+    uint8_t *data = &buffer[BL_HEADER];
+    uint32_t address = Address();
+    uint16_t length = DataLength();
+
+    switch (buffer[0])
+    {
+    case READ_VERSION:
+    {
+        uint16_t maxPacketSize = static_cast<uint16_t>(PROGMEM_SIZE / PROGMEM_PAGE_SIZE);
+        const uint8_t version[16] = {MINOR_VERSION, MAJOR_VERSION,
+                                     static_cast<uint8_t>(maxPacketSize), static_cast<uint8_t>(maxPacketSize >> 8U),
+                                     CAPABILITY_VERSION, static_cast<uint8_t>(CAPABILITY_SIZE),
+                                     static_cast<uint8_t>(DEVICE_ID), static_cast<uint8_t>(DEVICE_ID >> 8U),
+                                     0U, 0U,
+                                     static_cast<uint8_t>(PROGMEM_PAGE_SIZE), static_cast<uint8_t>(PROGMEM_PAGE_SIZE >> 8U),
+                                     0xFFU, 0xFFU, 0xFFU, 0xFFU};
+        for (size_t i = 0U; i < sizeof(version); i++)
+        {
+            data[i] = version[i];
+        }
+        if (address != VERSION_CAPABILITIES)
+        {
+            return BL_HEADER + sizeof(version);
+        }
+        return BL_HEADER + sizeof(version) + CapabilityBlock(&data[sizeof(version)]);
+    }
+    case READ_FLASH:
+        if (!plaintextFlash)
+        {
+            break;
+        }
+        if ((address < START_OF_APP) || (address >= PROGMEM_SIZE))
+        {
+            return Status(ERROR_ADDRESS_OUT_OF_RANGE);
+        }
+        if (length > BL_FRAME_DATA_SIZE)
+        {
+            return Status(COMMAND_OVERLOAD_ERROR);
+        }
+        for (uint16_t i = 0U; i < length; i++)
+        {
+            data[i + 1U] = flash[(address + i) % PROGMEM_SIZE];
+        }
+        data[0] = COMMAND_SUCCESS;
+        return BL_HEADER + 1U + length;
+    case WRITE_FLASH:
+    {
+        if (!plaintextFlash)
+        {
+            break;
+        }
+        if (!HasUnlockKey())
+        {
+            return Status(COMMAND_PROCESSING_ERROR);
+        }
+        if (length > BL_FRAME_DATA_SIZE)
+        {
+            return Status(COMMAND_OVERLOAD_ERROR);
+        }
+        if ((address < START_OF_APP) || (address >= PROGMEM_SIZE))
+        {
+            return Status(ERROR_ADDRESS_OUT_OF_RANGE);
+        }
+        uint32_t page = address & ~(PROGMEM_PAGE_SIZE - 1U);
+        uint32_t offset = address & (PROGMEM_PAGE_SIZE - 1U);
+        flashWrites++;
+        if (flashWrites == cutAtWrite)
+        {
+            // Power fails between the page erase and the row write
+            std::fill(flash.begin() + page, flash.begin() + page + PROGMEM_PAGE_SIZE, 0xFFU);
+            stats.pageErases++;
+            powerCut = true;
+            return 0U;
+        }
+        bool erased = erasedMap && erasedPages[page / PROGMEM_PAGE_SIZE];
+        erasedPages[page / PROGMEM_PAGE_SIZE] = false;
+        if (!erased && (!skipBlank || !PageBlank(page)))
+        {
+            stats.pageErases++;
+            nvmBusyUs += timing.pageEraseUs;
+        }
+        for (uint16_t i = 0U; (i < length) && ((offset + i) < PROGMEM_PAGE_SIZE); i++)
+        {
+            flash[page + offset + i] = data[i];
+        }
+        stats.pageWrites++;
+        nvmBusyUs += timing.pageWriteUs;
+        if (journal && ((offset + length) == PROGMEM_PAGE_SIZE))
+        {
+            JournalPageCommitted(page, nvmBusyUs);
+        }
+        return Status(COMMAND_SUCCESS);
+    }
+    case ERASE_FLASH:
+        if (!HasUnlockKey())
+        {
+            return Status(COMMAND_PROCESSING_ERROR);
+        }
+        if (((address & (PROGMEM_PAGE_SIZE - 1U)) != 0U) || (address < START_OF_APP))
+        {
+            return Status(ERROR_ADDRESS_OUT_OF_RANGE);
+        }
+        if (journal)
+        {
+            JournalErase(address, length, nvmBusyUs);
+        }
+    {
+        uint16_t erased = 0U;
+        uint16_t skipped = 0U;
+        for (uint16_t i = 0U; (i < length) && (address < PROGMEM_SIZE); i++)
+        {
+            if ((erasedMap && erasedPages[address / PROGMEM_PAGE_SIZE]) || (skipBlank && PageBlank(address)))
+            {
+                skipped++;
+            }
+            else
+            {
+                std::fill(flash.begin() + address, flash.begin() + address + PROGMEM_PAGE_SIZE, 0xFFU);
+                stats.pageErases++;
+                nvmBusyUs += timing.pageEraseUs;
+                erased++;
+            }
+            erasedPages[address / PROGMEM_PAGE_SIZE] = true;
+            address += PROGMEM_PAGE_SIZE;
+        }
+        if (!skipBlank || ((replyMode & REPLY_COUNTS) == 0U))
+        {
+            return Status(COMMAND_SUCCESS);
+        }
+        data[0] = COMMAND_SUCCESS;
+        data[1] = static_cast<uint8_t>(erased);
+        data[2] = static_cast<uint8_t>(erased >> 8U);
+        data[3] = static_cast<uint8_t>(skipped);
+        data[4] = static_cast<uint8_t>(skipped >> 8U);
+        return BL_HEADER + 1U + ERASE_COUNTS_SIZE;
+    }
+    case BLANK_CHECK:
+    {
+        if (((address & (PROGMEM_PAGE_SIZE - 1U)) != 0U) || (address < START_OF_APP) || (address >= PROGMEM_SIZE) ||
+            ((static_cast<uint32_t>(length) * PROGMEM_PAGE_SIZE) > (PROGMEM_SIZE - address)))
+        {
+            return Status(ERROR_ADDRESS_OUT_OF_RANGE);
+        }
+        uint16_t blank = 0U;
+        std::fill(data + 3, data + 3 + ((length + 7U) / 8U), 0U);
+        for (uint16_t page = 0U; page < length; page++)
+        {
+            if (PageBlank(address + (static_cast<uint32_t>(page) * PROGMEM_PAGE_SIZE)))
+            {
+                data[3U + (page / 8U)] |= static_cast<uint8_t>(1U << (page % 8U));
+                blank++;
+            }
+        }
+        data[0] = COMMAND_SUCCESS;
+        data[1] = static_cast<uint8_t>(blank);
+        data[2] = static_cast<uint8_t>(blank >> 8U);
+        return BL_HEADER + 3U + ((length + 7U) / 8U);
+    }
+    case READ_EE_DATA:
+        if ((address < EEPROM_START_ADDRESS) || (address >= (EEPROM_START_ADDRESS + EEPROM_SIZE)))
+        {
+            return Status(ERROR_ADDRESS_OUT_OF_RANGE);
+        }
+        if (length > BL_FRAME_DATA_SIZE)
+        {
+            return Status(COMMAND_OVERLOAD_ERROR);
+        }
+        for (uint16_t i = 0U; i < length; i++)
+        {
+            data[i + 1U] = eeprom[(address - EEPROM_START_ADDRESS + i) % EEPROM_SIZE];
+        }
+        data[0] = COMMAND_SUCCESS;
+        return BL_HEADER + 1U + length;
+    case WRITE_EE_DATA:
+        if (length > BL_FRAME_DATA_SIZE)
+        {
+            return Status(COMMAND_OVERLOAD_ERROR);
+        }
+        if ((address < EEPROM_START_ADDRESS) || (address >= (EEPROM_START_ADDRESS + EEPROM_SIZE)))
+        {
+            return Status(ERROR_ADDRESS_OUT_OF_RANGE);
+        }
+    {
+        uint16_t programmed = 0U;
+        uint16_t skipped = 0U;
+        for (uint16_t i = 0U; i < length; i++)
+        {
+            uint32_t offset = address - EEPROM_START_ADDRESS + i;
+            if (offset >= EEPROM_SIZE)
+            {
+                // The reply names the byte that failed
+                uint32_t failed = EEPROM_START_ADDRESS + offset;
+                buffer[5] = static_cast<uint8_t>(failed);
+                buffer[6] = static_cast<uint8_t>(failed >> 8U);
+                buffer[7] = static_cast<uint8_t>(failed >> 16U);
+                return WriteStatus(ERROR_ADDRESS_OUT_OF_RANGE, programmed, skipped);
+            }
+            if (skipUnchanged && (eeprom[offset] == data[i]))
+            {
+                skipped++;
+                continue;
+            }
+            eeprom[offset] = data[i];
+            stats.eepromWrites++;
+            programmed++;
+            nvmBusyUs += timing.eepromByteWriteUs;
+        }
+        return WriteStatus(COMMAND_SUCCESS, programmed, skipped);
+    }
+    case READ_CONFIG:
+        for (uint16_t i = 0U; i < length; i++)
+        {
+            uint32_t index = address + i - CONFIGURATION_BYTES_START;
+            data[i + 1U] = (index < CONFIGURATION_BYTES_SIZE) ? config[index] : 0xFFU;
+        }
+        data[0] = COMMAND_SUCCESS;
+        return BL_HEADER + 1U + length;
+    case WRITE_CONFIG:
+        if (address < START_OF_APP)
+        {
+            return Status(ERROR_ADDRESS_OUT_OF_RANGE);
+        }
+    {
+        uint16_t programmed = 0U;
+        uint16_t skipped = 0U;
+        for (uint16_t i = 0U; i < length; i++)
+        {
+            uint32_t index = address + i - CONFIGURATION_BYTES_START;
+            uint8_t current = (index < CONFIGURATION_BYTES_SIZE) ? config[index] : 0xFFU;
+            if (skipUnchanged && (current == data[i]))
+            {
+                skipped++;
+                continue;
+            }
+            if (index < CONFIGURATION_BYTES_SIZE)
+            {
+                config[index] = data[i];
+            }
+            programmed++;
+            nvmBusyUs += timing.eepromByteWriteUs;
+        }
+        return WriteStatus(COMMAND_SUCCESS, programmed, skipped);
+    }
+    case CALC_CHECKSUM:
+    {
+        uint32_t checksumLength = length | (static_cast<uint32_t>(buffer[3]) << 16U);
+        // Without plaintext flash access only the whole application area is summed
+        if ((address < START_OF_APP)
+            || (!plaintextFlash && ((address != START_OF_APP) || (checksumLength != (PROGMEM_SIZE - START_OF_APP)))))
+        {
+            return Status(ERROR_ADDRESS_OUT_OF_RANGE);
+        }
+        uint16_t checkSum = 0U;
+        for (uint32_t i = 0U; i < checksumLength; i += 2U)
+        {
+            checkSum = static_cast<uint16_t>(checkSum + flash[(address + i) % PROGMEM_SIZE]
+                                             + (flash[(address + i + 1U) % PROGMEM_SIZE] << 8U));
+        }
+        data[0] = static_cast<uint8_t>(checkSum);
+        data[1] = static_cast<uint8_t>(checkSum >> 8U);
+        return BL_HEADER + 2U;
+    }
+    case DIGEST:
+    {
+        if (!digest)
+        {
+            break;
+        }
+        uint32_t digestLength = length | (static_cast<uint32_t>(buffer[3]) << 16U);
+        if ((address < START_OF_APP) || (address >= PROGMEM_SIZE) || (digestLength > (PROGMEM_SIZE - address))
+            || (!plaintextFlash && ((address != START_OF_APP) || (digestLength != (PROGMEM_SIZE - START_OF_APP)))))
+        {
+            return Status(ERROR_ADDRESS_OUT_OF_RANGE);
+        }
+        Digest hash = Sha256(&flash[address], digestLength);
+        data[0] = COMMAND_SUCCESS;
+        std::copy(hash.begin(), hash.end(), data + 1);
+        return BL_HEADER + 1U + DIGEST_SIZE;
+    }
+    case RESET_DEVICE:
+        resetRequested = true;
+        return Status(COMMAND_SUCCESS);
+    case POLL_STATUS:
+        if (multidrop)
+        {
+            return PollStatus(data);
+        }
+        break;
+    case JOURNAL:
+        if (journal)
+        {
+            return Journal(data, nvmBusyUs);
+        }
+        break;
+    case BATCH:
+        if (batch)
+        {
+            if (length > BL_FRAME_DATA_SIZE)
+            {
+                return Status(COMMAND_OVERLOAD_ERROR);
+            }
+            return Batch(nvmBusyUs);
+        }
+        break;
+    case PATCH:
+        if (patch && plaintextFlash)
+        {
+            return Patch(nvmBusyUs);
+        }
+        break;
+    case SECURE_WRITE:
+        if (secureWrite)
+        {
+            return SecureWrite(nvmBusyUs);
+        }
+        break;
+    case REPLY_MODE:
+        if (ReplyModes() != 0U)
+        {
+            return ReplyMode(data);
+        }
+        break;
+    default:
+        break;
+    }
+
+    return Status(ERROR_INVALID_COMMAND);
+}
+
+}
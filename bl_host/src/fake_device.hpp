@@ -0,0 +1,152 @@
+/**
+ *
+ * @file fake_device.hpp
+ *
+ * @brief Behavioural model of the PIC18F57Q43 bootloader, used to exercise hosts without hardware.
+ */
+
+#ifndef FAKE_DEVICE_HPP
+#define FAKE_DEVICE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "bl_protocol.hpp"
+#include "secure.hpp"
+#include "sha256.hpp"
+
+namespace blhost
+{
+
+struct FakeDeviceStats
+{
+    uint64_t frames = 0U;
+    uint64_t pageErases = 0U;
+    uint64_t pageWrites = 0U;
+    uint64_t eepromWrites = 0U;
+    uint64_t broadcasts = 0U;
+    uint64_t framesLost = 0U;
+};
+
+class FakeDevice
+{
+public:
+    FakeDevice();
+
+    /**
+     * Feeds received bytes. Returns true when a complete frame was processed;
+     * the reply (STX included) is then appended to reply and the busy time in microseconds
+     * the real device would have spent on NVM operations is stored in nvmBusyUs.
+     * With multidrop set, frames for other nodes and their replies are consumed silently
+     * and broadcast frames are processed without a reply.
+     */
+    bool Receive(uint8_t byte, std::vector<uint8_t> &reply, uint64_t &nvmBusyUs);
+
+    const FakeDeviceStats &Stats() const { return stats; }
+    const std::vector<uint8_t> &Flash() const { return flash; }
+    const std::vector<uint8_t> &Eeprom() const { return eeprom; }
+    bool ResetRequested() const { return resetRequested; }
+    /** Wire length (STX included) of the frame Receive last completed. */
+    size_t FrameLength() const { return messageLength + 1U; }
+    void SeedLoss(uint32_t seed) { lossState = (seed * 0x9E3779B9U) | 1U; }
+    /** Lets queued EEPROM writes progress for elapsedUs of device time. */
+    void Elapse(uint64_t elapsedUs);
+
+    NvmTiming timing;
+    /** Models BL_MULTIDROP_ENABLE with this node address. */
+    bool multidrop = false;
+    uint8_t node = NODE_LOCAL;
+    /** Share of completed frames dropped as if corrupted on the wire, in percent. */
+    unsigned lossPercent = 0U;
+    /** Models BL_EE_QUEUE_ENABLE: WRITE_EE_DATA replies once its bytes fit the queue, other commands drain it first. */
+    bool eepromQueue = false;
+    /** Models BL_SKIP_UNCHANGED_ENABLE: unchanged EEPROM and configuration bytes are not programmed, and counted. */
+    bool skipUnchanged = true;
+    /** Models BL_SKIP_BLANK_ENABLE: ERASE_FLASH and WRITE_FLASH leave blank pages unerased, ERASE_FLASH counts them. */
+    bool skipBlank = true;
+    /** Models BL_ERASED_MAP_ENABLE: pages erased since the last reset are neither erased again nor read before a write. */
+    bool erasedMap = true;
+    /** Models BL_CMD_PATCH_ENABLE: PATCH rebuilds a page from the flash and the instructions in its data. */
+    bool patch = true;
+    /** Models BL_CMD_SECURE_WRITE_ENABLE with BL_SECURE_KEY secureKey: SECURE_WRITE programs pages sealed under it. */
+    bool secureWrite = false;
+    SecureKey secureKey = DEVELOPMENT_KEY;
+    /** Models BL_PLAINTEXT_FLASH_ENABLE: READ_FLASH, WRITE_FLASH and PATCH are served, CALC_CHECKSUM over any range. */
+    bool plaintextFlash = true;
+    /** Models BL_CMD_DIGEST_ENABLE: DIGEST replies the SHA-256 of a flash range, under the same range rules as CALC_CHECKSUM. */
+    bool digest = false;
+    /** Models BL_JOURNAL_ENABLE: committed pages are recorded in EEPROM and the JOURNAL command is served. */
+    bool journal = false;
+    /** Models BL_CMD_BATCH_ENABLE: BATCH runs the frames in its data. */
+    bool batch = true;
+    /** Models BL_COMPACT_REPLY_ENABLE: REPLY_MODE is served unless multidrop is set. */
+    bool compactReplies = true;
+    /** Loses power during the N-th WRITE_FLASH or SECURE_WRITE frame (counted from 1; 0 never): the page is left erased, no reply is sent. */
+    uint64_t cutAtWrite = 0U;
+
+    /** Returns true once after the power cut; the caller keeps the node unpowered for a while. */
+    bool TakePowerCut();
+
+private:
+    size_t Process(uint64_t &nvmBusyUs);
+    uint32_t Address() const;
+    uint16_t DataLength() const;
+    bool HasUnlockKey() const;
+    bool PageBlank(uint32_t page) const;
+    size_t Status(uint8_t status);
+    size_t WriteStatus(uint8_t status, uint16_t programmed, uint16_t skipped);
+    size_t PollStatus(uint8_t *data);
+    /** Capability block of a bootloader built with the options modelled here, as in BL_GetVersionData. */
+    size_t CapabilityBlock(uint8_t *data) const;
+    void RecordBroadcast();
+    uint64_t QueueEeprom(uint8_t command, uint64_t nvmBusyUs);
+    size_t Journal(uint8_t *data, uint64_t &nvmBusyUs);
+    size_t Batch(uint64_t &nvmBusyUs);
+    size_t Patch(uint64_t &nvmBusyUs);
+    size_t SecureWrite(uint64_t &nvmBusyUs);
+    /** Frame buffer size, header included, as frame_t of the options modelled here. */
+    size_t BufferSize() const;
+    /** Reply mode bits of the options modelled here, as BL_REPLY_MODES; REPLY_MODE is left out without any. */
+    uint8_t ReplyModes() const;
+    size_t ReplyMode(uint8_t *data);
+    /** Shortens a successful status reply in compact mode, as BL_CompactReply; returns the reply length. */
+    size_t CompactReply(size_t length);
+    /** DATALEN bytes of data follow the header of this command. */
+    bool CarriesData(uint8_t command) const;
+    /** Programs one journal byte if it changes, as BL_JournalProgram; returns the busy time. */
+    uint64_t JournalProgram(uint32_t offset, uint8_t value);
+    void JournalErase(uint32_t pageAddress, uint16_t pages, uint64_t &nvmBusyUs);
+    /** Clears the journal bit of a page written up to its end, as BL_JournalPageCommitted. */
+    void JournalPageCommitted(uint32_t pageAddress, uint64_t &nvmBusyUs);
+
+    std::vector<uint8_t> flash;
+    std::vector<uint8_t> eeprom;
+    std::vector<uint8_t> config;
+    std::vector<uint8_t> buffer;
+    /** Erased page bitmap of BL_ERASED_MAP_ENABLE, one entry per flash page; lost with the RAM. */
+    std::vector<bool> erasedPages;
+    size_t messageLength = BL_HEADER;
+    bool synced = false;
+    bool resetRequested = false;
+    FakeDeviceStats stats;
+    uint32_t lossState = 0x2545F491U;
+    /** Programming time of the EEPROM bytes still queued. */
+    uint64_t eepromBacklogUs = 0U;
+    /** Journal bytes the last frame queued behind its reply. */
+    uint64_t journalQueuedUs = 0U;
+    uint64_t flashWrites = 0U;
+    bool powerCut = false;
+    uint8_t replyMode = REPLY_FULL;
+    uint8_t replySequence = 0U;
+
+    // Broadcast status record, as in bl_multidrop.c
+    uint16_t broadcastFrames = 0U;
+    uint8_t broadcastStatus = COMMAND_SUCCESS;
+    uint8_t failedCommand = 0U;
+    uint32_t failedAddress = 0U;
+};
+
+}
+
+#endif // FAKE_DEVICE_HPP
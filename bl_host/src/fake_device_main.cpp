@@ -0,0 +1,425 @@
+/**
+ *
+ * @file fake_device_main.cpp
+ *
+ * @brief bl_fakedev: serves the bootloader model on a pseudo-terminal so that bl_host can run without hardware.
+ *
+ *        bl_fakedev [--link PATH] [--count N] [--bus N] [--loss P] [--baud N] [--nvm-timing] [--ee-queue] [--no-skip]
+ *                   [--journal] [--no-batch] [--no-compact] [--no-skip-blank] [--cut-at N]
+ *                   [--cut-off MS] [--no-erased-map] [--no-patch] [--secure-key FILE [--no-plaintext]] [--digest]
+ *
+ *        The slave side of each pty is printed on stdout (and symlinked to PATH, or PATH0..PATHn-1
+ *        with --count, when --link is given).
+ *        --count serves N independent devices from one event loop, for exercising bl_host farm.
+ *        --bus puts N multi-drop nodes with addresses 1..N on each pty. Every node hears the host
+ *        and the replies of the other nodes, as on an RS-485 bus.
+ *        --loss drops P percent of the frames at each node, as if corrupted on the wire.
+ *        --baud delays each reply by the time the frame and the reply would take on a UART at N baud.
+ *        --nvm-timing additionally delays by the datasheet erase/write times.
+ *        --ee-queue models BL_EE_QUEUE_ENABLE: EEPROM bytes are programmed while the next frame arrives.
+ *        --no-skip models a bootloader built without BL_SKIP_UNCHANGED_ENABLE.
+ *        --journal models BL_JOURNAL_ENABLE: committed pages are recorded and JOURNAL is served.
+ *        --no-batch models a bootloader built without BL_CMD_BATCH_ENABLE.
+ *        --no-compact models a bootloader built without BL_COMPACT_REPLY_ENABLE.
+ *        --no-skip-blank models a bootloader built without BL_SKIP_BLANK_ENABLE.
+ *        --no-erased-map models a bootloader built without BL_ERASED_MAP_ENABLE.
+ *        --no-patch models a bootloader built without BL_CMD_PATCH_ENABLE.
+ *        --secure-key models BL_CMD_SECURE_WRITE_ENABLE with the key in FILE (32 hex digits) as BL_SECURE_KEY.
+ *        --no-plaintext models BL_PLAINTEXT_FLASH_ENABLE 0: READ_FLASH, WRITE_FLASH and PATCH are left out.
+ *        --digest models BL_CMD_DIGEST_ENABLE: DIGEST replies the SHA-256 of a flash range.
+ *        --cut-at cuts the power of each node during its N-th WRITE_FLASH or SECURE_WRITE frame; the node stays
+ *        silent for MS milliseconds (--cut-off, default 3000) and then comes back with its memories intact.
+ *        A node that is still busy with a frame loses the bytes that arrive meanwhile.
+ */
+
+#include "fake_device.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+volatile std::sig_atomic_t stopRequested = 0;
+
+// One simulated target and the reply it is still "busy" producing
+struct Node
+{
+    blhost::FakeDevice device;
+    std::vector<uint8_t> pending;
+    Clock::time_point busyUntil;
+    // Device time up to which queued EEPROM writes have been accounted for
+    Clock::time_point nvmTime;
+};
+
+// One pty; several nodes share it when it models a multi-drop bus
+struct Endpoint
+{
+    int master = -1;
+    int slave = -1;
+    std::string slavePath;
+    std::string linkPath;
+    std::vector<std::unique_ptr<Node>> nodes;
+};
+
+struct Timing
+{
+    unsigned baudRate = 0U;
+    bool nvm = false;
+    bool eepromQueue = false;
+    bool skipUnchanged = true;
+    bool journal = false;
+    bool batch = true;
+    bool compactReplies = true;
+    bool skipBlank = true;
+    bool erasedMap = true;
+    bool patch = true;
+    bool secureWrite = false;
+    blhost::SecureKey secureKey = blhost::DEVELOPMENT_KEY;
+    bool plaintextFlash = true;
+    bool digest = false;
+    uint64_t cutAtWrite = 0U;
+    unsigned cutOffMs = 3000U;
+};
+
+void OnSignal(int)
+{
+    stopRequested = 1;
+}
+
+void Usage()
+{
+    std::fprintf(stderr, "usage: bl_fakedev [--link PATH] [--count N] [--bus N] [--loss P] [--baud N] [--nvm-timing] [--ee-queue] [--no-skip]\n"
+                         "                  [--journal] [--no-batch] [--no-compact] [--no-skip-blank] [--cut-at N]\n"
+                         "                  [--cut-off MS] [--no-erased-map] [--no-patch] [--secure-key FILE [--no-plaintext]] [--digest]\n");
+}
+
+bool OpenEndpoint(Endpoint &endpoint)
+{
+    endpoint.master = ::posix_openpt(O_RDWR | O_NOCTTY);
+    if ((endpoint.master < 0) || (::grantpt(endpoint.master) != 0) || (::unlockpt(endpoint.master) != 0))
+    {
+        std::perror("posix_openpt");
+        return false;
+    }
+    endpoint.slavePath = ::ptsname(endpoint.master);
+
+    // Hold the slave open in raw mode so the host never sees an echoing line discipline
+    endpoint.slave = ::open(endpoint.slavePath.c_str(), O_RDWR | O_NOCTTY);
+    struct termios tio;
+    ::tcgetattr(endpoint.slave, &tio);
+    ::cfmakeraw(&tio);
+    ::tcsetattr(endpoint.slave, TCSANOW, &tio);
+
+    if (!endpoint.linkPath.empty())
+    {
+        ::unlink(endpoint.linkPath.c_str());
+        if (::symlink(endpoint.slavePath.c_str(), endpoint.linkPath.c_str()) != 0)
+        {
+            std::perror("symlink");
+            return false;
+        }
+    }
+    return true;
+}
+
+void Feed(Endpoint &endpoint, const uint8_t *data, size_t length, const Node *source, const Timing &timing)
+{
+    auto now = Clock::now();
+
+    for (const auto &node : endpoint.nodes)
+    {
+        if ((node.get() == source) || (now < node->busyUntil))
+        {
+            continue;
+        }
+        if (timing.nvm && (now > node->nvmTime))
+        {
+            node->device.Elapse(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(now - node->nvmTime).count()));
+            node->nvmTime = now;
+        }
+        for (size_t i = 0U; i < length; i++)
+        {
+            uint64_t nvmBusyUs = 0U;
+            if (!node->device.Receive(data[i], node->pending, nvmBusyUs))
+            {
+                if (node->device.TakePowerCut())
+                {
+                    std::fprintf(stderr, "bl_fakedev: power cut, node offline for %u ms\n", timing.cutOffMs);
+                    node->busyUntil = now + std::chrono::milliseconds(timing.cutOffMs);
+                    node->nvmTime = node->busyUntil;
+                    break;
+                }
+                continue;
+            }
+
+            uint64_t delayUs = timing.nvm ? nvmBusyUs : 0U;
+            if (timing.baudRate != 0U)
+            {
+                delayUs += ((node->device.FrameLength() + node->pending.size()) * 10U * 1000000U) / timing.baudRate;
+            }
+            node->busyUntil = now + std::chrono::microseconds(delayUs);
+            // The queue already advanced over the NVM part of the delay
+            node->nvmTime = now + std::chrono::microseconds(timing.nvm ? nvmBusyUs : 0U);
+            // The protocol is strictly request/reply, so nothing else for this node arrives in this chunk
+            break;
+        }
+    }
+}
+
+void Flush(Endpoint &endpoint, Node &node, const Timing &timing)
+{
+    std::vector<uint8_t> reply;
+
+    reply.swap(node.pending);
+    for (size_t written = 0U; written < reply.size();)
+    {
+        ssize_t n = ::write(endpoint.master, reply.data() + written, reply.size() - written);
+        if (n > 0)
+        {
+            written += static_cast<size_t>(n);
+        }
+        else if ((n < 0) && (errno != EAGAIN) && (errno != EINTR))
+        {
+            break;
+        }
+    }
+
+    // Everything on the bus is heard by the other nodes
+    Feed(endpoint, reply.data(), reply.size(), &node, timing);
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    std::string linkPath;
+    unsigned count = 1U;
+    unsigned busNodes = 0U;
+    unsigned lossPercent = 0U;
+    Timing timing;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if ((arg == "--link") && ((i + 1) < argc))
+        {
+            linkPath = argv[++i];
+        }
+        else if ((arg == "--count") && ((i + 1) < argc))
+        {
+            count = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 0));
+        }
+        else if ((arg == "--bus") && ((i + 1) < argc))
+        {
+            busNodes = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 0));
+        }
+        else if ((arg == "--loss") && ((i + 1) < argc))
+        {
+            lossPercent = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 0));
+        }
+        else if ((arg == "--baud") && ((i + 1) < argc))
+        {
+            timing.baudRate = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 0));
+        }
+        else if (arg == "--nvm-timing")
+        {
+            timing.nvm = true;
+        }
+        else if (arg == "--ee-queue")
+        {
+            timing.eepromQueue = true;
+        }
+        else if (arg == "--no-skip")
+        {
+            timing.skipUnchanged = false;
+        }
+        else if (arg == "--journal")
+        {
+            timing.journal = true;
+        }
+        else if (arg == "--no-batch")
+        {
+            timing.batch = false;
+        }
+        else if (arg == "--no-compact")
+        {
+            timing.compactReplies = false;
+        }
+        else if (arg == "--no-skip-blank")
+        {
+            timing.skipBlank = false;
+        }
+        else if (arg == "--no-erased-map")
+        {
+            timing.erasedMap = false;
+        }
+        else if (arg == "--no-patch")
+        {
+            timing.patch = false;
+        }
+        else if ((arg == "--secure-key") && ((i + 1) < argc))
+        {
+            try
+            {
+                timing.secureKey = blhost::LoadSecureKey(argv[++i]);
+            }
+            catch (const std::exception &error)
+            {
+                std::fprintf(stderr, "bl_fakedev: %s\n", error.what());
+                return 2;
+            }
+            timing.secureWrite = true;
+        }
+        else if (arg == "--no-plaintext")
+        {
+            timing.plaintextFlash = false;
+        }
+        else if (arg == "--digest")
+        {
+            timing.digest = true;
+        }
+        else if ((arg == "--cut-at") && ((i + 1) < argc))
+        {
+            timing.cutAtWrite = std::strtoull(argv[++i], nullptr, 0);
+        }
+        else if ((arg == "--cut-off") && ((i + 1) < argc))
+        {
+            timing.cutOffMs = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 0));
+        }
+        else
+        {
+            Usage();
+            return 2;
+        }
+    }
+    // As the #error of bl_boot_config.h: the application could not be programmed at all
+    if ((count == 0U) || (busNodes > 254U) || (lossPercent > 100U) || (!timing.plaintextFlash && !timing.secureWrite))
+    {
+        Usage();
+        return 2;
+    }
+
+    std::vector<std::unique_ptr<Endpoint>> endpoints;
+    for (unsigned n = 0U; n < count; n++)
+    {
+        std::unique_ptr<Endpoint> endpoint(new Endpoint());
+        if (!linkPath.empty())
+        {
+            endpoint->linkPath = (count == 1U) ? linkPath : (linkPath + std::to_string(n));
+        }
+        if (!OpenEndpoint(*endpoint))
+        {
+            return 1;
+        }
+
+        unsigned nodes = (busNodes != 0U) ? busNodes : 1U;
+        for (unsigned address = 1U; address <= nodes; address++)
+        {
+            std::unique_ptr<Node> node(new Node());
+            node->device.multidrop = (busNodes != 0U);
+            node->device.node = node->device.multidrop ? static_cast<uint8_t>(address) : blhost::NODE_LOCAL;
+            node->device.lossPercent = lossPercent;
+            node->device.eepromQueue = timing.eepromQueue;
+            node->device.skipUnchanged = timing.skipUnchanged;
+            node->device.journal = timing.journal;
+            node->device.batch = timing.batch;
+            node->device.compactReplies = timing.compactReplies;
+            node->device.skipBlank = timing.skipBlank;
+            node->device.erasedMap = timing.erasedMap;
+            node->device.patch = timing.patch;
+            node->device.secureWrite = timing.secureWrite;
+            node->device.secureKey = timing.secureKey;
+            node->device.plaintextFlash = timing.plaintextFlash;
+            node->device.digest = timing.digest;
+            node->device.cutAtWrite = timing.cutAtWrite;
+            node->device.SeedLoss((n * 256U) + address);
+            endpoint->nodes.push_back(std::move(node));
+        }
+        std::printf("%s\n", endpoint->slavePath.c_str());
+        endpoints.push_back(std::move(endpoint));
+    }
+
+    std::signal(SIGINT, OnSignal);
+    std::signal(SIGTERM, OnSignal);
+    std::fflush(stdout);
+
+    std::vector<struct pollfd> pfds(endpoints.size());
+    while (stopRequested == 0)
+    {
+        int timeoutMs = 200;
+        auto now = Clock::now();
+        for (size_t n = 0U; n < endpoints.size(); n++)
+        {
+            pfds[n] = {endpoints[n]->master, POLLIN, 0};
+            for (const auto &node : endpoints[n]->nodes)
+            {
+                if (!node->pending.empty())
+                {
+                    auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(node->busyUntil - now).count();
+                    timeoutMs = std::min(timeoutMs, static_cast<int>(std::max<long long>(wait, 0)));
+                }
+            }
+        }
+        ::poll(pfds.data(), pfds.size(), timeoutMs);
+
+        for (size_t n = 0U; n < endpoints.size(); n++)
+        {
+            Endpoint &endpoint = *endpoints[n];
+            now = Clock::now();
+            for (const auto &node : endpoint.nodes)
+            {
+                if (!node->pending.empty() && (now >= node->busyUntil))
+                {
+                    Flush(endpoint, *node, timing);
+                }
+            }
+            if ((pfds[n].revents & POLLIN) != 0)
+            {
+                uint8_t chunk[512];
+                ssize_t received = ::read(endpoint.master, chunk, sizeof(chunk));
+                if (received > 0)
+                {
+                    Feed(endpoint, chunk, static_cast<size_t>(received), nullptr, timing);
+                }
+            }
+        }
+    }
+
+    for (const auto &endpoint : endpoints)
+    {
+        for (const auto &node : endpoint->nodes)
+        {
+            const blhost::FakeDeviceStats &stats = node->device.Stats();
+            std::fprintf(stderr, "bl_fakedev %s node %u: %llu frames (%llu broadcast, %llu lost), %llu page erases, "
+                         "%llu page writes, %llu EEPROM byte writes\n",
+                         endpoint->slavePath.c_str(), node->device.node, static_cast<unsigned long long>(stats.frames),
+                         static_cast<unsigned long long>(stats.broadcasts), static_cast<unsigned long long>(stats.framesLost),
+                         static_cast<unsigned long long>(stats.pageErases), static_cast<unsigned long long>(stats.pageWrites),
+                         static_cast<unsigned long long>(stats.eepromWrites));
+        }
+        if (!endpoint->linkPath.empty())
+        {
+            ::unlink(endpoint->linkPath.c_str());
+        }
+        ::close(endpoint->slave);
+        ::close(endpoint->master);
+    }
+    return 0;
+}
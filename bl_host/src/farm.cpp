@@ -0,0 +1,370 @@
+/**
+ *
+ * @file farm.cpp
+ *
+ * @brief Programs one packed image into many devices at once, one state machine per serial port
+ *        driven from a single epoll event loop.
+ */
+
+#include "farm.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+namespace blhost
+{
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+// Error replies are shorter than success replies; this gap ends a reply that may still grow
+constexpr unsigned IDLE_MS = 20U;
+
+double Seconds(Clock::time_point start, Clock::time_point end)
+{
+    return std::chrono::duration<double>(end - start).count();
+}
+
+}
+
+struct Farm::Worker
+{
+    SerialPort port;
+    PortResult result;
+    size_t step = 0U;
+    unsigned attempt = 0U;
+    bool active = false;
+    bool synced = false;
+    std::vector<uint8_t> rx;
+    Clock::time_point start;
+    Clock::time_point deadline;
+    Clock::time_point lastByte;
+};
+
+void FarmReport::Print() const
+{
+    uint64_t payload = 0U;
+    unsigned ok = 0U;
+
+    std::printf("  %-24s %-6s %9s %7s %10s %10s %8s %12s\n", "port", "result", "time[s]", "frames", "tx", "rx", "retries", "payload B/s");
+    for (const PortResult &port : ports)
+    {
+        double rate = (port.seconds > 0.0) ? (static_cast<double>(port.payloadBytes) / port.seconds) : 0.0;
+        std::printf("  %-24s %-6s %9.3f %7llu %10llu %10llu %8llu %12.0f\n", port.port.c_str(), port.ok ? "ok" : "FAIL",
+                    port.seconds, static_cast<unsigned long long>(port.link.frames),
+                    static_cast<unsigned long long>(port.link.bytesTx), static_cast<unsigned long long>(port.link.bytesRx),
+                    static_cast<unsigned long long>(port.link.retries), rate);
+        if (!port.ok)
+        {
+            std::printf("    %s\n", port.error.c_str());
+        }
+        else
+        {
+            ok++;
+            payload += port.payloadBytes;
+        }
+    }
+
+    double rate = (seconds > 0.0) ? (static_cast<double>(payload) / seconds) : 0.0;
+    std::printf("  %u/%zu devices programmed in %.3f s, aggregate %.0f payload B/s\n", ok, ports.size(), seconds, rate);
+}
+
+Farm::Farm(const PackedImage &packed, const FarmOptions &options) : packed(packed), options(options)
+{
+    BuildSteps();
+}
+
+Farm::~Farm()
+{
+    if (epollFd >= 0)
+    {
+        ::close(epollFd);
+    }
+}
+
+void Farm::BuildSteps()
+{
+    const ProgramOptions &program = options.program;
+
+    // Pointers into fixedFrames are kept in steps, so it must never reallocate
+    fixedFrames.reserve(3U);
+    if (program.erase)
+    {
+        uint16_t pages = static_cast<uint16_t>((PROGMEM_SIZE - START_OF_APP) / PROGMEM_PAGE_SIZE);
+        fixedFrames.emplace_back(MakeEraseFlash(START_OF_APP, pages, program.timing));
+        steps.push_back(&fixedFrames.back());
+    }
+    for (const PreparedFrame &prepared : packed.flashFrames)
+    {
+        steps.push_back(&prepared);
+    }
+    for (const PreparedFrame &prepared : packed.eepromFrames)
+    {
+        steps.push_back(&prepared);
+    }
+    for (const PreparedFrame &prepared : packed.configFrames)
+    {
+        steps.push_back(&prepared);
+    }
+    if (program.verify)
+    {
+        fixedFrames.emplace_back(MakeCalcChecksum(START_OF_APP, PROGMEM_SIZE - START_OF_APP));
+        steps.push_back(&fixedFrames.back());
+    }
+    if (program.reset)
+    {
+        fixedFrames.emplace_back(MakeResetDevice());
+        steps.push_back(&fixedFrames.back());
+    }
+}
+
+FarmReport Farm::Run(const std::vector<std::string> &ports)
+{
+    FarmReport report;
+    auto start = Clock::now();
+
+    epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0)
+    {
+        throw std::runtime_error(std::string("epoll_create1: ") + std::strerror(errno));
+    }
+
+    for (const std::string &path : ports)
+    {
+        std::unique_ptr<Worker> worker(new Worker());
+        worker->result.port = path;
+        try
+        {
+            worker->port.Open(path, options.baudRate);
+        }
+        catch (const std::exception &error)
+        {
+            worker->result.error = error.what();
+            workers.push_back(std::move(worker));
+            continue;
+        }
+
+        struct epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.ptr = worker.get();
+        ::epoll_ctl(epollFd, EPOLL_CTL_ADD, worker->port.Descriptor(), &event);
+        workers.push_back(std::move(worker));
+        Start(*workers.back());
+    }
+
+    for (;;)
+    {
+        Clock::time_point next = Clock::time_point::max();
+        bool anyActive = false;
+        for (const auto &worker : workers)
+        {
+            if (worker->active)
+            {
+                anyActive = true;
+                next = std::min(next, worker->deadline);
+                if (worker->rx.size() > BL_HEADER)
+                {
+                    next = std::min(next, worker->lastByte + std::chrono::milliseconds(IDLE_MS));
+                }
+            }
+        }
+        if (!anyActive)
+        {
+            break;
+        }
+
+        auto now = Clock::now();
+        int waitMs = (next <= now) ? 0 : static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(next - now).count() + 1);
+        struct epoll_event events[32];
+        int count = ::epoll_wait(epollFd, events, 32, waitMs);
+        if ((count < 0) && (errno != EINTR))
+        {
+            throw std::runtime_error(std::string("epoll_wait: ") + std::strerror(errno));
+        }
+        for (int i = 0; i < count; i++)
+        {
+            Worker &worker = *static_cast<Worker *>(events[i].data.ptr);
+            if (worker.active)
+            {
+                OnReadable(worker);
+            }
+        }
+
+        now = Clock::now();
+        for (const auto &worker : workers)
+        {
+            if (!worker->active)
+            {
+                continue;
+            }
+            bool idle = (worker->rx.size() > BL_HEADER) && (now >= (worker->lastByte + std::chrono::milliseconds(IDLE_MS)));
+            if (idle)
+            {
+                Complete(*worker);
+            }
+            else if (now >= worker->deadline)
+            {
+                OnTimeout(*worker);
+            }
+        }
+    }
+
+    for (const auto &worker : workers)
+    {
+        report.ports.push_back(worker->result);
+    }
+    report.seconds = Seconds(start, Clock::now());
+    return report;
+}
+
+void Farm::Start(Worker &worker)
+{
+    worker.active = true;
+    worker.step = 0U;
+    worker.start = Clock::now();
+    Send(worker);
+}
+
+void Farm::Send(Worker &worker)
+{
+    const PreparedFrame &prepared = *steps[worker.step];
+
+    worker.rx.clear();
+    worker.synced = false;
+    try
+    {
+        worker.port.Write(prepared.wire.data(), prepared.wire.size());
+    }
+    catch (const std::exception &error)
+    {
+        Fail(worker, error.what());
+        return;
+    }
+    worker.result.link.frames++;
+    worker.result.link.bytesTx += prepared.wire.size();
+    worker.deadline = Clock::now() + std::chrono::milliseconds(prepared.frame.timeoutMs + options.extraTimeoutMs);
+}
+
+void Farm::OnReadable(Worker &worker)
+{
+    const Frame &frame = steps[worker.step]->frame;
+    uint8_t chunk[512];
+    ssize_t count = ::read(worker.port.Descriptor(), chunk, sizeof(chunk));
+
+    if (count <= 0)
+    {
+        if ((count < 0) && (errno != EAGAIN) && (errno != EINTR))
+        {
+            Fail(worker, std::string("read: ") + std::strerror(errno));
+        }
+        return;
+    }
+
+    worker.result.link.bytesRx += static_cast<uint64_t>(count);
+    worker.lastByte = Clock::now();
+    for (ssize_t i = 0; i < count; i++)
+    {
+        if (!worker.synced)
+        {
+            worker.synced = (chunk[i] == STX);
+        }
+        else
+        {
+            worker.rx.push_back(chunk[i]);
+        }
+    }
+
+    size_t expected = (frame.expectedReplyLength != 0U) ? frame.expectedReplyLength : (BL_HEADER + 1U);
+    if (worker.rx.size() >= expected)
+    {
+        Complete(worker);
+    }
+    else if ((worker.rx.size() > BL_HEADER) && (frame.command != CALC_CHECKSUM) && (frame.command != READ_VERSION)
+             && (worker.rx[BL_HEADER] != COMMAND_SUCCESS))
+    {
+        // Error replies carry only the status byte
+        Complete(worker);
+    }
+}
+
+void Farm::OnTimeout(Worker &worker)
+{
+    if (worker.attempt >= options.retries)
+    {
+        Fail(worker, "no reply to " + CommandName(steps[worker.step]->frame.command) + " after "
+                         + std::to_string(worker.attempt + 1U) + " attempt(s)");
+        return;
+    }
+
+    worker.attempt++;
+    worker.result.timeouts++;
+    worker.result.link.retries++;
+    worker.port.Flush();
+    Send(worker);
+}
+
+void Farm::Complete(Worker &worker)
+{
+    const PreparedFrame &prepared = *steps[worker.step];
+    Reply reply;
+
+    reply.bytes = worker.rx;
+    if (!reply.Valid() || (reply.Command() != prepared.frame.command))
+    {
+        OnTimeout(worker);
+        return;
+    }
+
+    if (prepared.frame.command == CALC_CHECKSUM)
+    {
+        uint16_t checksum = (reply.DataLength() >= 2U) ? static_cast<uint16_t>(reply.Data()[0] | (reply.Data()[1] << 8U)) : 0U;
+        if ((reply.DataLength() < 2U) || (checksum != packed.expectedChecksum))
+        {
+            char message[64];
+            std::snprintf(message, sizeof(message), "verify: device checksum 0x%04X, expected 0x%04X", checksum, packed.expectedChecksum);
+            Fail(worker, message);
+            return;
+        }
+    }
+    else if (reply.Status() != COMMAND_SUCCESS)
+    {
+        char message[80];
+        std::snprintf(message, sizeof(message), "%s 0x%06X: %s", CommandName(prepared.frame.command).c_str(),
+                      prepared.frame.address, StatusName(reply.Status()).c_str());
+        Fail(worker, message);
+        return;
+    }
+
+    worker.result.payloadBytes += prepared.frame.data.size();
+    worker.attempt = 0U;
+    worker.step++;
+    if (worker.step == steps.size())
+    {
+        worker.active = false;
+        worker.result.ok = true;
+        worker.result.seconds = Seconds(worker.start, Clock::now());
+        worker.port.Close();
+        return;
+    }
+    Send(worker);
+}
+
+void Farm::Fail(Worker &worker, const std::string &error)
+{
+    worker.active = false;
+    worker.result.ok = false;
+    worker.result.error = error;
+    worker.result.seconds = Seconds(worker.start, Clock::now());
+    worker.port.Close();
+}
+
+}
@@ -0,0 +1,82 @@
+/**
+ *
+ * @file farm.hpp
+ *
+ * @brief Programs one packed image into many devices at once, one state machine per serial port
+ *        driven from a single epoll event loop.
+ */
+
+#ifndef FARM_HPP
+#define FARM_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "programmer.hpp"
+#include "serial_port.hpp"
+
+namespace blhost
+{
+
+struct FarmOptions
+{
+    unsigned baudRate = 115200U;
+    /** Resends of one frame before the port is given up. */
+    unsigned retries = 2U;
+    /** Added to every frame timeout, e.g. for USB-serial latency. */
+    unsigned extraTimeoutMs = 0U;
+    ProgramOptions program;
+};
+
+struct PortResult
+{
+    std::string port;
+    bool ok = false;
+    std::string error;
+    double seconds = 0.0;
+    LinkStats link;
+    uint64_t payloadBytes = 0U;
+    uint64_t timeouts = 0U;
+};
+
+struct FarmReport
+{
+    std::vector<PortResult> ports;
+    double seconds = 0.0;
+
+    void Print() const;
+};
+
+class Farm
+{
+public:
+    Farm(const PackedImage &packed, const FarmOptions &options);
+    ~Farm();
+
+    /** Opens every port and runs all of them to completion. */
+    FarmReport Run(const std::vector<std::string> &ports);
+
+private:
+    struct Worker;
+
+    void BuildSteps();
+    void Start(Worker &worker);
+    void Send(Worker &worker);
+    void OnReadable(Worker &worker);
+    void OnTimeout(Worker &worker);
+    void Complete(Worker &worker);
+    void Fail(Worker &worker, const std::string &error);
+
+    const PackedImage &packed;
+    FarmOptions options;
+    std::vector<PreparedFrame> fixedFrames;
+    std::vector<const PreparedFrame *> steps;
+    std::vector<std::unique_ptr<Worker>> workers;
+    int epollFd = -1;
+};
+
+}
+
+#endif // FARM_HPP
@@ -0,0 +1,241 @@
+/**
+ *
+ * @file golden.cpp
+ *
+ * @brief Builds the compressed golden image (bl_golden.h) and models its restore by the bootloader,
+ *        counting the NVM operations and flash reads of the restore path.
+ */
+
+#include "golden.hpp"
+
+#include <algorithm>
+
+namespace blhost
+{
+
+namespace
+{
+
+constexpr size_t WINDOW = 4096U;
+constexpr size_t MATCH_MIN = 3U;
+constexpr size_t MATCH_EXTENDED = MATCH_MIN + 15U;
+constexpr size_t MATCH_MAX = MATCH_EXTENDED + 255U;
+/** Candidates tried per position; enough for code and fill, and keeps a full image under a second. */
+constexpr unsigned CHAIN_LIMIT = 512U;
+
+void Put32(std::vector<uint8_t> &data, uint32_t value)
+{
+    for (unsigned i = 0U; i < 4U; i++)
+    {
+        data.push_back(static_cast<uint8_t>(value >> (8U * i)));
+    }
+}
+
+}
+
+std::vector<uint8_t> GoldenCompress(const std::vector<uint8_t> &image)
+{
+    std::vector<uint8_t> stream;
+    std::vector<int32_t> head(0x10000U, -1);
+    std::vector<int32_t> previous(image.size(), -1);
+    size_t flagsAt = 0U;
+    unsigned item = 8U;
+    size_t position = 0U;
+
+    auto hash = [&](size_t at) {
+        return static_cast<size_t>(((image[at] << 8U) ^ (image[at + 1U] << 4U) ^ image[at + 2U]) & 0xFFFFU);
+    };
+    auto insert = [&](size_t at) {
+        if ((at + MATCH_MIN) <= image.size())
+        {
+            size_t key = hash(at);
+            previous[at] = head[key];
+            head[key] = static_cast<int32_t>(at);
+        }
+    };
+
+    while (position < image.size())
+    {
+        if (item == 8U)
+        {
+            flagsAt = stream.size();
+            stream.push_back(0x00U);
+            item = 0U;
+        }
+
+        size_t bestLength = 0U;
+        size_t bestDistance = 0U;
+        if ((position + MATCH_MIN) <= image.size())
+        {
+            size_t limit = std::min(MATCH_MAX, image.size() - position);
+            unsigned tries = 0U;
+            for (int32_t candidate = head[hash(position)];
+                 (candidate >= 0) && ((position - static_cast<size_t>(candidate)) <= WINDOW) && (tries < CHAIN_LIMIT);
+                 candidate = previous[static_cast<size_t>(candidate)], tries++)
+            {
+                // Matches may overlap the bytes they produce, as the decoder copies one byte at a time
+                size_t length = 0U;
+                while ((length < limit) && (image[static_cast<size_t>(candidate) + length] == image[position + length]))
+                {
+                    length++;
+                }
+                if (length > bestLength)
+                {
+                    bestLength = length;
+                    bestDistance = position - static_cast<size_t>(candidate);
+                    if (length == limit)
+                    {
+                        break;
+                    }
+                }
+            }
+        }
+
+        if (bestLength >= MATCH_MIN)
+        {
+            size_t code = std::min(bestLength - MATCH_MIN, static_cast<size_t>(15U));
+            uint16_t token = static_cast<uint16_t>(((bestDistance - 1U) << 4U) | code);
+            stream.push_back(static_cast<uint8_t>(token));
+            stream.push_back(static_cast<uint8_t>(token >> 8U));
+            if (bestLength >= MATCH_EXTENDED)
+            {
+                stream.push_back(static_cast<uint8_t>(bestLength - MATCH_EXTENDED));
+            }
+            for (size_t i = 0U; i < bestLength; i++)
+            {
+                insert(position + i);
+            }
+            position += bestLength;
+        }
+        else
+        {
+            stream[flagsAt] = static_cast<uint8_t>(stream[flagsAt] | (1U << item));
+            stream.push_back(image[position]);
+            insert(position);
+            position++;
+        }
+        item++;
+    }
+    return stream;
+}
+
+std::vector<uint8_t> GoldenBlob(const std::vector<uint8_t> &image, uint16_t unlockKey)
+{
+    std::vector<uint8_t> stream = GoldenCompress(image);
+    std::vector<uint8_t> blob;
+    uint16_t sum = 0U;
+
+    for (uint8_t byte : stream)
+    {
+        sum = static_cast<uint16_t>(sum + byte);
+    }
+    blob.push_back(static_cast<uint8_t>(GOLDEN_MAGIC));
+    blob.push_back(static_cast<uint8_t>(GOLDEN_MAGIC >> 8U));
+    blob.push_back(GOLDEN_FORMAT);
+    blob.push_back(0xFFU);
+    blob.push_back(static_cast<uint8_t>(unlockKey));
+    blob.push_back(static_cast<uint8_t>(unlockKey >> 8U));
+    blob.push_back(static_cast<uint8_t>(sum));
+    blob.push_back(static_cast<uint8_t>(sum >> 8U));
+    Put32(blob, static_cast<uint32_t>(stream.size()));
+    Put32(blob, static_cast<uint32_t>(image.size()));
+    blob.insert(blob.end(), stream.begin(), stream.end());
+    return blob;
+}
+
+RestoreCounts GoldenRestore(SlotNvm &nvm, uint32_t goldenAddress)
+{
+    RestoreCounts counts;
+    uint8_t page[PROGMEM_PAGE_SIZE];
+    uint32_t out = START_OF_APP;
+    bool ok = true;
+
+    auto read = [&](uint32_t address) {
+        counts.flashReads++;
+        return nvm.FlashRead(address);
+    };
+    auto read16 = [&](uint32_t address) { return static_cast<uint16_t>(read(address) | (read(address + 1U) << 8U)); };
+    auto read32 = [&](uint32_t address) { return static_cast<uint32_t>(read16(address) | (read16(address + 2U) << 16U)); };
+    auto put = [&](uint8_t data) {
+        page[out % PROGMEM_PAGE_SIZE] = data;
+        out++;
+        if ((out % PROGMEM_PAGE_SIZE) == 0U)
+        {
+            uint32_t pageAddress = out - PROGMEM_PAGE_SIZE;
+            bool changed = false;
+            for (uint32_t offset = 0U; offset < PROGMEM_PAGE_SIZE; offset++)
+            {
+                changed = (page[offset] != read(pageAddress + offset)) || changed;
+            }
+            if (changed)
+            {
+                nvm.FlashPageErase(pageAddress);
+                nvm.FlashRowWrite(pageAddress, page);
+                counts.pagesWritten++;
+            }
+        }
+    };
+    auto get = [&](uint32_t address) {
+        return (address >= (out & ~(PROGMEM_PAGE_SIZE - 1U))) ? page[address % PROGMEM_PAGE_SIZE] : read(address);
+    };
+
+    uint32_t in = goldenAddress + GOLDEN_HEADER_SIZE;
+    uint32_t streamLength = read32(goldenAddress + 8U);
+    uint32_t end = in + streamLength;
+    if ((read16(goldenAddress) != GOLDEN_MAGIC) || (read(goldenAddress + 2U) != GOLDEN_FORMAT)
+            || (read32(goldenAddress + 12U) != (goldenAddress - START_OF_APP))
+            || (streamLength > (PROGMEM_SIZE - goldenAddress - GOLDEN_HEADER_SIZE)))
+    {
+        counts.result = BL_GOLDEN_MISSING;
+        return counts;
+    }
+    uint16_t sum = 0U;
+    for (uint32_t address = in; address < end; address++)
+    {
+        sum = static_cast<uint16_t>(sum + read(address));
+    }
+    if (sum != read16(goldenAddress + 6U))
+    {
+        counts.result = BL_GOLDEN_MISSING;
+        return counts;
+    }
+
+    while (ok && (in < end) && (out < goldenAddress))
+    {
+        uint8_t flags = read(in++);
+        for (unsigned item = 0U; (item < 8U) && (in < end) && (out < goldenAddress); item++)
+        {
+            if ((flags & 0x01U) != 0U)
+            {
+                put(read(in++));
+            }
+            else
+            {
+                uint16_t token = read16(in);
+                in += 2U;
+                unsigned length = (token & 0x0FU) + MATCH_MIN;
+                if ((token & 0x0FU) == 0x0FU)
+                {
+                    length += read(in++);
+                }
+                uint32_t source = out - ((token >> 4U) + 1U);
+                if (source < START_OF_APP)
+                {
+                    ok = false;
+                    break;
+                }
+                while ((length > 0U) && (out < goldenAddress))
+                {
+                    put(get(source++));
+                    length--;
+                }
+            }
+            flags = static_cast<uint8_t>(flags >> 1U);
+        }
+    }
+
+    counts.result = (out == goldenAddress) ? BL_GOLDEN_RESTORED : BL_GOLDEN_FAILED;
+    return counts;
+}
+
+}
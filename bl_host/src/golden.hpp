@@ -0,0 +1,47 @@
+/**
+ *
+ * @file golden.hpp
+ *
+ * @brief Builds the compressed golden image (bl_golden.h) and models its restore by the bootloader,
+ *        counting the NVM operations and flash reads of the restore path.
+ */
+
+#ifndef GOLDEN_HPP
+#define GOLDEN_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "bl_protocol.hpp"
+#include "slot_install.hpp"
+
+namespace blhost
+{
+
+/** Defaults of BL_GOLDEN_ADDRESS (bl_boot_config.h) and the header of bl_golden.h. */
+constexpr uint32_t GOLDEN_ADDRESS = 0x18000U;
+constexpr uint16_t GOLDEN_MAGIC = 0x601DU;
+constexpr uint8_t GOLDEN_FORMAT = 0x01U;
+constexpr size_t GOLDEN_HEADER_SIZE = 16U;
+
+/** LZSS stream of bl_golden.c: 4096 byte window, matches of 3 to 273 bytes. */
+std::vector<uint8_t> GoldenCompress(const std::vector<uint8_t> &image);
+
+/** Header and stream, as stored at the golden address. */
+std::vector<uint8_t> GoldenBlob(const std::vector<uint8_t> &image, uint16_t unlockKey);
+
+struct RestoreCounts
+{
+    uint8_t result = BL_GOLDEN_MISSING;
+    unsigned pagesWritten = 0U;
+    /** FLASH_Read calls of the restore: header, stream sum, stream, back-references and page compares. */
+    uint64_t flashReads = 0U;
+};
+
+/** Same algorithm as BL_GoldenRestore, on the flash of nvm; the golden address is where the blob is stored. */
+RestoreCounts GoldenRestore(SlotNvm &nvm, uint32_t goldenAddress);
+
+}
+
+#endif // GOLDEN_HPP
@@ -0,0 +1,188 @@
+/**
+ *
+ * @file golden_main.cpp
+ *
+ * @brief bl_golden: builds the compressed golden recovery image (BL_GOLDEN_ENABLE) and merges it into an application HEX file.
+ *
+ *        bl_golden APP.hex -o OUT.hex [--golden GOLDEN.hex] [--golden-address N] [--key N] [--read-us X]
+ *
+ *        The golden image is the application of GOLDEN.hex, or of APP.hex when no separate one is given. It must lie
+ *        below the golden address, which is also where the compressed blob is placed in OUT.hex. The restore of the
+ *        bootloader is then replayed on a model of the flash for an erased and for a partly damaged application,
+ *        and its duration is estimated from the worst-case NVM timings and the given time per FLASH_Read call.
+ */
+
+#include "golden.hpp"
+#include "hex_file.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+struct Options
+{
+    std::string appPath;
+    std::string goldenPath;
+    std::string outPath;
+    uint32_t goldenAddress = blhost::GOLDEN_ADDRESS;
+    uint16_t key = blhost::UNLOCK_KEY;
+    /** Assumed time of one FLASH_Read call (TBLRD plus call overhead) at 64 MHz; not measured. */
+    double readUs = 1.0;
+};
+
+void Usage()
+{
+    std::fprintf(stderr, "usage: bl_golden APP.hex -o OUT.hex [--golden GOLDEN.hex] [--golden-address N] [--key N] [--read-us X]\n");
+}
+
+/** Restore of the given application area, and the two BL_bootVerify passes around it. */
+void Scenario(const Options &options, const std::vector<uint8_t> &blob, const std::vector<uint8_t> &image,
+              const std::string &label, const std::vector<uint32_t> &damagedPages)
+{
+    blhost::SlotNvm nvm;
+    blhost::NvmTiming timing;
+
+    std::copy(image.begin(), image.end(), nvm.flash.begin() + blhost::START_OF_APP);
+    std::copy(blob.begin(), blob.end(), nvm.flash.begin() + options.goldenAddress);
+    if (damagedPages.empty())
+    {
+        std::fill(nvm.flash.begin() + blhost::START_OF_APP, nvm.flash.begin() + options.goldenAddress, 0xFFU);
+    }
+    for (uint32_t page : damagedPages)
+    {
+        std::fill_n(nvm.flash.begin() + page, blhost::PROGMEM_PAGE_SIZE, 0xFFU);
+    }
+
+    blhost::RestoreCounts counts = blhost::GoldenRestore(nvm, options.goldenAddress);
+    bool match = std::equal(image.begin(), image.end(), nvm.flash.begin() + blhost::START_OF_APP);
+    uint64_t verifyReads = 2U * (options.goldenAddress - blhost::START_OF_APP);
+    double nvmSeconds = nvm.counts.Seconds(timing);
+    double readSeconds = static_cast<double>(counts.flashReads + verifyReads) * options.readUs / 1e6;
+
+    std::printf("%s: %s, %u page(s) written, %.3f s NVM + %.3f s reads (%llu restore and %llu verify reads) = %.3f s%s\n",
+                label.c_str(), blhost::GoldenResultName(counts.result).c_str(), counts.pagesWritten, nvmSeconds, readSeconds,
+                static_cast<unsigned long long>(counts.flashReads), static_cast<unsigned long long>(verifyReads),
+                nvmSeconds + readSeconds, match ? "" : " (MISMATCH)");
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if ((arg[0] != '-') && options.appPath.empty())
+        {
+            options.appPath = arg;
+            continue;
+        }
+        if ((i + 1) >= argc)
+        {
+            Usage();
+            return 2;
+        }
+        std::string value = argv[++i];
+        if (arg == "-o")
+        {
+            options.outPath = value;
+        }
+        else if (arg == "--golden")
+        {
+            options.goldenPath = value;
+        }
+        else if (arg == "--golden-address")
+        {
+            options.goldenAddress = static_cast<uint32_t>(std::strtoul(value.c_str(), nullptr, 0));
+        }
+        else if (arg == "--key")
+        {
+            options.key = static_cast<uint16_t>(std::strtoul(value.c_str(), nullptr, 0));
+        }
+        else if (arg == "--read-us")
+        {
+            options.readUs = std::strtod(value.c_str(), nullptr);
+        }
+        else
+        {
+            Usage();
+            return 2;
+        }
+    }
+    if (options.appPath.empty() || options.outPath.empty() || (options.goldenAddress <= blhost::START_OF_APP)
+            || (options.goldenAddress >= blhost::PROGMEM_SIZE) || ((options.goldenAddress % blhost::PROGMEM_PAGE_SIZE) != 0U))
+    {
+        Usage();
+        return 2;
+    }
+
+    try
+    {
+        blhost::MemoryImage app = blhost::MemoryImage::FromHexFile(options.appPath);
+        blhost::MemoryImage golden =
+            options.goldenPath.empty() ? app : blhost::MemoryImage::FromHexFile(options.goldenPath);
+
+        // The restore writes the whole area below the golden address, so nothing of the golden image may lie above it
+        if (!golden.PagesIn(options.goldenAddress, blhost::PROGMEM_SIZE).empty()
+                || !app.PagesIn(options.goldenAddress, blhost::PROGMEM_SIZE).empty())
+        {
+            std::fprintf(stderr, "bl_golden: application data at or above the golden address 0x%05X\n", options.goldenAddress);
+            return 1;
+        }
+
+        std::vector<uint8_t> image = golden.Flatten(blhost::START_OF_APP, options.goldenAddress);
+        std::vector<uint8_t> blob = blhost::GoldenBlob(image, options.key);
+        if (blob.size() > (blhost::PROGMEM_SIZE - options.goldenAddress))
+        {
+            std::fprintf(stderr, "bl_golden: the blob needs %zu bytes, only %u are left above 0x%05X\n", blob.size(),
+                         blhost::PROGMEM_SIZE - options.goldenAddress, options.goldenAddress);
+            return 1;
+        }
+
+        for (size_t i = 0U; i < blob.size(); i++)
+        {
+            app.Set(options.goldenAddress + static_cast<uint32_t>(i), blob[i]);
+        }
+        std::ofstream out(options.outPath, std::ios::binary);
+        out << app.ToHexText();
+        if (!out)
+        {
+            std::fprintf(stderr, "bl_golden: cannot write %s\n", options.outPath.c_str());
+            return 1;
+        }
+
+        std::printf("golden image 0x%05X-0x%05X: %zu bytes compressed to %zu (%.1f %%), blob 0x%05X-0x%05zX\n",
+                    blhost::START_OF_APP, options.goldenAddress - 1U, image.size(), blob.size() - blhost::GOLDEN_HEADER_SIZE,
+                    100.0 * static_cast<double>(blob.size() - blhost::GOLDEN_HEADER_SIZE) / static_cast<double>(image.size()),
+                    options.goldenAddress, options.goldenAddress + blob.size() - 1U);
+        std::printf("restore timing (page erase/write %u/%u us, %.2f us per FLASH_Read assumed):\n",
+                    blhost::NvmTiming().pageEraseUs, blhost::NvmTiming().pageWriteUs, options.readUs);
+
+        std::vector<uint32_t> damaged;
+        for (uint32_t page : golden.PagesIn(blhost::START_OF_APP, options.goldenAddress))
+        {
+            damaged.push_back(page);
+            break;
+        }
+        if (damaged.empty())
+        {
+            damaged.push_back(blhost::START_OF_APP);
+        }
+        Scenario(options, blob, image, "  erased application", {});
+        Scenario(options, blob, image, "  one damaged page   ", damaged);
+        return 0;
+    }
+    catch (const std::exception &error)
+    {
+        std::fprintf(stderr, "bl_golden: %s\n", error.what());
+        return 1;
+    }
+}
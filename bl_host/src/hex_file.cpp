@@ -0,0 +1,273 @@
+/**
+ *
+ * @file hex_file.cpp
+ *
+ * @brief Intel HEX parser and page-organised memory image.
+ */
+
+#include "hex_file.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace blhost
+{
+
+namespace
+{
+
+const Page BLANK_PAGE;
+
+uint8_t HexByte(const std::string &line, size_t position, unsigned lineNumber)
+{
+    if ((position + 2U) > line.size())
+    {
+        throw std::runtime_error("HEX line " + std::to_string(lineNumber) + ": record truncated");
+    }
+
+    unsigned value = 0U;
+    for (size_t i = position; i < (position + 2U); i++)
+    {
+        char c = line[i];
+        value <<= 4U;
+        if ((c >= '0') && (c <= '9'))
+        {
+            value |= static_cast<unsigned>(c - '0');
+        }
+        else if ((c >= 'A') && (c <= 'F'))
+        {
+            value |= static_cast<unsigned>(c - 'A' + 10);
+        }
+        else if ((c >= 'a') && (c <= 'f'))
+        {
+            value |= static_cast<unsigned>(c - 'a' + 10);
+        }
+        else
+        {
+            throw std::runtime_error("HEX line " + std::to_string(lineNumber) + ": invalid digit");
+        }
+    }
+    return static_cast<uint8_t>(value);
+}
+
+}
+
+bool Page::IsBlank() const
+{
+    for (uint8_t value : data)
+    {
+        if (value != 0xFFU)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+MemoryImage MemoryImage::FromHexFile(const std::string &path)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        throw std::runtime_error("cannot open " + path);
+    }
+
+    std::stringstream text;
+    text << file.rdbuf();
+    return FromHexText(text.str());
+}
+
+MemoryImage MemoryImage::FromHexText(const std::string &text)
+{
+    MemoryImage image;
+    std::istringstream lines(text);
+    std::string line;
+    uint32_t baseAddress = 0U;
+    unsigned lineNumber = 0U;
+    bool endSeen = false;
+
+    while (std::getline(lines, line) && !endSeen)
+    {
+        lineNumber++;
+        while (!line.empty() && ((line.back() == '\r') || (line.back() == ' ')))
+        {
+            line.pop_back();
+        }
+        if (line.empty())
+        {
+            continue;
+        }
+        if (line[0] != ':')
+        {
+            throw std::runtime_error("HEX line " + std::to_string(lineNumber) + ": missing ':'");
+        }
+
+        uint8_t count = HexByte(line, 1U, lineNumber);
+        uint16_t offset = static_cast<uint16_t>((HexByte(line, 3U, lineNumber) << 8U) | HexByte(line, 5U, lineNumber));
+        uint8_t type = HexByte(line, 7U, lineNumber);
+        uint8_t sum = static_cast<uint8_t>(count + (offset >> 8U) + offset + type);
+        std::vector<uint8_t> bytes(count);
+
+        for (size_t i = 0U; i < count; i++)
+        {
+            bytes[i] = HexByte(line, 9U + (2U * i), lineNumber);
+            sum = static_cast<uint8_t>(sum + bytes[i]);
+        }
+        sum = static_cast<uint8_t>(sum + HexByte(line, 9U + (2U * count), lineNumber));
+        if (sum != 0U)
+        {
+            throw std::runtime_error("HEX line " + std::to_string(lineNumber) + ": checksum mismatch");
+        }
+
+        switch (type)
+        {
+        case 0x00U:
+            for (size_t i = 0U; i < count; i++)
+            {
+                image.Set(baseAddress + offset + static_cast<uint32_t>(i), bytes[i]);
+            }
+            break;
+        case 0x01U:
+            endSeen = true;
+            break;
+        case 0x02U:
+            baseAddress = static_cast<uint32_t>((bytes.at(0) << 8U) | bytes.at(1)) << 4U;
+            break;
+        case 0x04U:
+            baseAddress = static_cast<uint32_t>((bytes.at(0) << 8U) | bytes.at(1)) << 16U;
+            break;
+        case 0x03U:
+        case 0x05U:
+            // Start address records carry no memory content
+            break;
+        default:
+            throw std::runtime_error("HEX line " + std::to_string(lineNumber) + ": unsupported record type");
+        }
+    }
+
+    return image;
+}
+
+void MemoryImage::Set(uint32_t address, uint8_t value)
+{
+    Page &page = pages[address & ~(PROGMEM_PAGE_SIZE - 1U)];
+    uint32_t offset = address & (PROGMEM_PAGE_SIZE - 1U);
+
+    page.data[offset] = value;
+    page.present.set(offset);
+}
+
+uint8_t MemoryImage::Get(uint32_t address) const
+{
+    return PageAt(address & ~(PROGMEM_PAGE_SIZE - 1U)).data[address & (PROGMEM_PAGE_SIZE - 1U)];
+}
+
+std::vector<uint32_t> MemoryImage::PagesIn(uint32_t start, uint32_t end) const
+{
+    std::vector<uint32_t> result;
+
+    for (auto it = pages.lower_bound(start & ~(PROGMEM_PAGE_SIZE - 1U)); (it != pages.end()) && (it->first < end); ++it)
+    {
+        result.push_back(it->first);
+    }
+    return result;
+}
+
+const Page &MemoryImage::PageAt(uint32_t pageAddress) const
+{
+    auto it = pages.find(pageAddress);
+    return (it == pages.end()) ? BLANK_PAGE : it->second;
+}
+
+std::vector<std::pair<uint32_t, std::vector<uint8_t>>> MemoryImage::RunsIn(uint32_t start, uint32_t end, size_t maxRun) const
+{
+    std::vector<std::pair<uint32_t, std::vector<uint8_t>>> runs;
+
+    for (uint32_t pageAddress : PagesIn(start, end))
+    {
+        const Page &page = pages.at(pageAddress);
+        for (uint32_t offset = 0U; offset < PROGMEM_PAGE_SIZE; offset++)
+        {
+            uint32_t address = pageAddress + offset;
+            if ((address < start) || (address >= end) || !page.present.test(offset))
+            {
+                continue;
+            }
+            if (runs.empty()
+                    || ((runs.back().first + runs.back().second.size()) != address)
+                    || (runs.back().second.size() >= maxRun))
+            {
+                runs.emplace_back(address, std::vector<uint8_t>());
+            }
+            runs.back().second.push_back(page.data[offset]);
+        }
+    }
+    return runs;
+}
+
+std::vector<uint8_t> MemoryImage::Flatten(uint32_t start, uint32_t end) const
+{
+    std::vector<uint8_t> flat(end - start, 0xFFU);
+
+    for (uint32_t pageAddress : PagesIn(start, end))
+    {
+        const Page &page = pages.at(pageAddress);
+        for (uint32_t offset = 0U; offset < PROGMEM_PAGE_SIZE; offset++)
+        {
+            uint32_t address = pageAddress + offset;
+            if ((address >= start) && (address < end))
+            {
+                flat[address - start] = page.data[offset];
+            }
+        }
+    }
+    return flat;
+}
+
+std::string MemoryImage::ToHexText() const
+{
+    std::string text;
+    uint32_t upper = 0U;
+    char field[16];
+
+    auto record = [&](uint8_t type, uint16_t address, const uint8_t *data, size_t length) {
+        uint8_t sum = static_cast<uint8_t>(length + (address >> 8U) + address + type);
+        std::snprintf(field, sizeof(field), ":%02X%04X%02X", static_cast<unsigned>(length), address, type);
+        text += field;
+        for (size_t i = 0U; i < length; i++)
+        {
+            std::snprintf(field, sizeof(field), "%02X", data[i]);
+            text += field;
+            sum = static_cast<uint8_t>(sum + data[i]);
+        }
+        std::snprintf(field, sizeof(field), "%02X\n", static_cast<uint8_t>(0x100U - sum) & 0xFFU);
+        text += field;
+    };
+
+    for (const auto &run : RunsIn(0U, 0xFFFFFFFFU, 16U))
+    {
+        uint32_t address = run.first;
+        size_t done = 0U;
+        while (done < run.second.size())
+        {
+            // A record never crosses a 64 KB boundary
+            size_t length = std::min<size_t>(run.second.size() - done, 0x10000U - (address & 0xFFFFU));
+            if ((address >> 16U) != upper)
+            {
+                upper = address >> 16U;
+                const uint8_t extended[2] = {static_cast<uint8_t>(upper >> 8U), static_cast<uint8_t>(upper)};
+                record(0x04U, 0U, extended, sizeof(extended));
+            }
+            record(0x00U, static_cast<uint16_t>(address), &run.second[done], length);
+            done += length;
+            address += static_cast<uint32_t>(length);
+        }
+    }
+    record(0x01U, 0U, nullptr, 0U);
+    return text;
+}
+
+}
@@ -0,0 +1,71 @@
+/**
+ *
+ * @file hex_file.hpp
+ *
+ * @brief Intel HEX parser and page-organised memory image.
+ */
+
+#ifndef HEX_FILE_HPP
+#define HEX_FILE_HPP
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "bl_protocol.hpp"
+
+namespace blhost
+{
+
+/**
+ * @brief One PROGMEM_PAGE_SIZE block of the image. Bytes not present in the HEX file read as 0xFF.
+ */
+struct Page
+{
+    std::array<uint8_t, PROGMEM_PAGE_SIZE> data;
+    std::bitset<PROGMEM_PAGE_SIZE> present;
+
+    Page() { data.fill(0xFFU); }
+
+    /** True when every byte of the page is in the erased state. */
+    bool IsBlank() const;
+};
+
+/**
+ * @brief Sparse memory image keyed by page start address.
+ */
+class MemoryImage
+{
+public:
+    /** Parses an Intel HEX file. Throws std::runtime_error on malformed input. */
+    static MemoryImage FromHexFile(const std::string &path);
+    static MemoryImage FromHexText(const std::string &text);
+
+    void Set(uint32_t address, uint8_t value);
+    uint8_t Get(uint32_t address) const;
+
+    /** Pages inside [start, end), in ascending address order. */
+    std::vector<uint32_t> PagesIn(uint32_t start, uint32_t end) const;
+    const Page &PageAt(uint32_t pageAddress) const;
+
+    /** Bytes present in the HEX file inside [start, end), grouped into runs of consecutive addresses. */
+    std::vector<std::pair<uint32_t, std::vector<uint8_t>>> RunsIn(uint32_t start, uint32_t end, size_t maxRun) const;
+
+    /** Copies [start, end) into a flat buffer with 0xFF fill. */
+    std::vector<uint8_t> Flatten(uint32_t start, uint32_t end) const;
+
+    /** Intel HEX text of every byte present, 16 bytes per data record. */
+    std::string ToHexText() const;
+
+    size_t PageCount() const { return pages.size(); }
+
+private:
+    std::map<uint32_t, Page> pages;
+};
+
+}
+
+#endif // HEX_FILE_HPP
@@ -0,0 +1,256 @@
+/**
+ *
+ * @file log_sim_main.cpp
+ *
+ * @brief bl_logsim: endurance and power-cut simulation of the bootloader record log (BL_LOG_ENABLE).
+ *
+ *        bl_logsim [--keys N] [--writes N] [--endurance N] [--cuts N] [--seed N]
+ *
+ *        The log is bl_log.c, compiled for Linux with BL_LOG_BANK_SIZE of bl_boot_config.h or SIM_DEFINES and run
+ *        on the simulated NVM of bl_sim (sim_log.c).
+ *
+ *        The endurance run updates N keys in random order and reports how often the most worn cell was written,
+ *        the projected number of updates before it reaches the endurance, and what updating the values in
+ *        place would give instead. Every update is read back, also after a fresh boot lookup.
+ *        The power-cut run tears a random byte write, boots again and checks that every key holds either
+ *        the value before or the value of the interrupted update, and that the log keeps working.
+ */
+
+#include "../sim/sim_log.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+// Data sheet EEPROM endurance
+constexpr uint64_t EEPROM_ENDURANCE = 100000U;
+
+struct Options
+{
+    unsigned keys = 3U;
+    uint64_t writes = 100000U;
+    uint64_t endurance = EEPROM_ENDURANCE;
+    unsigned cuts = 10000U;
+    uint32_t seed = 1U;
+};
+
+class Random
+{
+public:
+    explicit Random(uint32_t seed) : state((seed * 0x9E3779B9U) | 1U) {}
+
+    uint32_t Next(uint32_t range)
+    {
+        state ^= state << 13U;
+        state ^= state >> 17U;
+        state ^= state << 5U;
+        return state % range;
+    }
+
+private:
+    uint32_t state;
+};
+
+void Usage()
+{
+    std::fprintf(stderr, "usage: bl_logsim [--keys N] [--writes N] [--endurance N] [--cuts N] [--seed N]\n");
+}
+
+bool CheckAll(const std::vector<uint32_t> &expected, const std::vector<bool> &written)
+{
+    for (size_t k = 0U; k < expected.size(); k++)
+    {
+        uint32_t value = 0U;
+        bool found = SIM_LogRead(static_cast<uint8_t>(k + 1U), &value);
+        if ((found != written[k]) || (found && (value != expected[k])))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Endurance(const Options &options)
+{
+    std::vector<uint64_t> wear(SIM_EEPROM_SIZE, 0U);
+    std::vector<uint32_t> expected(options.keys, 0U);
+    std::vector<bool> written(options.keys, false);
+    Random random(options.seed);
+    uint64_t reads = 0U;
+    uint64_t bootReads = 0U;
+
+    SIM_LogReset();
+    SIM_EepromTrack(wear.data(), &reads);
+    SIM_LogBoot();
+    for (uint64_t n = 0U; n < options.writes; n++)
+    {
+        unsigned k = random.Next(options.keys);
+        bool done = false;
+        expected[k]++;
+        written[k] = true;
+        if (!SIM_LogWrite(static_cast<uint8_t>(k + 1U), expected[k], &done) || !done || !CheckAll(expected, written))
+        {
+            std::printf("endurance: FAIL at update %llu\n", static_cast<unsigned long long>(n));
+            return false;
+        }
+        if ((n % 97U) == 0U)
+        {
+            uint64_t before = reads;
+            SIM_LogBoot();
+            bootReads = std::max(bootReads, reads - before);
+            if (!CheckAll(expected, written))
+            {
+                std::printf("endurance: FAIL after boot lookup at update %llu\n", static_cast<unsigned long long>(n));
+                return false;
+            }
+        }
+    }
+
+    SIM_EepromTrack(nullptr, nullptr);
+    // The cells of the two banks
+    uint64_t maxWear = 0U;
+    uint64_t totalWear = 0U;
+    for (uint32_t i = 0U; i < (2U * simLogBankSize); i++)
+    {
+        maxWear = std::max(maxWear, wear[simLogOffset + i]);
+        totalWear += wear[simLogOffset + i];
+    }
+    uint64_t byteWrites = SIM_LogMemory()->counters.eepromWrites;
+    double perUpdate = static_cast<double>(maxWear) / static_cast<double>(options.writes);
+    // In place, each update rewrites the cells of its key, so the busiest key wears out first
+    double inPlace = static_cast<double>(options.endurance) * static_cast<double>(options.keys);
+
+    std::printf("endurance: %u keys, bank %u bytes (%u slots), %llu updates, %u compactions\n", options.keys,
+                simLogBankSize, simLogSlots, static_cast<unsigned long long>(options.writes), SIM_LogEpoch());
+    std::printf("  %llu byte writes (%.2f per update), most worn cell %llu, mean %.1f\n",
+                static_cast<unsigned long long>(byteWrites),
+                static_cast<double>(byteWrites) / static_cast<double>(options.writes),
+                static_cast<unsigned long long>(maxWear),
+                static_cast<double>(totalWear) / static_cast<double>(2U * simLogBankSize));
+    std::printf("  boot lookup reads at most %llu EEPROM bytes\n", static_cast<unsigned long long>(bootReads));
+    std::printf("  lifetime at %llu cycles: about %.0f updates (in place: about %.0f, %.1fx)\n",
+                static_cast<unsigned long long>(options.endurance), static_cast<double>(options.endurance) / perUpdate,
+                inPlace, (static_cast<double>(options.endurance) / perUpdate) / inPlace);
+    return true;
+}
+
+bool PowerCuts(const Options &options)
+{
+    std::vector<uint32_t> expected(options.keys, 0U);
+    std::vector<bool> written(options.keys, false);
+    Random random(options.seed + 1U);
+    unsigned newer = 0U;
+
+    SIM_LogReset();
+    for (unsigned cut = 0U; cut < options.cuts; cut++)
+    {
+        SIM_LogBoot();
+
+        // A compaction of a full bank takes about two banks of byte writes
+        SIM_LogCutAfter(random.Next(4U * simLogBankSize), random.Next(0xFFFFFFFFU));
+        unsigned k = 0U;
+        uint32_t value = 0U;
+        bool done = true;
+        for (;;)
+        {
+            k = random.Next(options.keys);
+            value = expected[k] + 1U;
+            if (!SIM_LogWrite(static_cast<uint8_t>(k + 1U), value, &done) || !done)
+            {
+                break;
+            }
+            expected[k] = value;
+            written[k] = true;
+        }
+        if (!done)
+        {
+            std::printf("power cuts: FAIL, BL_LogWrite failed before cut %u\n", cut);
+            return false;
+        }
+
+        SIM_LogBoot();
+        uint32_t found = 0U;
+        if (SIM_LogRead(static_cast<uint8_t>(k + 1U), &found) && (found == value))
+        {
+            // The interrupted update made it
+            expected[k] = value;
+            written[k] = true;
+            newer++;
+        }
+        if (!CheckAll(expected, written))
+        {
+            std::printf("power cuts: FAIL after cut %u (key %u)\n", cut, k + 1U);
+            return false;
+        }
+    }
+
+    std::printf("power cuts: %u cuts recovered, %u interrupted updates already complete, %llu byte writes\n",
+                options.cuts, newer, static_cast<unsigned long long>(SIM_LogMemory()->counters.eepromWrites));
+    return true;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if ((i + 1) >= argc)
+        {
+            Usage();
+            return 2;
+        }
+        unsigned long long value = std::strtoull(argv[++i], nullptr, 0);
+        if (arg == "--keys")
+        {
+            options.keys = static_cast<unsigned>(value);
+        }
+        else if (arg == "--writes")
+        {
+            options.writes = value;
+        }
+        else if (arg == "--endurance")
+        {
+            options.endurance = value;
+        }
+        else if (arg == "--cuts")
+        {
+            options.cuts = static_cast<unsigned>(value);
+        }
+        else if (arg == "--seed")
+        {
+            options.seed = static_cast<uint32_t>(value);
+        }
+        else
+        {
+            Usage();
+            return 2;
+        }
+    }
+    // One slot is the header; compaction needs room for one more record than there are keys
+    if ((options.keys == 0U) || ((options.keys + 2U) > simLogSlots) || (options.writes == 0U))
+    {
+        Usage();
+        return 2;
+    }
+
+    try
+    {
+        bool ok = Endurance(options);
+        ok = PowerCuts(options) && ok;
+        return ok ? 0 : 1;
+    }
+    catch (const std::exception &error)
+    {
+        std::fprintf(stderr, "bl_logsim: %s\n", error.what());
+        return 1;
+    }
+}
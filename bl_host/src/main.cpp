@@ -0,0 +1,704 @@
+/**
+ *
+ * @file main.cpp
+ *
+ * @brief bl_host: command line programmer for the PIC18F57Q43 8-bit bootloader.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bus.hpp"
+#include "device_link.hpp"
+#include "farm.hpp"
+#include "hex_file.hpp"
+#include "programmer.hpp"
+#include "port.hpp"
+#include "secure.hpp"
+#include "sha256.hpp"
+
+using namespace blhost;
+
+namespace
+{
+
+struct CommandLine
+{
+    std::string command;
+    std::string port;
+    std::vector<std::string> ports;
+    std::string hexFile;
+    std::string patchFrom;
+    std::string secureKeyFile;
+    uint32_t rangeAddress = START_OF_APP;
+    uint32_t rangeLength = PROGMEM_SIZE - START_OF_APP;
+    unsigned baudRate = 115200U;
+    unsigned retries = 2U;
+    unsigned extraTimeoutMs = 0U;
+    bool clearTrace = false;
+    std::vector<uint8_t> nodes;
+    unsigned guardUs = 2000U;
+    unsigned count = 1000U;
+    unsigned breakMs = 4U;
+    bool repair = true;
+    ProgramOptions program;
+};
+
+void Usage()
+{
+    std::fprintf(stderr,
+                 "usage: bl_host <command> -p PORT [options]\n"
+                 "\n"
+                 "commands:\n"
+                 "  program FILE.hex   erase, write, verify and reset\n"
+                 "  farm FILE.hex      program every -p PORT concurrently from one packed image\n"
+                 "  bus FILE.hex       broadcast to all --nodes of a multi-drop bus, then poll and repair\n"
+                 "  version            print the bootloader version block\n"
+                 "  trace              decode the device trace ring (READ_TRACE)\n"
+                 "  blank              list the application flash that is not blank (BLANK_CHECK)\n"
+                 "  digest [FILE.hex]  SHA-256 of the --range flash (DIGEST), compared with FILE.hex\n"
+                 "  linktest           soak the transport with --count READ_FLASH frames\n"
+                 "  enter              send a --break-ms break to the running application, then time\n"
+                 "                     the handoff until the bootloader accepts READ_VERSION\n"
+                 "\n"
+                 "options:\n"
+                 "  -p PORT            serial port (e.g. /dev/ttyACM0); repeat for farm\n"
+                 "                     or spi:/dev/spidevB.C for the SPI transport\n"
+                 "  -b BAUD            baud rate, or SPI clock in Hz (default 115200)\n"
+                 "  --retries N        resend a frame N times on timeout (default 2)\n"
+                 "  --timeout-extra MS added to every reply timeout (default 0)\n"
+                 "  --no-erase         do not erase the application area first\n"
+                 "  --no-eeprom        ignore EEPROM data in the HEX file\n"
+                 "  --config           also write configuration bytes from the HEX file\n"
+                 "  --no-verify        skip the CALC_CHECKSUM verification\n"
+                 "  --no-reset         leave the device in the bootloader\n"
+                 "  --resume           continue an interrupted update of the same image from the\n"
+                 "                     device page journal (BL_JOURNAL_ENABLE)\n"
+                 "  --patch-from OLD   program: send the pages that differ from OLD.hex, which the\n"
+                 "                     device holds, as PATCH deltas (BL_CMD_PATCH_ENABLE)\n"
+                 "  --secure-key FILE  program/farm: send the pages as SECURE_WRITE frames sealed with\n"
+                 "                     the AES-128 key in FILE (BL_CMD_SECURE_WRITE_ENABLE)\n"
+                 "  --no-batch         send every frame on its own, even to devices with BATCH\n"
+                 "  --no-compact       keep full replies, even from devices with REPLY_MODE\n"
+                 "  --pipeline N       frames prepared ahead of the wire (default 8)\n"
+                 "  --clear            clear the trace ring after reading it\n"
+                 "  --range ADDR:LEN   digest range (default the application area, the only range\n"
+                 "                     bootloaders without BL_PLAINTEXT_FLASH_ENABLE accept)\n"
+                 "  --nodes LIST       bus node addresses, e.g. 1,2,5-8\n"
+                 "  --guard-us N       extra wait after each broadcast frame (default 2000)\n"
+                 "  --no-repair        do not reprogram nodes that missed broadcast frames\n"
+                 "  --count N          linktest frames (default 1000)\n"
+                 "  --break-ms N       break length for enter (default 4)\n");
+}
+
+bool ParseNodes(const std::string &list, std::vector<uint8_t> &nodes)
+{
+    size_t position = 0U;
+
+    while (position < list.size())
+    {
+        size_t end = list.find(',', position);
+        std::string item = list.substr(position, (end == std::string::npos) ? std::string::npos : (end - position));
+        size_t dash = item.find('-');
+        unsigned first = static_cast<unsigned>(std::strtoul(item.c_str(), nullptr, 0));
+        unsigned last = (dash == std::string::npos) ? first : static_cast<unsigned>(std::strtoul(item.c_str() + dash + 1U, nullptr, 0));
+
+        if ((first == NODE_LOCAL) || (last >= NODE_BROADCAST) || (first > last))
+        {
+            return false;
+        }
+        for (unsigned node = first; node <= last; node++)
+        {
+            nodes.push_back(static_cast<uint8_t>(node));
+        }
+        position = (end == std::string::npos) ? list.size() : (end + 1U);
+    }
+    return !nodes.empty();
+}
+
+bool Parse(int argc, char **argv, CommandLine &line)
+{
+    if (argc < 2)
+    {
+        return false;
+    }
+    line.command = argv[1];
+
+    for (int i = 2; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1) < argc;
+
+        if ((arg == "-p") && hasValue)
+        {
+            line.port = argv[++i];
+            line.ports.push_back(line.port);
+        }
+        else if ((arg == "-b") && hasValue)
+        {
+            line.baudRate = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 0));
+        }
+        else if ((arg == "--retries") && hasValue)
+        {
+            line.retries = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 0));
+        }
+        else if ((arg == "--timeout-extra") && hasValue)
+        {
+            line.extraTimeoutMs = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 0));
+        }
+        else if ((arg == "--pipeline") && hasValue)
+        {
+            line.program.pipelineDepth = std::strtoul(argv[++i], nullptr, 0);
+        }
+        else if (arg == "--no-erase")
+        {
+            line.program.erase = false;
+        }
+        else if (arg == "--no-eeprom")
+        {
+            line.program.eeprom = false;
+        }
+        else if (arg == "--config")
+        {
+            line.program.config = true;
+        }
+        else if (arg == "--no-verify")
+        {
+            line.program.verify = false;
+        }
+        else if (arg == "--no-reset")
+        {
+            line.program.reset = false;
+        }
+        else if (arg == "--resume")
+        {
+            line.program.resume = true;
+        }
+        else if ((arg == "--patch-from") && hasValue)
+        {
+            line.patchFrom = argv[++i];
+        }
+        else if ((arg == "--secure-key") && hasValue)
+        {
+            line.secureKeyFile = argv[++i];
+        }
+        else if (arg == "--no-batch")
+        {
+            line.program.batch = false;
+        }
+        else if (arg == "--no-compact")
+        {
+            line.program.compact = false;
+        }
+        else if (arg == "--clear")
+        {
+            line.clearTrace = true;
+        }
+        else if ((arg == "--range") && hasValue)
+        {
+            char *end = nullptr;
+            line.rangeAddress = static_cast<uint32_t>(std::strtoul(argv[++i], &end, 0));
+            if (*end != ':')
+            {
+                return false;
+            }
+            line.rangeLength = static_cast<uint32_t>(std::strtoul(end + 1, nullptr, 0));
+        }
+        else if ((arg == "--nodes") && hasValue)
+        {
+            if (!ParseNodes(argv[++i], line.nodes))
+            {
+                return false;
+            }
+        }
+        else if ((arg == "--guard-us") && hasValue)
+        {
+            line.guardUs = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 0));
+        }
+        else if (arg == "--no-repair")
+        {
+            line.repair = false;
+        }
+        else if ((arg == "--count") && hasValue)
+        {
+            line.count = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 0));
+        }
+        else if ((arg == "--break-ms") && hasValue)
+        {
+            line.breakMs = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 0));
+        }
+        else if ((arg[0] != '-') && line.hexFile.empty())
+        {
+            line.hexFile = arg;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    if (line.program.pipelineDepth == 0U)
+    {
+        line.program.pipelineDepth = 1U;
+    }
+    bool needsImage = (line.command == "program") || (line.command == "farm") || (line.command == "bus");
+    if ((line.command == "bus") && line.nodes.empty())
+    {
+        return false;
+    }
+    // A delta starts from the flash as it is, not from an erased or half-written application
+    if (!line.patchFrom.empty() && ((line.command != "program") || line.program.resume || !line.program.erase))
+    {
+        return false;
+    }
+    // Broadcast frames and PATCH streams are not sealed
+    if (!line.secureKeyFile.empty() && (((line.command != "program") && (line.command != "farm")) || !line.patchFrom.empty()))
+    {
+        return false;
+    }
+    if ((line.rangeLength == 0U) || (line.rangeAddress >= PROGMEM_SIZE) || (line.rangeLength > (PROGMEM_SIZE - line.rangeAddress)))
+    {
+        return false;
+    }
+    return !line.port.empty() && (!needsImage || !line.hexFile.empty());
+}
+
+int RunVersion(DeviceLink &link)
+{
+    // Bootloaders without a capability block ignore the address and end the reply after the version bytes
+    Reply reply = link.Transact(MakeReadCapabilities());
+
+    if (reply.DataLength() < 12U)
+    {
+        std::fprintf(stderr, "short version reply\n");
+        return 1;
+    }
+    const uint8_t *data = reply.Data();
+    std::printf("bootloader version %u.%u\n", data[1], data[0]);
+    std::printf("max packet size    %u\n", static_cast<unsigned>(data[2] | (data[3] << 8U)));
+    std::printf("device id          0x%04X\n", static_cast<unsigned>(data[6] | (data[7] << 8U)));
+    std::printf("page size          %u\n", static_cast<unsigned>(data[10] | (data[11] << 8U)));
+
+    Capabilities capabilities = ParseCapabilities(reply);
+    if (!capabilities.present)
+    {
+        std::printf("capabilities       not reported\n");
+        return 0;
+    }
+    std::printf("capability block   version %u\n", capabilities.version);
+    std::printf("commands          ");
+    for (uint8_t command = 0U; command < 32U; command++)
+    {
+        if (capabilities.HasCommand(command))
+        {
+            std::printf(" %s", CommandName(command).c_str());
+        }
+    }
+    std::printf("\n");
+    std::printf("features           %s\n", FeatureNames(capabilities.features).c_str());
+    std::printf("max frame data     %u\n", capabilities.maxFrameData);
+    std::printf("verification       %s\n", (capabilities.verifyScheme == VERIFY_CHECKSUM16) ? "checksum16"
+                                         : (capabilities.verifyScheme == VERIFY_SHA256)   ? "sha256"
+                                                                                          : "unknown");
+    std::printf("frame window       %u\n", capabilities.frameWindow);
+    std::printf("rx depth           %u\n", capabilities.rxDepth);
+    std::printf("eeprom queue       %u\n", capabilities.eeQueueSize);
+    if (capabilities.transport == TRANSPORT_SPI)
+    {
+        std::printf("transport          spi\n");
+    }
+    else
+    {
+        std::printf("transport          uart, %u to %u baud\n", static_cast<unsigned>(capabilities.baudMin),
+                    static_cast<unsigned>(capabilities.baudMax));
+    }
+    std::printf("start of app       0x%05X\n", static_cast<unsigned>(capabilities.startOfApp));
+    return 0;
+}
+
+int RunTrace(DeviceLink &link, bool clear)
+{
+    Reply reply = link.Transact(MakeReadTrace(clear));
+    const uint8_t *data = reply.Data();
+
+    if ((reply.DataLength() < 7U) || (data[0] != COMMAND_SUCCESS))
+    {
+        std::fprintf(stderr, "READ_TRACE not supported by this bootloader\n");
+        return 1;
+    }
+
+    size_t recordSize = data[1];
+    size_t depth = data[2];
+    unsigned count = static_cast<unsigned>(data[3] | (data[4] << 8U));
+    unsigned tickUs = data[5];
+    size_t valid = (count < depth) ? count : depth;
+    const uint8_t *records = &data[7];
+
+    if ((recordSize < 9U) || (reply.DataLength() < (7U + (depth * recordSize))))
+    {
+        std::fprintf(stderr, "truncated trace reply\n");
+        return 1;
+    }
+
+    std::printf("%u record(s) logged, showing the last %zu (tick %u us)\n", count, valid, tickUs);
+    std::printf("  %12s  %-14s %-22s %8s  %s\n", "time[ms]", "command", "result", "length", "address");
+
+    // The newest record is last. Timestamps wrap: 9-byte records carry the 16-bit TMR0 count, 10-byte records
+    // add the upper byte counted by BL_TraceTick after the address
+    uint32_t timestampMask = (recordSize >= 10U) ? 0xFFFFFFU : 0xFFFFU;
+    uint64_t elapsedTicks = 0U;
+    uint32_t previous = 0U;
+    double entry = -1.0;
+    for (size_t i = depth - valid; i < depth; i++)
+    {
+        const uint8_t *record = records + (i * recordSize);
+        uint32_t timestamp = static_cast<uint32_t>(record[0] | (record[1] << 8U));
+        uint8_t command = record[2];
+        uint8_t status = record[3];
+        unsigned length = static_cast<unsigned>(record[4] | (record[5] << 8U));
+        unsigned address = static_cast<unsigned>(record[6] | (record[7] << 8U) | (record[8] << 16U));
+
+        if (recordSize >= 10U)
+        {
+            timestamp |= static_cast<uint32_t>(record[9]) << 16U;
+        }
+        if (i != (depth - valid))
+        {
+            elapsedTicks += (timestamp - previous) & timestampMask;
+        }
+        previous = timestamp;
+
+        std::string result = (command == BL_TRACE_EVENT_NVM_ERROR) ? "NVM_ERROR" : StatusName(status);
+        if ((command == READ_VERSION) || (command == CALC_CHECKSUM))
+        {
+            result = "-";
+        }
+        if (command == BL_TRACE_EVENT_ENTRY)
+        {
+            // TMR0 starts in SYSTEM_Initialize, so the raw timestamp is the entry decision time
+            result = EntryReasonName(status);
+            entry = static_cast<double>(static_cast<uint64_t>(timestamp) * tickUs) / 1000.0;
+        }
+        if (command == BL_TRACE_EVENT_INSTALL)
+        {
+            // The address field holds the number of pages copied
+            result = SlotResultName(status);
+        }
+        if (command == BL_TRACE_EVENT_RESTORE)
+        {
+            // The address field holds the number of pages written
+            result = GoldenResultName(status);
+        }
+        std::printf("  %12.3f  %-14s %-22s %8u  0x%06X\n", static_cast<double>(elapsedTicks * tickUs) / 1000.0,
+                    CommandName(command).c_str(), result.c_str(), length, address);
+    }
+    if (entry >= 0.0)
+    {
+        std::printf("ready for frames %.3f ms after TMR0 was started\n", entry);
+    }
+    return 0;
+}
+
+int RunBlank(DeviceLink &link)
+{
+    uint16_t pages = static_cast<uint16_t>((PROGMEM_SIZE - START_OF_APP) / PROGMEM_PAGE_SIZE);
+    BlankMap map;
+
+    if (!map.Parse(link.Transact(MakeBlankCheck(START_OF_APP, pages)), START_OF_APP, pages))
+    {
+        std::fprintf(stderr, "BLANK_CHECK not supported by this bootloader\n");
+        return 1;
+    }
+    std::printf("%u of %u application pages blank\n", map.blankPages, pages);
+
+    // Runs of pages that are not blank, as address ranges
+    for (uint16_t page = 0U; page < pages;)
+    {
+        if (map.Blank(page))
+        {
+            page++;
+            continue;
+        }
+        uint16_t first = page;
+        while ((page < pages) && !map.Blank(page))
+        {
+            page++;
+        }
+        std::printf("  0x%06X-0x%06X  %u page(s) in use\n",
+                    static_cast<unsigned>(START_OF_APP + (static_cast<uint32_t>(first) * PROGMEM_PAGE_SIZE)),
+                    static_cast<unsigned>(START_OF_APP + (static_cast<uint32_t>(page) * PROGMEM_PAGE_SIZE) - 1U),
+                    static_cast<unsigned>(page - first));
+    }
+    return 0;
+}
+
+int RunDigest(DeviceLink &link, const CommandLine &line)
+{
+    using Clock = std::chrono::steady_clock;
+    const Frame frame = MakeDigest(line.rangeAddress, line.rangeLength);
+
+    auto start = Clock::now();
+    Reply reply = link.Transact(frame);
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    if (reply.Status() != COMMAND_SUCCESS)
+    {
+        std::fprintf(stderr, "DIGEST of 0x%06X:%u failed: %s\n", static_cast<unsigned>(line.rangeAddress),
+                     static_cast<unsigned>(line.rangeLength), StatusName(reply.Status()).c_str());
+        return 1;
+    }
+    if (reply.DataLength() < (1U + DIGEST_SIZE))
+    {
+        std::fprintf(stderr, "DIGEST reply too short\n");
+        return 1;
+    }
+
+    Digest digest;
+    std::copy(reply.Data() + 1, reply.Data() + 1 + DIGEST_SIZE, digest.begin());
+    std::printf("sha256 0x%06X:%u  ", static_cast<unsigned>(line.rangeAddress), static_cast<unsigned>(line.rangeLength));
+    for (uint8_t byte : digest)
+    {
+        std::printf("%02x", byte);
+    }
+    std::printf("\n");
+
+    // The frame and its reply on the wire at 10 bits per byte; the rest of the round trip is the device hashing
+    double wireSeconds = static_cast<double>(PreparedFrame(frame).wire.size() + 1U + frame.expectedReplyLength) * 10.0 / line.baudRate;
+    double deviceSeconds = (seconds > wireSeconds) ? (seconds - wireSeconds) : 0.0;
+    std::printf("  %.1f ms round trip, about %.1f ms on the device, %.2f ms/KB\n", seconds * 1e3, deviceSeconds * 1e3,
+                deviceSeconds * 1e3 * 1024.0 / line.rangeLength);
+
+    if (line.hexFile.empty())
+    {
+        return 0;
+    }
+    // Bytes the HEX file leaves out read back erased
+    std::vector<uint8_t> flat = MemoryImage::FromHexFile(line.hexFile).Flatten(line.rangeAddress, line.rangeAddress + line.rangeLength);
+    bool match = Sha256(flat.data(), flat.size()) == digest;
+    std::printf("  %s %s\n", match ? "matches" : "does NOT match", line.hexFile.c_str());
+    return match ? 0 : 1;
+}
+
+int RunProgram(DeviceLink &link, const CommandLine &line)
+{
+    MemoryImage image = MemoryImage::FromHexFile(line.hexFile);
+    Programmer programmer(link, line.program);
+    ProgramReport report = line.patchFrom.empty() ? programmer.Program(image)
+                                                  : programmer.Patch(MemoryImage::FromHexFile(line.patchFrom), image);
+
+    report.Print(line.port);
+    return 0;
+}
+
+int RunBus(DeviceLink &link, const CommandLine &line)
+{
+    MemoryImage image = MemoryImage::FromHexFile(line.hexFile);
+    BusOptions options;
+
+    options.program = line.program;
+    options.guardUs = line.guardUs;
+    options.repair = line.repair;
+
+    PackedImage packed = PackImage(image, options.program);
+    BusProgrammer programmer(link, options);
+    BusReport report = programmer.Program(packed, line.nodes);
+    report.Print(line.port);
+
+    for (const NodeResult &node : report.nodes)
+    {
+        if (!node.ok)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int RunLinkTest(DeviceLink &link, const CommandLine &line)
+{
+    using Clock = std::chrono::steady_clock;
+    const Frame frame = MakeReadFlash(START_OF_APP, static_cast<uint16_t>(BL_FRAME_DATA_SIZE));
+    const PreparedFrame prepared(frame);
+    std::vector<uint8_t> reference;
+    unsigned timeouts = 0U;
+    unsigned mismatches = 0U;
+    uint64_t payload = 0U;
+
+    // Every read returns the same page, so any difference is a transport error
+    auto start = Clock::now();
+    for (unsigned i = 0U; i < line.count; i++)
+    {
+        try
+        {
+            Reply reply = link.Transact(prepared);
+            std::vector<uint8_t> data(reply.Data(), reply.Data() + reply.DataLength());
+
+            if (reference.empty())
+            {
+                reference = data;
+            }
+            else if (data != reference)
+            {
+                mismatches++;
+            }
+            payload += data.size();
+        }
+        catch (const LinkError &)
+        {
+            timeouts++;
+        }
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    const LinkStats &stats = link.Stats();
+
+    std::printf("%s\n", line.port.c_str());
+    std::printf("  %u frames in %.3f s, %.0f payload B/s, %.3f ms per frame\n", line.count, seconds,
+                (seconds > 0.0) ? (static_cast<double>(payload) / seconds) : 0.0,
+                (line.count > 0U) ? (seconds * 1000.0 / static_cast<double>(line.count)) : 0.0);
+    std::printf("  %llu bytes tx, %llu bytes rx, %llu retries, %u timeouts, %u mismatches\n",
+                static_cast<unsigned long long>(stats.bytesTx), static_cast<unsigned long long>(stats.bytesRx),
+                static_cast<unsigned long long>(stats.retries), timeouts, mismatches);
+    return ((timeouts == 0U) && (mismatches == 0U)) ? 0 : 1;
+}
+
+int RunEnter(Port &port, const CommandLine &line)
+{
+    using Clock = std::chrono::steady_clock;
+    // Each probe is a single short attempt, so the first reply is seen within one frame time
+    DeviceLink link(port, 0U);
+    Frame probe = MakeReadVersion();
+    probe.timeoutMs = 10U + line.extraTimeoutMs;
+    const PreparedFrame prepared(probe);
+    unsigned attempts = 0U;
+
+    auto start = Clock::now();
+    port.SendBreak(line.breakMs * 1000U);
+    auto released = Clock::now();
+    auto deadline = released + std::chrono::seconds(2);
+
+    while (Clock::now() < deadline)
+    {
+        attempts++;
+        try
+        {
+            (void) link.Transact(prepared);
+            auto accepted = Clock::now();
+            std::printf("%s\n", line.port.c_str());
+            std::printf("  break %.3f ms, first accepted frame %.3f ms after the break ended (%.3f ms after it began), "
+                        "%u probe(s)\n",
+                        std::chrono::duration<double, std::milli>(released - start).count(),
+                        std::chrono::duration<double, std::milli>(accepted - released).count(),
+                        std::chrono::duration<double, std::milli>(accepted - start).count(), attempts);
+            return 0;
+        }
+        catch (const LinkError &)
+        {
+            // The application ignores frames, and a probe cut by the reset leaves stray bytes
+            port.Flush();
+        }
+    }
+    std::fprintf(stderr, "bl_host: %s: no bootloader reply within 2 s of the break (%u probes)\n", line.port.c_str(),
+                 attempts);
+    return 1;
+}
+
+int RunFarm(const CommandLine &line)
+{
+    MemoryImage image = MemoryImage::FromHexFile(line.hexFile);
+    FarmOptions options;
+
+    options.baudRate = line.baudRate;
+    options.retries = line.retries;
+    options.extraTimeoutMs = line.extraTimeoutMs;
+    options.program = line.program;
+
+    PackedImage packed = PackImage(image, options.program);
+    std::printf("%zu flash frames, %zu EEPROM frames, %u blank pages skipped, checksum 0x%04X\n", packed.flashFrames.size(),
+                packed.eepromFrames.size(), packed.blankPagesSkipped, packed.expectedChecksum);
+
+    Farm farm(packed, options);
+    FarmReport report = farm.Run(line.ports);
+    report.Print();
+
+    for (const PortResult &port : report.ports)
+    {
+        if (!port.ok)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    CommandLine line;
+
+    if (!Parse(argc, argv, line))
+    {
+        Usage();
+        return 2;
+    }
+
+    try
+    {
+        if (!line.secureKeyFile.empty())
+        {
+            line.program.secureKey = LoadSecureKey(line.secureKeyFile);
+        }
+        if (line.command == "farm")
+        {
+            return RunFarm(line);
+        }
+
+        std::unique_ptr<Port> port = OpenPort(line.port, line.baudRate);
+        DeviceLink link(*port, line.retries);
+
+        if (line.command == "program")
+        {
+            return RunProgram(link, line);
+        }
+        if (line.command == "bus")
+        {
+            return RunBus(link, line);
+        }
+        if (line.command == "version")
+        {
+            return RunVersion(link);
+        }
+        if (line.command == "trace")
+        {
+            return RunTrace(link, line.clearTrace);
+        }
+        if (line.command == "blank")
+        {
+            return RunBlank(link);
+        }
+        if (line.command == "digest")
+        {
+            return RunDigest(link, line);
+        }
+        if (line.command == "linktest")
+        {
+            return RunLinkTest(link, line);
+        }
+        if (line.command == "enter")
+        {
+            return RunEnter(*port, line);
+        }
+        Usage();
+        return 2;
+    }
+    catch (const std::exception &error)
+    {
+        std::fprintf(stderr, "bl_host: %s\n", error.what());
+        return 1;
+    }
+}
@@ -0,0 +1,37 @@
+/**
+ *
+ * @file port.cpp
+ *
+ * @brief Byte stream to a device, independent of the physical transport (UART or SPI).
+ */
+
+#include "port.hpp"
+
+#include "serial_port.hpp"
+#include "spi_port.hpp"
+
+namespace blhost
+{
+
+namespace
+{
+
+const std::string SPI_PREFIX = "spi:";
+
+}
+
+std::unique_ptr<Port> OpenPort(const std::string &spec, unsigned rate)
+{
+    if (spec.compare(0U, SPI_PREFIX.size(), SPI_PREFIX) == 0)
+    {
+        auto port = std::make_unique<SpiPort>();
+        port->Open(spec.substr(SPI_PREFIX.size()), rate);
+        return port;
+    }
+
+    auto port = std::make_unique<SerialPort>();
+    port->Open(spec, rate);
+    return port;
+}
+
+}
@@ -0,0 +1,53 @@
+/**
+ *
+ * @file port.hpp
+ *
+ * @brief Byte stream to a device, independent of the physical transport (UART or SPI).
+ */
+
+#ifndef PORT_HPP
+#define PORT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace blhost
+{
+
+class Port
+{
+public:
+    virtual ~Port() = default;
+
+    /** Writes all bytes, blocking until the transport accepted them. */
+    virtual void Write(const uint8_t *data, size_t length) = 0;
+
+    /**
+     * Reads up to length bytes. Returns once length bytes arrived, timeoutMs elapsed in total,
+     * or no byte arrived for idleMs after at least one byte was received (idleMs == 0 disables the idle rule).
+     */
+    virtual size_t Read(uint8_t *data, size_t length, unsigned timeoutMs, unsigned idleMs) = 0;
+
+    /** Discards pending input. */
+    virtual void Flush() = 0;
+
+    virtual const std::string &Path() const = 0;
+
+    /** Seconds needed to shift one byte at the configured bit rate. */
+    virtual double ByteTime() const = 0;
+
+    /** Holds the line in the break (low) state for durationUs. Throws std::runtime_error if the transport has no break. */
+    virtual void SendBreak(unsigned durationUs) = 0;
+};
+
+/**
+ * Opens "spi:/dev/spidevB.C" as an SPI host port clocked at rate Hz, anything else as a serial port at rate baud.
+ * Throws std::runtime_error on failure.
+ */
+std::unique_ptr<Port> OpenPort(const std::string &spec, unsigned rate);
+
+}
+
+#endif // PORT_HPP
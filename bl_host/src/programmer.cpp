@@ -0,0 +1,951 @@
+/**
+ *
+ * @file programmer.cpp
+ *
+ * @brief Programming flow: erase, write, EEPROM, verify and reset, with per-phase statistics.
+ */
+
+#include "programmer.hpp"
+
+#include "delta.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace blhost
+{
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+double Seconds(Clock::time_point start, Clock::time_point end)
+{
+    return std::chrono::duration<double>(end - start).count();
+}
+
+enum class Phase
+{
+    Flash,
+    Eeprom,
+    Config,
+    Done
+};
+
+const char *const PHASE_NAMES[3] = {"write", "eeprom", "config"};
+
+struct WorkItem
+{
+    Phase phase = Phase::Done;
+    PreparedFrame prepared;
+};
+
+/**
+ * @brief Fixed capacity single-producer single-consumer queue.
+ */
+class FrameQueue
+{
+public:
+    explicit FrameQueue(size_t capacity) : capacity(capacity) {}
+
+    /** Returns false when the consumer gave up. */
+    bool Push(WorkItem item)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this] { return cancelled || (items.size() < capacity); });
+        if (cancelled)
+        {
+            return false;
+        }
+        items.push_back(std::move(item));
+        notEmpty.notify_one();
+        return true;
+    }
+
+    WorkItem Pop()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [this] { return !items.empty(); });
+        WorkItem item = std::move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return item;
+    }
+
+    void Cancel()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        cancelled = true;
+        notFull.notify_all();
+    }
+
+private:
+    size_t capacity;
+    std::deque<WorkItem> items;
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    bool cancelled = false;
+};
+
+std::vector<uint32_t> AppPages(const MemoryImage &image, uint32_t &blankPages, uint32_t &outsidePages)
+{
+    std::vector<uint32_t> pages;
+
+    blankPages = 0U;
+    outsidePages = static_cast<uint32_t>(image.PagesIn(0U, START_OF_APP).size());
+    for (uint32_t pageAddress : image.PagesIn(START_OF_APP, PROGMEM_SIZE))
+    {
+        // The application area is erased first, so blank pages need no frame
+        if (image.PageAt(pageAddress).IsBlank())
+        {
+            blankPages++;
+        }
+        else
+        {
+            pages.push_back(pageAddress);
+        }
+    }
+    return pages;
+}
+
+uint32_t Crc32(uint32_t crc, const uint8_t *data, size_t length)
+{
+    crc = ~crc;
+    for (size_t i = 0U; i < length; i++)
+    {
+        crc ^= data[i];
+        for (unsigned bit = 0U; bit < 8U; bit++)
+        {
+            crc = ((crc & 1U) != 0U) ? ((crc >> 1U) ^ 0xEDB88320U) : (crc >> 1U);
+        }
+    }
+    return ~crc;
+}
+
+template <typename Emit>
+void PackDataRegions(const MemoryImage &image, const ProgramOptions &options, bool batch, Emit emit)
+{
+    std::vector<Frame> eeprom;
+    std::vector<Frame> config;
+
+    if (options.eeprom)
+    {
+        for (const auto &run : image.RunsIn(EEPROM_START_ADDRESS, EEPROM_START_ADDRESS + EEPROM_SIZE, BL_FRAME_DATA_SIZE))
+        {
+            eeprom.push_back(MakeWriteEeprom(run.first, run.second.data(), static_cast<uint16_t>(run.second.size()), options.timing));
+        }
+        // The device may still be programming queued bytes; wait for them and collect their result
+        if (!eeprom.empty())
+        {
+            eeprom.push_back(MakeEepromBarrier(options.timing));
+        }
+    }
+    if (options.config)
+    {
+        for (const auto &run : image.RunsIn(CONFIGURATION_BYTES_START, CONFIGURATION_BYTES_START + CONFIGURATION_BYTES_SIZE, BL_FRAME_DATA_SIZE))
+        {
+            config.push_back(MakeWriteConfig(run.first, run.second.data(), static_cast<uint16_t>(run.second.size()), options.timing));
+        }
+    }
+    for (Frame &frame : batch ? PackBatches(eeprom) : eeprom)
+    {
+        emit(Phase::Eeprom, std::move(frame));
+    }
+    for (Frame &frame : batch ? PackBatches(config) : config)
+    {
+        emit(Phase::Config, std::move(frame));
+    }
+}
+
+}
+
+void PhaseStats::CountWrites(const Reply &reply)
+{
+    // Bootloaders without BL_SKIP_UNCHANGED_ENABLE, or not asked for REPLY_COUNTS, reply with the status only
+    if (reply.DataLength() >= (1U + WRITE_COUNTS_SIZE))
+    {
+        const uint8_t *data = reply.Data();
+        writeCounts = true;
+        bytesProgrammed += static_cast<uint16_t>(data[1] | (data[2] << 8U));
+        bytesSkipped += static_cast<uint16_t>(data[3] | (data[4] << 8U));
+    }
+}
+
+void PhaseStats::CountErases(const Reply &reply)
+{
+    // Bootloaders without BL_SKIP_BLANK_ENABLE, or not asked for REPLY_COUNTS, reply with the status only
+    if (reply.DataLength() >= (1U + ERASE_COUNTS_SIZE))
+    {
+        const uint8_t *data = reply.Data();
+        eraseCounts = true;
+        pagesErased += static_cast<uint16_t>(data[1] | (data[2] << 8U));
+        pagesBlank += static_cast<uint16_t>(data[3] | (data[4] << 8U));
+    }
+}
+
+bool BlankMap::Parse(const Reply &reply, uint32_t start, uint16_t count)
+{
+    size_t bitmapSize = (count + 7U) / 8U;
+
+    if ((reply.Status() != COMMAND_SUCCESS) || (reply.DataLength() < (3U + bitmapSize)))
+    {
+        return false;
+    }
+    const uint8_t *data = reply.Data();
+    address = start;
+    pages = count;
+    blankPages = static_cast<uint16_t>(data[1] | (data[2] << 8U));
+    bitmap.assign(data + 3, data + 3 + bitmapSize);
+    return true;
+}
+
+bool PageJournal::Parse(const Reply &reply)
+{
+    supported = (reply.Status() == COMMAND_SUCCESS) && (reply.DataLength() >= (1U + JOURNAL_STATUS_SIZE));
+    if (!supported)
+    {
+        return false;
+    }
+    const uint8_t *data = reply.Data() + 1;
+    imageId = static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8U)
+              | (static_cast<uint32_t>(data[2]) << 16U) | (static_cast<uint32_t>(data[3]) << 24U);
+    bitmap.assign(data + JOURNAL_ID_SIZE + 2U, data + JOURNAL_STATUS_SIZE);
+    return true;
+}
+
+bool PageJournal::Committed(uint32_t pageAddress) const
+{
+    if (!supported || (pageAddress < START_OF_APP) || (pageAddress >= PROGMEM_SIZE))
+    {
+        return false;
+    }
+    uint32_t page = (pageAddress - START_OF_APP) / PROGMEM_PAGE_SIZE;
+    return (bitmap[page / 8U] & (1U << (page % 8U))) == 0U;
+}
+
+void ProgramReport::Print(const std::string &label) const
+{
+    std::printf("%s\n", label.c_str());
+    std::printf("  %-8s %9s %9s %7s %10s %10s %12s\n", "phase", "time[s]", "prep[s]", "frames", "payload", "wire", "payload B/s");
+    for (const PhaseStats &phase : phases)
+    {
+        double rate = (phase.seconds > 0.0) ? (static_cast<double>(phase.payloadBytes) / phase.seconds) : 0.0;
+        std::printf("  %-8s %9.3f %9.3f %7llu %10llu %10llu %12.0f\n", phase.name.c_str(), phase.seconds, phase.prepareSeconds,
+                    static_cast<unsigned long long>(phase.frames), static_cast<unsigned long long>(phase.payloadBytes),
+                    static_cast<unsigned long long>(phase.wireBytes), rate);
+    }
+    std::printf("  total %.3f s, %llu frames, %llu bytes tx, %llu bytes rx, %llu retries, %u blank pages skipped\n",
+                totalSeconds, static_cast<unsigned long long>(link.frames), static_cast<unsigned long long>(link.bytesTx),
+                static_cast<unsigned long long>(link.bytesRx), static_cast<unsigned long long>(link.retries), blankPagesSkipped);
+    for (const PhaseStats &phase : phases)
+    {
+        if (phase.eraseCounts)
+        {
+            std::printf("  %s: %llu pages erased, %llu blank pages not erased\n", phase.name.c_str(),
+                        static_cast<unsigned long long>(phase.pagesErased), static_cast<unsigned long long>(phase.pagesBlank));
+        }
+        if (phase.writeCounts)
+        {
+            std::printf("  %s: %llu bytes programmed, %llu unchanged bytes skipped\n", phase.name.c_str(),
+                        static_cast<unsigned long long>(phase.bytesProgrammed), static_cast<unsigned long long>(phase.bytesSkipped));
+        }
+    }
+    if (link.compactReplies != 0U)
+    {
+        std::printf("  %llu compact replies, %llu lost\n", static_cast<unsigned long long>(link.compactReplies),
+                    static_cast<unsigned long long>(link.lostReplies));
+    }
+    if (secure)
+    {
+        std::printf("  pages sent as SECURE_WRITE under nonce ");
+        for (uint8_t byte : nonce)
+        {
+            std::printf("%02x", byte);
+        }
+        std::printf("\n");
+    }
+    if (patched)
+    {
+        std::printf("  delta: %u page(s) patched, %u written in full, %u unchanged, %llu bytes of page data\n", pagesPatched,
+                    pagesWritten, pagesUnchanged, static_cast<unsigned long long>(deltaBytes));
+    }
+    if (resumed)
+    {
+        std::printf("  resumed image 0x%08X: %u page(s) already on the device were not sent again\n", imageId, pagesResumed);
+    }
+    else if (journal)
+    {
+        std::printf("  page journal started for image 0x%08X\n", imageId);
+    }
+    if (verified)
+    {
+        std::printf("  checksum 0x%04X verified\n", deviceChecksum);
+    }
+}
+
+PreparedFrame PackFlashPage(const MemoryImage &image, uint32_t pageAddress, const NvmTiming &timing)
+{
+    const Page &page = image.PageAt(pageAddress);
+    return PreparedFrame(MakeWriteFlash(pageAddress, page.data.data(), static_cast<uint16_t>(PROGMEM_PAGE_SIZE), timing));
+}
+
+PreparedFrame PackSecurePage(const MemoryImage &image, uint32_t pageAddress, const Aes128 &cipher, const SecureNonce &nonce,
+                             const NvmTiming &timing)
+{
+    const Page &page = image.PageAt(pageAddress);
+    return PreparedFrame(MakeSecureWrite(pageAddress, SealPage(cipher, nonce, pageAddress, page.data.data()), timing));
+}
+
+PackedImage PackImage(const MemoryImage &image, const ProgramOptions &options)
+{
+    PackedImage packed;
+    const Aes128 cipher(options.secureKey.value_or(SecureKey{}));
+
+    packed.secure = options.secureKey.has_value();
+    packed.nonce = RandomNonce();
+    for (uint32_t pageAddress : AppPages(image, packed.blankPagesSkipped, packed.pagesOutsideApp))
+    {
+        packed.flashFrames.push_back(packed.secure ? PackSecurePage(image, pageAddress, cipher, packed.nonce, options.timing)
+                                                   : PackFlashPage(image, pageAddress, options.timing));
+        packed.flashPayloadBytes += PROGMEM_PAGE_SIZE;
+    }
+    // Packed into BATCH frames at send time, once the capabilities of each device are known
+    PackDataRegions(image, options, false, [&packed](Phase phase, Frame frame) {
+        auto &frames = (phase == Phase::Eeprom) ? packed.eepromFrames : packed.configFrames;
+        frames.emplace_back(std::move(frame));
+    });
+    packed.expectedChecksum = ExpectedAppChecksum(image);
+    packed.imageId = ImageId(image);
+
+    return packed;
+}
+
+uint16_t ExpectedAppChecksum(const MemoryImage &image)
+{
+    std::vector<uint8_t> flat = image.Flatten(START_OF_APP, PROGMEM_SIZE);
+    return Checksum16(flat.data(), flat.size());
+}
+
+uint32_t ImageId(const MemoryImage &image)
+{
+    uint32_t blankPages = 0U;
+    uint32_t outsidePages = 0U;
+    uint32_t crc = 0U;
+
+    for (uint32_t pageAddress : AppPages(image, blankPages, outsidePages))
+    {
+        const uint8_t address[4] = {static_cast<uint8_t>(pageAddress), static_cast<uint8_t>(pageAddress >> 8U),
+                                    static_cast<uint8_t>(pageAddress >> 16U), static_cast<uint8_t>(pageAddress >> 24U)};
+        crc = Crc32(crc, address, sizeof(address));
+        crc = Crc32(crc, image.PageAt(pageAddress).data.data(), PROGMEM_PAGE_SIZE);
+    }
+    // The erased ID means "no image" on the device
+    return (crc == JOURNAL_NO_IMAGE) ? (JOURNAL_NO_IMAGE - 1U) : crc;
+}
+
+void CheckStatus(const Reply &reply, const std::string &context)
+{
+    if (reply.Status() != COMMAND_SUCCESS)
+    {
+        char address[32];
+        std::snprintf(address, sizeof(address), "0x%06X", reply.Address());
+        if ((reply.Command() == BATCH) && (reply.DataLength() >= BATCH_REPLY_SIZE))
+        {
+            throw ProgramError(context + ": batch frame " + std::to_string(reply.Data()[1]) + " at " + address + ": "
+                               + StatusName(reply.Status()));
+        }
+        // With the EEPROM write queue the byte may have come with an earlier frame, so the device names it
+        if (reply.Command() == WRITE_EE_DATA)
+        {
+            throw ProgramError(context + ": EEPROM byte " + address + ": " + StatusName(reply.Status()));
+        }
+        throw ProgramError(context + ": " + StatusName(reply.Status()));
+    }
+}
+
+std::vector<PreparedFrame> Programmer::Batched(const std::vector<PreparedFrame> &frames) const
+{
+    if (!Batching())
+    {
+        return frames;
+    }
+
+    std::vector<Frame> plain;
+    std::vector<PreparedFrame> batched;
+    for (const PreparedFrame &prepared : frames)
+    {
+        plain.push_back(prepared.frame);
+    }
+    for (Frame &frame : PackBatches(plain))
+    {
+        batched.emplace_back(std::move(frame));
+    }
+    return batched;
+}
+
+bool Programmer::Query(uint32_t imageId, PageJournal &journal, ProgramReport &report)
+{
+    PhaseStats query;
+    auto start = Clock::now();
+    PreparedFrame version(MakeReadCapabilities());
+    PreparedFrame read(MakeReadJournal());
+
+    // Bootloaders without a capability block end the reply after the version bytes
+    capabilities = ParseCapabilities(link.Transact(version));
+    query.frames = 1U;
+    query.wireBytes = version.wire.size();
+    CheckWriteCommand();
+    // Without a block, one short frame tells whether the device keeps a journal at all
+    if (!capabilities.present || capabilities.HasCommand(JOURNAL))
+    {
+        journal.Parse(link.Transact(read));
+        query.frames++;
+        query.wireBytes += read.wire.size();
+    }
+    // Set either way, as an earlier run may have left the device in another mode
+    if (capabilities.HasCommand(REPLY_MODE))
+    {
+        uint8_t mode = REPLY_FULL;
+
+        mode |= (options.compact && capabilities.HasFeature(FEATURE_COMPACT_REPLY)) ? REPLY_COMPACT : 0U;
+        mode |= (capabilities.HasFeature(FEATURE_SKIP_UNCHANGED) || capabilities.HasFeature(FEATURE_SKIP_BLANK)) ? REPLY_COUNTS : 0U;
+        query.wireBytes += SelectReplyMode(mode);
+        query.frames++;
+    }
+    query.name = "query";
+    query.seconds = Seconds(start, Clock::now());
+    report.phases.push_back(query);
+    report.journal = journal.supported;
+    report.imageId = imageId;
+
+    if (options.resume)
+    {
+        if (!journal.supported)
+        {
+            std::fprintf(stderr, "warning: the device keeps no page journal (BL_JOURNAL_ENABLE), programming from the start\n");
+        }
+        else if (journal.imageId != imageId)
+        {
+            std::fprintf(stderr, "warning: the device journal belongs to another image, programming from the start\n");
+        }
+        else
+        {
+            report.resumed = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+void Programmer::CheckWriteCommand() const
+{
+    // Bootloaders without a capability block have WRITE_FLASH and no SECURE_WRITE
+    bool secureWrite = capabilities.HasCommand(SECURE_WRITE);
+    bool writeFlash = !capabilities.present || capabilities.HasCommand(WRITE_FLASH);
+
+    if (options.secureKey && !secureWrite)
+    {
+        throw ProgramError("the device does not list SECURE_WRITE (BL_CMD_SECURE_WRITE_ENABLE)");
+    }
+    if (!options.secureKey && !writeFlash)
+    {
+        throw ProgramError("the device only takes SECURE_WRITE pages (BL_PLAINTEXT_FLASH_ENABLE 0), use --secure-key");
+    }
+}
+
+void Programmer::StartUpdate(uint32_t imageId, PageJournal &journal, ProgramReport &report)
+{
+    if (options.erase)
+    {
+        report.phases.push_back(Erase());
+    }
+    StartJournal(imageId, journal, report);
+}
+
+void Programmer::StartJournal(uint32_t imageId, PageJournal &journal, ProgramReport &report)
+{
+    if (journal.supported)
+    {
+        PhaseStats stats;
+        auto start = Clock::now();
+        PreparedFrame begin(MakeStartJournal(imageId, options.timing));
+        Reply reply = link.Transact(begin);
+        CheckStatus(reply, "journal");
+        if (!journal.Parse(reply) || (journal.imageId != imageId))
+        {
+            throw ProgramError("journal: the device did not take the image ID");
+        }
+        stats.name = "journal";
+        stats.frames = 1U;
+        stats.payloadBytes = begin.frame.data.size();
+        stats.wireBytes = begin.wire.size();
+        stats.seconds = Seconds(start, Clock::now());
+        report.phases.push_back(stats);
+    }
+}
+
+PhaseStats Programmer::Erase()
+{
+    PhaseStats stats;
+    auto start = Clock::now();
+    uint16_t pages = static_cast<uint16_t>((PROGMEM_SIZE - START_OF_APP) / PROGMEM_PAGE_SIZE);
+    std::vector<std::pair<uint32_t, uint16_t>> runs;
+
+    if (!capabilities.HasFeature(FEATURE_SKIP_BLANK) && capabilities.HasCommand(BLANK_CHECK))
+    {
+        PreparedFrame check(MakeBlankCheck(START_OF_APP, pages));
+        BlankMap map;
+        if (!map.Parse(link.Transact(check), START_OF_APP, pages))
+        {
+            throw ProgramError("blank check: no blank map in the reply");
+        }
+        stats.frames++;
+        stats.wireBytes += check.wire.size();
+        for (uint16_t page = 0U; page < pages; page++)
+        {
+            uint32_t address = START_OF_APP + (static_cast<uint32_t>(page) * PROGMEM_PAGE_SIZE);
+            if (map.Blank(page))
+            {
+                continue;
+            }
+            if (!runs.empty() && ((runs.back().first + (runs.back().second * PROGMEM_PAGE_SIZE)) == address))
+            {
+                runs.back().second++;
+            }
+            else
+            {
+                runs.emplace_back(address, 1U);
+            }
+        }
+        stats.eraseCounts = true;
+        stats.pagesBlank = map.blankPages;
+        stats.pagesErased = pages - map.blankPages;
+    }
+    else
+    {
+        runs.emplace_back(START_OF_APP, pages);
+    }
+
+    for (const auto &run : runs)
+    {
+        PreparedFrame erase(MakeEraseFlash(run.first, run.second, options.timing));
+        Reply reply = link.Transact(erase);
+        CheckStatus(reply, "erase");
+        stats.CountErases(reply);
+        stats.frames++;
+        stats.wireBytes += erase.wire.size();
+    }
+
+    stats.name = "erase";
+    stats.seconds = Seconds(start, Clock::now());
+    return stats;
+}
+
+PhaseStats Programmer::SendFrames(const std::string &name, const std::vector<PreparedFrame> &frames)
+{
+    PhaseStats stats;
+    auto start = Clock::now();
+
+    stats.name = name;
+    for (const PreparedFrame &prepared : frames)
+    {
+        char context[48];
+        std::snprintf(context, sizeof(context), "%s 0x%06X", name.c_str(), prepared.frame.address);
+        Reply reply = link.Transact(prepared);
+        CheckStatus(reply, context);
+        if (name != PHASE_NAMES[0])
+        {
+            stats.CountWrites(reply);
+        }
+        stats.frames++;
+        stats.payloadBytes += prepared.frame.data.size();
+        stats.wireBytes += prepared.wire.size();
+    }
+    stats.seconds = Seconds(start, Clock::now());
+    return stats;
+}
+
+PhaseStats Programmer::Verify(uint16_t expected, ProgramReport &report)
+{
+    PhaseStats stats;
+    auto start = Clock::now();
+    PreparedFrame checksum(MakeCalcChecksum(START_OF_APP, PROGMEM_SIZE - START_OF_APP));
+    Reply reply = link.Transact(checksum);
+
+    if (reply.DataLength() < 2U)
+    {
+        throw ProgramError("verify: " + StatusName(reply.Status()));
+    }
+    CheckChecksum(expected, static_cast<uint16_t>(reply.Data()[0] | (reply.Data()[1] << 8U)), report);
+
+    stats.name = "verify";
+    stats.frames = 1U;
+    stats.wireBytes = checksum.wire.size();
+    stats.payloadBytes = PROGMEM_SIZE - START_OF_APP;
+    stats.seconds = Seconds(start, Clock::now());
+    return stats;
+}
+
+uint16_t Programmer::DeviceChecksum(ProgramReport &report)
+{
+    PhaseStats stats;
+    auto start = Clock::now();
+    PreparedFrame checksum(MakeCalcChecksum(START_OF_APP, PROGMEM_SIZE - START_OF_APP));
+    Reply reply = link.Transact(checksum);
+
+    if (reply.DataLength() < 2U)
+    {
+        throw ProgramError("base checksum: " + StatusName(reply.Status()));
+    }
+
+    stats.name = "base";
+    stats.frames = 1U;
+    stats.wireBytes = checksum.wire.size();
+    stats.payloadBytes = PROGMEM_SIZE - START_OF_APP;
+    stats.seconds = Seconds(start, Clock::now());
+    report.phases.push_back(stats);
+    return static_cast<uint16_t>(reply.Data()[0] | (reply.Data()[1] << 8U));
+}
+
+void Programmer::CheckChecksum(uint16_t expected, uint16_t device, ProgramReport &report)
+{
+    report.expectedChecksum = expected;
+    report.deviceChecksum = device;
+    if (device != expected)
+    {
+        char message[64];
+        std::snprintf(message, sizeof(message), "verify: device checksum 0x%04X, expected 0x%04X", device, expected);
+        throw ProgramError(message);
+    }
+    report.verified = true;
+}
+
+PhaseStats Programmer::VerifyAndReset(uint16_t expected, ProgramReport &report)
+{
+    PhaseStats stats;
+    auto start = Clock::now();
+    // The device resets before the host compares the checksum; its own boot verification keeps a bad image from running
+    PreparedFrame batch(MakeBatch({MakeCalcChecksum(START_OF_APP, PROGMEM_SIZE - START_OF_APP), MakeResetDevice()}));
+    Reply reply = link.Transact(batch);
+
+    if (reply.DataLength() < BATCH_REPLY_SIZE)
+    {
+        throw ProgramError("verify: " + StatusName(reply.Status()));
+    }
+    CheckStatus(reply, "verify");
+    CheckChecksum(expected, static_cast<uint16_t>(reply.Data()[2] | (reply.Data()[3] << 8U)), report);
+
+    stats.name = "finish";
+    stats.frames = 1U;
+    stats.wireBytes = batch.wire.size();
+    stats.payloadBytes = PROGMEM_SIZE - START_OF_APP;
+    stats.seconds = Seconds(start, Clock::now());
+    return stats;
+}
+
+void Programmer::Finish(uint16_t expected, ProgramReport &report)
+{
+    if (options.verify && options.reset && Batching())
+    {
+        report.phases.push_back(VerifyAndReset(expected, report));
+        return;
+    }
+    if (options.verify)
+    {
+        report.phases.push_back(Verify(expected, report));
+    }
+    if (options.reset)
+    {
+        report.phases.push_back(Reset());
+    }
+    else if (link.ReplyMode() != REPLY_FULL)
+    {
+        // Other hosts, such as UBHA, expect full replies
+        SelectReplyMode(REPLY_FULL);
+    }
+}
+
+size_t Programmer::SelectReplyMode(uint8_t mode)
+{
+    PreparedFrame frame(MakeReplyMode(mode));
+    Reply reply = link.Transact(frame);
+
+    CheckStatus(reply, "reply mode");
+    if (reply.DataLength() < REPLY_MODE_SIZE)
+    {
+        throw ProgramError("reply mode: short reply");
+    }
+    link.SetReplyMode(reply.Data()[1], reply.Data()[2]);
+    return frame.wire.size();
+}
+
+PhaseStats Programmer::Reset()
+{
+    PhaseStats stats;
+    auto start = Clock::now();
+    PreparedFrame reset(MakeResetDevice());
+
+    CheckStatus(link.Transact(reset), "reset");
+
+    stats.name = "reset";
+    stats.frames = 1U;
+    stats.wireBytes = reset.wire.size();
+    stats.seconds = Seconds(start, Clock::now());
+    return stats;
+}
+
+ProgramReport Programmer::Program(const MemoryImage &image)
+{
+    ProgramReport report;
+    auto start = Clock::now();
+    FrameQueue queue(options.pipelineDepth);
+    double prepareSeconds[3] = {0.0, 0.0, 0.0};
+    uint32_t blankPages = 0U;
+    uint32_t outsidePages = 0U;
+    uint16_t expected = 0U;
+    // One nonce per image; the page address makes the CCM nonce of each page unique
+    const Aes128 cipher(options.secureKey.value_or(SecureKey{}));
+    report.secure = options.secureKey.has_value();
+    report.nonce = RandomNonce();
+
+    std::vector<uint32_t> pages = AppPages(image, blankPages, outsidePages);
+    if (outsidePages != 0U)
+    {
+        std::fprintf(stderr, "warning: %u page(s) below 0x%X are not programmed\n", outsidePages, START_OF_APP);
+    }
+
+    // The journal decides which pages are still to be sent, so it is read before the producer starts
+    PageJournal journal;
+    uint32_t imageId = ImageId(image);
+    bool resuming = Query(imageId, journal, report);
+    if (resuming)
+    {
+        std::vector<uint32_t> missing;
+        for (uint32_t pageAddress : pages)
+        {
+            if (journal.Committed(pageAddress))
+            {
+                report.pagesResumed++;
+            }
+            else
+            {
+                missing.push_back(pageAddress);
+            }
+        }
+        pages.swap(missing);
+    }
+
+    // Producer: encodes frames while the erase and earlier writes are on the wire
+    std::thread producer([&]() {
+        for (uint32_t pageAddress : pages)
+        {
+            auto itemStart = Clock::now();
+            WorkItem item;
+            item.phase = Phase::Flash;
+            item.prepared = report.secure ? PackSecurePage(image, pageAddress, cipher, report.nonce, options.timing)
+                                          : PackFlashPage(image, pageAddress, options.timing);
+            prepareSeconds[0] += Seconds(itemStart, Clock::now());
+            if (!queue.Push(std::move(item)))
+            {
+                return;
+            }
+        }
+        auto checksumStart = Clock::now();
+        expected = ExpectedAppChecksum(image);
+        prepareSeconds[0] += Seconds(checksumStart, Clock::now());
+
+        PackDataRegions(image, options, Batching(), [&](Phase phase, Frame frame) {
+            auto itemStart = Clock::now();
+            WorkItem item;
+            item.phase = phase;
+            item.prepared = PreparedFrame(std::move(frame));
+            prepareSeconds[static_cast<int>(phase)] += Seconds(itemStart, Clock::now());
+            queue.Push(std::move(item));
+        });
+        queue.Push(WorkItem());
+    });
+
+    try
+    {
+        if (!resuming)
+        {
+            StartUpdate(imageId, journal, report);
+        }
+
+        PhaseStats current;
+        Phase currentPhase = Phase::Flash;
+        auto phaseStart = Clock::now();
+        current.name = PHASE_NAMES[0];
+
+        for (WorkItem item = queue.Pop(); item.phase != Phase::Done; item = queue.Pop())
+        {
+            if (item.phase != currentPhase)
+            {
+                current.seconds = Seconds(phaseStart, Clock::now());
+                report.phases.push_back(current);
+                current = PhaseStats();
+                current.name = PHASE_NAMES[static_cast<int>(item.phase)];
+                currentPhase = item.phase;
+                phaseStart = Clock::now();
+            }
+
+            char context[48];
+            std::snprintf(context, sizeof(context), "%s 0x%06X", current.name.c_str(), item.prepared.frame.address);
+            Reply reply = link.Transact(item.prepared);
+            CheckStatus(reply, context);
+            if (item.phase != Phase::Flash)
+            {
+                current.CountWrites(reply);
+            }
+            current.frames++;
+            current.payloadBytes += item.prepared.frame.data.size();
+            current.wireBytes += item.prepared.wire.size();
+        }
+        current.seconds = Seconds(phaseStart, Clock::now());
+        report.phases.push_back(current);
+    }
+    catch (...)
+    {
+        queue.Cancel();
+        producer.join();
+        throw;
+    }
+    producer.join();
+
+    for (PhaseStats &phase : report.phases)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            if (phase.name == PHASE_NAMES[i])
+            {
+                phase.prepareSeconds = prepareSeconds[i];
+            }
+        }
+    }
+
+    Finish(expected, report);
+
+    report.blankPagesSkipped = blankPages;
+    report.link = link.Stats();
+    report.totalSeconds = Seconds(start, Clock::now());
+    return report;
+}
+
+ProgramReport Programmer::Program(const PackedImage &packed)
+{
+    ProgramReport report;
+    auto start = Clock::now();
+    PageJournal journal;
+    std::vector<PreparedFrame> resumedFrames;
+    const std::vector<PreparedFrame> *flashFrames = &packed.flashFrames;
+
+    if (Query(packed.imageId, journal, report))
+    {
+        for (const PreparedFrame &prepared : packed.flashFrames)
+        {
+            if (journal.Committed(prepared.frame.address))
+            {
+                report.pagesResumed++;
+            }
+            else
+            {
+                resumedFrames.push_back(prepared);
+            }
+        }
+        flashFrames = &resumedFrames;
+    }
+    else
+    {
+        StartUpdate(packed.imageId, journal, report);
+    }
+    report.phases.push_back(SendFrames("write", *flashFrames));
+    if (!packed.eepromFrames.empty())
+    {
+        report.phases.push_back(SendFrames("eeprom", Batched(packed.eepromFrames)));
+    }
+    if (!packed.configFrames.empty())
+    {
+        report.phases.push_back(SendFrames("config", Batched(packed.configFrames)));
+    }
+    Finish(packed.expectedChecksum, report);
+
+    report.blankPagesSkipped = packed.blankPagesSkipped;
+    report.secure = packed.secure;
+    report.nonce = packed.nonce;
+    report.link = link.Stats();
+    report.totalSeconds = Seconds(start, Clock::now());
+    return report;
+}
+
+
+ProgramReport Programmer::Patch(const MemoryImage &oldImage, const MemoryImage &image)
+{
+    ProgramReport report;
+    auto start = Clock::now();
+    PageJournal journal;
+    uint32_t imageId = ImageId(image);
+
+    Query(imageId, journal, report);
+    if (!capabilities.HasCommand(PATCH))
+    {
+        std::fprintf(stderr, "warning: the device does not list PATCH (BL_CMD_PATCH_ENABLE), programming the full image\n");
+        return Program(image);
+    }
+    // COPY instructions read the flash, so it has to hold the old image
+    uint16_t base = ExpectedAppChecksum(oldImage);
+    uint16_t device = DeviceChecksum(report);
+    if (device != base)
+    {
+        std::fprintf(stderr, "warning: device checksum 0x%04X is not the one of the old image (0x%04X), programming the full image\n",
+                     device, base);
+        return Program(image);
+    }
+    // A journal of the old image would let a later resume skip pages that were patched since
+    StartJournal(imageId, journal, report);
+
+    auto prepareStart = Clock::now();
+    Delta delta = MakeDelta(oldImage.Flatten(START_OF_APP, PROGMEM_SIZE), image.Flatten(START_OF_APP, PROGMEM_SIZE));
+    std::vector<PreparedFrame> frames;
+    for (const PagePatch &page : delta.pages)
+    {
+        frames.emplace_back(page.write ? MakeWriteFlash(page.address, page.data.data(), static_cast<uint16_t>(page.data.size()), options.timing)
+                                       : MakePatch(page.address, page.data, options.timing));
+    }
+    uint16_t expected = ExpectedAppChecksum(image);
+    double prepareSeconds = Seconds(prepareStart, Clock::now());
+
+    report.phases.push_back(SendFrames("patch", Batched(frames)));
+    report.phases.back().prepareSeconds = prepareSeconds;
+    std::vector<PreparedFrame> eeprom;
+    std::vector<PreparedFrame> config;
+    PackDataRegions(image, options, false, [&](Phase phase, Frame frame) {
+        ((phase == Phase::Eeprom) ? eeprom : config).emplace_back(std::move(frame));
+    });
+    if (!eeprom.empty())
+    {
+        report.phases.push_back(SendFrames("eeprom", Batched(eeprom)));
+    }
+    if (!config.empty())
+    {
+        report.phases.push_back(SendFrames("config", Batched(config)));
+    }
+    Finish(expected, report);
+
+    report.patched = true;
+    report.pagesPatched = delta.pagesPatched;
+    report.pagesWritten = delta.pagesWritten;
+    report.pagesUnchanged = delta.pagesUnchanged;
+    report.deltaBytes = delta.dataBytes;
+    report.link = link.Stats();
+    report.totalSeconds = Seconds(start, Clock::now());
+    return report;
+}
+
+}
@@ -0,0 +1,242 @@
+/**
+ *
+ * @file programmer.hpp
+ *
+ * @brief Programming flow: erase, write, EEPROM, verify and reset, with per-phase statistics.
+ */
+
+#ifndef PROGRAMMER_HPP
+#define PROGRAMMER_HPP
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "device_link.hpp"
+#include "hex_file.hpp"
+#include "secure.hpp"
+
+namespace blhost
+{
+
+struct ProgramOptions
+{
+    bool erase = true;
+    bool eeprom = true;
+    bool config = false;
+    bool verify = true;
+    bool reset = true;
+    /** Continue an interrupted update of the same image: skip the erase and the pages the device journal holds. */
+    bool resume = false;
+    /**
+     * Packs the EEPROM and configuration frames, and the final verify and reset, into BATCH frames
+     * when the capability block of the device lists BATCH.
+     */
+    bool batch = true;
+    /**
+     * Asks devices that list REPLY_MODE for compact replies: a successful status reply is then 2 bytes after STX
+     * instead of 10. The device is set back to full replies when it is not reset at the end.
+     */
+    bool compact = true;
+    /**
+     * Sends the application pages as SECURE_WRITE frames sealed under this key, for devices built with
+     * BL_CMD_SECURE_WRITE_ENABLE; each image gets a new random nonce.
+     */
+    std::optional<SecureKey> secureKey;
+    /** Frames prepared ahead of the one on the wire. */
+    size_t pipelineDepth = 8U;
+    NvmTiming timing;
+};
+
+/**
+ * @brief Everything the device has to receive for one image, encoded once.
+ */
+struct PackedImage
+{
+    std::vector<PreparedFrame> flashFrames;
+    std::vector<PreparedFrame> eepromFrames;
+    std::vector<PreparedFrame> configFrames;
+    uint32_t blankPagesSkipped = 0U;
+    uint32_t pagesOutsideApp = 0U;
+    uint32_t flashPayloadBytes = 0U;
+    uint16_t expectedChecksum = 0U;
+    uint32_t imageId = 0U;
+    /** The flash frames are SECURE_WRITE frames under this nonce. */
+    bool secure = false;
+    SecureNonce nonce{};
+};
+
+/**
+ * @brief Page journal of a device built with BL_JOURNAL_ENABLE, as returned by JOURNAL.
+ */
+struct PageJournal
+{
+    bool supported = false;
+    uint32_t imageId = JOURNAL_NO_IMAGE;
+    std::vector<uint8_t> bitmap;
+
+    /** Returns false when the reply carries no journal, e.g. INVALID_COMMAND from a bootloader without one. */
+    bool Parse(const Reply &reply);
+    bool Committed(uint32_t pageAddress) const;
+};
+
+/**
+ * @brief Blank pages of a flash range, as returned by BLANK_CHECK.
+ */
+struct BlankMap
+{
+    uint32_t address = 0U;
+    uint16_t pages = 0U;
+    uint16_t blankPages = 0U;
+    std::vector<uint8_t> bitmap;
+
+    /** Returns false when the reply carries no map, e.g. INVALID_COMMAND from a bootloader without BLANK_CHECK. */
+    bool Parse(const Reply &reply, uint32_t start, uint16_t count);
+    bool Blank(uint16_t page) const { return (bitmap[page / 8U] & (1U << (page % 8U))) != 0U; }
+};
+
+struct PhaseStats
+{
+    std::string name;
+    double seconds = 0.0;
+    /** Time spent preparing frames for this phase on the producer thread. */
+    double prepareSeconds = 0.0;
+    uint64_t frames = 0U;
+    uint64_t payloadBytes = 0U;
+    uint64_t wireBytes = 0U;
+    /** EEPROM and configuration bytes the device programmed or skipped as unchanged, if it reports them. */
+    bool writeCounts = false;
+    uint64_t bytesProgrammed = 0U;
+    uint64_t bytesSkipped = 0U;
+
+    /** Pages erased and blank pages left as they were, if the device reports them. */
+    bool eraseCounts = false;
+    uint64_t pagesErased = 0U;
+    uint64_t pagesBlank = 0U;
+
+    /** Adds the counts of a WRITE_EE_DATA or WRITE_CONFIG reply. */
+    void CountWrites(const Reply &reply);
+    /** Adds the counts of an ERASE_FLASH reply. */
+    void CountErases(const Reply &reply);
+};
+
+struct ProgramReport
+{
+    std::vector<PhaseStats> phases;
+    LinkStats link;
+    uint32_t blankPagesSkipped = 0U;
+    uint16_t expectedChecksum = 0U;
+    uint16_t deviceChecksum = 0U;
+    bool verified = false;
+    /** The device keeps a page journal; resumed is set when it already held pages of this image. */
+    bool journal = false;
+    bool resumed = false;
+    uint32_t imageId = 0U;
+    uint32_t pagesResumed = 0U;
+    /** Update sent as a delta: pages patched, written in full and left as they were, and the bytes of patch data. */
+    bool patched = false;
+    uint32_t pagesPatched = 0U;
+    uint32_t pagesWritten = 0U;
+    uint32_t pagesUnchanged = 0U;
+    uint64_t deltaBytes = 0U;
+    /** Pages sent as SECURE_WRITE frames under this image nonce. */
+    bool secure = false;
+    SecureNonce nonce{};
+    double totalSeconds = 0.0;
+
+    void Print(const std::string &label) const;
+};
+
+class ProgramError : public std::runtime_error
+{
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/** Frames for one flash page (page aligned, full page). */
+PreparedFrame PackFlashPage(const MemoryImage &image, uint32_t pageAddress, const NvmTiming &timing);
+
+/** SECURE_WRITE frame for one flash page, sealed under the image nonce. */
+PreparedFrame PackSecurePage(const MemoryImage &image, uint32_t pageAddress, const Aes128 &cipher, const SecureNonce &nonce,
+                             const NvmTiming &timing);
+
+/** Encodes the whole image up front. Used when one image feeds several devices. */
+PackedImage PackImage(const MemoryImage &image, const ProgramOptions &options);
+
+/** Checksum the device is expected to report for the application area. */
+uint16_t ExpectedAppChecksum(const MemoryImage &image);
+
+/** ID the device journal is started with: CRC-32 over the address and data of each application page sent. */
+uint32_t ImageId(const MemoryImage &image);
+
+/**
+ * Throws ProgramError when a reply carries an error status. For BATCH it names the frame that failed and its address,
+ * for WRITE_EE_DATA the EEPROM byte that failed, which the EEPROM write queue may have taken from an earlier frame.
+ */
+void CheckStatus(const Reply &reply, const std::string &context);
+
+class Programmer
+{
+public:
+    Programmer(DeviceLink &link, const ProgramOptions &options) : link(link), options(options) {}
+
+    /** Programs the image, packing frames on a producer thread while earlier frames are on the wire. */
+    ProgramReport Program(const MemoryImage &image);
+
+    /** Programs an image that was packed beforehand. */
+    ProgramReport Program(const PackedImage &packed);
+
+    /**
+     * Updates a device that holds oldImage to image with PATCH frames for the changed pages, and programs the
+     * EEPROM and configuration bytes as Program does. Programs the full image instead when the device does not
+     * list PATCH, or when its application checksum is not the one of oldImage.
+     */
+    ProgramReport Patch(const MemoryImage &oldImage, const MemoryImage &image);
+
+private:
+    /**
+     * Reads the capability block and the device journal, and selects the reply mode on devices with REPLY_MODE;
+     * returns true when options.resume is set and the journal belongs to this image.
+     */
+    bool Query(uint32_t imageId, PageJournal &journal, ProgramReport &report);
+    /**
+     * Throws ProgramError when the device does not list the command the pages would be sent with: SECURE_WRITE
+     * with a key, else WRITE_FLASH, which a bootloader built without BL_PLAINTEXT_FLASH_ENABLE leaves out.
+     */
+    void CheckWriteCommand() const;
+    /** Sends REPLY_MODE and has the link follow the mode the device acknowledged; returns the bytes sent. */
+    size_t SelectReplyMode(uint8_t mode);
+    /** BATCH frames may be sent: enabled in the options and listed by the device. */
+    bool Batching() const { return options.batch && capabilities.HasCommand(BATCH); }
+    /** The frames as they go on the wire, packed into BATCH frames when Batching. */
+    std::vector<PreparedFrame> Batched(const std::vector<PreparedFrame> &frames) const;
+    /** Erases the application area and, on devices with a journal, starts it for this image. */
+    void StartUpdate(uint32_t imageId, PageJournal &journal, ProgramReport &report);
+    /** Starts the journal of a device that keeps one for this image; its pages are not committed yet. */
+    void StartJournal(uint32_t imageId, PageJournal &journal, ProgramReport &report);
+    /** Application checksum of the device, reported as the "base" phase. */
+    uint16_t DeviceChecksum(ProgramReport &report);
+    /**
+     * Erases the application area. A device that lists BLANK_CHECK but does not skip blank pages itself is sent
+     * one ERASE_FLASH per run of pages that are not blank.
+     */
+    PhaseStats Erase();
+    PhaseStats SendFrames(const std::string &name, const std::vector<PreparedFrame> &frames);
+    PhaseStats Verify(uint16_t expected, ProgramReport &report);
+    PhaseStats Reset();
+    /** CALC_CHECKSUM and RESET_DEVICE in one BATCH frame, reported as the "finish" phase. */
+    PhaseStats VerifyAndReset(uint16_t expected, ProgramReport &report);
+    /** Verifies and resets as the options ask. */
+    void Finish(uint16_t expected, ProgramReport &report);
+    /** Compares the checksum the device reported with the expected one; throws ProgramError on a mismatch. */
+    void CheckChecksum(uint16_t expected, uint16_t device, ProgramReport &report);
+
+    DeviceLink &link;
+    ProgramOptions options;
+    Capabilities capabilities;
+};
+
+}
+
+#endif // PROGRAMMER_HPP
@@ -0,0 +1,234 @@
+/**
+ *
+ * @file secure.cpp
+ *
+ * @brief AES-128-CCM sealing of application pages for SECURE_WRITE, the host side of bl_secure.c.
+ */
+
+#include "secure.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+
+namespace blhost
+{
+
+namespace
+{
+
+constexpr unsigned ROUNDS = 10U;
+constexpr uint8_t B0_FLAGS = 0x1BU;
+constexpr uint8_t CTR_FLAGS = 0x03U;
+
+const uint8_t SBOX[256] = {
+    0x63U, 0x7CU, 0x77U, 0x7BU, 0xF2U, 0x6BU, 0x6FU, 0xC5U, 0x30U, 0x01U, 0x67U, 0x2BU, 0xFEU, 0xD7U, 0xABU, 0x76U,
+    0xCAU, 0x82U, 0xC9U, 0x7DU, 0xFAU, 0x59U, 0x47U, 0xF0U, 0xADU, 0xD4U, 0xA2U, 0xAFU, 0x9CU, 0xA4U, 0x72U, 0xC0U,
+    0xB7U, 0xFDU, 0x93U, 0x26U, 0x36U, 0x3FU, 0xF7U, 0xCCU, 0x34U, 0xA5U, 0xE5U, 0xF1U, 0x71U, 0xD8U, 0x31U, 0x15U,
+    0x04U, 0xC7U, 0x23U, 0xC3U, 0x18U, 0x96U, 0x05U, 0x9AU, 0x07U, 0x12U, 0x80U, 0xE2U, 0xEBU, 0x27U, 0xB2U, 0x75U,
+    0x09U, 0x83U, 0x2CU, 0x1AU, 0x1BU, 0x6EU, 0x5AU, 0xA0U, 0x52U, 0x3BU, 0xD6U, 0xB3U, 0x29U, 0xE3U, 0x2FU, 0x84U,
+    0x53U, 0xD1U, 0x00U, 0xEDU, 0x20U, 0xFCU, 0xB1U, 0x5BU, 0x6AU, 0xCBU, 0xBEU, 0x39U, 0x4AU, 0x4CU, 0x58U, 0xCFU,
+    0xD0U, 0xEFU, 0xAAU, 0xFBU, 0x43U, 0x4DU, 0x33U, 0x85U, 0x45U, 0xF9U, 0x02U, 0x7FU, 0x50U, 0x3CU, 0x9FU, 0xA8U,
+    0x51U, 0xA3U, 0x40U, 0x8FU, 0x92U, 0x9DU, 0x38U, 0xF5U, 0xBCU, 0xB6U, 0xDAU, 0x21U, 0x10U, 0xFFU, 0xF3U, 0xD2U,
+    0xCDU, 0x0CU, 0x13U, 0xECU, 0x5FU, 0x97U, 0x44U, 0x17U, 0xC4U, 0xA7U, 0x7EU, 0x3DU, 0x64U, 0x5DU, 0x19U, 0x73U,
+    0x60U, 0x81U, 0x4FU, 0xDCU, 0x22U, 0x2AU, 0x90U, 0x88U, 0x46U, 0xEEU, 0xB8U, 0x14U, 0xDEU, 0x5EU, 0x0BU, 0xDBU,
+    0xE0U, 0x32U, 0x3AU, 0x0AU, 0x49U, 0x06U, 0x24U, 0x5CU, 0xC2U, 0xD3U, 0xACU, 0x62U, 0x91U, 0x95U, 0xE4U, 0x79U,
+    0xE7U, 0xC8U, 0x37U, 0x6DU, 0x8DU, 0xD5U, 0x4EU, 0xA9U, 0x6CU, 0x56U, 0xF4U, 0xEAU, 0x65U, 0x7AU, 0xAEU, 0x08U,
+    0xBAU, 0x78U, 0x25U, 0x2EU, 0x1CU, 0xA6U, 0xB4U, 0xC6U, 0xE8U, 0xDDU, 0x74U, 0x1FU, 0x4BU, 0xBDU, 0x8BU, 0x8AU,
+    0x70U, 0x3EU, 0xB5U, 0x66U, 0x48U, 0x03U, 0xF6U, 0x0EU, 0x61U, 0x35U, 0x57U, 0xB9U, 0x86U, 0xC1U, 0x1DU, 0x9EU,
+    0xE1U, 0xF8U, 0x98U, 0x11U, 0x69U, 0xD9U, 0x8EU, 0x94U, 0x9BU, 0x1EU, 0x87U, 0xE9U, 0xCEU, 0x55U, 0x28U, 0xDFU,
+    0x8CU, 0xA1U, 0x89U, 0x0DU, 0xBFU, 0xE6U, 0x42U, 0x68U, 0x41U, 0x99U, 0x2DU, 0x0FU, 0xB0U, 0x54U, 0xBBU, 0x16U
+};
+
+uint8_t Xtime(uint8_t x)
+{
+    return static_cast<uint8_t>((x << 1U) ^ (((x & 0x80U) != 0U) ? 0x1BU : 0x00U));
+}
+
+/** A0 (counter 0) or B0 (length of one page) of the page at pageAddress. */
+std::array<uint8_t, SECURE_BLOCK_SIZE> FirstBlock(uint8_t flags, const uint8_t *nonce, uint32_t pageAddress, uint32_t last)
+{
+    std::array<uint8_t, SECURE_BLOCK_SIZE> block{};
+
+    block[0] = flags;
+    for (size_t i = 0U; i < SECURE_NONCE_SIZE; i++)
+    {
+        block[1U + i] = nonce[i];
+    }
+    block[9] = static_cast<uint8_t>(pageAddress);
+    block[10] = static_cast<uint8_t>(pageAddress >> 8U);
+    block[11] = static_cast<uint8_t>(pageAddress >> 16U);
+    block[12] = static_cast<uint8_t>(last >> 24U);
+    block[13] = static_cast<uint8_t>(last >> 16U);
+    block[14] = static_cast<uint8_t>(last >> 8U);
+    block[15] = static_cast<uint8_t>(last);
+    return block;
+}
+
+/**
+ * CTR over one page from in to out and the CBC-MAC over the plaintext, which is in when sealing and out when
+ * opening; returns the tag.
+ */
+std::array<uint8_t, SECURE_TAG_SIZE> Ccm(const Aes128 &cipher, const uint8_t *nonce, uint32_t pageAddress, const uint8_t *in,
+                                         uint8_t *out, bool sealing)
+{
+    std::array<uint8_t, SECURE_BLOCK_SIZE> mac = FirstBlock(B0_FLAGS, nonce, pageAddress, PROGMEM_PAGE_SIZE);
+    std::array<uint8_t, SECURE_TAG_SIZE> tag;
+
+    cipher.Encrypt(mac.data());
+    for (uint32_t block = 0U; block < (PROGMEM_PAGE_SIZE / SECURE_BLOCK_SIZE); block++)
+    {
+        std::array<uint8_t, SECURE_BLOCK_SIZE> stream = FirstBlock(CTR_FLAGS, nonce, pageAddress, block + 1U);
+        cipher.Encrypt(stream.data());
+        for (size_t i = 0U; i < SECURE_BLOCK_SIZE; i++)
+        {
+            size_t offset = (block * SECURE_BLOCK_SIZE) + i;
+            out[offset] = in[offset] ^ stream[i];
+            mac[i] ^= sealing ? in[offset] : out[offset];
+        }
+        cipher.Encrypt(mac.data());
+    }
+
+    std::array<uint8_t, SECURE_BLOCK_SIZE> first = FirstBlock(CTR_FLAGS, nonce, pageAddress, 0U);
+    cipher.Encrypt(first.data());
+    for (size_t i = 0U; i < SECURE_TAG_SIZE; i++)
+    {
+        tag[i] = mac[i] ^ first[i];
+    }
+    return tag;
+}
+
+}
+
+const SecureKey DEVELOPMENT_KEY = {0x2BU, 0x7EU, 0x15U, 0x16U, 0x28U, 0xAEU, 0xD2U, 0xA6U,
+                                   0xABU, 0xF7U, 0x15U, 0x88U, 0x09U, 0xCFU, 0x4FU, 0x3CU};
+
+SecureKey LoadSecureKey(const std::string &path)
+{
+    std::ifstream file(path);
+    std::string digits;
+    SecureKey key;
+    char c;
+
+    if (!file)
+    {
+        throw std::runtime_error("cannot open key file " + path);
+    }
+    while (file.get(c))
+    {
+        if (!std::isspace(static_cast<unsigned char>(c)))
+        {
+            digits.push_back(c);
+        }
+    }
+    if ((digits.size() != (2U * SECURE_KEY_SIZE)) || (digits.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos))
+    {
+        throw std::runtime_error("key file " + path + " does not hold 32 hex digits");
+    }
+    for (size_t i = 0U; i < SECURE_KEY_SIZE; i++)
+    {
+        key[i] = static_cast<uint8_t>(std::stoul(digits.substr(2U * i, 2U), nullptr, 16));
+    }
+    return key;
+}
+
+SecureNonce RandomNonce()
+{
+    std::random_device random;
+    SecureNonce nonce;
+
+    for (uint8_t &byte : nonce)
+    {
+        byte = static_cast<uint8_t>(random());
+    }
+    return nonce;
+}
+
+Aes128::Aes128(const SecureKey &key)
+{
+    uint8_t rcon = 0x01U;
+
+    std::copy(key.begin(), key.end(), roundKeys.begin());
+    for (size_t i = SECURE_KEY_SIZE; i < roundKeys.size(); i += 4U)
+    {
+        uint8_t word[4] = {roundKeys[i - 4U], roundKeys[i - 3U], roundKeys[i - 2U], roundKeys[i - 1U]};
+        if ((i % SECURE_KEY_SIZE) == 0U)
+        {
+            uint8_t first = word[0];
+            word[0] = SBOX[word[1]] ^ rcon;
+            word[1] = SBOX[word[2]];
+            word[2] = SBOX[word[3]];
+            word[3] = SBOX[first];
+            rcon = Xtime(rcon);
+        }
+        for (size_t j = 0U; j < 4U; j++)
+        {
+            roundKeys[i + j] = roundKeys[i + j - SECURE_KEY_SIZE] ^ word[j];
+        }
+    }
+}
+
+void Aes128::Encrypt(uint8_t *block) const
+{
+    uint8_t state[SECURE_BLOCK_SIZE];
+
+    for (size_t i = 0U; i < SECURE_BLOCK_SIZE; i++)
+    {
+        state[i] = block[i] ^ roundKeys[i];
+    }
+    for (unsigned round = 1U; round <= ROUNDS; round++)
+    {
+        // SubBytes and ShiftRows: byte r of column c comes from column c + r
+        uint8_t shifted[SECURE_BLOCK_SIZE];
+        for (size_t column = 0U; column < 4U; column++)
+        {
+            for (size_t row = 0U; row < 4U; row++)
+            {
+                shifted[(4U * column) + row] = SBOX[state[(4U * ((column + row) % 4U)) + row]];
+            }
+        }
+        if (round != ROUNDS)
+        {
+            for (size_t column = 0U; column < 4U; column++)
+            {
+                uint8_t *a = &shifted[4U * column];
+                uint8_t b[4] = {a[0], a[1], a[2], a[3]};
+                a[0] = Xtime(b[0]) ^ Xtime(b[1]) ^ b[1] ^ b[2] ^ b[3];
+                a[1] = b[0] ^ Xtime(b[1]) ^ Xtime(b[2]) ^ b[2] ^ b[3];
+                a[2] = b[0] ^ b[1] ^ Xtime(b[2]) ^ Xtime(b[3]) ^ b[3];
+                a[3] = Xtime(b[0]) ^ b[0] ^ b[1] ^ b[2] ^ Xtime(b[3]);
+            }
+        }
+        for (size_t i = 0U; i < SECURE_BLOCK_SIZE; i++)
+        {
+            state[i] = shifted[i] ^ roundKeys[(round * SECURE_BLOCK_SIZE) + i];
+        }
+    }
+    std::copy(state, state + SECURE_BLOCK_SIZE, block);
+}
+
+std::vector<uint8_t> SealPage(const Aes128 &cipher, const SecureNonce &nonce, uint32_t pageAddress, const uint8_t *page)
+{
+    std::vector<uint8_t> data(SECURE_FRAME_SIZE);
+
+    std::copy(nonce.begin(), nonce.end(), data.begin());
+    std::array<uint8_t, SECURE_TAG_SIZE> tag = Ccm(cipher, nonce.data(), pageAddress, page, &data[SECURE_NONCE_SIZE], true);
+    std::copy(tag.begin(), tag.end(), data.begin() + static_cast<std::ptrdiff_t>(SECURE_NONCE_SIZE + PROGMEM_PAGE_SIZE));
+    return data;
+}
+
+bool OpenPage(const Aes128 &cipher, const uint8_t *data, uint32_t pageAddress, uint8_t *page)
+{
+    std::array<uint8_t, SECURE_TAG_SIZE> tag = Ccm(cipher, data, pageAddress, data + SECURE_NONCE_SIZE, page, false);
+    uint8_t difference = 0U;
+
+    for (size_t i = 0U; i < SECURE_TAG_SIZE; i++)
+    {
+        difference |= tag[i] ^ data[SECURE_NONCE_SIZE + PROGMEM_PAGE_SIZE + i];
+    }
+    return difference == 0U;
+}
+
+}
@@ -0,0 +1,64 @@
+/**
+ *
+ * @file secure.hpp
+ *
+ * @brief AES-128-CCM sealing of application pages for SECURE_WRITE (BL_CMD_SECURE_WRITE_ENABLE), the host side
+ *        of bl_secure.c. The CCM nonce of a page is the 8 byte image nonce and the 3 byte page address, little-endian;
+ *        there is no associated data and the tag is 8 bytes.
+ */
+
+#ifndef SECURE_HPP
+#define SECURE_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "bl_protocol.hpp"
+
+namespace blhost
+{
+
+constexpr size_t SECURE_KEY_SIZE = 16U;
+constexpr size_t SECURE_BLOCK_SIZE = 16U;
+
+using SecureKey = std::array<uint8_t, SECURE_KEY_SIZE>;
+using SecureNonce = std::array<uint8_t, SECURE_NONCE_SIZE>;
+
+/** Default BL_SECURE_KEY of bl_boot_config.h, for development devices only. */
+extern const SecureKey DEVELOPMENT_KEY;
+
+/** Reads a key file of 32 hex digits; white space is ignored. Throws std::runtime_error. */
+SecureKey LoadSecureKey(const std::string &path);
+
+/** Nonce for one image, from std::random_device. A nonce must not be used twice with the same key. */
+SecureNonce RandomNonce();
+
+/**
+ * @brief AES-128 encryption with the key expanded once; CCM needs no decryption direction.
+ */
+class Aes128
+{
+public:
+    explicit Aes128(const SecureKey &key);
+
+    void Encrypt(uint8_t *block) const;
+
+private:
+    std::array<uint8_t, 11U * SECURE_BLOCK_SIZE> roundKeys;
+};
+
+/** SECURE_WRITE data for the page at pageAddress: [NONCE][CIPHERTEXT][TAG]. */
+std::vector<uint8_t> SealPage(const Aes128 &cipher, const SecureNonce &nonce, uint32_t pageAddress, const uint8_t *page);
+
+/**
+ * Decrypts SECURE_WRITE data of SECURE_FRAME_SIZE bytes into page, as BL_SecurePageOpen does; returns false when
+ * the tag does not match, page then holds the decrypted bytes all the same.
+ */
+bool OpenPage(const Aes128 &cipher, const uint8_t *data, uint32_t pageAddress, uint8_t *page);
+
+}
+
+#endif // SECURE_HPP
@@ -0,0 +1,404 @@
+/**
+ *
+ * @file secure_bench_main.cpp
+ *
+ * @brief bl_secbench: checks the AES-128-CCM code of SECURE_WRITE and the SHA-256 code of DIGEST against
+ *        known-answer vectors and times them.
+ *
+ *        bl_secbench [VECTORS] [-b BAUD] [-n PAGES]
+ *
+ *        VECTORS (default vectors/secure_vectors.txt, from vectors/secure_vectors.sh) is checked against the host
+ *        code of secure.cpp, and its vectors under the development key against the firmware code of bl_secure.c,
+ *        compiled for Linux with BL_SECURE_DEVELOPMENT_KEY. The firmware code must also reject every page with one
+ *        byte of the nonce, the ciphertext or the tag changed, and under another page address. Then PAGES pages
+ *        (default 2000) are opened with BL_SecurePageOpen and the time per byte is compared with the time a
+ *        SECURE_WRITE frame takes on the wire at BAUD. The PIC18 time per byte comes from the secure_page
+ *        primitive of PIC18F57Q43_Bench.X; the time here only shows the cost of the code relative to the host.
+ *
+ *        The digest vectors are checked against sha256.cpp and against BL_DigestFlash of bl_digest.c, which reads
+ *        the message from a model of the flash through TBLRD*+ at an odd address, and the application area is
+ *        hashed both ways to compare their time per KB. The PIC18 figure comes from the digest primitive.
+ */
+
+#include "bl_protocol.hpp"
+#include "secure.hpp"
+#include "sha256.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+extern "C"
+{
+void BL_SecureInitialize(void);
+void BL_SecureBlockEncrypt(uint8_t *block);
+bool BL_SecurePageOpen(uint8_t *data, uint32_t pageAddress);
+void BL_DigestFlash(uint32_t address, uint32_t length, uint8_t *digest);
+
+extern volatile uint8_t TBLPTRU;
+extern volatile uint8_t TBLPTRH;
+extern volatile uint8_t TBLPTRL;
+extern volatile uint8_t TABLAT;
+}
+
+namespace
+{
+
+std::vector<uint8_t> flash(blhost::PROGMEM_SIZE, 0xFFU);
+
+}
+
+/** The table reads of bl_digest.c, from the flash model. */
+extern "C" void SIM_Asm(const char *text)
+{
+    if (std::strncmp(text, "TBLRD*", 6U) != 0)
+    {
+        std::fprintf(stderr, "bl_secbench: unsupported inline assembly %s\n", text);
+        std::exit(1);
+    }
+    uint32_t tablePointer = (static_cast<uint32_t>(TBLPTRU) << 16U) | (static_cast<uint32_t>(TBLPTRH) << 8U) | TBLPTRL;
+    TABLAT = flash[tablePointer % flash.size()];
+    if (text[6] == '+')
+    {
+        tablePointer++;
+        TBLPTRU = static_cast<uint8_t>(tablePointer >> 16U);
+        TBLPTRH = static_cast<uint8_t>(tablePointer >> 8U);
+        TBLPTRL = static_cast<uint8_t>(tablePointer);
+    }
+}
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+std::vector<uint8_t> FromHex(const std::string &text)
+{
+    std::vector<uint8_t> bytes;
+
+    if ((text.size() % 2U) != 0U)
+    {
+        throw std::runtime_error("odd hex string in the vectors");
+    }
+    for (size_t i = 0U; i < text.size(); i += 2U)
+    {
+        bytes.push_back(static_cast<uint8_t>(std::stoul(text.substr(i, 2U), nullptr, 16)));
+    }
+    return bytes;
+}
+
+blhost::SecureKey ToKey(const std::vector<uint8_t> &bytes)
+{
+    blhost::SecureKey key;
+
+    if (bytes.size() != key.size())
+    {
+        throw std::runtime_error("key of the wrong length in the vectors");
+    }
+    std::memcpy(key.data(), bytes.data(), key.size());
+    return key;
+}
+
+struct Results
+{
+    unsigned checks = 0U;
+    unsigned failures = 0U;
+
+    void Check(bool passed, const char *what, unsigned line)
+    {
+        checks++;
+        if (!passed)
+        {
+            failures++;
+            std::printf("  line %u: %s FAILED\n", line, what);
+        }
+    }
+};
+
+/** BL_SecurePageOpen on a copy of data, as the frame buffer would hold it. */
+bool FirmwareOpen(const std::vector<uint8_t> &data, uint32_t address, std::vector<uint8_t> *page)
+{
+    std::vector<uint8_t> buffer = data;
+    bool opened = BL_SecurePageOpen(buffer.data(), address);
+
+    if (page != nullptr)
+    {
+        page->assign(buffer.begin() + blhost::SECURE_NONCE_SIZE, buffer.begin() + blhost::SECURE_NONCE_SIZE + blhost::PROGMEM_PAGE_SIZE);
+    }
+    return opened;
+}
+
+void CheckPage(Results &results, unsigned line, const blhost::SecureKey &key, const std::vector<uint8_t> &nonceBytes, uint32_t address,
+               const std::vector<uint8_t> &plaintext, const std::vector<uint8_t> &data)
+{
+    blhost::Aes128 cipher(key);
+    blhost::SecureNonce nonce;
+    std::vector<uint8_t> page(blhost::PROGMEM_PAGE_SIZE);
+
+    if ((nonceBytes.size() != nonce.size()) || (plaintext.size() != blhost::PROGMEM_PAGE_SIZE) || (data.size() != blhost::SECURE_FRAME_SIZE))
+    {
+        throw std::runtime_error("page vector of the wrong length");
+    }
+    std::memcpy(nonce.data(), nonceBytes.data(), nonce.size());
+    results.Check(blhost::SealPage(cipher, nonce, address, plaintext.data()) == data, "host SealPage", line);
+    results.Check(blhost::OpenPage(cipher, data.data(), address, page.data()) && (page == plaintext), "host OpenPage", line);
+
+    if (key != blhost::DEVELOPMENT_KEY)
+    {
+        return;
+    }
+    results.Check(FirmwareOpen(data, address, &page) && (page == plaintext), "BL_SecurePageOpen", line);
+    // One changed byte in the nonce, the first and last ciphertext block and the tag, and another page
+    bool rejected = true;
+    for (size_t position : {size_t{0U}, blhost::SECURE_NONCE_SIZE, blhost::SECURE_NONCE_SIZE + blhost::PROGMEM_PAGE_SIZE - 1U,
+                            blhost::SECURE_FRAME_SIZE - 1U})
+    {
+        std::vector<uint8_t> tampered = data;
+        tampered[position] ^= 0x01U;
+        rejected = rejected && !FirmwareOpen(tampered, address, nullptr);
+    }
+    rejected = rejected && !FirmwareOpen(data, address + blhost::PROGMEM_PAGE_SIZE, nullptr);
+    results.Check(rejected, "BL_SecurePageOpen rejects tampered pages", line);
+}
+
+void CheckDigest(Results &results, unsigned line, const std::vector<uint8_t> &message, const std::vector<uint8_t> &expected)
+{
+    // At an odd address, so that the block reads do not line up with the flash words
+    const uint32_t address = blhost::START_OF_APP + 1U;
+    blhost::Digest digest;
+
+    if (expected.size() != digest.size())
+    {
+        throw std::runtime_error("digest vector of the wrong length");
+    }
+    digest = blhost::Sha256(message.data(), message.size());
+    results.Check(std::equal(digest.begin(), digest.end(), expected.begin()), "host Sha256", line);
+
+    std::fill(flash.begin(), flash.end(), 0xFFU);
+    std::copy(message.begin(), message.end(), flash.begin() + address);
+    BL_DigestFlash(address, static_cast<uint32_t>(message.size()), digest.data());
+    results.Check(std::equal(digest.begin(), digest.end(), expected.begin()), "BL_DigestFlash", line);
+}
+
+void CheckVectors(Results &results, const std::string &path)
+{
+    std::ifstream file(path);
+    std::string text;
+    unsigned line = 0U;
+
+    if (!file)
+    {
+        throw std::runtime_error("cannot open " + path);
+    }
+    while (std::getline(file, text))
+    {
+        std::istringstream fields(text);
+        std::string kind;
+
+        line++;
+        if (!(fields >> kind) || (kind[0] == '#'))
+        {
+            continue;
+        }
+        if (kind == "block")
+        {
+            std::string key, plaintext, ciphertext;
+            fields >> key >> plaintext >> ciphertext;
+            std::vector<uint8_t> block = FromHex(plaintext);
+            if (block.size() != blhost::SECURE_BLOCK_SIZE)
+            {
+                throw std::runtime_error("block vector of the wrong length");
+            }
+            blhost::SecureKey aesKey = ToKey(FromHex(key));
+            blhost::Aes128(aesKey).Encrypt(block.data());
+            results.Check(block == FromHex(ciphertext), "host Aes128", line);
+            if (aesKey == blhost::DEVELOPMENT_KEY)
+            {
+                block = FromHex(plaintext);
+                BL_SecureBlockEncrypt(block.data());
+                results.Check(block == FromHex(ciphertext), "BL_SecureBlockEncrypt", line);
+            }
+        }
+        else if (kind == "page")
+        {
+            std::string key, nonce, address, plaintext, data;
+            fields >> key >> nonce >> address >> plaintext >> data;
+            CheckPage(results, line, ToKey(FromHex(key)), FromHex(nonce), static_cast<uint32_t>(std::stoul(address, nullptr, 0)),
+                      FromHex(plaintext), FromHex(data));
+        }
+        else if (kind == "digest")
+        {
+            std::string message, expected;
+            fields >> message >> expected;
+            CheckDigest(results, line, (message == "-") ? std::vector<uint8_t>() : FromHex(message), FromHex(expected));
+        }
+        else
+        {
+            throw std::runtime_error("unknown vector kind " + kind);
+        }
+    }
+}
+
+uint64_t Cycles()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0U;
+#endif
+}
+
+void Usage()
+{
+    std::fprintf(stderr, "usage: bl_secbench [VECTORS] [-b BAUD] [-n PAGES]\n");
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    std::string path = "vectors/secure_vectors.txt";
+    unsigned baudRate = 115200U;
+    unsigned pages = 2000U;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if ((arg == "-b") && ((i + 1) < argc))
+        {
+            baudRate = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 0));
+        }
+        else if ((arg == "-n") && ((i + 1) < argc))
+        {
+            pages = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 0));
+        }
+        else if (arg[0] != '-')
+        {
+            path = arg;
+        }
+        else
+        {
+            Usage();
+            return 2;
+        }
+    }
+    if ((baudRate == 0U) || (pages == 0U))
+    {
+        Usage();
+        return 2;
+    }
+
+    try
+    {
+        Results results;
+
+        BL_SecureInitialize();
+        CheckVectors(results, path);
+        std::printf("vectors %s: %u check(s), %u failed\n", path.c_str(), results.checks, results.failures);
+        if ((results.failures != 0U) || (results.checks == 0U))
+        {
+            return 1;
+        }
+
+        // Sealed pages of random content, opened in place from a fresh copy each time
+        blhost::Aes128 cipher(blhost::DEVELOPMENT_KEY);
+        blhost::SecureNonce nonce = blhost::RandomNonce();
+        std::vector<uint8_t> page(blhost::PROGMEM_PAGE_SIZE);
+        for (size_t i = 0U; i < page.size(); i++)
+        {
+            page[i] = static_cast<uint8_t>(i * 167U + 13U);
+        }
+        uint32_t address = blhost::START_OF_APP;
+        std::vector<uint8_t> sealed = blhost::SealPage(cipher, nonce, address, page.data());
+        std::vector<uint8_t> buffer(sealed.size());
+        unsigned opened = 0U;
+
+        Clock::time_point start = Clock::now();
+        uint64_t cyclesStart = Cycles();
+        for (unsigned i = 0U; i < pages; i++)
+        {
+            std::memcpy(buffer.data(), sealed.data(), sealed.size());
+            opened += BL_SecurePageOpen(buffer.data(), address) ? 1U : 0U;
+        }
+        uint64_t cycles = Cycles() - cyclesStart;
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        if (opened != pages)
+        {
+            std::printf("BL_SecurePageOpen rejected %u of %u pages\n", pages - opened, pages);
+            return 1;
+        }
+
+        double bytes = static_cast<double>(pages) * blhost::PROGMEM_PAGE_SIZE;
+        // STX, the 9 byte header and the data; the reply is not counted
+        size_t frameBytes = blhost::MakeSecureWrite(address, sealed, blhost::NvmTiming()).Encode().size();
+        double lineSeconds = static_cast<double>(frameBytes) * 10.0 / baudRate;
+        std::printf("BL_SecurePageOpen, %u pages of %u bytes on this host:\n", pages, static_cast<unsigned>(blhost::PROGMEM_PAGE_SIZE));
+        std::printf("  %.2f ns/byte, %.1f MB/s, %.1f us/page", seconds * 1e9 / bytes, bytes / seconds / 1e6, seconds * 1e6 / pages);
+        if (cycles != 0U)
+        {
+            std::printf(", %.1f TSC cycles/byte", static_cast<double>(cycles) / bytes);
+        }
+        std::printf("\n");
+        std::printf("SECURE_WRITE frame of %zu bytes: %.2f ms on the wire at %u baud, %.0f PIC18 instruction cycles at 16 MIPS\n",
+                    frameBytes, lineSeconds * 1e3, baudRate, lineSeconds * 16e6);
+
+        // The application area of random content, as DIGEST and the boot check hash it
+        const uint32_t length = blhost::PROGMEM_SIZE - blhost::START_OF_APP;
+        const unsigned runs = 20U;
+        for (size_t i = 0U; i < flash.size(); i++)
+        {
+            flash[i] = static_cast<uint8_t>((i * 167U + 13U) ^ (i >> 8U));
+        }
+        blhost::Digest digest;
+        blhost::Digest reference = blhost::Sha256(&flash[blhost::START_OF_APP], length);
+        bool match = true;
+
+        start = Clock::now();
+        cyclesStart = Cycles();
+        for (unsigned i = 0U; i < runs; i++)
+        {
+            BL_DigestFlash(blhost::START_OF_APP, length, digest.data());
+            match = match && (digest == reference);
+        }
+        cycles = Cycles() - cyclesStart;
+        seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        start = Clock::now();
+        for (unsigned i = 0U; i < runs; i++)
+        {
+            match = match && (blhost::Sha256(&flash[blhost::START_OF_APP], length) == reference);
+        }
+        double hostSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+        if (!match)
+        {
+            std::printf("BL_DigestFlash does not match Sha256 over the application area\n");
+            return 1;
+        }
+
+        double kilobytes = static_cast<double>(runs) * length / 1024.0;
+        std::printf("BL_DigestFlash, %u runs over the %u byte application area on this host:\n", runs, static_cast<unsigned>(length));
+        std::printf("  %.2f us/KB, %.1f ms per run", seconds * 1e6 / kilobytes, seconds * 1e3 / runs);
+        if (cycles != 0U)
+        {
+            std::printf(", %.0f TSC cycles/KB", static_cast<double>(cycles) / kilobytes);
+        }
+        std::printf("\n");
+        std::printf("Sha256 (sha256.cpp): %.2f us/KB\n", hostSeconds * 1e6 / kilobytes);
+        return 0;
+    }
+    catch (const std::exception &error)
+    {
+        std::fprintf(stderr, "bl_secbench: %s\n", error.what());
+        return 1;
+    }
+}
@@ -0,0 +1,239 @@
+/**
+ *
+ * @file serial_port.cpp
+ *
+ * @brief Raw POSIX serial port (also works on pseudo-terminals).
+ */
+
+#include "serial_port.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace blhost
+{
+
+namespace
+{
+
+speed_t BaudConstant(unsigned baudRate)
+{
+    switch (baudRate)
+    {
+    case 9600U:
+        return B9600;
+    case 19200U:
+        return B19200;
+    case 38400U:
+        return B38400;
+    case 57600U:
+        return B57600;
+    case 115200U:
+        return B115200;
+    case 230400U:
+        return B230400;
+    case 460800U:
+        return B460800;
+    case 500000U:
+        return B500000;
+    case 921600U:
+        return B921600;
+    case 1000000U:
+        return B1000000;
+    case 2000000U:
+        return B2000000;
+    default:
+        break;
+    }
+    throw std::runtime_error("unsupported baud rate " + std::to_string(baudRate));
+}
+
+std::runtime_error SystemError(const std::string &what)
+{
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+}
+
+SerialPort::~SerialPort()
+{
+    Close();
+}
+
+SerialPort::SerialPort(SerialPort &&other) noexcept
+    : fd(other.fd), path(std::move(other.path)), baudRate(other.baudRate)
+{
+    other.fd = -1;
+}
+
+SerialPort &SerialPort::operator=(SerialPort &&other) noexcept
+{
+    if (this != &other)
+    {
+        Close();
+        fd = other.fd;
+        path = std::move(other.path);
+        baudRate = other.baudRate;
+        other.fd = -1;
+    }
+    return *this;
+}
+
+void SerialPort::Open(const std::string &portPath, unsigned rate)
+{
+    Close();
+
+    fd = ::open(portPath.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0)
+    {
+        throw SystemError("open " + portPath);
+    }
+
+    struct termios tio;
+    if (::tcgetattr(fd, &tio) != 0)
+    {
+        int savedErrno = errno;
+        Close();
+        errno = savedErrno;
+        throw SystemError("tcgetattr " + portPath);
+    }
+    ::cfmakeraw(&tio);
+    tio.c_cflag |= (CLOCAL | CREAD);
+    tio.c_cflag &= ~(CSTOPB | PARENB | CRTSCTS);
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+    ::cfsetispeed(&tio, BaudConstant(rate));
+    ::cfsetospeed(&tio, BaudConstant(rate));
+    if (::tcsetattr(fd, TCSANOW, &tio) != 0)
+    {
+        int savedErrno = errno;
+        Close();
+        errno = savedErrno;
+        throw SystemError("tcsetattr " + portPath);
+    }
+
+    path = portPath;
+    baudRate = rate;
+    Flush();
+}
+
+void SerialPort::Close()
+{
+    if (fd >= 0)
+    {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+void SerialPort::Write(const uint8_t *data, size_t length)
+{
+    while (length > 0U)
+    {
+        ssize_t written = ::write(fd, data, length);
+        if (written < 0)
+        {
+            if (errno == EAGAIN)
+            {
+                struct pollfd pfd = {fd, POLLOUT, 0};
+                ::poll(&pfd, 1, 100);
+                continue;
+            }
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            throw SystemError("write " + path);
+        }
+        data += written;
+        length -= static_cast<size_t>(written);
+    }
+}
+
+size_t SerialPort::Read(uint8_t *data, size_t length, unsigned timeoutMs, unsigned idleMs)
+{
+    using Clock = std::chrono::steady_clock;
+    const auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+    size_t received = 0U;
+
+    while (received < length)
+    {
+        auto now = Clock::now();
+        if (now >= deadline)
+        {
+            break;
+        }
+        long waitMs = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count() + 1;
+        if ((idleMs != 0U) && (received > 0U) && (waitMs > static_cast<long>(idleMs)))
+        {
+            waitMs = idleMs;
+        }
+
+        struct pollfd pfd = {fd, POLLIN, 0};
+        int ready = ::poll(&pfd, 1, static_cast<int>(waitMs));
+        if (ready < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            throw SystemError("poll " + path);
+        }
+        if (ready == 0)
+        {
+            if ((idleMs != 0U) && (received > 0U))
+            {
+                break;
+            }
+            continue;
+        }
+
+        ssize_t count = ::read(fd, data + received, length - received);
+        if (count > 0)
+        {
+            received += static_cast<size_t>(count);
+        }
+        else if ((count < 0) && (errno != EAGAIN) && (errno != EINTR))
+        {
+            throw SystemError("read " + path);
+        }
+        else if (count == 0)
+        {
+            // Pseudo-terminal peer closed; nothing more will arrive
+            break;
+        }
+    }
+
+    return received;
+}
+
+void SerialPort::Flush()
+{
+    ::tcflush(fd, TCIFLUSH);
+}
+
+void SerialPort::SendBreak(unsigned durationUs)
+{
+    // tcsendbreak() has a fixed 250 ms or longer duration; TIOCSBRK/TIOCCBRK give the exact length
+    ::tcdrain(fd);
+    if (::ioctl(fd, TIOCSBRK) != 0)
+    {
+        throw SystemError("TIOCSBRK " + path);
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(durationUs));
+    if (::ioctl(fd, TIOCCBRK) != 0)
+    {
+        throw SystemError("TIOCCBRK " + path);
+    }
+}
+
+}
@@ -0,0 +1,57 @@
+/**
+ *
+ * @file serial_port.hpp
+ *
+ * @brief Raw POSIX serial port (also works on pseudo-terminals).
+ */
+
+#ifndef SERIAL_PORT_HPP
+#define SERIAL_PORT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "port.hpp"
+
+namespace blhost
+{
+
+class SerialPort : public Port
+{
+public:
+    SerialPort() = default;
+    ~SerialPort() override;
+
+    SerialPort(const SerialPort &) = delete;
+    SerialPort &operator=(const SerialPort &) = delete;
+    SerialPort(SerialPort &&other) noexcept;
+    SerialPort &operator=(SerialPort &&other) noexcept;
+
+    /** Opens the port in raw 8N1 mode. Throws std::runtime_error on failure. */
+    void Open(const std::string &path, unsigned baudRate);
+    void Close();
+
+    bool IsOpen() const { return fd >= 0; }
+    int Descriptor() const { return fd; }
+    const std::string &Path() const override { return path; }
+    unsigned BaudRate() const { return baudRate; }
+
+    void Write(const uint8_t *data, size_t length) override;
+    size_t Read(uint8_t *data, size_t length, unsigned timeoutMs, unsigned idleMs) override;
+    void Flush() override;
+    void SendBreak(unsigned durationUs) override;
+
+    /** Seconds needed to shift one byte at the configured baud rate (10 bit times). */
+    double ByteTime() const override { return 10.0 / static_cast<double>(baudRate); }
+
+private:
+    int fd = -1;
+    std::string path;
+    unsigned baudRate = 0U;
+};
+
+}
+
+#endif // SERIAL_PORT_HPP
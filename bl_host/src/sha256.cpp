@@ -0,0 +1,127 @@
+/**
+ *
+ * @file sha256.cpp
+ *
+ * @brief SHA-256 (FIPS 180-4) of flash ranges, the host side of bl_digest.c.
+ */
+
+#include "sha256.hpp"
+
+namespace blhost
+{
+
+namespace
+{
+
+constexpr size_t BLOCK_SIZE = 64U;
+
+const uint32_t ROUND_CONSTANTS[64] = {
+    0x428A2F98U, 0x71374491U, 0xB5C0FBCFU, 0xE9B5DBA5U, 0x3956C25BU, 0x59F111F1U, 0x923F82A4U, 0xAB1C5ED5U,
+    0xD807AA98U, 0x12835B01U, 0x243185BEU, 0x550C7DC3U, 0x72BE5D74U, 0x80DEB1FEU, 0x9BDC06A7U, 0xC19BF174U,
+    0xE49B69C1U, 0xEFBE4786U, 0x0FC19DC6U, 0x240CA1CCU, 0x2DE92C6FU, 0x4A7484AAU, 0x5CB0A9DCU, 0x76F988DAU,
+    0x983E5152U, 0xA831C66DU, 0xB00327C8U, 0xBF597FC7U, 0xC6E00BF3U, 0xD5A79147U, 0x06CA6351U, 0x14292967U,
+    0x27B70A85U, 0x2E1B2138U, 0x4D2C6DFCU, 0x53380D13U, 0x650A7354U, 0x766A0ABBU, 0x81C2C92EU, 0x92722C85U,
+    0xA2BFE8A1U, 0xA81A664BU, 0xC24B8B70U, 0xC76C51A3U, 0xD192E819U, 0xD6990624U, 0xF40E3585U, 0x106AA070U,
+    0x19A4C116U, 0x1E376C08U, 0x2748774CU, 0x34B0BCB5U, 0x391C0CB3U, 0x4ED8AA4AU, 0x5B9CCA4FU, 0x682E6FF3U,
+    0x748F82EEU, 0x78A5636FU, 0x84C87814U, 0x8CC70208U, 0x90BEFFFAU, 0xA4506CEBU, 0xBEF9A3F7U, 0xC67178F2U,
+};
+
+const uint32_t INITIAL_STATE[8] = {
+    0x6A09E667U, 0xBB67AE85U, 0x3C6EF372U, 0xA54FF53AU, 0x510E527FU, 0x9B05688CU, 0x1F83D9ABU, 0x5BE0CD19U,
+};
+
+uint32_t Rotate(uint32_t x, unsigned bits)
+{
+    return (x >> bits) | (x << (32U - bits));
+}
+
+void Block(uint32_t *state, const uint8_t *block)
+{
+    uint32_t w[64];
+    uint32_t v[8];
+
+    for (unsigned i = 0U; i < 16U; i++)
+    {
+        w[i] = (static_cast<uint32_t>(block[4U * i]) << 24U) | (static_cast<uint32_t>(block[(4U * i) + 1U]) << 16U)
+               | (static_cast<uint32_t>(block[(4U * i) + 2U]) << 8U) | block[(4U * i) + 3U];
+    }
+    for (unsigned i = 16U; i < 64U; i++)
+    {
+        uint32_t s0 = Rotate(w[i - 15U], 7U) ^ Rotate(w[i - 15U], 18U) ^ (w[i - 15U] >> 3U);
+        uint32_t s1 = Rotate(w[i - 2U], 17U) ^ Rotate(w[i - 2U], 19U) ^ (w[i - 2U] >> 10U);
+        w[i] = w[i - 16U] + s0 + w[i - 7U] + s1;
+    }
+    for (unsigned i = 0U; i < 8U; i++)
+    {
+        v[i] = state[i];
+    }
+    for (unsigned i = 0U; i < 64U; i++)
+    {
+        uint32_t s1 = Rotate(v[4], 6U) ^ Rotate(v[4], 11U) ^ Rotate(v[4], 25U);
+        uint32_t choice = (v[4] & v[5]) ^ (~v[4] & v[6]);
+        uint32_t t1 = v[7] + s1 + choice + ROUND_CONSTANTS[i] + w[i];
+        uint32_t s0 = Rotate(v[0], 2U) ^ Rotate(v[0], 13U) ^ Rotate(v[0], 22U);
+        uint32_t majority = (v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]);
+        v[7] = v[6];
+        v[6] = v[5];
+        v[5] = v[4];
+        v[4] = v[3] + t1;
+        v[3] = v[2];
+        v[2] = v[1];
+        v[1] = v[0];
+        v[0] = t1 + s0 + majority;
+    }
+    for (unsigned i = 0U; i < 8U; i++)
+    {
+        state[i] += v[i];
+    }
+}
+
+}
+
+Digest Sha256(const uint8_t *data, size_t length)
+{
+    uint32_t state[8];
+    uint8_t block[BLOCK_SIZE] = {};
+    size_t offset = 0U;
+    Digest digest;
+
+    for (unsigned i = 0U; i < 8U; i++)
+    {
+        state[i] = INITIAL_STATE[i];
+    }
+    for (; (offset + BLOCK_SIZE) <= length; offset += BLOCK_SIZE)
+    {
+        Block(state, data + offset);
+    }
+
+    // The tail, the 0x80 byte, and the bit length in the last 8 bytes of a block of its own if it does not fit
+    size_t tail = length - offset;
+    for (size_t i = 0U; i < tail; i++)
+    {
+        block[i] = data[offset + i];
+    }
+    block[tail] = 0x80U;
+    if (tail >= (BLOCK_SIZE - 8U))
+    {
+        Block(state, block);
+        for (uint8_t &byte : block)
+        {
+            byte = 0x00U;
+        }
+    }
+    uint64_t bits = static_cast<uint64_t>(length) * 8U;
+    for (unsigned i = 0U; i < 8U; i++)
+    {
+        block[BLOCK_SIZE - 1U - i] = static_cast<uint8_t>(bits >> (8U * i));
+    }
+    Block(state, block);
+
+    for (unsigned i = 0U; i < DIGEST_SIZE; i++)
+    {
+        digest[i] = static_cast<uint8_t>(state[i / 4U] >> (24U - (8U * (i % 4U))));
+    }
+    return digest;
+}
+
+}
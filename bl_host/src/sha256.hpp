@@ -0,0 +1,27 @@
+/**
+ *
+ * @file sha256.hpp
+ *
+ * @brief SHA-256 (FIPS 180-4) of flash ranges, the host side of the DIGEST command and of the digest footer
+ *        checked at boot (bl_digest.c).
+ */
+
+#ifndef SHA256_HPP
+#define SHA256_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "bl_protocol.hpp"
+
+namespace blhost
+{
+
+using Digest = std::array<uint8_t, DIGEST_SIZE>;
+
+Digest Sha256(const uint8_t *data, size_t length);
+
+}
+
+#endif // SHA256_HPP
@@ -0,0 +1,308 @@
+/**
+ *
+ * @file sim_bench_main.cpp
+ *
+ * @brief bl_simbench: benchmarks full-image updates against the bootloader firmware running in bl_sim.
+ *
+ *        bl_simbench FILE.hex [--sim PATH] [-b BAUD] [--nvm FILE] [--erase-us N] [--write-us N] [--byte-write-us N]
+ *
+ *        bl_sim (next to bl_simbench unless --sim is given) is started on a fresh memory file with the entry pin
+ *        held, and the image is programmed with the bl_host programming flow in three scenarios: into the erased
+ *        device, the same image again, and the same image without the bulk erase. For each, the counters of
+ *        bl_sim give the frames, bytes on the wire and page erases, writes and reads, and the device time is
+ *        estimated as the wire time at BAUD plus the data sheet time of every erase and write. The time the firmware
+ *        spends decoding frames and computing checksums is not modelled, so real updates take somewhat longer.
+ *        The memory file is removed afterwards unless --nvm names it.
+ */
+
+#include "device_link.hpp"
+#include "hex_file.hpp"
+#include "port.hpp"
+#include "programmer.hpp"
+
+#include "../sim/sim.h"
+
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+struct Options
+{
+    std::string hexPath;
+    std::string simPath;
+    std::string nvmPath;
+    unsigned baudRate = 115200U;
+    /** Passed on to bl_sim as given. */
+    std::vector<std::string> simArgs;
+};
+
+struct Scenario
+{
+    const char *name;
+    bool erase;
+};
+
+void Usage()
+{
+    std::fprintf(stderr, "usage: bl_simbench FILE.hex [--sim PATH] [-b BAUD] [--nvm FILE] [--erase-us N] [--write-us N] [--byte-write-us N]\n");
+}
+
+/** bl_sim running on a memory file, with its counters mapped. */
+class Simulator
+{
+public:
+    explicit Simulator(const Options &options)
+    {
+        int out[2];
+        if (::pipe(out) != 0)
+        {
+            throw std::runtime_error("pipe failed");
+        }
+
+        std::vector<std::string> args = {options.simPath, "--nvm", options.nvmPath, "--entry-pin"};
+        args.insert(args.end(), options.simArgs.begin(), options.simArgs.end());
+        pid = ::fork();
+        if (pid == 0)
+        {
+            std::vector<char *> argv;
+            for (std::string &arg : args)
+            {
+                argv.push_back(&arg[0]);
+            }
+            argv.push_back(nullptr);
+            ::dup2(out[1], STDOUT_FILENO);
+            ::close(out[0]);
+            ::close(out[1]);
+            ::execv(argv[0], argv.data());
+            std::perror(argv[0]);
+            ::_exit(127);
+        }
+        ::close(out[1]);
+
+        // bl_sim prints the pseudo-terminal once the memory file is set up
+        char line[256] = {};
+        FILE *stream = ::fdopen(out[0], "r");
+        bool started = (stream != nullptr) && (std::fgets(line, sizeof(line), stream) != nullptr);
+        if (stream != nullptr)
+        {
+            std::fclose(stream);
+        }
+        if ((pid < 0) || !started)
+        {
+            throw std::runtime_error("cannot start " + options.simPath);
+        }
+        line[std::strcspn(line, "\n")] = '\0';
+        ptyPath = line;
+
+        int fd = ::open(options.nvmPath.c_str(), O_RDONLY);
+        void *map = (fd < 0) ? MAP_FAILED : ::mmap(nullptr, sizeof(sim_memory_t), PROT_READ, MAP_SHARED, fd, 0);
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+        if (map == MAP_FAILED)
+        {
+            throw std::runtime_error("cannot map " + options.nvmPath);
+        }
+        memory = static_cast<const sim_memory_t *>(map);
+    }
+
+    ~Simulator()
+    {
+        if (memory != nullptr)
+        {
+            ::munmap(const_cast<sim_memory_t *>(memory), sizeof(sim_memory_t));
+        }
+        if (pid > 0)
+        {
+            ::kill(pid, SIGTERM);
+            ::waitpid(pid, nullptr, 0);
+        }
+    }
+
+    Simulator(const Simulator &) = delete;
+    Simulator &operator=(const Simulator &) = delete;
+
+    const std::string &PtyPath() const { return ptyPath; }
+    sim_counters_t Counters() const
+    {
+        sim_counters_t counters;
+        std::memcpy(&counters, const_cast<const sim_counters_t *>(&memory->counters), sizeof(counters));
+        return counters;
+    }
+
+private:
+    pid_t pid = -1;
+    std::string ptyPath;
+    const sim_memory_t *memory = nullptr;
+};
+
+void PrintHeader(unsigned baudRate)
+{
+    std::printf("estimates at %u baud (10 bits per byte) plus the data sheet erase and write times\n", baudRate);
+    std::printf("  %-14s %7s %9s %9s %9s %7s %7s %7s %7s %9s %9s %10s %11s\n", "scenario", "frames", "sim fr/s", "tx bytes",
+                "rx bytes", "erases", "writes", "reads", "ee/cfg", "wire[s]", "nvm[s]", "device[s]", "device fr/s");
+}
+
+void RunScenario(Simulator &sim, blhost::DeviceLink &link, const blhost::MemoryImage &image, const Scenario &scenario,
+                 unsigned baudRate)
+{
+    blhost::ProgramOptions options;
+    options.erase = scenario.erase;
+
+    sim_counters_t before = sim.Counters();
+    auto start = Clock::now();
+    blhost::ProgramReport report = blhost::Programmer(link, options).Program(image);
+    double hostSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+    sim_counters_t after = sim.Counters();
+
+    uint64_t frames = after.framesReceived - before.framesReceived;
+    uint64_t bytesRx = after.bytesRx - before.bytesRx;
+    uint64_t bytesTx = after.bytesTx - before.bytesTx;
+    double wireSeconds = (static_cast<double>(bytesRx + bytesTx) * 10.0) / static_cast<double>(baudRate);
+    double nvmSeconds = static_cast<double>(after.nvmBusyUs - before.nvmBusyUs) / 1e6;
+    double deviceSeconds = wireSeconds + nvmSeconds;
+
+    // tx and rx are seen from the host, as in the bl_host reports
+    std::printf("  %-14s %7llu %9.0f %9llu %9llu %7llu %7llu %7llu %7llu %9.3f %9.3f %10.3f %11.1f%s\n", scenario.name,
+                static_cast<unsigned long long>(frames), static_cast<double>(frames) / hostSeconds,
+                static_cast<unsigned long long>(bytesRx), static_cast<unsigned long long>(bytesTx),
+                static_cast<unsigned long long>(after.pageErases - before.pageErases),
+                static_cast<unsigned long long>(after.pageWrites - before.pageWrites),
+                static_cast<unsigned long long>(after.pageReads - before.pageReads),
+                static_cast<unsigned long long>((after.eepromWrites - before.eepromWrites) + (after.configWrites - before.configWrites)),
+                wireSeconds, nvmSeconds, deviceSeconds, static_cast<double>(frames) / deviceSeconds,
+                report.verified ? "" : " (not verified)");
+    if (after.writeErrors != before.writeErrors)
+    {
+        std::printf("  %-14s %llu erase/write(s) refused without the unlock key\n", "",
+                    static_cast<unsigned long long>(after.writeErrors - before.writeErrors));
+    }
+}
+
+std::string DefaultSimPath()
+{
+    char self[4096];
+    ssize_t n = ::readlink("/proc/self/exe", self, sizeof(self) - 1U);
+    if (n <= 0)
+    {
+        return "bl_sim";
+    }
+    std::string path(self, static_cast<size_t>(n));
+    return path.substr(0U, path.rfind('/') + 1U) + "bl_sim";
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if ((arg[0] != '-') && options.hexPath.empty())
+        {
+            options.hexPath = arg;
+            continue;
+        }
+        if ((i + 1) >= argc)
+        {
+            Usage();
+            return 2;
+        }
+        std::string value = argv[++i];
+        if (arg == "--sim")
+        {
+            options.simPath = value;
+        }
+        else if (arg == "-b")
+        {
+            options.baudRate = static_cast<unsigned>(std::strtoul(value.c_str(), nullptr, 0));
+        }
+        else if (arg == "--nvm")
+        {
+            options.nvmPath = value;
+        }
+        else if ((arg == "--erase-us") || (arg == "--write-us") || (arg == "--byte-write-us"))
+        {
+            options.simArgs.push_back(arg);
+            options.simArgs.push_back(value);
+        }
+        else
+        {
+            Usage();
+            return 2;
+        }
+    }
+    if (options.hexPath.empty() || (options.baudRate == 0U))
+    {
+        Usage();
+        return 2;
+    }
+    if (options.simPath.empty())
+    {
+        options.simPath = DefaultSimPath();
+    }
+
+    bool removeNvm = options.nvmPath.empty();
+    if (removeNvm)
+    {
+        char path[] = "/tmp/bl_simbench.XXXXXX";
+        int fd = ::mkstemp(path);
+        if (fd < 0)
+        {
+            std::perror("mkstemp");
+            return 1;
+        }
+        ::close(fd);
+        options.nvmPath = path;
+    }
+
+    int result = 0;
+    try
+    {
+        blhost::MemoryImage image = blhost::MemoryImage::FromHexFile(options.hexPath);
+        Simulator sim(options);
+        std::unique_ptr<blhost::Port> port = blhost::OpenPort(sim.PtyPath(), options.baudRate);
+        blhost::DeviceLink link(*port, 2U);
+
+        PrintHeader(options.baudRate);
+        const Scenario scenarios[] = {
+            {"erased device", true},
+            {"same image", true},
+            {"no bulk erase", false},
+        };
+        for (const Scenario &scenario : scenarios)
+        {
+            RunScenario(sim, link, image, scenario, options.baudRate);
+        }
+    }
+    catch (const std::exception &error)
+    {
+        std::fprintf(stderr, "bl_simbench: %s\n", error.what());
+        result = 1;
+    }
+
+    if (removeNvm)
+    {
+        ::unlink(options.nvmPath.c_str());
+    }
+    return result;
+}
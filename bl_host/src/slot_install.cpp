@@ -0,0 +1,94 @@
+/**
+ *
+ * @file slot_install.cpp
+ *
+ * @brief Simulated flash and EEPROM for the host model of the golden restore (golden.cpp), which can lose power
+ *        in the middle of any page erase, row write or EEPROM byte write.
+ */
+
+#include "slot_install.hpp"
+
+namespace blhost
+{
+
+double NvmCounts::Seconds(const NvmTiming &timing) const
+{
+    return ((static_cast<double>(pageErases) * timing.pageEraseUs) + (static_cast<double>(rowWrites) * timing.pageWriteUs)
+            + (static_cast<double>(eepromWrites) * timing.eepromByteWriteUs)) / 1e6;
+}
+
+bool SlotNvm::Cut()
+{
+    if (!cutArmed)
+    {
+        return false;
+    }
+    if (cutCountdown == 0U)
+    {
+        cutArmed = false;
+        return true;
+    }
+    cutCountdown--;
+    return false;
+}
+
+uint8_t SlotNvm::Garbage()
+{
+    cutState = (cutState * 1103515245U) + 12345U;
+    return static_cast<uint8_t>(cutState >> 16U);
+}
+
+void SlotNvm::FlashPageErase(uint32_t address)
+{
+    bool cut = Cut();
+
+    counts.pageErases++;
+    for (uint32_t offset = 0U; offset < PROGMEM_PAGE_SIZE; offset++)
+    {
+        // A torn erase leaves some bytes erased and some only partly
+        uint8_t &cell = flash.at(address + offset);
+        cell = (!cut || ((Garbage() & 1U) != 0U)) ? 0xFFU : static_cast<uint8_t>(cell | Garbage());
+    }
+    if (cut)
+    {
+        throw PowerCut();
+    }
+}
+
+void SlotNvm::FlashRowWrite(uint32_t address, const uint8_t *data)
+{
+    bool cut = Cut();
+    uint32_t reached = cut ? (Garbage() % PROGMEM_PAGE_SIZE) : PROGMEM_PAGE_SIZE;
+
+    counts.rowWrites++;
+    for (uint32_t offset = 0U; offset < PROGMEM_PAGE_SIZE; offset++)
+    {
+        // Programming only clears bits; a torn write leaves the rest of the row partly programmed
+        uint8_t &cell = flash.at(address + offset);
+        cell = static_cast<uint8_t>(cell & ((offset < reached) ? data[offset] : (data[offset] | Garbage())));
+    }
+    if (cut)
+    {
+        throw PowerCut();
+    }
+}
+
+void SlotNvm::EepromWrite(uint32_t address, uint8_t data)
+{
+    counts.eepromWrites++;
+    if (Cut())
+    {
+        eeprom.at(address) = Garbage();
+        throw PowerCut();
+    }
+    eeprom.at(address) = data;
+}
+
+void SlotNvm::CutAfter(uint64_t operationsLeft, uint32_t seed)
+{
+    cutArmed = true;
+    cutCountdown = operationsLeft;
+    cutState = seed;
+}
+
+}
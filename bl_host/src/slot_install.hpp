@@ -0,0 +1,72 @@
+/**
+ *
+ * @file slot_install.hpp
+ *
+ * @brief Simulated flash and EEPROM for the host model of the golden restore (golden.cpp), which can lose power
+ *        in the middle of any page erase, row write or EEPROM byte write. The dual-slot install itself runs the
+ *        firmware's bl_slot.c on the NVM of bl_sim (bl_slotsim).
+ */
+
+#ifndef SLOT_INSTALL_HPP
+#define SLOT_INSTALL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "bl_protocol.hpp"
+
+namespace blhost
+{
+
+/** Thrown by SlotNvm when the simulated power cut hits. */
+class PowerCut : public std::runtime_error
+{
+public:
+    PowerCut() : std::runtime_error("power cut") {}
+};
+
+struct NvmCounts
+{
+    uint64_t pageErases = 0U;
+    uint64_t rowWrites = 0U;
+    uint64_t eepromWrites = 0U;
+
+    uint64_t Operations() const { return pageErases + rowWrites + eepromWrites; }
+    /** Device time spent in NVM operations, with the worst-case timings the host uses for its timeouts. */
+    double Seconds(const NvmTiming &timing) const;
+};
+
+/** Program flash and EEPROM of the device. Every operation may be the one that a power cut tears. */
+class SlotNvm
+{
+public:
+    SlotNvm() : flash(PROGMEM_SIZE, 0xFFU), eeprom(EEPROM_SIZE, 0xFFU) {}
+
+    uint8_t FlashRead(uint32_t address) const { return flash.at(address); }
+    void FlashPageErase(uint32_t address);
+    void FlashRowWrite(uint32_t address, const uint8_t *data);
+    uint8_t EepromRead(uint32_t address) const { return eeprom.at(address); }
+    void EepromWrite(uint32_t address, uint8_t data);
+
+    /** The operation after the next operationsLeft ones is torn and throws PowerCut. */
+    void CutAfter(uint64_t operationsLeft, uint32_t seed);
+    void CutDisarm() { cutArmed = false; }
+
+    std::vector<uint8_t> flash;
+    std::vector<uint8_t> eeprom;
+    NvmCounts counts;
+
+private:
+    bool Cut();
+    uint8_t Garbage();
+
+    bool cutArmed = false;
+    uint64_t cutCountdown = 0U;
+    uint32_t cutState = 1U;
+};
+
+}
+
+#endif // SLOT_INSTALL_HPP
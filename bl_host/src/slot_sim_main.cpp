@@ -0,0 +1,303 @@
+/**
+ *
+ * @file slot_sim_main.cpp
+ *
+ * @brief bl_slotsim: downtime and power-cut simulation of the dual-slot install (BL_SLOT_ENABLE).
+ *
+ *        bl_slotsim [--changed PERCENT] [--cuts N] [--nested PERCENT] [--baud N] [--seed N]
+ *
+ *        The install is BL_SlotInstall of bl_slot.c, compiled for Linux with BL_SLOT_SIZE of bl_boot_config.h
+ *        and run on the simulated NVM of bl_sim (sim_slot.c).
+ *
+ *        The downtime run installs a download slot in which the given share of pages differs from the running image,
+ *        and compares the NVM time of the install with streaming the same image through the bootloader protocol.
+ *        The power-cut run tears a random NVM operation of the install, then boots again without the RAM request,
+ *        with further cuts during the resume at the given probability. After the last boot, the device must run
+ *        either the new image, or the old one with the install state idle so that the application can ask again.
+ */
+
+#include "bl_protocol.hpp"
+#include "../sim/sim_slot.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+struct Options
+{
+    unsigned changed = 100U;
+    unsigned cuts = 2000U;
+    unsigned nested = 30U;
+    unsigned baud = 115200U;
+    uint32_t seed = 1U;
+};
+
+class Random
+{
+public:
+    explicit Random(uint32_t seed) : state((seed * 0x9E3779B9U) | 1U) {}
+
+    uint32_t Next(uint32_t range)
+    {
+        state ^= state << 13U;
+        state ^= state >> 17U;
+        state ^= state << 5U;
+        return state % range;
+    }
+
+private:
+    uint32_t state;
+};
+
+constexpr unsigned MAX_NESTED_CUTS = 8U;
+
+void Usage()
+{
+    std::fprintf(stderr, "usage: bl_slotsim [--changed PERCENT] [--cuts N] [--nested PERCENT] [--baud N] [--seed N]\n");
+}
+
+struct Images
+{
+    std::vector<uint8_t> running;
+    std::vector<uint8_t> download;
+};
+
+/** Sets the last two bytes of an image to the 16-bit sum of its little-endian words, as BL_bootVerifyImage checks. */
+void SealImage(std::vector<uint8_t> &image)
+{
+    uint16_t sum = 0U;
+    size_t length = image.size() - 2U;
+
+    for (size_t i = 0U; i < length; i += 2U)
+    {
+        sum = static_cast<uint16_t>(sum + image[i] + (image[i + 1U] << 8U));
+    }
+    image[length] = static_cast<uint8_t>(sum);
+    image[length + 1U] = static_cast<uint8_t>(sum >> 8U);
+}
+
+Images MakeImages(const Options &options, Random &random)
+{
+    Images images;
+
+    images.running.resize(simSlotSize);
+    for (uint8_t &byte : images.running)
+    {
+        byte = static_cast<uint8_t>(random.Next(256U));
+    }
+    images.download = images.running;
+    for (uint32_t page = 0U; page < (simSlotSize / blhost::PROGMEM_PAGE_SIZE); page++)
+    {
+        if (random.Next(100U) < options.changed)
+        {
+            images.download[(page * blhost::PROGMEM_PAGE_SIZE) + random.Next(blhost::PROGMEM_PAGE_SIZE)] ^= 0x5AU;
+        }
+    }
+    SealImage(images.running);
+    SealImage(images.download);
+    return images;
+}
+
+void Load(const Images &images)
+{
+    SIM_SlotReset();
+    std::copy(images.running.begin(), images.running.end(), SIM_SlotMemory()->flash + simSlotStart);
+    std::copy(images.download.begin(), images.download.end(), SIM_SlotMemory()->flash + simSlotStart + simSlotSize);
+}
+
+bool SlotEquals(const std::vector<uint8_t> &image)
+{
+    return std::equal(image.begin(), image.end(), SIM_SlotMemory()->flash + simSlotStart);
+}
+
+bool StateInstalling()
+{
+    return SIM_SlotMemory()->eeprom[simSlotStateOffset + 2U] == simSlotStateInstalling;
+}
+
+uint64_t Operations()
+{
+    const sim_counters_t &counts = SIM_SlotMemory()->counters;
+
+    return counts.pageErases + counts.pageWrites + counts.wordWrites + counts.eepromWrites + counts.configWrites;
+}
+
+/** BL_SlotInstall without a power cut; returns the BL_SLOT_xxx result. */
+uint8_t Install(bool requested)
+{
+    uint8_t result = blhost::BL_SLOT_NONE;
+
+    (void) SIM_SlotInstall(requested, blhost::UNLOCK_KEY, &result);
+    return result;
+}
+
+bool Downtime(const Options &options, const Images &images)
+{
+    blhost::NvmTiming timing;
+    const sim_counters_t &counts = SIM_SlotMemory()->counters;
+
+    // A damaged download slot must leave the running image alone
+    Load(images);
+    SIM_SlotMemory()->flash[simSlotStart + simSlotSize + 1U] ^= 0x01U;
+    if ((Install(true) != blhost::BL_SLOT_REJECTED) || !SlotEquals(images.running) || (Operations() != 0U))
+    {
+        std::printf("downtime: FAIL, a damaged download slot was not rejected\n");
+        return false;
+    }
+
+    Load(images);
+    uint8_t result = Install(true);
+    if ((result != blhost::BL_SLOT_INSTALLED) || !SlotEquals(images.download) || StateInstalling())
+    {
+        std::printf("downtime: FAIL, install returned %s\n", blhost::SlotResultName(result).c_str());
+        return false;
+    }
+
+    // Streaming: one WRITE_FLASH frame per page (sync, header, data) and its reply (STX, header, status), 10 bits per byte
+    unsigned slotPages = simSlotSize / blhost::PROGMEM_PAGE_SIZE;
+    double frameSeconds = (static_cast<double>(1U + blhost::BL_HEADER + blhost::PROGMEM_PAGE_SIZE + 1U + blhost::BL_HEADER + 1U)
+                           * 10.0) / options.baud;
+    double pageSeconds = static_cast<double>(timing.pageEraseUs + timing.pageWriteUs) / 1e6;
+
+    std::printf("install: %u pages per slot, %llu changed, %llu page erases, %llu row writes, %llu EEPROM byte writes\n",
+                slotPages, static_cast<unsigned long long>(counts.pageWrites), static_cast<unsigned long long>(counts.pageErases),
+                static_cast<unsigned long long>(counts.pageWrites), static_cast<unsigned long long>(counts.eepromWrites));
+    std::printf("  downtime about %.2f s of NVM time (page erase %.1f ms, row write %.1f ms, EEPROM byte %.1f ms)\n",
+                static_cast<double>(counts.nvmBusyUs) / 1e6, SIM_PAGE_ERASE_US / 1000.0, SIM_PAGE_WRITE_US / 1000.0,
+                SIM_BYTE_WRITE_US / 1000.0);
+    std::printf("  streaming the image through the bootloader at %u baud: about %.2f s\n", options.baud,
+                slotPages * (frameSeconds + pageSeconds));
+    return true;
+}
+
+bool PowerCuts(const Options &options, const Images &images)
+{
+    Random random(options.seed + 1U);
+    unsigned resumed = 0U;
+    unsigned lost = 0U;
+    unsigned nestedCuts = 0U;
+
+    // Number of NVM operations of an uninterrupted install, the range the cuts are drawn from
+    Load(images);
+    (void) Install(true);
+    uint32_t operations = static_cast<uint32_t>(Operations());
+
+    for (unsigned cut = 0U; cut < options.cuts; cut++)
+    {
+        Load(images);
+        SIM_SlotCutAfter(random.Next(operations), random.Next(0xFFFFFFFFU));
+        bool requested = true;
+        unsigned boots = 0U;
+        uint8_t result = blhost::BL_SLOT_NONE;
+
+        // RAM is lost with the power, so only the EEPROM state can bring the install back
+        while (!SIM_SlotInstall(requested, blhost::UNLOCK_KEY, &result))
+        {
+            requested = false;
+            boots++;
+            if ((boots < MAX_NESTED_CUTS) && (random.Next(100U) < options.nested))
+            {
+                SIM_SlotCutAfter(random.Next(operations), random.Next(0xFFFFFFFFU));
+                nestedCuts++;
+            }
+        }
+        SIM_CutDisarm();
+        if (result == blhost::BL_SLOT_RESUMED)
+        {
+            resumed++;
+        }
+
+        if (StateInstalling())
+        {
+            std::printf("power cuts: FAIL after cut %u, the install state was left set\n", cut);
+            return false;
+        }
+        if (SlotEquals(images.running) && SIM_SlotVerify(simSlotStart))
+        {
+            // Cut before the state was stored: the old image runs, and the application asks again
+            lost++;
+            if (Install(true) != blhost::BL_SLOT_INSTALLED)
+            {
+                std::printf("power cuts: FAIL after cut %u, the repeated request did not install\n", cut);
+                return false;
+            }
+        }
+        if (!SlotEquals(images.download))
+        {
+            std::printf("power cuts: FAIL after cut %u, the execution slot holds neither image\n", cut);
+            return false;
+        }
+    }
+
+    std::printf("power cuts: %u cuts and %u more during the resume recovered, %u installs resumed by the bootloader, "
+                "%u requests lost before the install started\n",
+                options.cuts, nestedCuts, resumed, lost);
+    return true;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if ((i + 1) >= argc)
+        {
+            Usage();
+            return 2;
+        }
+        unsigned long long value = std::strtoull(argv[++i], nullptr, 0);
+        if (arg == "--changed")
+        {
+            options.changed = static_cast<unsigned>(value);
+        }
+        else if (arg == "--cuts")
+        {
+            options.cuts = static_cast<unsigned>(value);
+        }
+        else if (arg == "--nested")
+        {
+            options.nested = static_cast<unsigned>(value);
+        }
+        else if (arg == "--baud")
+        {
+            options.baud = static_cast<unsigned>(value);
+        }
+        else if (arg == "--seed")
+        {
+            options.seed = static_cast<uint32_t>(value);
+        }
+        else
+        {
+            Usage();
+            return 2;
+        }
+    }
+    if ((options.changed > 100U) || (options.baud == 0U))
+    {
+        Usage();
+        return 2;
+    }
+
+    try
+    {
+        Random random(options.seed);
+        Images images = MakeImages(options, random);
+        bool ok = Downtime(options, images);
+        ok = PowerCuts(options, images) && ok;
+        return ok ? 0 : 1;
+    }
+    catch (const std::exception &error)
+    {
+        std::fprintf(stderr, "bl_slotsim: %s\n", error.what());
+        return 1;
+    }
+}
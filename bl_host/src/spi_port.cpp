@@ -0,0 +1,226 @@
+/**
+ *
+ * @file spi_port.cpp
+ *
+ * @brief Linux spidev host port for the SPI target transport of the bootloader (BL_TRANSPORT_SPI).
+ */
+
+#include "spi_port.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#include <fcntl.h>
+#include <linux/spi/spidev.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace blhost
+{
+
+namespace
+{
+
+// Byte the device clocks out while it has no reply (BL_SPI_IDLE in bl_transport_spi.c)
+constexpr uint8_t SPI_IDLE = 0x00U;
+// spidev's default buffer size limits a single transfer
+constexpr size_t MAX_TRANSFER = 4096U;
+// bl_sim answers every byte, so a transfer to it is kept well inside the terminal buffers
+constexpr size_t SIM_TRANSFER = 256U;
+// Longest wait for bl_sim to answer a transfer; it only stops the clock while the firmware is busy
+constexpr int SIM_ANSWER_MS = 2000;
+// Pause between idle polls so a busy device is not clocked needlessly
+constexpr unsigned POLL_INTERVAL_US = 50U;
+
+std::runtime_error SystemError(const std::string &what)
+{
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+}
+
+SpiPort::~SpiPort()
+{
+    Close();
+}
+
+void SpiPort::Open(const std::string &devicePath, unsigned rate)
+{
+    uint8_t mode = SPI_MODE_0;
+    uint8_t bits = 8U;
+    uint32_t speed = rate;
+
+    Close();
+    fd = ::open(devicePath.c_str(), O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        throw SystemError("open " + devicePath);
+    }
+    simulated = (::isatty(fd) == 1);
+    if (simulated)
+    {
+        struct termios tio;
+
+        if (::tcgetattr(fd, &tio) == 0)
+        {
+            ::cfmakeraw(&tio);
+            (void) ::tcsetattr(fd, TCSANOW, &tio);
+        }
+    }
+    else if ((::ioctl(fd, SPI_IOC_WR_MODE, &mode) < 0) || (::ioctl(fd, SPI_IOC_WR_BITS_PER_WORD, &bits) < 0)
+        || (::ioctl(fd, SPI_IOC_WR_MAX_SPEED_HZ, &speed) < 0))
+    {
+        std::runtime_error error = SystemError("configure " + devicePath);
+        Close();
+        throw error;
+    }
+    path = devicePath;
+    clockHz = rate;
+    replyStarted = false;
+}
+
+void SpiPort::Close()
+{
+    if (fd >= 0)
+    {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+void SpiPort::SimTransfer(const uint8_t *tx, uint8_t *rx, size_t length)
+{
+    uint8_t out[SIM_TRANSFER] = {};
+    uint8_t in[SIM_TRANSFER];
+    size_t done = 0U;
+
+    if (tx != nullptr)
+    {
+        std::memcpy(out, tx, length);
+    }
+    while (done < length)
+    {
+        ssize_t n = ::write(fd, out + done, length - done);
+        if ((n < 0) && (errno != EINTR))
+        {
+            throw SystemError("write " + path);
+        }
+        done += (n > 0) ? static_cast<size_t>(n) : 0U;
+    }
+    for (done = 0U; done < length;)
+    {
+        struct pollfd pfd = {fd, POLLIN, 0};
+        int ready = ::poll(&pfd, 1U, SIM_ANSWER_MS);
+        if (ready == 0)
+        {
+            throw std::runtime_error("bl_sim did not answer the transfer: " + path);
+        }
+        ssize_t n = (ready > 0) ? ::read(fd, in + done, length - done) : -1;
+        if ((n < 0) && (errno != EINTR))
+        {
+            throw SystemError("read " + path);
+        }
+        done += (n > 0) ? static_cast<size_t>(n) : 0U;
+    }
+    if (rx != nullptr)
+    {
+        std::memcpy(rx, in, length);
+    }
+}
+
+void SpiPort::Transfer(const uint8_t *tx, uint8_t *rx, size_t length)
+{
+    while (simulated && (length > 0U))
+    {
+        size_t chunk = (length < SIM_TRANSFER) ? length : SIM_TRANSFER;
+
+        SimTransfer(tx, rx, chunk);
+        tx = (tx != nullptr) ? (tx + chunk) : nullptr;
+        rx = (rx != nullptr) ? (rx + chunk) : nullptr;
+        length -= chunk;
+    }
+    while (length > 0U)
+    {
+        size_t chunk = (length < MAX_TRANSFER) ? length : MAX_TRANSFER;
+        struct spi_ioc_transfer transfer;
+
+        std::memset(&transfer, 0, sizeof(transfer));
+        transfer.tx_buf = reinterpret_cast<uintptr_t>(tx);
+        transfer.rx_buf = reinterpret_cast<uintptr_t>(rx);
+        transfer.len = static_cast<uint32_t>(chunk);
+        transfer.speed_hz = clockHz;
+        transfer.bits_per_word = 8U;
+        if (::ioctl(fd, SPI_IOC_MESSAGE(1), &transfer) < 0)
+        {
+            throw SystemError("transfer " + path);
+        }
+        if (tx != nullptr)
+        {
+            tx += chunk;
+        }
+        if (rx != nullptr)
+        {
+            rx += chunk;
+        }
+        length -= chunk;
+    }
+}
+
+void SpiPort::Write(const uint8_t *data, size_t length)
+{
+    // Whatever the device clocks out meanwhile belongs to no reply
+    Transfer(data, nullptr, length);
+    replyStarted = false;
+}
+
+size_t SpiPort::Read(uint8_t *data, size_t length, unsigned timeoutMs, unsigned idleMs)
+{
+    using Clock = std::chrono::steady_clock;
+    const auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+    const uint8_t idle = SPI_IDLE;
+    size_t received = 0U;
+
+    (void) idleMs;
+    while (!replyStarted && (received < length))
+    {
+        Transfer(&idle, data, 1U);
+        if (data[0] != SPI_IDLE)
+        {
+            replyStarted = true;
+            received = 1U;
+        }
+        else if (Clock::now() >= deadline)
+        {
+            return 0U;
+        }
+        else
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(POLL_INTERVAL_US));
+        }
+    }
+
+    if (received < length)
+    {
+        // The reply is streamed from DMA, so the rest is clocked in one go; tx_buf == NULL sends zeros
+        Transfer(nullptr, data + received, length - received);
+        received = length;
+    }
+    return received;
+}
+
+void SpiPort::Flush()
+{
+    replyStarted = false;
+}
+
+void SpiPort::SendBreak(unsigned)
+{
+    throw std::runtime_error("break entry needs the UART transport: " + path);
+}
+
+}
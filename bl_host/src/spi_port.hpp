@@ -0,0 +1,67 @@
+/**
+ *
+ * @file spi_port.hpp
+ *
+ * @brief Linux spidev host port for the SPI target transport of the bootloader (BL_TRANSPORT_SPI).
+ *        SPI is full duplex and host clocked: every byte read is clocked out as an idle byte, and the device
+ *        answers with idle bytes until its reply starts with STX.
+ *
+ *        A terminal in place of the spidev device is bl_sim built with BL_TRANSPORT_SPI: every byte written to it
+ *        is one clocked byte, and bl_sim answers it with the byte the device shifted out.
+ */
+
+#ifndef SPI_PORT_HPP
+#define SPI_PORT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "port.hpp"
+
+namespace blhost
+{
+
+class SpiPort : public Port
+{
+public:
+    SpiPort() = default;
+    ~SpiPort() override;
+
+    SpiPort(const SpiPort &) = delete;
+    SpiPort &operator=(const SpiPort &) = delete;
+
+    /** Opens the device in SPI mode 0 with 8-bit words, or bl_sim raw. Throws std::runtime_error on failure. */
+    void Open(const std::string &path, unsigned clockHz);
+    void Close();
+
+    void Write(const uint8_t *data, size_t length) override;
+
+    /**
+     * Until the reply has started, idle bytes count as no data and are polled for until timeoutMs.
+     * Once it has started every byte is reply data, so idleMs does not apply: the read clocks in length bytes.
+     */
+    size_t Read(uint8_t *data, size_t length, unsigned timeoutMs, unsigned idleMs) override;
+    void Flush() override;
+    void SendBreak(unsigned durationUs) override;
+
+    const std::string &Path() const override { return path; }
+
+    /** Seconds needed to shift one byte at the configured clock (8 clocks). */
+    double ByteTime() const override { return 8.0 / static_cast<double>(clockHz); }
+
+private:
+    void Transfer(const uint8_t *tx, uint8_t *rx, size_t length);
+    /** One transfer of at most SIM_TRANSFER bytes to bl_sim. */
+    void SimTransfer(const uint8_t *tx, uint8_t *rx, size_t length);
+
+    int fd = -1;
+    std::string path;
+    unsigned clockHz = 0U;
+    bool simulated = false;
+    bool replyStarted = false;
+};
+
+}
+
+#endif // SPI_PORT_HPP
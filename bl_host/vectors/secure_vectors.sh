@@ -0,0 +1,96 @@
+#!/bin/bash
+#
+#  Generates the known-answer vectors of bl_secbench with the openssl command line tool, independently of the
+#  AES and SHA-256 code of the bootloader (bl_secure.c, bl_digest.c) and of the host tools (secure.cpp, sha256.cpp):
+#
+#    ./secure_vectors.sh > secure_vectors.txt
+#
+#  block KEY PLAINTEXT CIPHERTEXT           one AES-128 block
+#  page KEY NONCE ADDRESS PLAINTEXT DATA    one SECURE_WRITE page: DATA is [NONCE][CIPHERTEXT][TAG]
+#  digest MESSAGE SHA256                    SHA-256 of MESSAGE, - for the empty message
+#
+#  A page is CCM with the 8 byte NONCE and the 3 byte little-endian ADDRESS as the 11 byte CCM nonce, no associated
+#  data and an 8 byte tag: the ciphertext is AES-CTR from counter block 1, the tag the CBC-MAC over B0 and the
+#  plaintext, encrypted with the keystream of counter block 0.
+#
+
+set -eu
+
+DEV_KEY=2b7e151628aed2a6abf7158809cf4f3c
+ZERO_BLOCK=00000000000000000000000000000000
+
+hex() { xxd -p | tr -d '\n'; }
+unhex() { echo -n "$1" | xxd -r -p; }
+
+ecb() { unhex "$2" | openssl enc -aes-128-ecb -nopad -K "$1" | hex; }
+
+# XOR of two hex strings of the same length
+xor()
+{
+    local a=$1 b=$2 out= i
+    for ((i = 0; i < ${#a}; i += 2)); do
+        out+=$(printf '%02x' $((16#${a:i:2} ^ 16#${b:i:2})))
+    done
+    echo -n "$out"
+}
+
+# 256 bytes: zero, ff, count, or random (an AES-CTR keystream, so that the file can be generated again)
+pattern()
+{
+    case $1 in
+        zero) head -c 256 /dev/zero | hex ;;
+        ff) head -c 256 /dev/zero | tr '\000' '\377' | hex ;;
+        count) for ((i = 0; i < 256; i++)); do printf '%02x' $i; done ;;
+        random) head -c 256 /dev/zero | openssl enc -aes-128-ctr -K "$2" -iv $ZERO_BLOCK | hex ;;
+    esac
+}
+
+page()
+{
+    local key=$1 nonce=$2 address=$3 plain=$4
+    local addr=$(printf '%02x%02x%02x' $((address & 0xFF)) $(((address >> 8) & 0xFF)) $(((address >> 16) & 0xFF)))
+    local a0=03${nonce}${addr}00000000
+    local a1=03${nonce}${addr}00000001
+    local b0=1b${nonce}${addr}00000100
+    local cipher=$(unhex "$plain" | openssl enc -aes-128-ctr -K "$key" -iv "$a1" | hex)
+    local mac=$(unhex "${b0}${plain}" | openssl enc -aes-128-cbc -nopad -K "$key" -iv $ZERO_BLOCK | hex)
+    local s0=$(ecb "$key" "$a0")
+    local tag=$(xor "${mac: -32:16}" "${s0:0:16}")
+    printf 'page %s %s 0x%06X %s %s%s%s\n' "$key" "$nonce" "$address" "$plain" "$nonce" "$cipher" "$tag"
+}
+
+block()
+{
+    printf 'block %s %s %s\n' "$1" "$2" "$(ecb "$1" "$2")"
+}
+
+digest()
+{
+    printf 'digest %s %s\n' "${1:--}" "$(unhex "$1" | openssl dgst -sha256 -r | cut -d' ' -f1)"
+}
+
+# Bytes of the AES-CTR keystream under the development key
+keystream() { head -c "$1" /dev/zero | openssl enc -aes-128-ctr -K $DEV_KEY -iv $ZERO_BLOCK | hex; }
+
+echo "# Generated by secure_vectors.sh with $(openssl version | cut -d' ' -f1-2)"
+echo "# FIPS-197 appendix C.1 and B, SP 800-38A F.1.1 (ECB-AES128)"
+block 000102030405060708090a0b0c0d0e0f 00112233445566778899aabbccddeeff
+block $DEV_KEY 3243f6a8885a308d313198a2e0370734
+block $DEV_KEY 6bc1bee22e409f96e93d7e117393172a
+block $DEV_KEY ae2d8a571e03ac9c9eb76fac45af8e51
+block $DEV_KEY 30c81c46a35ce411e5fbc1191a0a52ef
+block $DEV_KEY f69f2445df4f9b17ad2b417be66c3710
+echo "# Pages under the development key, then under another key"
+page $DEV_KEY 0001020304050607 $((0x3000)) "$(pattern count)"
+page $DEV_KEY a0a1a2a3a4a5a6a7 $((0x1FF00)) "$(pattern zero)"
+page $DEV_KEY f0f1f2f3f4f5f6f7 $((0x3100)) "$(pattern ff)"
+page $DEV_KEY 5a17c3e08b4d2f96 $((0x12300)) "$(pattern random $DEV_KEY)"
+page 000102030405060708090a0b0c0d0e0f 1011121314151617 $((0x4000)) "$(pattern random 000102030405060708090a0b0c0d0e0f)"
+echo "# FIPS 180-4 examples, then the lengths around the padding boundaries of one and two blocks"
+digest ""
+digest "$(echo -n abc | hex)"
+digest "$(echo -n abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq | hex)"
+digest "$(echo -n abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu | hex)"
+for length in 55 56 63 64 65 119 120 1000; do
+    digest "$(keystream $length)"
+done